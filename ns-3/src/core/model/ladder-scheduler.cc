@@ -0,0 +1,382 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "type-id.h"
+#include "uinteger.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * Order events in decreasing time stamp order.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a is later than \c b.
+ */
+bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+    .AddAttribute ("Threshold",
+                   "The largest number of events sorted at once, "
+                   "beyond which the events of a bucket are spread over a new rung",
+                   TypeId::ATTR_CONSTRUCT,
+                   UintegerValue (50),
+                   MakeUintegerAccessor (&LadderScheduler::SetThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxRungs",
+                   "The largest number of rungs of the ladder",
+                   TypeId::ATTR_CONSTRUCT,
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&LadderScheduler::SetMaxRungs),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+uint64_t
+LadderScheduler::Rung::GetCurrentStart (void) const
+{
+  return m_start + m_current * m_width;
+}
+
+uint32_t
+LadderScheduler::Rung::GetBucket (uint64_t ts) const
+{
+  uint32_t bucket = (ts - m_start) / m_width;
+  NS_ASSERT (bucket >= m_current && bucket < m_nBuckets);
+  return bucket;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_nRungs (0),
+    m_qSize (0),
+    m_threshold (50),
+    m_maxRungs (0),
+    m_bottomLimit (50)
+{
+  NS_LOG_FUNCTION (this);
+  SetMaxRungs (8);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LadderScheduler::SetThreshold (uint32_t threshold)
+{
+  NS_LOG_FUNCTION (this << threshold);
+  m_threshold = threshold;
+  m_bottomLimit = threshold;
+}
+
+void
+LadderScheduler::SetMaxRungs (uint32_t maxRungs)
+{
+  NS_LOG_FUNCTION (this << maxRungs);
+  NS_ASSERT (m_nRungs == 0);
+  m_maxRungs = maxRungs;
+  // The buckets are referenced while rungs are added
+  m_rungs.reserve (maxRungs);
+}
+
+uint64_t
+LadderScheduler::GetBottomEnd (void) const
+{
+  if (m_nRungs == 0)
+    {
+      return m_topStart;
+    }
+  return m_rungs[m_nRungs - 1].GetCurrentStart ();
+}
+
+void
+LadderScheduler::SpawnRung (uint64_t start, uint64_t end, Bucket &events)
+{
+  NS_LOG_FUNCTION (this << start << end << events.size ());
+  NS_ASSERT (m_nRungs < m_maxRungs && start < end && !events.empty ());
+
+  if (m_nRungs == m_rungs.size ())
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs];
+  uint64_t span = end - start;
+  uint64_t n = events.size ();
+  rung.m_start = start;
+  rung.m_width = std::max<uint64_t> (1, (span + n - 1) / n);
+  rung.m_current = 0;
+  rung.m_nEvents = events.size ();
+  rung.m_nBuckets = (span + rung.m_width - 1) / rung.m_width;
+  if (rung.m_buckets.size () < rung.m_nBuckets)
+    {
+      rung.m_buckets.resize (rung.m_nBuckets);
+    }
+  m_nRungs++;
+
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.m_buckets[rung.GetBucket (i->key.m_ts)].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::SortIntoBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+}
+
+void
+LadderScheduler::InsertIntoBottom (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+
+  if (m_bottom.size () >= m_bottomLimit && m_nRungs < m_maxRungs)
+    {
+      // Too many events are inserted close to the current time: spread
+      // them over a new rung, to sort them in smaller batches
+      uint64_t start = std::min (ev.key.m_ts, m_bottom.back ().key.m_ts);
+      uint64_t end = GetBottomEnd ();
+      m_bottom.push_back (ev);
+      SpawnRung (start, end, m_bottom);
+      RefillBottom ();
+      return;
+    }
+
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater), ev);
+}
+
+void
+LadderScheduler::RefillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (m_bottom.empty () && m_qSize > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          // Move the top to the ladder, and start a new top after its events
+          NS_ASSERT (!m_top.empty ());
+          uint64_t minTs = m_top.front ().key.m_ts;
+          uint64_t maxTs = minTs;
+          for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+            {
+              minTs = std::min (minTs, i->key.m_ts);
+              maxTs = std::max (maxTs, i->key.m_ts);
+            }
+          m_topStart = maxTs + 1;
+          NS_LOG_LOGIC ("move " << m_top.size () << " events from the top, until " << m_topStart);
+          if (m_top.size () > m_threshold)
+            {
+              SpawnRung (minTs, m_topStart, m_top);
+            }
+          else
+            {
+              SortIntoBottom (m_top);
+            }
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.m_nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      uint64_t start = rung.GetCurrentStart ();
+      rung.m_current++;
+      rung.m_nEvents -= bucket.size ();
+      if (bucket.size () > m_threshold && m_nRungs < m_maxRungs && rung.m_width > 1)
+        {
+          SpawnRung (start, start + rung.m_width, bucket);
+        }
+      else
+        {
+          SortIntoBottom (bucket);
+        }
+    }
+
+  m_bottomLimit = std::max<uint32_t> (m_threshold, 2 * m_bottom.size ());
+}
+
+bool
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  m_qSize++;
+
+  if (ev.key.m_ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+    }
+  else
+    {
+      uint32_t i = 0;
+      while (i < m_nRungs && ev.key.m_ts < m_rungs[i].GetCurrentStart ())
+        {
+          i++;
+        }
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          rung.m_buckets[rung.GetBucket (ev.key.m_ts)].push_back (ev);
+          rung.m_nEvents++;
+        }
+      else
+        {
+          InsertIntoBottom (ev);
+        }
+    }
+
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_qSize--;
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+
+  if (ev.key.m_ts >= m_topStart)
+    {
+      if (!RemoveFromBucket (m_top, ev))
+        {
+          NS_ASSERT_MSG (false, "Event not found in the top");
+        }
+    }
+  else
+    {
+      uint32_t i = 0;
+      while (i < m_nRungs && ev.key.m_ts < m_rungs[i].GetCurrentStart ())
+        {
+          i++;
+        }
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          if (!RemoveFromBucket (rung.m_buckets[rung.GetBucket (ev.key.m_ts)], ev))
+            {
+              NS_ASSERT_MSG (false, "Event not found in rung " << i);
+            }
+          rung.m_nEvents--;
+        }
+      else
+        {
+          Bucket::iterator it = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+          NS_ASSERT (it != m_bottom.end () && it->key.m_uid == ev.key.m_uid);
+          m_bottom.erase (it);
+        }
+    }
+
+  m_qSize--;
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+}
+
+} // namespace ns3
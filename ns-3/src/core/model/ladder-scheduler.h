@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * ["Ladder Queue: An O(1) Priority Queue Structure for Large-Scale Discrete
+ * Event Simulation" by Wee Tong Tang, Rick Siow Mong Goh and Ian Li-Jin
+ * Thng][Tang], a calendar queue that needs no resizing heuristic.
+ *
+ * [Tang]: https://doi.org/10.1145/1103323.1103324 "Tang"
+ *
+ * Events are kept in three tiers:
+ *
+ * - Top: an unsorted vector of the events at or after \c m_topStart, which
+ *   are inserted in constant time. This is where most events of periodic
+ *   traffic land, one period ahead of the current time.
+ * - Ladder: rungs of buckets, each rung covering the time span of a single
+ *   bucket of the rung above it, with narrower buckets. When the bottom
+ *   runs out of events, the top is spread over a new rung, whose bucket
+ *   width is the span of its events divided by their number, and the first
+ *   non-empty bucket of the lowest rung is either spread over a new rung,
+ *   if it holds more than \c Threshold events, or sorted into the bottom.
+ * - Bottom: a short vector of the earliest events, sorted in decreasing
+ *   time stamp order, from which the next event is removed in constant time.
+ *
+ * Each event is thus moved a small number of times, whatever the
+ * distribution of the time stamps, and the width of the buckets adapts to
+ * the density of the events at each time scale (for instance, the events of
+ * the current transmissions and those of the next periodic uplinks).
+ *
+ * Removing an event needs a search of its bucket only. Events that are
+ * cancelled with Simulator::Cancel stay in the queue until they are
+ * reached, as with all schedulers.
+ *
+ * \par Time Complexity
+ *
+ * Operation    | Amortized %Time | Reason
+ * :----------- | :-------------- | :-----
+ * Insert()     | ~Constant       | Append to top or bucket; sorted insert in bottom
+ * IsEmpty()    | Constant        | Explicit queue size
+ * PeekNext()   | Constant        | Last event of the bottom
+ * Remove()     | ~Constant       | Search within bucket
+ * RemoveNext() | ~Constant       | Each event moves down a few tiers
+ *
+ * \par Memory Complexity
+ *
+ * Category  | Memory                           | Reason
+ * :-------- | :------------------------------- | :-----
+ * Overhead  | Rungs of `std::vector` buckets   | At most one bucket per event, per rung
+ * Per Event | 0                                | `std::vector` of Scheduler::Event
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Ladder bucket type: an unsorted vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** Time stamp at the start of the first bucket. */
+    uint64_t m_start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t m_width;
+    /** Index of the first bucket that can still hold events. */
+    uint32_t m_current;
+    /** Number of events in the buckets of the rung. */
+    uint32_t m_nEvents;
+    /** The buckets, of which only the first m_nBuckets are used. */
+    std::vector<Bucket> m_buckets;
+    /** Number of buckets of the rung. */
+    uint32_t m_nBuckets;
+
+    /**
+     * Get the start of the current bucket.
+     *
+     * \returns The time stamp from which events go into this rung.
+     */
+    uint64_t GetCurrentStart (void) const;
+    /**
+     * Get the bucket of a time stamp.
+     *
+     * \param [in] ts The time stamp, at or after GetCurrentStart.
+     * \returns The bucket index.
+     */
+    uint32_t GetBucket (uint64_t ts) const;
+  };
+
+  /**
+   * Set the maximum number of events that are sorted into the bottom at
+   * once, or kept in the bottom when events are inserted in it.
+   *
+   * \param [in] threshold The number of events.
+   */
+  void SetThreshold (uint32_t threshold);
+  /**
+   * Set the maximum number of rungs of the ladder.
+   *
+   * \param [in] maxRungs The number of rungs.
+   */
+  void SetMaxRungs (uint32_t maxRungs);
+
+  /**
+   * Get the time stamp from which events go into the ladder rather than
+   * into the bottom.
+   *
+   * \returns The start of the current bucket of the lowest rung, or
+   *          \c m_topStart if the ladder is empty.
+   */
+  uint64_t GetBottomEnd (void) const;
+  /**
+   * Add a rung below the lowest one, and spread events over it.
+   *
+   * \param [in] start The start of the time span of the rung.
+   * \param [in] end The end of the time span of the rung.
+   * \param [in,out] events The events to spread, which is emptied.
+   */
+  void SpawnRung (uint64_t start, uint64_t end, Bucket &events);
+  /**
+   * Sort events into the (empty) bottom.
+   *
+   * \param [in,out] events The events to sort, which is emptied.
+   */
+  void SortIntoBottom (Bucket &events);
+  /**
+   * Insert an event into the bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertIntoBottom (const Scheduler::Event &ev);
+  /**
+   * Move events down the tiers until the bottom is not empty, if there is
+   * any event.
+   */
+  void RefillBottom (void);
+  /**
+   * Remove an event from an unsorted bucket.
+   *
+   * \param [in,out] bucket The bucket.
+   * \param [in] ev The event.
+   * \returns \c true if the event was found.
+   */
+  static bool RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+
+  /** Events at or after \c m_topStart, unsorted. */
+  Bucket m_top;
+  /** The time stamp from which events go to the top. */
+  uint64_t m_topStart;
+  /** The rungs, of which only the first m_nRungs are used. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs of the ladder. */
+  uint32_t m_nRungs;
+  /** The earliest events, in decreasing order. */
+  Bucket m_bottom;
+  /** Number of events in queue. */
+  uint32_t m_qSize;
+  /** The largest number of events sorted at once. */
+  uint32_t m_threshold;
+  /** The largest number of rungs. */
+  uint32_t m_maxRungs;
+  /**
+   * Size of the bottom from which the events inserted in it are spread over
+   * a new rung, which doubles the size of the bottom after it is refilled.
+   */
+  uint32_t m_bottomLimit;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -90,6 +90,16 @@ public:
    */
   void operator() (Ts... args) const;
 
+  /**
+   * Checks if the Callbacks list is empty.
+   *
+   * Trace sources whose arguments are costly to compute can use this to
+   * skip the computation when nothing is connected.
+   *
+   * \return true if the Callbacks list is empty.
+   */
+  bool IsEmpty () const;
+
   /**
    *  TracedCallback signature for POD.
    *
@@ -188,6 +198,13 @@ TracedCallback<Ts...>::operator() (Ts... args) const
     }
 }
 
+template<typename... Ts>
+bool
+TracedCallback<Ts...>::IsEmpty () const
+{
+  return m_callbackList.empty ();
+}
+
 } // namespace ns3
 
 #endif /* TRACED_CALLBACK_H */
@@ -28,6 +28,15 @@
 #include "ns3/building-penetration-loss.h"
 #include "ns3/building-allocator.h"
 #include "ns3/buildings-helper.h"
+#include "ns3/building-list.h"
+#include "ns3/lazy-basic-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/lora-object-pool.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-metrics-collector.h"
+#include "ns3/lora-output-writer.h"
+#include <fstream>
+#include <map>
 
 using namespace ns3;
 using namespace lorawan;
@@ -44,6 +53,33 @@ void OnTxPowerChange (double oldTxPower, double newTxPower)
   NS_LOG_DEBUG (oldTxPower << " dBm -> " << newTxPower << " dBm");
 }
 
+// Energy consumed transmitting by each end device, in total and at the last print
+std::map<uint32_t, double> txEnergy;
+std::map<uint32_t, double> txEnergyAtLastPrint;
+Ptr<LoraOutputWriter> txEnergyWriter;
+
+void OnTxEnergyConsumption (uint32_t nodeId, double oldEnergy, double newEnergy)
+{
+  txEnergy[nodeId] = newEnergy;
+}
+
+// Print, for each end device, the Joules spent transmitting during the last
+// period and since the beginning: time nodeId periodJoules totalJoules
+void PrintTxEnergy (NodeContainer endDevices, Time period)
+{
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      uint32_t nodeId = (*j)->GetId ();
+      txEnergyWriter->Add (Simulator::Now ().GetSeconds ());
+      txEnergyWriter->Add (nodeId);
+      txEnergyWriter->Add (txEnergy[nodeId] - txEnergyAtLastPrint[nodeId]);
+      txEnergyWriter->Add (txEnergy[nodeId]);
+      txEnergyWriter->EndRow ();
+      txEnergyAtLastPrint[nodeId] = txEnergy[nodeId];
+    }
+  Simulator::Schedule (period, &PrintTxEnergy, endDevices, period);
+}
+
 int main (int argc, char *argv[])
 {
 
@@ -62,12 +98,59 @@ int main (int argc, char *argv[])
   bool realisticChannelModel = true;
   bool isPrintBuildings = true;
 
+  // Whether to install a LoraRadioEnergyModel (with a linear tx current model) on the end devices
+  bool energyModel = false;
+
+  // Whether to write the allocation statistics of the object pools at the end
+  bool allocationStats = false;
+
+  // Whether to write the report of the hot path profiler at the end
+  bool profile = false;
+
   double maxRandomLoss = 10; // For the not-realisticChannelModel that uses a random loss
 
   double minSpeed = 2;
   double maxSpeed = 16;
   std::string adrType = "ns3::AdrComponent"; /* [Renzo] Here we can use different ADR implementations (at NS) */
 
+  // Output (the sweep driver adr-bandit-sweep.py gives each run its own directory)
+  std::string outputDir = "";
+  std::string topologyFile = "";
+
+  // Format of the periodic output files (text, csv or binary), and whether
+  // they are written by a background thread
+  std::string outputFormat = "text";
+  bool outputThread = false;
+
+  // Whether to print the status of the end devices only when it changes,
+  // with a full snapshot every keyframeInterval seconds (only at the start
+  // if 0), instead of every state sample period
+  bool deviceStatusChanges = false;
+  double keyframeInterval = 0;
+
+  // Whether to compute the PDR, energy and UNEC over the last metricsWindow
+  // periods during the simulation, and whether to write the periodic
+  // device status and performance files they are otherwise computed from
+  bool metrics = true;
+  uint32_t metricsWindow = 10;
+  bool rawLogs = true;
+
+  // Whether to write the learning of the bandits (arms chosen, feedback and
+  // posteriors) to a binary file
+  bool banditTelemetry = false;
+
+  // Whether to capture the packets of the gateways in a loratap pcap capture
+  // (gwCapture-*.pcap), configured with the ns3::LoraPcapCapture attributes
+  bool pcapCapture = false;
+
+  // Whether to write the energy spent transmitting by each end device at
+  // every period (txEnergy)
+  bool printTxEnergy = false;
+
+  // Type of the event scheduler of the simulator (ns3::LadderScheduler
+  // suits the periodic uplinks and receive windows of large networks)
+  std::string scheduler = "ns3::MapScheduler";
+
   CommandLine cmd;
   cmd.AddValue ("verbose", "Whether to print output or not", verbose);
   cmd.AddValue ("MultipleGwCombiningMethod",
@@ -107,8 +190,96 @@ int main (int argc, char *argv[])
                  maxSpeed);
    cmd.AddValue ("MaxTransmissions",
                  "ns3::EndDeviceLorawanMac::MaxTransmissions");
+   cmd.AddValue ("BatchReceiveWindows",
+                 "ns3::NetworkScheduler::BatchReceiveWindows");
+   cmd.AddValue ("FramesForBootstrapping",
+                 "ns3::BanditDelayedRewardIntelligence::FramesForBootstrapping");
+   cmd.AddValue ("FeedbackProbability",
+                 "ns3::BanditDelayedRewardIntelligence::FeedbackProbability");
+   cmd.AddValue ("RewardMode",
+                 "ns3::BanditDelayedRewardIntelligence::RewardMode");
+   cmd.AddValue ("energyModel",
+                 "Whether to install a LoraRadioEnergyModel on the end devices "
+                 "(else the bandits use a LinearLoraTxCurrentModel to compute "
+                 "the energy of their transmissions)",
+                 energyModel);
+   cmd.AddValue ("allocationStats",
+                 "Whether to write the allocation statistics of the object "
+                 "pools to allocationStats.txt at the end of the simulation",
+                 allocationStats);
+   cmd.AddValue ("profile",
+                 "Whether to write the report of the hot path profiler to "
+                 "profile.txt at the end of the simulation (the module must be "
+                 "configured with --enable-lorawan-profiling)",
+                 profile);
+   cmd.AddValue ("outputDir",
+                 "Directory where the output files are written (must exist)",
+                 outputDir);
+   cmd.AddValue ("outputFormat",
+                 "Format of nodeData, gwData, phyPerformance and "
+                 "globalPerformance: text (.txt), csv (.csv) or binary (.bin)",
+                 outputFormat);
+   cmd.AddValue ("outputThread",
+                 "Whether the periodic output files are written by a background "
+                 "thread",
+                 outputThread);
+   cmd.AddValue ("deviceStatusChanges",
+                 "Whether to write the changes of the end device status to "
+                 "nodeDataChanges instead of writing the status of all end "
+                 "devices to nodeData every 1200 s (see "
+                 "lorawan-device-status-reader.py)",
+                 deviceStatusChanges);
+   cmd.AddValue ("keyframeInterval",
+                 "Seconds between full snapshots in nodeDataChanges (0: only "
+                 "at the start)",
+                 keyframeInterval);
+   cmd.AddValue ("metrics",
+                 "Whether to write the PDR, energy and UNEC over the last "
+                 "periods to metrics.txt, and per end device to deviceMetrics",
+                 metrics);
+   cmd.AddValue ("metricsWindow",
+                 "Number of last periods over which the metrics are computed",
+                 metricsWindow);
+   cmd.AddValue ("rawLogs",
+                 "Whether to write nodeData, phyPerformance and "
+                 "globalPerformance",
+                 rawLogs);
+   cmd.AddValue ("banditTelemetry",
+                 "Whether to write the arms chosen, the feedback and the "
+                 "posteriors of the bandits to banditTelemetry.bin",
+                 banditTelemetry);
+   cmd.AddValue ("pcapCapture",
+                 "Whether to capture the packets of the gateways to "
+                 "gwCapture-*.pcap; e.g., with "
+                 "--ns3::LoraPcapCapture::RingDuration=60s, only the last "
+                 "minute is written on bursts of receptions lost because a "
+                 "gateway was transmitting",
+                 pcapCapture);
+   cmd.AddValue ("txEnergy",
+                 "Whether to write the Joules spent transmitting by each end "
+                 "device during each period and in total to txEnergy, in the "
+                 "outputFormat",
+                 printTxEnergy);
+   cmd.AddValue ("topologyFile",
+                 "Topology snapshot (node positions, buildings, data rates and "
+                 "path losses) loaded if it exists, and written otherwise",
+                 topologyFile);
+   cmd.AddValue ("printBuildings",
+                 "Whether to write the buildings to buildings.txt",
+                 isPrintBuildings);
+   cmd.AddValue ("scheduler",
+                 "Type of the event scheduler, e.g., ns3::LadderScheduler",
+                 scheduler);
    cmd.Parse (argc, argv);
 
+   ObjectFactory schedulerFactory (scheduler);
+   Simulator::SetScheduler (schedulerFactory);
+
+   if (!outputDir.empty () && outputDir.back () != '/')
+     {
+       outputDir += "/";
+     }
+
 
 
    int gatewayRings = 2 + (std::sqrt(2) * sideLength) / (gatewayDistance);
@@ -124,7 +295,12 @@ int main (int argc, char *argv[])
    // Logging
    //////////
 
-   LogComponentEnable ("AdrBanditExampleMultiGW", LOG_LEVEL_ALL);
+   // Only when asked: even with nothing printed, enabled components format
+   // every message of the hot paths
+   if (verbose)
+     {
+       LogComponentEnable ("AdrBanditExampleMultiGW", LOG_LEVEL_ALL);
+     }
 
    //LogComponentEnable ("LoraHelper", LOG_LEVEL_ALL);
    // LogComponentEnable ("LoraPacketTracker", LOG_LEVEL_ALL);
@@ -186,9 +362,12 @@ int main (int argc, char *argv[])
 
 
 
-   LogComponentEnableAll (LOG_PREFIX_FUNC);
-   LogComponentEnableAll (LOG_PREFIX_NODE);
-   LogComponentEnableAll (LOG_PREFIX_TIME);
+   if (verbose)
+     {
+       LogComponentEnableAll (LOG_PREFIX_FUNC);
+       LogComponentEnableAll (LOG_PREFIX_NODE);
+       LogComponentEnableAll (LOG_PREFIX_TIME);
+     }
 
 
 
@@ -297,6 +476,25 @@ int main (int argc, char *argv[])
    LoraHelper helper = LoraHelper ();
    helper.EnablePacketTracking ();
 
+   LoraOutputWriter::Format outputWriterFormat = LoraOutputWriter::TEXT;
+   std::string outputExtension = ".txt";
+   if (outputFormat == "csv")
+     {
+       outputWriterFormat = LoraOutputWriter::CSV;
+       outputExtension = ".csv";
+     }
+   else if (outputFormat == "binary")
+     {
+       outputWriterFormat = LoraOutputWriter::BINARY;
+       outputExtension = ".bin";
+     }
+   else
+     {
+       NS_ABORT_MSG_IF (outputFormat != "text", "Unknown output format " << outputFormat);
+     }
+   helper.SetOutputFormat (outputWriterFormat);
+   helper.SetOutputBackgroundThread (outputThread);
+
    /*********************
     *  Create Gateways  *
     *********************/
@@ -349,6 +547,14 @@ int main (int argc, char *argv[])
   macHelper.SetRegion (LorawanMacHelper::EU);
   helper.Install (phyHelper, macHelper, endDevices);
 
+  // Reuse the geometry and data rates of a previous run, if available
+  Ptr<LoraTopologySnapshot> snapshot = 0;
+  if (!topologyFile.empty ())
+    {
+      snapshot = helper.LoadTopologySnapshot (topologyFile, endDevices, gateways);
+    }
+
+
 
   /**********************
   *  Handle buildings  *
@@ -371,22 +577,26 @@ int main (int argc, char *argv[])
 
 
 
-   Ptr<GridBuildingAllocator> gridBuildingAllocator;
-   gridBuildingAllocator = CreateObject<GridBuildingAllocator> ();
-   gridBuildingAllocator->SetAttribute ("GridWidth", UintegerValue (gridWidth));
-   gridBuildingAllocator->SetAttribute ("LengthX", DoubleValue (xLength));
-   gridBuildingAllocator->SetAttribute ("LengthY", DoubleValue (yLength));
-   gridBuildingAllocator->SetAttribute ("DeltaX", DoubleValue (deltaX));
-   gridBuildingAllocator->SetAttribute ("DeltaY", DoubleValue (deltaY));
-   gridBuildingAllocator->SetAttribute ("Height", DoubleValue (6));
-   gridBuildingAllocator->SetBuildingAttribute ("NRoomsX", UintegerValue (2));
-   gridBuildingAllocator->SetBuildingAttribute ("NRoomsY", UintegerValue (4));
-   gridBuildingAllocator->SetBuildingAttribute ("NFloors", UintegerValue (2));
-   gridBuildingAllocator->SetAttribute (
-       "MinX", DoubleValue (-gridWidth * (xLength + deltaX) / 2 + deltaX / 2));
-   gridBuildingAllocator->SetAttribute (
-       "MinY", DoubleValue (-gridHeight * (yLength + deltaY) / 2 + deltaY / 2));
-   BuildingContainer bContainer = gridBuildingAllocator->Create (gridWidth * gridHeight);
+   // The buildings were already created from the snapshot
+   if (snapshot == 0)
+     {
+       Ptr<GridBuildingAllocator> gridBuildingAllocator;
+       gridBuildingAllocator = CreateObject<GridBuildingAllocator> ();
+       gridBuildingAllocator->SetAttribute ("GridWidth", UintegerValue (gridWidth));
+       gridBuildingAllocator->SetAttribute ("LengthX", DoubleValue (xLength));
+       gridBuildingAllocator->SetAttribute ("LengthY", DoubleValue (yLength));
+       gridBuildingAllocator->SetAttribute ("DeltaX", DoubleValue (deltaX));
+       gridBuildingAllocator->SetAttribute ("DeltaY", DoubleValue (deltaY));
+       gridBuildingAllocator->SetAttribute ("Height", DoubleValue (6));
+       gridBuildingAllocator->SetBuildingAttribute ("NRoomsX", UintegerValue (2));
+       gridBuildingAllocator->SetBuildingAttribute ("NRoomsY", UintegerValue (4));
+       gridBuildingAllocator->SetBuildingAttribute ("NFloors", UintegerValue (2));
+       gridBuildingAllocator->SetAttribute (
+           "MinX", DoubleValue (-gridWidth * (xLength + deltaX) / 2 + deltaX / 2));
+       gridBuildingAllocator->SetAttribute (
+           "MinY", DoubleValue (-gridHeight * (yLength + deltaY) / 2 + deltaY / 2));
+       gridBuildingAllocator->Create (gridWidth * gridHeight);
+     }
 
 
    BuildingsHelper::Install (endDevices);
@@ -398,10 +608,10 @@ int main (int argc, char *argv[])
    if (isPrintBuildings)
      {
        std::ofstream myfile;
-       myfile.open ("buildings.txt");
-       std::vector<Ptr<Building>>::const_iterator it;
+       myfile.open (outputDir + "buildings.txt");
+       BuildingList::Iterator it;
        int j = 1;
-       for (it = bContainer.Begin (); it != bContainer.End (); ++it, ++j)
+       for (it = BuildingList::Begin (); it != BuildingList::End (); ++it, ++j)
 	 {
 	   Box boundaries = (*it)->GetBoundaries ();
 	   myfile << "set object " << j << " rect from " << boundaries.xMin << "," << boundaries.yMin
@@ -428,11 +638,40 @@ int main (int argc, char *argv[])
   ApplicationContainer appContainer = appHelper.Install (endDevices);
 
   // Do not set spreading factors up: we will wait for the NS to do this
-  if (initializeSF)
+  // (If a snapshot was loaded, the data rates are those it was written with)
+  if (initializeSF && snapshot == 0)
     {
       macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
     }
 
+  if (!topologyFile.empty () && snapshot == 0)
+    {
+      helper.WriteTopologySnapshot (topologyFile, endDevices, gateways, channel);
+    }
+
+  /************************
+   * Install Energy Model *
+   ************************/
+
+  if (energyModel)
+    {
+      // No periodic energy update events, which would dominate large simulations
+      LazyBasicEnergySourceHelper sourceHelper;
+      sourceHelper.Set ("InitialEnergyJ", DoubleValue (1e6)); // Never depleted
+      sourceHelper.Set ("SupplyVoltageV", DoubleValue (3.3));
+
+      LoraRadioEnergyModelHelper radioEnergyHelper;
+      radioEnergyHelper.SetTxCurrentModel ("ns3::LinearLoraTxCurrentModel");
+
+      EnergySourceContainer sources = sourceHelper.Install (endDevices);
+      NetDeviceContainer endDevicesNetDevices;
+      for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+        {
+          endDevicesNetDevices.Add ((*j)->GetDevice (0));
+        }
+      radioEnergyHelper.Install (endDevicesNetDevices, sources);
+    }
+
   ////////////
   // Create NS
   ////////////
@@ -461,12 +700,67 @@ int main (int argc, char *argv[])
 
   // Activate printing of ED MAC parameters
   Time stateSamplePeriod = Seconds (1200);
-  helper.DoPrintDeviceStatus (gateways, "gwData.txt"); // Renzo: We save the GWs position
-  helper.EnablePeriodicDeviceStatusPrinting (endDevices, gateways, "nodeData.txt", stateSamplePeriod); // Renzo: currently I disabled info from gateways
+  helper.DoPrintDeviceStatus (gateways, outputDir + "gwData" + outputExtension); // Renzo: We save the GWs position
+  if (rawLogs && deviceStatusChanges)
+    {
+      helper.EnableDeviceStatusChangePrinting (endDevices,
+                                               outputDir + "nodeDataChanges" + outputExtension,
+                                               Seconds (keyframeInterval));
+    }
+  else if (rawLogs)
+    {
+      helper.EnablePeriodicDeviceStatusPrinting (endDevices, gateways, outputDir + "nodeData" + outputExtension, stateSamplePeriod); // Renzo: currently I disabled info from gateways
+    }
+
+
+  if (rawLogs)
+    {
+      helper.EnablePeriodicPhyPerformancePrinting (gateways, outputDir + "phyPerformance" + outputExtension, stateSamplePeriod);
+      helper.EnablePeriodicGlobalPerformancePrinting (outputDir + "globalPerformance" + outputExtension, stateSamplePeriod);
+    }
 
+  // PDR, energy and UNEC over the last periods (replaces the offline
+  // computation from nodeData and globalPerformance)
+  LoraMetricsCollector metricsCollector;
+  if (metrics)
+    {
+      metricsCollector.SetPeriod (stateSamplePeriod);
+      metricsCollector.SetWindowPeriods (metricsWindow);
+      metricsCollector.Install (endDevices, gateways);
+    }
+
+  if (banditTelemetry)
+    {
+      helper.EnableBanditTelemetry (endDevices, outputDir + "banditTelemetry.bin");
+    }
 
-  helper.EnablePeriodicPhyPerformancePrinting (gateways, "phyPerformance.txt", stateSamplePeriod);
-  helper.EnablePeriodicGlobalPerformancePrinting ("globalPerformance.txt", stateSamplePeriod);
+  if (pcapCapture)
+    {
+      Ptr<LoraPcapCapture> capture = helper.EnablePcapCapture (outputDir + "gwCapture",
+                                                               gateways);
+      helper.EnablePcapCaptureTrigger (capture, gateways);
+    }
+
+  // Energy spent transmitting by each bandit end device (replaces the offline computation from nodeData)
+  if (printTxEnergy)
+    {
+      for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+        {
+          Ptr<LoraNetDevice> loraNetDevice = (*j)->GetDevice (0)->GetObject<LoraNetDevice> ();
+          loraNetDevice->GetMac ()->TraceConnectWithoutContext
+            ("TxEnergyConsumption", MakeBoundCallback (&OnTxEnergyConsumption, (*j)->GetId ()));
+        }
+
+      std::vector<LoraOutputColumn> columns;
+      columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE));
+      columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+      columns.push_back (LoraOutputColumn ("periodJoules", LoraOutputColumn::DOUBLE));
+      columns.push_back (LoraOutputColumn ("totalJoules", LoraOutputColumn::DOUBLE));
+      txEnergyWriter = Create<LoraOutputWriter> (outputDir + "txEnergy" + outputExtension,
+                                                 LoraOutputWriter::CreateEncoder (outputWriterFormat),
+                                                 columns, false, outputThread);
+      Simulator::Schedule (stateSamplePeriod, &PrintTxEnergy, endDevices, stateSamplePeriod);
+    }
 
 
   // phyPerformance: SENT  RECEIVED   INTERFERED NO_MORE_RECEIVERS  UNDER_SENSITIVITY  LOST_BECAUSE_TX
@@ -499,6 +793,28 @@ int main (int argc, char *argv[])
   Simulator::Stop (simulationTime);
   Simulator::Run ();
   Simulator::Destroy ();
+  if (txEnergyWriter != 0)
+    {
+      txEnergyWriter->Close ();
+      txEnergyWriter = 0;
+    }
+
+  if (allocationStats)
+    {
+      std::ofstream allocationStatsFile (outputDir + "allocationStats.txt");
+      LoraObjectPool::PrintStatistics (allocationStatsFile);
+    }
+  if (profile)
+    {
+      std::ofstream profileFile (outputDir + "profile.txt");
+      LoraProfiler::PrintReport (profileFile);
+    }
+  if (metrics)
+    {
+      metricsCollector.WriteSummary (outputDir + "metrics.txt");
+      metricsCollector.WriteDeviceSummary (outputDir + "deviceMetrics" + outputExtension,
+                                           outputWriterFormat);
+    }
 
   std::cout << tracker.CountMacPacketsGlobally(Seconds (1200 * (nPeriods - 2)),
                                                Seconds (1200 * (nPeriods - 1))) << std::endl;
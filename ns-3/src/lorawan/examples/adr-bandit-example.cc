@@ -94,7 +94,12 @@ int main (int argc, char *argv[])
    // Logging
    //////////
 
-   LogComponentEnable ("AdrBanditExample", LOG_LEVEL_ALL);
+   // Only when asked: even with nothing printed, enabled components format
+   // every message of the hot paths
+   if (verbose)
+     {
+       LogComponentEnable ("AdrBanditExample", LOG_LEVEL_ALL);
+     }
 
    //LogComponentEnable ("LoraHelper", LOG_LEVEL_ALL);
    // LogComponentEnable ("LoraPacketTracker", LOG_LEVEL_ALL);
@@ -156,9 +161,12 @@ int main (int argc, char *argv[])
 
 
 
-   LogComponentEnableAll (LOG_PREFIX_FUNC);
-   LogComponentEnableAll (LOG_PREFIX_NODE);
-   LogComponentEnableAll (LOG_PREFIX_TIME);
+   if (verbose)
+     {
+       LogComponentEnableAll (LOG_PREFIX_FUNC);
+       LogComponentEnableAll (LOG_PREFIX_NODE);
+       LogComponentEnableAll (LOG_PREFIX_TIME);
+     }
 
 
 
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Run a parameter sweep of adr-bandit-example-multi-gw in parallel.
+
+Each combination of the swept parameters is run for a number of replications
+(distinct RngRun values) by a pool of concurrent simulation processes. Every
+run writes its output files in its own directory, and all runs of the same
+topology share a snapshot of it (node positions, buildings, data rates and
+path losses), which is generated once beforehand. The global performance of
+all runs is then collected in a single CSV file, with one column per swept
+parameter. The runs may write their files in any outputFormat; a run that
+does not leave its globalPerformance file behind counts as failed.
+
+Example, from the ns-3 directory and after ./waf build:
+
+    python3 src/lorawan/examples/adr-bandit-sweep.py \\
+        --param FramesForBootstrapping=0,15 --param FeedbackProbability=0.1,0.067 \\
+        --runs 5 --jobs 8 --output sweep-results \\
+        --nDevices=2000 --HistoryRange=1000 --PeriodsToSimulate=100
+
+Arguments that are not recognized are passed as-is to all runs.
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import glob
+import importlib.util
+import itertools
+import os
+import subprocess
+import sys
+
+PROGRAM = 'adr-bandit-example-multi-gw'
+
+# Command line arguments of the example that change the node positions
+TOPOLOGY_PARAMETERS = ['nDevices', 'sideLength', 'gatewayDistance']
+
+# Extension of the output files for each value of the outputFormat argument
+OUTPUT_EXTENSIONS = {'text': '.txt', 'csv': '.csv', 'binary': '.bin'}
+
+# Columns of globalPerformance, which text files have no header for
+PERFORMANCE_COLUMNS = ['time', 'sent', 'received']
+
+
+def load_reader():
+    """
+    Import lorawan-device-status-reader.py, whose read_table reads the files
+    written in any output format.
+    """
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        'lorawan-device-status-reader.py')
+    spec = importlib.util.spec_from_file_location('lorawan_device_status_reader', path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def find_program(ns3_dir):
+    """
+    Return the path of the built example, and the library directory.
+    """
+    build_dir = os.path.join(ns3_dir, 'build')
+    candidates = glob.glob(os.path.join(build_dir, 'src', 'lorawan', 'examples',
+                                        'ns3-*-' + PROGRAM + '*'))
+    if not candidates:
+        sys.exit('Could not find %s in %s: run ./waf build first' %
+                 (PROGRAM, build_dir))
+    return candidates[0], os.path.join(build_dir, 'lib')
+
+
+def parse_parameters(params):
+    """
+    Turn ['a=1,2', 'b=3'] into the list of all the combinations, as dicts.
+    """
+    names = []
+    values = []
+    for param in params:
+        name, _, value_list = param.partition('=')
+        names.append(name)
+        values.append(value_list.split(','))
+    return [dict(zip(names, combination))
+            for combination in itertools.product(*values)]
+
+
+def run(program, lib_dir, arguments, cwd):
+    """
+    Run a simulation, with its standard output and error logged in cwd.
+    """
+    env = dict(os.environ)
+    env['LD_LIBRARY_PATH'] = lib_dir + os.pathsep + env.get('LD_LIBRARY_PATH', '')
+    with open(os.path.join(cwd, 'stdout.txt'), 'w') as out, \
+            open(os.path.join(cwd, 'stderr.txt'), 'w') as err:
+        code = subprocess.call([program] + arguments, cwd=cwd, env=env,
+                               stdout=out, stderr=err)
+    return cwd, code
+
+
+def to_arguments(values):
+    return ['--%s=%s' % (name, value) for name, value in sorted(values.items())]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--param', action='append', default=[],
+                        help='NAME=V1,V2,... command line argument of the '
+                        'example to sweep (can be repeated)')
+    parser.add_argument('--runs', type=int, default=1,
+                        help='Number of replications of each configuration')
+    parser.add_argument('--first-run', type=int, default=1,
+                        help='RngRun of the first replication')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='Number of concurrent simulations')
+    parser.add_argument('--output', default='sweep-results',
+                        help='Directory where all results are written')
+    parser.add_argument('--ns3-dir', default='.',
+                        help='Directory of ns-3, where waf is')
+    args, fixed = parser.parse_known_args()
+
+    program, lib_dir = find_program(os.path.abspath(args.ns3_dir))
+    output = os.path.abspath(args.output)
+    os.makedirs(output, exist_ok=True)
+
+    configurations = parse_parameters(args.param)
+    fixed_values = dict(argument.lstrip('-').partition('=')[::2]
+                        for argument in fixed)
+    output_format = fixed_values.get('outputFormat', 'text')
+    if output_format not in OUTPUT_EXTENSIONS:
+        sys.exit('Unknown output format %s' % output_format)
+    performance_file = 'globalPerformance' + OUTPUT_EXTENSIONS[output_format]
+    reader = load_reader()
+
+    def topology_key(configuration):
+        values = dict(fixed_values, **configuration)
+        return '-'.join('%s=%s' % (name, values[name])
+                        for name in TOPOLOGY_PARAMETERS if name in values) or 'default'
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        # Generate each topology (and the buildings) once, without simulating
+        topologies = {}
+        for configuration in configurations:
+            key = topology_key(configuration)
+            if key in topologies:
+                continue
+            directory = os.path.join(output, 'topology-' + key)
+            os.makedirs(directory, exist_ok=True)
+            topology_file = os.path.join(directory, 'topology.bin')
+            if os.path.exists(topology_file):
+                os.remove(topology_file)
+            arguments = fixed + to_arguments(configuration) + [
+                '--PeriodsToSimulate=0', '--topologyFile=' + topology_file,
+                '--outputDir=' + directory]
+            topologies[key] = (topology_file,
+                               pool.submit(run, program, lib_dir, arguments, directory))
+        for topology_file, future in topologies.values():
+            directory, code = future.result()
+            if code != 0:
+                sys.exit('Topology generation failed, see %s' % directory)
+
+        # Then run all the replications of all configurations
+        futures = {}
+        for index, configuration in enumerate(configurations):
+            topology_file = topologies[topology_key(configuration)][0]
+            for rng_run in range(args.first_run, args.first_run + args.runs):
+                directory = os.path.join(output, 'config-%d' % index, 'run-%d' % rng_run)
+                os.makedirs(directory, exist_ok=True)
+                arguments = fixed + to_arguments(configuration) + [
+                    '--RngRun=%d' % rng_run, '--topologyFile=' + topology_file,
+                    '--outputDir=' + directory, '--printBuildings=0']
+                future = pool.submit(run, program, lib_dir, arguments, directory)
+                futures[future] = (index, configuration, rng_run)
+
+        failed = 0
+        for future in concurrent.futures.as_completed(futures):
+            directory, code = future.result()
+            if code != 0:
+                failed += 1
+                print('Run failed, see %s' % directory, file=sys.stderr)
+            else:
+                print('Done: %s' % directory)
+
+    # Collect the global performance of all runs in a single columnar file.
+    # A successful run without that file is an error, not an empty result.
+    names = sorted(set(name for configuration in configurations
+                       for name in configuration))
+    with open(os.path.join(output, 'results.csv'), 'w', newline='') as results:
+        writer = csv.writer(results)
+        writer.writerow(names + ['RngRun', 'time', 'sent', 'received'])
+        for future, (index, configuration, rng_run) in sorted(
+                futures.items(), key=lambda item: (item[1][0], item[1][2])):
+            directory, code = future.result()
+            if code != 0:
+                continue
+            path = os.path.join(directory, performance_file)
+            if not os.path.exists(path):
+                failed += 1
+                print('Missing %s, see %s' % (performance_file, directory),
+                      file=sys.stderr)
+                continue
+            columns, rows = reader.read_table(path, PERFORMANCE_COLUMNS)
+            time, sent, received = (columns.index(name) for name in PERFORMANCE_COLUMNS)
+            for row in rows:
+                writer.writerow([configuration[name] for name in names] +
+                                [rng_run, '%.10g' % row[time], int(row[sent]),
+                                 int(row[received])])
+
+    if failed:
+        sys.exit('%d runs failed' % failed)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Rebuild the periodic device status from a file of status changes.
+
+LoraHelper::EnableDeviceStatusChangePrinting only writes the status of the
+end devices (position, data rate and transmission power) at keyframes and
+when it changes. This reads such a file, in any of the formats of
+LoraHelper::SetOutputFormat (text, CSV or binary), and writes the status of
+every end device at regular sample times, in the format of
+LoraHelper::EnablePeriodicDeviceStatusPrinting (nodeData.txt):
+
+    time nodeId x y dr txPower
+
+Positions between course changes are extrapolated from the velocity recorded
+at the last change, which is exact for the piecewise linear mobility models.
+Example:
+
+    python3 src/lorawan/examples/lorawan-device-status-reader.py \\
+        nodeDataChanges.bin --period 1200 --output nodeData.txt
+
+read_table can also be imported to read any file written by LoraOutputWriter.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+# Columns of the files written by EnableDeviceStatusChangePrinting, which is
+# what text files (that have no header) are assumed to hold
+CHANGE_COLUMNS = ['time', 'nodeId', 'kind', 'x', 'y', 'vx', 'vy', 'dr', 'txPower']
+
+MAGIC = b'LORACOL\0'
+
+# LoraOutputColumn::Type, as struct formats
+BINARY_TYPES = {0: 'i', 1: 'I', 2: 'd', 3: 'B', 4: 'f'}
+
+
+def read_binary(data):
+    """
+    Decode the binary columnar format of LoraBinaryOutputEncoder.
+    """
+    version, n_columns = struct.unpack_from('<II', data, len(MAGIC))
+    if version != 1:
+        raise ValueError('Unsupported version %d' % version)
+    offset = len(MAGIC) + 8
+    names = []
+    types = []
+    for _ in range(n_columns):
+        column_type, length = struct.unpack_from('<BH', data, offset)
+        offset += 3
+        names.append(data[offset:offset + length].decode())
+        types.append(BINARY_TYPES[column_type])
+        offset += length
+
+    rows = []
+    while offset < len(data):
+        (n_rows,) = struct.unpack_from('<I', data, offset)
+        offset += 4
+        columns = []
+        for column_type in types:
+            fmt = '<%d%s' % (n_rows, column_type)
+            columns.append(struct.unpack_from(fmt, data, offset))
+            offset += struct.calcsize(fmt)
+        rows.extend(zip(*columns))
+    return names, rows
+
+
+def read_table(path, columns=None):
+    """
+    Read a file written by LoraOutputWriter, and return the names of its
+    columns and its rows, as tuples of numbers. Text files have no header, so
+    the names of their columns are given (CHANGE_COLUMNS by default).
+    """
+    with open(path, 'rb') as file:
+        data = file.read()
+    if data.startswith(MAGIC):
+        return read_binary(data)
+
+    lines = data.decode().splitlines()
+    if lines and ',' in lines[0]:
+        reader = csv.reader(lines)
+        names = next(reader)
+        return names, [tuple(float(value) for value in row) for row in reader if row]
+
+    names = columns or CHANGE_COLUMNS
+    return names, [tuple(float(value) for value in line.split())
+                   for line in lines if line.strip()]
+
+
+def rebuild(names, rows, period, start=0.0, end=None):
+    """
+    Yield (time, nodeId, x, y, dr, txPower) for every end device known at each
+    sample time from start to end (the time of the last row by default), in
+    the order in which the devices first appear.
+    """
+    index = dict((name, i) for i, name in enumerate(names))
+    time, node, x, y, vx, vy, dr, tx_power = (
+        index[name] for name in ['time', 'nodeId', 'x', 'y', 'vx', 'vy', 'dr', 'txPower'])
+    if end is None:
+        end = rows[-1][time] if rows else start
+
+    states = {}
+    next_row = 0
+    sample = 0
+    while start + sample * period <= end:
+        now = start + sample * period
+        while next_row < len(rows) and rows[next_row][time] <= now:
+            row = rows[next_row]
+            states[int(row[node])] = row
+            next_row += 1
+        for node_id, row in states.items():
+            elapsed = now - row[time]
+            yield (now, node_id, row[x] + row[vx] * elapsed, row[y] + row[vy] * elapsed,
+                   int(row[dr]), int(row[tx_power]))
+        sample += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='File written by EnableDeviceStatusChangePrinting')
+    parser.add_argument('--period', type=float, required=True,
+                        help='Time between samples, in seconds')
+    parser.add_argument('--start', type=float, default=0.0,
+                        help='Time of the first sample, in seconds')
+    parser.add_argument('--end', type=float, default=None,
+                        help='Time of the last sample, in seconds (by default, '
+                             'the time of the last change)')
+    parser.add_argument('--columns', default=None,
+                        help='Comma-separated names of the columns of a text file')
+    parser.add_argument('--output', default=None,
+                        help='File to write (by default, the standard output)')
+    args = parser.parse_args()
+
+    names, rows = read_table(args.input, args.columns.split(',') if args.columns else None)
+    output = open(args.output, 'w') if args.output else sys.stdout
+    try:
+        for sample in rebuild(names, rows, args.period, args.start, args.end):
+            output.write('%g %d %g %g %d %d\n' % sample)
+    finally:
+        if args.output:
+            output.close()
+
+
+if __name__ == '__main__':
+    main()
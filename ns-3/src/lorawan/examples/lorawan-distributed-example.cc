@@ -0,0 +1,241 @@
+/*
+ * This script splits a deployment of end devices and gateways over several
+ * MPI ranks with a LoraRemoteChannel. The area is divided in vertical strips,
+ * one per rank: each rank simulates the nodes of its strip, and receives the
+ * transmissions of the nodes of the other strips that are within range.
+ *
+ * It needs ns-3 to be configured with --enable-mpi, and is run with, e.g.:
+ *
+ *   mpirun -np 4 ./waf --run "lorawan-distributed-example --nDevices=4000"
+ *
+ * Every rank prints the number of packets sent by its end devices and the
+ * number of packets received by its gateways, transmissions of the other
+ * ranks included.
+ *
+ * With --nullMessage, the ranks exchange messages every LookAhead of
+ * simulated time, which makes long simulations slow unless a longer
+ * --ns3::LoraRemoteChannel::LookAhead is chosen.
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/lora-remote-channel.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-phy-helper.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node-container.h"
+#include "ns3/command-line.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/global-value.h"
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanDistributedExample");
+
+// Network settings
+int nDevices = 2000;
+int gatewaysPerSide = 4;
+double sideLength = 40000;
+double maxRange = 15000;
+double simulationTime = 3600;
+int appPeriodSeconds = 600;
+
+// Synchronization algorithm
+bool nullMessage = false;
+
+// Packets seen by the local nodes
+uint32_t packetsSent = 0;
+uint32_t packetsReceived = 0;
+
+void
+OnPacketSent (Ptr<const Packet> packet, uint32_t systemId)
+{
+  packetsSent++;
+}
+
+void
+OnPacketReceived (Ptr<const Packet> packet, uint32_t systemId)
+{
+  packetsReceived++;
+}
+
+/**
+ * Create a node on the rank that is responsible for a position.
+ */
+Ptr<Node>
+CreateNodeAt (Ptr<LoraRemoteChannel> channel, Vector position)
+{
+  Ptr<Node> node = CreateObject<Node> (channel->GetRegion (position));
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (position);
+  node->AggregateObject (mobility);
+  return node;
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices to include in the simulation", nDevices);
+  cmd.AddValue ("gatewaysPerSide", "Number of gateways along each side of the square grid",
+                gatewaysPerSide);
+  cmd.AddValue ("sideLength", "Side of the square area to simulate, in meters", sideLength);
+  cmd.AddValue ("maxRange", "Distance beyond which transmissions are not forwarded to "
+                "other ranks, in meters", maxRange);
+  cmd.AddValue ("simulationTime", "The time for which to simulate", simulationTime);
+  cmd.AddValue ("appPeriod",
+                "The period in seconds to be used by periodically transmitting applications",
+                appPeriodSeconds);
+  cmd.AddValue ("nullMessage", "Use the null message synchronization algorithm instead "
+                "of the granted time window", nullMessage);
+  cmd.Parse (argc, argv);
+
+  // The simulator must be chosen before MPI is enabled
+  if (nullMessage)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::NullMessageSimulatorImpl"));
+    }
+  else
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::DistributedSimulatorImpl"));
+    }
+  MpiInterface::Enable (&argc, &argv);
+
+  uint32_t rank = MpiInterface::GetSystemId ();
+  uint32_t nRanks = MpiInterface::GetSize ();
+
+  /************************
+  *  Create the channel  *
+  ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  // One strip of the area per rank
+  Ptr<LoraRemoteChannel> channel = CreateObject<LoraRemoteChannel> (loss, delay);
+  channel->SetAttribute ("RegionOrigin", DoubleValue (0));
+  channel->SetAttribute ("RegionWidth", DoubleValue (sideLength / nRanks));
+  channel->SetAttribute ("MaxRange", DoubleValue (maxRange));
+
+  // All ranks create the proxies, and then all the nodes, in the same order
+  NodeContainer proxies;
+  for (uint32_t i = 0; i < nRanks; i++)
+    {
+      proxies.Add (CreateObject<Node> (i));
+    }
+  channel->SetRankProxies (proxies);
+
+  /*********************
+  *  Create the nodes  *
+  *********************/
+
+  // A square grid of gateways
+  NodeContainer gateways;
+  double gatewayDistance = sideLength / gatewaysPerSide;
+  for (int i = 0; i < gatewaysPerSide; i++)
+    {
+      for (int j = 0; j < gatewaysPerSide; j++)
+        {
+          gateways.Add (CreateNodeAt (channel, Vector (gatewayDistance * (i + 0.5),
+                                                       gatewayDistance * (j + 0.5), 15)));
+        }
+    }
+
+  // End devices placed uniformly at random: all ranks draw the same positions
+  NodeContainer endDevices;
+  Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+  coordinate->SetAttribute ("Min", DoubleValue (0));
+  coordinate->SetAttribute ("Max", DoubleValue (sideLength));
+  for (int i = 0; i < nDevices; i++)
+    {
+      double x = coordinate->GetValue ();
+      double y = coordinate->GetValue ();
+      endDevices.Add (CreateNodeAt (channel, Vector (x, y, 1.2)));
+    }
+
+  // Only the local nodes get a device
+  NodeContainer localGateways;
+  NodeContainer localEndDevices;
+  for (uint32_t i = 0; i < gateways.GetN (); i++)
+    {
+      if (gateways.Get (i)->GetSystemId () == rank)
+        {
+          localGateways.Add (gateways.Get (i));
+        }
+    }
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      if (endDevices.Get (i)->GetSystemId () == rank)
+        {
+          localEndDevices.Add (endDevices.Get (i));
+        }
+    }
+
+  /***********************
+  *  Install the devices *
+  ***********************/
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  LoraHelper helper = LoraHelper ();
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, localEndDevices);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, localGateways);
+
+  // The spreading factors only depend on the positions of the gateways, so
+  // they are computed against all of them, local or not
+  LorawanMacHelper::SetSpreadingFactorsUp (localEndDevices, gateways, channel);
+
+  for (uint32_t i = 0; i < localEndDevices.GetN (); i++)
+    {
+      Ptr<LoraNetDevice> device = localEndDevices.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      device->GetPhy ()->TraceConnectWithoutContext ("StartSending",
+                                                     MakeCallback (&OnPacketSent));
+    }
+  for (uint32_t i = 0; i < localGateways.GetN (); i++)
+    {
+      Ptr<LoraNetDevice> device = localGateways.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      device->GetPhy ()->TraceConnectWithoutContext ("ReceivedPacket",
+                                                     MakeCallback (&OnPacketReceived));
+    }
+
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (appPeriodSeconds));
+  appHelper.Install (localEndDevices);
+
+  /****************
+  *  Simulation  *
+  ****************/
+
+  Simulator::Stop (Seconds (simulationTime));
+  Simulator::Run ();
+
+  std::cout << "Rank " << rank << ": " << localEndDevices.GetN () << " end devices, "
+            << localGateways.GetN () << " gateways, " << packetsSent << " packets sent, "
+            << packetsReceived << " packets received" << std::endl;
+
+  Simulator::Destroy ();
+  MpiInterface::Disable ();
+
+  return 0;
+}
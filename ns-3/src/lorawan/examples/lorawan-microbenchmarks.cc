@@ -0,0 +1,553 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * This program measures the time taken by the hot kernels of the lorawan
+ * module (PHY, interference, propagation, headers, network server and bandit
+ * agent), so that performance regressions can be tracked over time.
+ *
+ * Each kernel is first run a growing number of times, until a run takes at
+ * least minTime milliseconds. Then, it is run that many times in each of
+ * the repetitions, and the median, minimum and maximum time per call are
+ * written as CSV (default) or JSON, one record per kernel and problem size.
+ *
+ * Numbers are only meaningful in an optimized build, with logging compiled
+ * out:
+ *
+ *   ./waf configure -d optimized --enable-examples ...
+ *   ./waf --run "lorawan-microbenchmarks --label=$(git rev-parse --short HEAD)
+ *                --output=microbenchmarks.csv"
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/packet.h"
+#include "ns3/buffer.h"
+#include "ns3/mac48-address.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/lora-phy.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-tag.h"
+#include "ns3/simple-end-device-lora-phy.h"
+#include "ns3/lora-interference-helper.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/mac-command.h"
+#include "ns3/end-device-status.h"
+#include "ns3/network-controller-component-bandit.h"
+#include "ns3/adr-bandit-agent.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanMicrobenchmarks");
+
+/**
+ * A kernel to measure.
+ */
+struct Kernel
+{
+  std::string name; //!< The function that is measured
+  std::string parameter; //!< The problem size, as name=value
+  std::function<void (uint64_t)> run; //!< Calls the function a number of times
+};
+
+/**
+ * The measured time per call of a kernel.
+ */
+struct Result
+{
+  std::string name; //!< The function that was measured
+  std::string parameter; //!< The problem size
+  uint64_t iterations; //!< The number of calls in each repetition
+  uint32_t repetitions; //!< The number of repetitions
+  double medianNs; //!< The median time per call, over the repetitions
+  double minNs; //!< The smallest time per call
+  double maxNs; //!< The largest time per call
+};
+
+// Results of the kernels are accumulated here, so that the compiler cannot
+// optimize the calls away
+volatile uint64_t g_sink = 0;
+
+std::string
+Parameter (std::string name, uint64_t value)
+{
+  std::ostringstream os;
+  os << name << "=" << value;
+  return os.str ();
+}
+
+/**
+ * Create an uplink packet, with its headers and the tag that the gateway PHY
+ * adds at reception.
+ */
+Ptr<Packet>
+CreateUplink (uint16_t fCnt, uint8_t sf)
+{
+  Ptr<Packet> packet = Create<Packet> (20);
+
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetFCnt (fCnt);
+  frameHdr.SetAddress (LoraDeviceAddress (1, 1));
+  packet->AddHeader (frameHdr);
+
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+
+  LoraTag tag (sf);
+  tag.SetFrequency (868.1);
+  tag.SetReceivePower (-110);
+  packet->AddPacketTag (tag);
+
+  return packet;
+}
+
+/**
+ * Gives access to the computation of the reply to a BanditRewardReq.
+ */
+class RewardAnsComponent : public NetworkControllerComponentBandit
+{
+public:
+  using NetworkControllerComponentBandit::GetBanditRewardAns;
+};
+
+void
+AddOnAirTimeKernels (std::vector<Kernel> &kernels)
+{
+  Ptr<Packet> packet = Create<Packet> (20);
+  kernels.push_back ({"LoraPhy::GetOnAirTime", Parameter ("payload", 20),
+                      [packet] (uint64_t n) {
+                        LoraTxParameters txParams;
+                        for (uint64_t i = 0; i < n; i++)
+                          {
+                            txParams.sf = 7 + i % 6;
+                            g_sink += LoraPhy::GetOnAirTime (packet, txParams).GetTimeStep ();
+                          }
+                      }});
+}
+
+void
+AddInterferenceKernels (std::vector<Kernel> &kernels)
+{
+  for (uint32_t nEvents : {10, 100, 1000})
+    {
+      // All events overlap with the one that is checked
+      std::shared_ptr<LoraInterferenceHelper> helper =
+          std::make_shared<LoraInterferenceHelper> ();
+      Ptr<LoraInterferenceHelper::Event> event =
+          helper->Add (Seconds (1), -110, 7, Create<Packet> (20), 868.1);
+      for (uint32_t i = 1; i < nEvents; i++)
+        {
+          helper->Add (MilliSeconds (100 + i % 900), -140 + i % 40, 7 + i % 6,
+                       Create<Packet> (20), 868.1);
+        }
+      kernels.push_back ({"LoraInterferenceHelper::IsDestroyedByInterference",
+                          Parameter ("events", nEvents), [helper, event] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                g_sink += helper->IsDestroyedByInterference (event);
+                              }
+                          }});
+    }
+}
+
+void
+AddShadowingKernels (std::vector<Kernel> &kernels)
+{
+  uint32_t nNodes = 1000;
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Max", DoubleValue (10000));
+  x->SetStream (1);
+
+  std::vector<Ptr<MobilityModel>> nodes;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility =
+          CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (x->GetValue (), x->GetValue (), 1.2));
+      nodes.push_back (mobility);
+    }
+
+  // Fill the shadowing map, so that the kernel only performs lookups
+  Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+      CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      shadowing->CalcRxPower (14, nodes[i], nodes[(i * 7 + 1) % nNodes]);
+    }
+
+  kernels.push_back ({"CorrelatedShadowingPropagationLossModel::CalcRxPower",
+                      Parameter ("nodes", nNodes), [shadowing, nodes] (uint64_t n) {
+                        uint32_t size = nodes.size ();
+                        for (uint64_t i = 0; i < n; i++)
+                          {
+                            uint32_t a = i % size;
+                            g_sink += shadowing->CalcRxPower (14, nodes[a],
+                                                              nodes[(a * 7 + 1) % size]);
+                          }
+                      }});
+}
+
+void
+AddFrameHeaderKernels (std::vector<Kernel> &kernels)
+{
+  LoraFrameHeader uplink;
+  uplink.SetAsUplink ();
+  uplink.SetFCnt (300);
+  uplink.SetAddress (LoraDeviceAddress (1, 1));
+  uplink.AddCommand (Create<BanditRewardReq> (300, 20));
+
+  LoraFrameHeader downlink;
+  downlink.SetAsDownlink ();
+  downlink.SetFCnt (12);
+  downlink.SetAddress (LoraDeviceAddress (1, 1));
+  downlink.AddCommand (CreateObject<BanditRewardAns> (1, 2, 3, 4, 5, 6));
+
+  std::vector<std::pair<std::string, LoraFrameHeader>> headers = {
+      {"BanditRewardReq", uplink}, {"BanditRewardAns", downlink}};
+  for (auto &named : headers)
+    {
+      LoraFrameHeader header = named.second;
+      std::string parameter = "command=" + named.first;
+
+      kernels.push_back ({"LoraFrameHeader::Serialize", parameter, [header] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                Buffer buffer;
+                                buffer.AddAtStart (header.GetSerializedSize ());
+                                header.Serialize (buffer.Begin ());
+                                g_sink += buffer.GetSize ();
+                              }
+                          }});
+
+      // Decoding the MAC commands is part of the deserialization
+      bool isUplink = named.first == "BanditRewardReq";
+      std::shared_ptr<Buffer> serialized = std::make_shared<Buffer> ();
+      serialized->AddAtStart (header.GetSerializedSize ());
+      header.Serialize (serialized->Begin ());
+      kernels.push_back ({"LoraFrameHeader::Deserialize", parameter,
+                          [serialized, isUplink] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                LoraFrameHeader frameHdr;
+                                if (isUplink)
+                                  {
+                                    frameHdr.SetAsUplink ();
+                                  }
+                                else
+                                  {
+                                    frameHdr.SetAsDownlink ();
+                                  }
+                                frameHdr.Deserialize (serialized->Begin ());
+                                g_sink += frameHdr.GetCommands ().size ();
+                              }
+                          }});
+    }
+
+  Ptr<Packet> packet = CreateUplink (300, 7);
+  kernels.push_back ({"LoraFrameHeaderView::GetFCnt", "command=none", [packet] (uint64_t n) {
+                        for (uint64_t i = 0; i < n; i++)
+                          {
+                            g_sink += LoraFrameHeaderView (packet).GetFCnt ();
+                          }
+                      }});
+}
+
+void
+AddNetworkServerKernels (std::vector<Kernel> &kernels)
+{
+  Address firstGateway = Mac48Address ("00:00:00:00:00:01");
+  Address secondGateway = Mac48Address ("00:00:00:00:00:02");
+  Ptr<RewardAnsComponent> component = CreateObject<RewardAnsComponent> ();
+
+  for (uint32_t depth : {10, 100, 1000})
+    {
+      Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> ();
+      Ptr<Packet const> oldest;
+      for (uint32_t fCnt = 1; fCnt <= depth; fCnt++)
+        {
+          Ptr<Packet> packet = CreateUplink (fCnt, 7 + fCnt % 6);
+          status->InsertReceivedPacket (packet, firstGateway);
+          if (fCnt == 1)
+            {
+              oldest = packet;
+            }
+        }
+
+      // A copy of the oldest packet, received by another gateway, is looked
+      // up in the whole history, like a new packet would be
+      kernels.push_back ({"EndDeviceStatus::InsertReceivedPacket",
+                          Parameter ("history", depth),
+                          [status, oldest, secondGateway] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                status->InsertReceivedPacket (oldest, secondGateway);
+                              }
+                          }});
+
+      EndDeviceStatus::ReceivedPacketList packetList = status->GetReceivedPacketList ();
+      Ptr<BanditRewardReq> request =
+          Create<BanditRewardReq> (depth, std::min<uint32_t> (depth - 1, 255));
+      kernels.push_back ({"NetworkControllerComponentBandit::GetBanditRewardAns",
+                          Parameter ("history", depth),
+                          [component, request, packetList] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                Ptr<BanditRewardAns> answer =
+                                    component->GetBanditRewardAns (request, packetList);
+                                g_sink += answer->GetSerializedSize ();
+                              }
+                          }});
+    }
+}
+
+void
+AddBanditKernels (std::vector<Kernel> &kernels)
+{
+  Ptr<AdrBanditAgent> agent = CreateObject<AdrBanditAgent> ();
+  kernels.push_back ({"AdrBanditAgent::ChooseArm", Parameter ("arms", agent->GetNumberOfArms ()),
+                      [agent] (uint64_t n) {
+                        for (uint64_t i = 0; i < n; i++)
+                          {
+                            g_sink += agent->ChooseArm ();
+                          }
+                      }});
+  kernels.push_back ({"AdrBanditAgent::UpdateReward",
+                      Parameter ("arms", agent->GetNumberOfArms ()), [agent] (uint64_t n) {
+                        size_t arms = agent->GetNumberOfArms ();
+                        for (uint64_t i = 0; i < n; i++)
+                          {
+                            agent->UpdateReward (i % arms, (i % 3 == 0) ? 1 : 0);
+                          }
+                      }});
+}
+
+void
+AddChannelKernels (std::vector<Kernel> &kernels)
+{
+  for (uint32_t nReceivers : {10, 100, 1000})
+    {
+      Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+      loss->SetPathLossExponent (3.76);
+      loss->SetReference (1, 7.7);
+      loss->SetNext (CreateObject<CorrelatedShadowingPropagationLossModel> ());
+      Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+      Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+      // Most end devices are asleep when a packet is sent, so that they drop
+      // it as soon as it arrives
+      for (uint32_t i = 0; i < nReceivers; i++)
+        {
+          Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy> ();
+          Ptr<ConstantPositionMobilityModel> mobility =
+              CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (Vector (100.0 * (i % 100), 100.0 * (i / 100), 1.2));
+          phy->SetMobility (mobility);
+          phy->SwitchToStandby ();
+          phy->SwitchToSleep ();
+          channel->Add (phy);
+          phy->SetChannel (channel);
+        }
+
+      Ptr<SimpleEndDeviceLoraPhy> sender = CreateObject<SimpleEndDeviceLoraPhy> ();
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (5000, 5000, 1.2));
+      sender->SetMobility (mobility);
+
+      LoraTxParameters txParams;
+      txParams.sf = 7;
+      Ptr<Packet> packet = Create<Packet> (20);
+      Time duration = LoraPhy::GetOnAirTime (packet, txParams);
+
+      // Each call is followed by the delivery of the packet to all receivers.
+      // Packets are sent one second apart, so that the interference helpers
+      // of the receivers get rid of the old events as they would in a
+      // simulation.
+      kernels.push_back ({"LoraChannel::Send", Parameter ("receivers", nReceivers),
+                          [channel, sender, packet, txParams, duration] (uint64_t n) {
+                            for (uint64_t i = 0; i < n; i++)
+                              {
+                                Simulator::Schedule (Seconds (1), &LoraChannel::Send, channel,
+                                                     sender, packet, 14, txParams, duration,
+                                                     868.1);
+                                Simulator::Run ();
+                              }
+                          }});
+    }
+}
+
+double
+TimeKernel (const Kernel &kernel, uint64_t iterations)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  kernel.run (iterations);
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now () - start;
+  return std::chrono::duration<double, std::nano> (elapsed).count ();
+}
+
+Result
+Measure (const Kernel &kernel, double minTimeNs, uint32_t repetitions)
+{
+  // Calibrate the number of calls per repetition, which also warms up the
+  // caches
+  uint64_t iterations = 1;
+  while (TimeKernel (kernel, iterations) < minTimeNs && iterations < (1ULL << 32))
+    {
+      iterations *= 2;
+    }
+
+  std::vector<double> nsPerCall;
+  for (uint32_t r = 0; r < repetitions; r++)
+    {
+      nsPerCall.push_back (TimeKernel (kernel, iterations) / iterations);
+    }
+  std::sort (nsPerCall.begin (), nsPerCall.end ());
+
+  Result result;
+  result.name = kernel.name;
+  result.parameter = kernel.parameter;
+  result.iterations = iterations;
+  result.repetitions = repetitions;
+  result.medianNs = nsPerCall[nsPerCall.size () / 2];
+  result.minNs = nsPerCall.front ();
+  result.maxNs = nsPerCall.back ();
+  return result;
+}
+
+std::string
+GetBuildProfile (void)
+{
+#if defined(NS3_BUILD_PROFILE_OPTIMIZED)
+  return "optimized";
+#elif defined(NS3_BUILD_PROFILE_RELEASE)
+  return "release";
+#else
+  return "debug";
+#endif
+}
+
+void
+PrintCsv (std::ostream &os, const std::vector<Result> &results, std::string label)
+{
+  os << "label,build,kernel,parameter,iterations,repetitions,medianNs,minNs,maxNs" << std::endl;
+  for (const Result &result : results)
+    {
+      os << label << "," << GetBuildProfile () << "," << result.name << ","
+         << result.parameter << "," << result.iterations << "," << result.repetitions << ","
+         << result.medianNs << "," << result.minNs << "," << result.maxNs << std::endl;
+    }
+}
+
+void
+PrintJson (std::ostream &os, const std::vector<Result> &results, std::string label)
+{
+  os << "{\"label\": \"" << label << "\", \"build\": \"" << GetBuildProfile ()
+     << "\", \"results\": [";
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      const Result &result = results[i];
+      os << (i > 0 ? "," : "") << std::endl
+         << "  {\"kernel\": \"" << result.name << "\", \"parameter\": \"" << result.parameter
+         << "\", \"iterations\": " << result.iterations
+         << ", \"repetitions\": " << result.repetitions << ", \"medianNs\": " << result.medianNs
+         << ", \"minNs\": " << result.minNs << ", \"maxNs\": " << result.maxNs << "}";
+    }
+  os << std::endl << "]}" << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  double minTime = 200;
+  uint32_t repetitions = 5;
+  std::string filter = "";
+  std::string format = "csv";
+  std::string output = "";
+  std::string label = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("minTime", "Minimum duration of a repetition, in milliseconds", minTime);
+  cmd.AddValue ("repetitions", "Number of timed repetitions of each kernel", repetitions);
+  cmd.AddValue ("filter", "Only run the kernels whose name contains this string", filter);
+  cmd.AddValue ("format", "Output format: csv or json", format);
+  cmd.AddValue ("output", "File where the results are written (default: standard output)",
+                output);
+  cmd.AddValue ("label", "Label of this run in the results, e.g., a revision", label);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (format == "csv" || format == "json", "Unknown format " << format);
+  NS_ABORT_MSG_UNLESS (repetitions > 0, "At least one repetition is needed");
+
+  std::vector<Kernel> kernels;
+  AddOnAirTimeKernels (kernels);
+  AddInterferenceKernels (kernels);
+  AddShadowingKernels (kernels);
+  AddFrameHeaderKernels (kernels);
+  AddNetworkServerKernels (kernels);
+  AddBanditKernels (kernels);
+  AddChannelKernels (kernels);
+
+  std::vector<Result> results;
+  for (const Kernel &kernel : kernels)
+    {
+      if (kernel.name.find (filter) == std::string::npos)
+        {
+          continue;
+        }
+      results.push_back (Measure (kernel, minTime * 1e6, repetitions));
+      NS_LOG_INFO (kernel.name << " " << kernel.parameter << ": "
+                               << results.back ().medianNs << " ns");
+    }
+
+  Simulator::Destroy ();
+
+  std::ofstream file;
+  if (output != "")
+    {
+      file.open (output.c_str ());
+      NS_ABORT_MSG_UNLESS (file.is_open (), "Could not open " << output);
+    }
+  std::ostream &os = (output != "") ? file : std::cout;
+  if (format == "csv")
+    {
+      PrintCsv (os, results, label);
+    }
+  else
+    {
+      PrintJson (os, results, label);
+    }
+
+  return 0;
+}
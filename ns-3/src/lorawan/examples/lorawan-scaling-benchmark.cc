@@ -0,0 +1,479 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * This program measures how fast the network of adr-bandit-example-multi-gw
+ * (bandit end devices sending every 20 minutes, gateways on a hexagonal grid,
+ * correlated shadowing and buildings) is simulated, as a function of the
+ * number of devices, of gateways and of the simulated duration.
+ *
+ * No trace file is written. At the end of the run, a line is appended to a
+ * CSV file with the wall time of the setup and of the simulation, the
+ * number of events and events per second, the wall time per simulated day,
+ * the device-hours simulated per wall second, the peak resident set size and
+ * the largest number of events that were pending in the scheduler at once.
+ *
+ * Each configuration must run in its own process, since the peak resident
+ * set size covers the whole process: lorawan-scaling-benchmark.py sweeps the
+ * parameters this way. Results are only meaningful in an optimized build,
+ * where logging is compiled out:
+ *
+ *   ./waf configure -d optimized --enable-examples ...
+ *   ./waf --run "lorawan-scaling-benchmark --nDevices=10000 --nGateways=19"
+ *
+ * The cost of disabled logging is measured by building with --enable-logs,
+ * with or without --lorawan-log-levels, and running with --logConfigured.
+ * The build column of the results tells these runs apart.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/object-factory.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/config.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-phy-helper.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-device-address-generator.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/building-allocator.h"
+#include "ns3/buildings-helper.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanScalingBenchmark");
+
+/**
+ * A scheduler that keeps track of the number of pending events, and
+ * delegates the actual scheduling to another scheduler.
+ */
+class QueueDepthScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  QueueDepthScheduler ();
+  virtual ~QueueDepthScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+  /**
+   * Get the largest number of events that were pending at the same time,
+   * over all instances.
+   */
+  static uint64_t GetHighWaterMark (void);
+
+private:
+  void SetScheduler (std::string type);
+
+  Ptr<Scheduler> m_scheduler; //!< The scheduler that is wrapped
+  uint64_t m_depth; //!< The number of pending events
+  static uint64_t m_highWaterMark; //!< The largest value of m_depth
+};
+
+NS_OBJECT_ENSURE_REGISTERED (QueueDepthScheduler);
+
+uint64_t QueueDepthScheduler::m_highWaterMark = 0;
+
+TypeId
+QueueDepthScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QueueDepthScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<QueueDepthScheduler> ()
+    .AddAttribute ("Scheduler", "The type of the scheduler that is wrapped",
+                   StringValue ("ns3::MapScheduler"),
+                   MakeStringAccessor (&QueueDepthScheduler::SetScheduler),
+                   MakeStringChecker ());
+  return tid;
+}
+
+QueueDepthScheduler::QueueDepthScheduler ()
+  : m_depth (0)
+{
+}
+
+QueueDepthScheduler::~QueueDepthScheduler ()
+{
+}
+
+void
+QueueDepthScheduler::SetScheduler (std::string type)
+{
+  NS_ASSERT (m_depth == 0);
+  ObjectFactory factory (type);
+  m_scheduler = factory.Create<Scheduler> ();
+}
+
+void
+QueueDepthScheduler::Insert (const Event &ev)
+{
+  m_scheduler->Insert (ev);
+  m_depth++;
+  m_highWaterMark = std::max (m_highWaterMark, m_depth);
+}
+
+bool
+QueueDepthScheduler::IsEmpty (void) const
+{
+  return m_scheduler->IsEmpty ();
+}
+
+Scheduler::Event
+QueueDepthScheduler::PeekNext (void) const
+{
+  return m_scheduler->PeekNext ();
+}
+
+Scheduler::Event
+QueueDepthScheduler::RemoveNext (void)
+{
+  m_depth--;
+  return m_scheduler->RemoveNext ();
+}
+
+void
+QueueDepthScheduler::Remove (const Event &ev)
+{
+  m_depth--;
+  m_scheduler->Remove (ev);
+}
+
+uint64_t
+QueueDepthScheduler::GetHighWaterMark (void)
+{
+  return m_highWaterMark;
+}
+
+double
+GetPeakRssMiB (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  // Linux reports the maximum resident set size in KiB
+  return usage.ru_maxrss / 1024.0;
+}
+
+std::string
+GetBuildProfile (bool logConfigured)
+{
+#if defined(NS3_BUILD_PROFILE_OPTIMIZED)
+  std::string profile = "optimized";
+#elif defined(NS3_BUILD_PROFILE_RELEASE)
+  std::string profile = "release";
+#else
+  std::string profile = "debug";
+#endif
+#ifdef NS3_LOG_ENABLE
+  profile += "+logs";
+#endif
+  if (logConfigured)
+    {
+      profile += "+configured";
+    }
+  return profile;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int nDevices = 1000;
+  int nGateways = 7;
+  double gatewayDistance = 2000;
+  double sideLength = 0;
+  double hours = 24;
+  bool realisticChannelModel = true;
+  bool packetTracking = true;
+  std::string scheduler = "ns3::MapScheduler";
+  std::string output = "scalingBenchmark.csv";
+  std::string label = "";
+  bool logConfigured = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices", nDevices);
+  cmd.AddValue ("nGateways", "Number of gateways, on a hexagonal grid", nGateways);
+  cmd.AddValue ("gatewayDistance", "Distance between gateways", gatewayDistance);
+  cmd.AddValue ("sideLength",
+                "Half the side of the square the end devices are placed in "
+                "(default: 1.1 times the radius of the gateway grid)",
+                sideLength);
+  cmd.AddValue ("hours", "Simulated duration, in hours", hours);
+  cmd.AddValue ("realisticChannelModel",
+                "Whether to add correlated shadowing and buildings to the "
+                "log-distance path loss",
+                realisticChannelModel);
+  cmd.AddValue ("packetTracking",
+                "Whether to track packets, as adr-bandit-example-multi-gw does",
+                packetTracking);
+  cmd.AddValue ("scheduler", "Type of the event scheduler", scheduler);
+  cmd.AddValue ("output", "CSV file the results are appended to", output);
+  cmd.AddValue ("label", "Label of this run in the results, e.g., a revision", label);
+  cmd.AddValue ("logConfigured",
+                "Whether to enable the prefixes and the errors of all log "
+                "components, so that every log statement is checked",
+                logConfigured);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (nDevices > 0 && nGateways > 0 && hours > 0, "Nothing to simulate");
+
+  // Logging that is configured but prints nothing, as in a simulation run
+  // with some prefixes set: the cost left is that of the disabled statements
+  if (logConfigured)
+    {
+      LogComponentEnableAll (LOG_PREFIX_ALL);
+      LogComponentEnableAll (LOG_LEVEL_ERROR);
+    }
+
+  std::chrono::steady_clock::time_point setupStart = std::chrono::steady_clock::now ();
+
+  ObjectFactory schedulerFactory ("ns3::QueueDepthScheduler");
+  schedulerFactory.Set ("Scheduler", StringValue (scheduler));
+  Simulator::SetScheduler (schedulerFactory);
+
+  // Number of rings of the hexagonal grid needed for all the gateways
+  int gatewayRings = 1;
+  while (3 * gatewayRings * gatewayRings - 3 * gatewayRings + 1 < nGateways)
+    {
+      gatewayRings++;
+    }
+  if (sideLength <= 0)
+    {
+      sideLength = 1.1 * gatewayDistance * std::max (1, gatewayRings - 1);
+    }
+
+  // Set the EDs to require Data Rate control from the NS
+  Config::SetDefault ("ns3::EndDeviceLorawanMac::DRControl", BooleanValue (true));
+
+  /************************
+   *  Create the channel  *
+   ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  if (realisticChannelModel)
+    {
+      Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+        CreateObject<CorrelatedShadowingPropagationLossModel> ();
+      loss->SetNext (shadowing);
+      shadowing->SetNext (CreateObject<BuildingPenetrationLoss> ());
+    }
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  /************************
+   *  Create the helpers  *
+   ************************/
+
+  MobilityHelper mobilityEd, mobilityGw;
+  mobilityEd.SetPositionAllocator ("ns3::RandomRectanglePositionAllocator",
+                                   "X", PointerValue (CreateObjectWithAttributes<UniformRandomVariable>
+                                                        ("Min", DoubleValue (-sideLength),
+                                                        "Max", DoubleValue (sideLength))),
+                                   "Y", PointerValue (CreateObjectWithAttributes<UniformRandomVariable>
+                                                        ("Min", DoubleValue (-sideLength),
+                                                        "Max", DoubleValue (sideLength))));
+  mobilityEd.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobilityGw.SetPositionAllocator (CreateObject<HexGridPositionAllocator> (gatewayDistance / 2));
+  mobilityGw.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  LoraHelper helper = LoraHelper ();
+  if (packetTracking)
+    {
+      helper.EnablePacketTracking ();
+    }
+
+  /*********************
+   *  Create Gateways  *
+   *********************/
+
+  NodeContainer gateways;
+  gateways.Create (nGateways);
+  mobilityGw.Install (gateways);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  /************************
+   *  Create End Devices  *
+   ************************/
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobilityEd.Install (endDevices);
+
+  // Make it so that nodes are at a certain height > 0
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<MobilityModel> mobility = (*j)->GetObject<MobilityModel> ();
+      Vector position = mobility->GetPosition ();
+      position.z = 1.2;
+      mobility->SetPosition (position);
+    }
+
+  Ptr<LoraDeviceAddressGenerator> addrGen = CreateObject<LoraDeviceAddressGenerator> (54, 1864);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A_ADR_BANDIT);
+  macHelper.SetAddressGenerator (addrGen);
+  macHelper.SetRegion (LorawanMacHelper::EU);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  /**********************
+   *  Handle buildings  *
+   **********************/
+
+  if (realisticChannelModel)
+    {
+      double xLength = 130;
+      double deltaX = 32;
+      double yLength = 64;
+      double deltaY = 17;
+      int gridWidth = 2 * sideLength / (xLength + deltaX);
+      int gridHeight = 2 * sideLength / (yLength + deltaY);
+
+      Ptr<GridBuildingAllocator> gridBuildingAllocator = CreateObject<GridBuildingAllocator> ();
+      gridBuildingAllocator->SetAttribute ("GridWidth", UintegerValue (gridWidth));
+      gridBuildingAllocator->SetAttribute ("LengthX", DoubleValue (xLength));
+      gridBuildingAllocator->SetAttribute ("LengthY", DoubleValue (yLength));
+      gridBuildingAllocator->SetAttribute ("DeltaX", DoubleValue (deltaX));
+      gridBuildingAllocator->SetAttribute ("DeltaY", DoubleValue (deltaY));
+      gridBuildingAllocator->SetAttribute ("Height", DoubleValue (6));
+      gridBuildingAllocator->SetBuildingAttribute ("NRoomsX", UintegerValue (2));
+      gridBuildingAllocator->SetBuildingAttribute ("NRoomsY", UintegerValue (4));
+      gridBuildingAllocator->SetBuildingAttribute ("NFloors", UintegerValue (2));
+      gridBuildingAllocator->SetAttribute (
+          "MinX", DoubleValue (-gridWidth * (xLength + deltaX) / 2 + deltaX / 2));
+      gridBuildingAllocator->SetAttribute (
+          "MinY", DoubleValue (-gridHeight * (yLength + deltaY) / 2 + deltaY / 2));
+      gridBuildingAllocator->Create (gridWidth * gridHeight);
+
+      BuildingsHelper::Install (endDevices);
+      BuildingsHelper::Install (gateways);
+    }
+
+  /*********************************************
+   *  Install applications on the end devices  *
+   *********************************************/
+
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPacketSize (32);
+  appHelper.SetPeriod (Seconds (1200));
+  appHelper.Install (endDevices);
+
+  ////////////
+  // Create NS
+  ////////////
+
+  NodeContainer networkServers;
+  networkServers.Create (1);
+
+  NetworkServerHelper networkServerHelper;
+  networkServerHelper.SetGateways (gateways);
+  networkServerHelper.SetEndDevices (endDevices);
+  networkServerHelper.EnableAdr (true);
+  networkServerHelper.SetAdr ("ns3::AdrComponent");
+  networkServerHelper.Install (networkServers);
+
+  ForwarderHelper forwarderHelper;
+  forwarderHelper.Install (gateways);
+
+  /**********************
+   *  Run the scenario  *
+   **********************/
+
+  Time simulationTime = Seconds (hours * 3600);
+  Simulator::Stop (simulationTime);
+
+  std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  std::chrono::steady_clock::time_point runEnd = std::chrono::steady_clock::now ();
+
+  uint64_t events = Simulator::GetEventCount ();
+  double setupSeconds = std::chrono::duration<double> (runStart - setupStart).count ();
+  double runSeconds = std::chrono::duration<double> (runEnd - runStart).count ();
+
+  std::string packets = "0 0";
+  if (packetTracking)
+    {
+      packets = helper.GetPacketTracker ().CountMacPacketsGlobally (Seconds (0), simulationTime);
+    }
+  std::istringstream packetStream (packets);
+  double sent = 0;
+  double received = 0;
+  packetStream >> sent >> received;
+
+  Simulator::Destroy ();
+
+  std::ifstream existing (output.c_str ());
+  bool writeHeader = !existing.good () || existing.peek () == std::ifstream::traits_type::eof ();
+  existing.close ();
+
+  std::ofstream csv (output.c_str (), std::ios::app);
+  NS_ABORT_MSG_UNLESS (csv.is_open (), "Could not open " << output);
+  if (writeHeader)
+    {
+      csv << "label,build,scheduler,nDevices,nGateways,simulatedHours,setupSeconds,"
+          << "runSeconds,events,eventsPerSecond,wallSecondsPerSimulatedDay,"
+          << "deviceHoursPerWallSecond,peakRssMiB,queueHighWaterMark,sent,received"
+          << std::endl;
+    }
+  csv << label << "," << GetBuildProfile (logConfigured) << "," << scheduler << "," << nDevices << ","
+      << nGateways << "," << hours << "," << setupSeconds << "," << runSeconds << ","
+      << events << "," << events / runSeconds << "," << runSeconds * 24 / hours << ","
+      << nDevices * hours / runSeconds << "," << GetPeakRssMiB () << ","
+      << QueueDepthScheduler::GetHighWaterMark () << "," << sent << "," << received
+      << std::endl;
+
+  NS_LOG_INFO ("Simulated " << nDevices * hours << " device-hours in " << runSeconds
+                            << " s (" << events / runSeconds << " events/s)");
+
+  return 0;
+}
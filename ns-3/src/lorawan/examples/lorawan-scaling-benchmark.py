@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Measure how the simulation speed scales with the size of the network.
+
+lorawan-scaling-benchmark is run once for each combination of the number of
+end devices, of gateways and of the simulated duration, each time in a new
+process, so that its peak memory is measured separately. Every run appends
+a line to the same CSV file, with the events per second, the wall time per
+simulated day, the device-hours simulated per wall second, the peak resident
+set size and the largest number of pending events.
+
+Runs are sequential by default, since concurrent runs slow each other down.
+Results are only meaningful in an optimized build, where logging is compiled
+out. Example, from the ns-3 directory:
+
+    ./waf configure -d optimized --enable-examples ... && ./waf build
+    python3 src/lorawan/examples/lorawan-scaling-benchmark.py \\
+        --devices 1000,10000,100000,200000 --gateways 7,19 --hours 24 \\
+        --label $(git rev-parse --short HEAD) --output scaling.csv
+
+The event schedulers are compared by giving several of them, e.g.,
+--scheduler ns3::MapScheduler,ns3::HeapScheduler,ns3::LadderScheduler.
+
+Arguments that are not recognized are passed as-is to all runs, e.g.,
+--logConfigured to measure the cost of disabled logging in a build with
+--enable-logs.
+"""
+
+import argparse
+import concurrent.futures
+import glob
+import itertools
+import os
+import subprocess
+import sys
+
+PROGRAM = 'lorawan-scaling-benchmark'
+
+
+def find_program(ns3_dir):
+    """
+    Return the path of the built benchmark, and the library directory.
+    """
+    build_dir = os.path.join(ns3_dir, 'build')
+    candidates = glob.glob(os.path.join(build_dir, 'src', 'lorawan', 'examples',
+                                        'ns3-*-' + PROGRAM + '*'))
+    if not candidates:
+        sys.exit('Could not find %s in %s: run ./waf build first' %
+                 (PROGRAM, build_dir))
+    return candidates[0], os.path.join(build_dir, 'lib')
+
+
+def run(program, lib_dir, arguments, timeout):
+    """
+    Run a configuration, and return whether it completed.
+    """
+    env = dict(os.environ)
+    env['LD_LIBRARY_PATH'] = lib_dir + os.pathsep + env.get('LD_LIBRARY_PATH', '')
+    try:
+        code = subprocess.call([program] + arguments, env=env, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        print('Timed out: %s' % ' '.join(arguments), file=sys.stderr)
+        return False
+    if code != 0:
+        print('Failed (%d): %s' % (code, ' '.join(arguments)), file=sys.stderr)
+    return code == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--devices', default='1000,10000,100000,200000',
+                        help='Comma-separated numbers of end devices')
+    parser.add_argument('--gateways', default='7',
+                        help='Comma-separated numbers of gateways')
+    parser.add_argument('--hours', default='24',
+                        help='Comma-separated simulated durations, in hours')
+    parser.add_argument('--scheduler', default='ns3::MapScheduler',
+                        help='Comma-separated types of event scheduler')
+    parser.add_argument('--jobs', type=int, default=1,
+                        help='Number of concurrent runs')
+    parser.add_argument('--timeout', type=float, default=None,
+                        help='Maximum wall time of a run, in seconds')
+    parser.add_argument('--label', default='',
+                        help='Label of the runs in the results, e.g., a revision')
+    parser.add_argument('--output', default='scalingBenchmark.csv',
+                        help='CSV file the results are appended to')
+    parser.add_argument('--ns3-dir', default='.',
+                        help='Directory of ns-3, where waf is')
+    args, fixed = parser.parse_known_args()
+
+    program, lib_dir = find_program(os.path.abspath(args.ns3_dir))
+    output = os.path.abspath(args.output)
+
+    # Smallest configurations first, so that a sweep that is interrupted
+    # still gives the scaling trend
+    configurations = sorted(itertools.product(
+        [int(value) for value in args.devices.split(',')],
+        [int(value) for value in args.gateways.split(',')],
+        [float(value) for value in args.hours.split(',')],
+        args.scheduler.split(',')))
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = []
+        for devices, gateways, hours, scheduler in configurations:
+            arguments = fixed + ['--nDevices=%d' % devices, '--nGateways=%d' % gateways,
+                                 '--hours=%g' % hours, '--scheduler=' + scheduler,
+                                 '--label=' + args.label, '--output=' + output]
+            futures.append(pool.submit(run, program, lib_dir, arguments, args.timeout))
+            # The first run writes the header of a new file alone
+            if len(futures) == 1:
+                futures[0].result()
+        failed = sum(1 for future in futures if not future.result())
+
+    print('Results appended to %s' % output)
+    if failed:
+        sys.exit('%d runs failed' % failed)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lazy-basic-energy-source-helper.h"
+#include "ns3/energy-source.h"
+
+namespace ns3 {
+namespace lorawan {
+
+LazyBasicEnergySourceHelper::LazyBasicEnergySourceHelper ()
+{
+  m_lazyBasicEnergySource.SetTypeId ("ns3::LazyBasicEnergySource");
+}
+
+LazyBasicEnergySourceHelper::~LazyBasicEnergySourceHelper ()
+{
+}
+
+void
+LazyBasicEnergySourceHelper::Set (std::string name, const AttributeValue &v)
+{
+  m_lazyBasicEnergySource.Set (name, v);
+}
+
+Ptr<EnergySource>
+LazyBasicEnergySourceHelper::DoInstall (Ptr<Node> node) const
+{
+  NS_ASSERT (node != NULL);
+  Ptr<EnergySource> source = m_lazyBasicEnergySource.Create<EnergySource> ();
+  NS_ASSERT (source != NULL);
+  source->SetNode (node);
+  return source;
+}
+
+} // namespace lorawan
+} // namespace ns3
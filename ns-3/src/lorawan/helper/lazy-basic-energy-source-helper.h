@@ -0,0 +1,53 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LAZY_BASIC_ENERGY_SOURCE_HELPER_H
+#define LAZY_BASIC_ENERGY_SOURCE_HELPER_H
+
+#include "ns3/energy-model-helper.h"
+#include "ns3/node.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup energy
+ * \brief Creates a LazyBasicEnergySource object.
+ *
+ * This is a drop-in replacement for BasicEnergySourceHelper that avoids
+ * one periodic energy update event per node.
+ */
+class LazyBasicEnergySourceHelper : public EnergySourceHelper
+{
+public:
+  LazyBasicEnergySourceHelper ();
+  ~LazyBasicEnergySourceHelper ();
+
+  void Set (std::string name, const AttributeValue &v);
+
+private:
+  virtual Ptr<EnergySource> DoInstall (Ptr<Node> node) const;
+
+private:
+  ObjectFactory m_lazyBasicEnergySource;
+
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LAZY_BASIC_ENERGY_SOURCE_HELPER_H */
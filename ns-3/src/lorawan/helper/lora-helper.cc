@@ -19,19 +19,94 @@
  */
 
 #include "ns3/lora-helper.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/loratap-pcap-header.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/class-a-end-device-lorawan-mac-bandit.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/building-list.h"
+#include "ns3/node-list.h"
 
 #include <fstream>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraHelper");
+LORA_LOG_COMPONENT_DEFINE ("LoraHelper");
+
+namespace {
+
+// The columns of the files written by DoPrintDeviceStatus
+std::vector<LoraOutputColumn>
+DeviceStatusColumns (void)
+{
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("x", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("y", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("dr", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("txPower", LoraOutputColumn::INT32));
+  return columns;
+}
+
+// The columns of the files written by EnableDeviceStatusChangePrinting
+std::vector<LoraOutputColumn>
+DeviceStatusChangeColumns (void)
+{
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("kind", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("x", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("y", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("vx", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("vy", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("dr", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("txPower", LoraOutputColumn::INT32));
+  return columns;
+}
+
+// The kinds of rows of the files written by EnableDeviceStatusChangePrinting
+enum DeviceStatusChangeKind
+{
+  KEYFRAME = 0,
+  TRANSMISSION_PARAMETERS = 1,
+  COURSE_CHANGE = 2
+};
+
+// The columns of the files written by EnableBanditTelemetry
+std::vector<LoraOutputColumn>
+BanditTelemetryColumns (void)
+{
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE, "%.10g"));
+  columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("event", LoraOutputColumn::UINT8));
+  columns.push_back (LoraOutputColumn ("arm", LoraOutputColumn::UINT8));
+  columns.push_back (LoraOutputColumn ("value0", LoraOutputColumn::FLOAT));
+  columns.push_back (LoraOutputColumn ("value1", LoraOutputColumn::FLOAT));
+  columns.push_back (LoraOutputColumn ("value2", LoraOutputColumn::FLOAT));
+  return columns;
+}
+
+// The events of the files written by EnableBanditTelemetry
+enum BanditTelemetryEvent
+{
+  ARM_CHOSEN = 0,
+  FEEDBACK_REQUESTED = 1,
+  REWARDS_CONSOLIDATED = 2,
+  ARM_POSTERIOR = 3
+};
+
+} // namespace
 
   LoraHelper::LoraHelper () :
     m_lastPhyPerformanceUpdate (Seconds (0)),
-    m_lastGlobalPerformanceUpdate (Seconds (0))
+    m_lastGlobalPerformanceUpdate (Seconds (0)),
+    m_outputFormat (LoraOutputWriter::TEXT),
+    m_outputBackgroundThread (false)
   {
   }
 
@@ -172,6 +247,132 @@ LoraHelper::GetPacketTracker (void)
   return *m_packetTracker;
 }
 
+void
+LoraHelper::SetOutputFormat (LoraOutputWriter::Format format)
+{
+  NS_LOG_FUNCTION (this << format);
+
+  m_outputFormat = format;
+}
+
+void
+LoraHelper::SetOutputBackgroundThread (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+
+  m_outputBackgroundThread = enable;
+}
+
+Ptr<LoraOutputWriter>
+LoraHelper::GetOutputWriter (std::string filename,
+                             const std::vector<LoraOutputColumn> &columns)
+{
+  return GetOutputWriter (filename, columns, m_outputFormat);
+}
+
+Ptr<LoraOutputWriter>
+LoraHelper::GetOutputWriter (std::string filename,
+                             const std::vector<LoraOutputColumn> &columns,
+                             LoraOutputWriter::Format format)
+{
+  Ptr<LoraOutputWriter> &writer = m_outputWriters[filename];
+  if (writer == 0 || !writer->IsOpen ())
+    {
+      // Only append to the file if it is opened during the simulation
+      writer = Create<LoraOutputWriter> (filename,
+                                         LoraOutputWriter::CreateEncoder (format),
+                                         columns,
+                                         Simulator::Now () != Seconds (0),
+                                         m_outputBackgroundThread);
+      Simulator::ScheduleDestroy (&LoraOutputWriter::Close, writer);
+    }
+  return writer;
+}
+
+bool
+LoraHelper::WriteTopologySnapshot (std::string filename,
+                                   NodeContainer endDevices,
+                                   NodeContainer gateways,
+                                   Ptr<LoraChannel> channel) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  return LoraTopologySnapshot::Write (filename, endDevices, gateways, channel);
+}
+
+Ptr<LoraTopologySnapshot>
+LoraHelper::LoadTopologySnapshot (std::string filename,
+                                  NodeContainer endDevices,
+                                  NodeContainer gateways) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Ptr<LoraTopologySnapshot> snapshot = Create<LoraTopologySnapshot> (filename);
+  if (!snapshot->IsValid ())
+    {
+      return 0;
+    }
+  if (snapshot->GetNEndDevices () != endDevices.GetN ()
+      || snapshot->GetNGateways () != gateways.GetN ())
+    {
+      NS_LOG_WARN ("Snapshot " << filename << " has " <<
+                   snapshot->GetNEndDevices () << " end devices and " <<
+                   snapshot->GetNGateways () << " gateways instead of " <<
+                   endDevices.GetN () << " and " << gateways.GetN ());
+      return 0;
+    }
+
+  // Positions
+  for (uint32_t i = 0; i < gateways.GetN (); i++)
+    {
+      SetSnapshotPosition (gateways.Get (i), snapshot->GetGatewayPosition (i));
+    }
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      SetSnapshotPosition (endDevices.Get (i), snapshot->GetEndDevicePosition (i));
+    }
+
+  // Buildings
+  if (BuildingList::GetNBuildings () == 0)
+    {
+      snapshot->CreateBuildings ();
+    }
+
+  // Data rates of the end devices that already have a MAC
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<Node> node = endDevices.Get (i);
+      uint8_t dataRate = snapshot->GetDataRate (i);
+      if (dataRate == LoraTopologySnapshot::NO_DATA_RATE || node->GetNDevices () == 0)
+        {
+          continue;
+        }
+      Ptr<LoraNetDevice> device = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+      if (device != 0 && device->GetMac () != 0)
+        {
+          Ptr<EndDeviceLorawanMac> mac = device->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+          if (mac != 0)
+            {
+              mac->SetDataRate (dataRate);
+            }
+        }
+    }
+
+  return snapshot;
+}
+
+void
+LoraHelper::SetSnapshotPosition (Ptr<Node> node, Vector position) const
+{
+  Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+  if (mobility == 0)
+    {
+      mobility = CreateObject<ConstantPositionMobilityModel> ();
+      node->AggregateObject (mobility);
+    }
+  mobility->SetPosition (position);
+}
+
 void
 LoraHelper::EnableSimulationTimePrinting (Time interval)
 {
@@ -200,18 +401,8 @@ void
 LoraHelper::DoPrintDeviceStatus (NodeContainer endDevices, NodeContainer gateways,
                                  std::string filename)
 {
-  const char * c = filename.c_str ();
-  std::ofstream outputFile;
-  if (Simulator::Now () == Seconds (0))
-    {
-      // Delete contents of the file as it is opened
-      outputFile.open (c, std::ofstream::out | std::ofstream::trunc);
-    }
-  else
-    {
-      // Only append to the file
-      outputFile.open (c, std::ofstream::out | std::ofstream::app);
-    }
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename,
+                                                        DeviceStatusColumns ());
 
   Time currentTime = Simulator::Now();
   for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
@@ -226,10 +417,13 @@ LoraHelper::DoPrintDeviceStatus (NodeContainer endDevices, NodeContainer gateway
       int dr = int(mac->GetDataRate ());
       double txPower = mac->GetTransmissionPower ();
       Vector pos = position->GetPosition ();
-      outputFile << currentTime.GetSeconds () << " "
-                 << object->GetId () <<  " "
-                 << pos.x << " " << pos.y << " " << dr << " "
-                 << unsigned(txPower) << std::endl;
+      outputWriter->Add (currentTime.GetSeconds ());
+      outputWriter->Add (object->GetId ());
+      outputWriter->Add (pos.x);
+      outputWriter->Add (pos.y);
+      outputWriter->Add (dr);
+      outputWriter->Add (unsigned(txPower));
+      outputWriter->EndRow ();
     }
 
 // [renzo] Here we can print the info for the gateways, but I disabled for having only Nodes in this file
@@ -242,24 +436,13 @@ LoraHelper::DoPrintDeviceStatus (NodeContainer endDevices, NodeContainer gateway
 //                  << object->GetId () <<  " "
 //                  << pos.x << " " << pos.y << " " << "-1 -1" << std::endl;
 //     }
-  outputFile.close ();
 }
 
 void
 LoraHelper::DoPrintDeviceStatus (NodeContainer gateways, std::string filename)
 {
-  const char * c = filename.c_str ();
-  std::ofstream outputFile;
-  if (Simulator::Now () == Seconds (0))
-    {
-      // Delete contents of the file as it is opened
-      outputFile.open (c, std::ofstream::out | std::ofstream::trunc);
-    }
-  else
-    {
-      // Only append to the file
-      outputFile.open (c, std::ofstream::out | std::ofstream::app);
-    }
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename,
+                                                        DeviceStatusColumns ());
 
   Time currentTime = Simulator::Now();
   // [renzo] Here we can print the info for the nodes (we use it for gateways..)
@@ -268,14 +451,198 @@ LoraHelper::DoPrintDeviceStatus (NodeContainer gateways, std::string filename)
        Ptr<Node> object = *j;
        Ptr<MobilityModel> position = object->GetObject<MobilityModel> ();
        Vector pos = position->GetPosition ();
-       outputFile << currentTime.GetSeconds () << " "
-                  << object->GetId () <<  " "
-                  << pos.x << " " << pos.y << " " << "-1 -1" << std::endl;
+       outputWriter->Add (currentTime.GetSeconds ());
+       outputWriter->Add (object->GetId ());
+       outputWriter->Add (pos.x);
+       outputWriter->Add (pos.y);
+       outputWriter->Add (-1);
+       outputWriter->Add (-1);
+       outputWriter->EndRow ();
      }
-  outputFile.close ();
 }
 
 
+void
+LoraHelper::EnableDeviceStatusChangePrinting (NodeContainer endDevices,
+                                              std::string filename,
+                                              Time keyframeInterval)
+{
+  NS_LOG_FUNCTION (this << filename << keyframeInterval);
+
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename,
+                                                        DeviceStatusChangeColumns ());
+
+  // The node id is bound instead of the node, which holds the trace sources
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<Node> object = *j;
+      Ptr<MobilityModel> position = object->GetObject<MobilityModel> ();
+      NS_ASSERT (position != 0);
+      Ptr<LoraNetDevice> loraNetDevice = object->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      loraNetDevice->GetMac ()->TraceConnectWithoutContext
+        ("TransmissionParameters",
+        MakeBoundCallback (&LoraHelper::TransmissionParametersChangeCallback, outputWriter,
+                           object->GetId ()));
+      position->TraceConnectWithoutContext
+        ("CourseChange",
+        MakeBoundCallback (&LoraHelper::CourseChangeCallback, outputWriter,
+                           object->GetId ()));
+    }
+
+  DoPrintDeviceStatusKeyframe (endDevices, filename, keyframeInterval);
+}
+
+void
+LoraHelper::DoPrintDeviceStatusKeyframe (NodeContainer endDevices, std::string filename,
+                                         Time keyframeInterval)
+{
+  NS_LOG_FUNCTION (this << filename << keyframeInterval);
+
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename,
+                                                        DeviceStatusChangeColumns ());
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<Node> object = *j;
+      Ptr<EndDeviceLorawanMac> mac = object->GetDevice (0)->GetObject<LoraNetDevice> ()
+        ->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+      DoPrintDeviceStatusChange (outputWriter, object->GetId (), KEYFRAME,
+                                 mac->GetDataRate (), mac->GetTransmissionPower ());
+    }
+
+  if (!keyframeInterval.IsZero ())
+    {
+      Simulator::Schedule (keyframeInterval, &LoraHelper::DoPrintDeviceStatusKeyframe,
+                           this, endDevices, filename, keyframeInterval);
+    }
+}
+
+void
+LoraHelper::DoPrintDeviceStatusChange (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                       uint32_t kind, uint8_t dataRate, double txPower)
+{
+  Ptr<MobilityModel> position = NodeList::GetNode (nodeId)->GetObject<MobilityModel> ();
+  Vector pos = position->GetPosition ();
+  Vector velocity = position->GetVelocity ();
+  outputWriter->Add (Simulator::Now ().GetSeconds ());
+  outputWriter->Add (nodeId);
+  outputWriter->Add (kind);
+  outputWriter->Add (pos.x);
+  outputWriter->Add (pos.y);
+  outputWriter->Add (velocity.x);
+  outputWriter->Add (velocity.y);
+  outputWriter->Add (dataRate);
+  outputWriter->Add (unsigned(txPower));
+  outputWriter->EndRow ();
+}
+
+void
+LoraHelper::TransmissionParametersChangeCallback (Ptr<LoraOutputWriter> outputWriter,
+                                                  uint32_t nodeId, uint8_t dataRate,
+                                                  double txPower)
+{
+  DoPrintDeviceStatusChange (outputWriter, nodeId, TRANSMISSION_PARAMETERS, dataRate,
+                             txPower);
+}
+
+void
+LoraHelper::CourseChangeCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                  Ptr<const MobilityModel> mobility)
+{
+  Ptr<EndDeviceLorawanMac> mac = NodeList::GetNode (nodeId)->GetDevice (0)
+    ->GetObject<LoraNetDevice> ()->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+  DoPrintDeviceStatusChange (outputWriter, nodeId, COURSE_CHANGE, mac->GetDataRate (),
+                             mac->GetTransmissionPower ());
+}
+
+void
+LoraHelper::EnableBanditTelemetry (NodeContainer endDevices, std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename, BanditTelemetryColumns (),
+                                                        LoraOutputWriter::BINARY);
+
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<Node> object = *j;
+      Ptr<LoraNetDevice> loraNetDevice = object->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<ClassAEndDeviceLorawanMacBandit> mac =
+        DynamicCast<ClassAEndDeviceLorawanMacBandit> (loraNetDevice->GetMac ());
+      if (mac == 0)
+        {
+          continue;
+        }
+      uint32_t nodeId = object->GetId ();
+      mac->TraceConnectWithoutContext
+        ("ArmChosen",
+        MakeBoundCallback (&LoraHelper::BanditArmChosenCallback, outputWriter, nodeId));
+      mac->TraceConnectWithoutContext
+        ("FeedbackRequested",
+        MakeBoundCallback (&LoraHelper::BanditFeedbackRequestedCallback, outputWriter,
+                           nodeId));
+      mac->TraceConnectWithoutContext
+        ("RewardsConsolidated",
+        MakeBoundCallback (&LoraHelper::BanditRewardsConsolidatedCallback, outputWriter,
+                           nodeId));
+      mac->TraceConnectWithoutContext
+        ("ArmPosterior",
+        MakeBoundCallback (&LoraHelper::BanditArmPosteriorCallback, outputWriter, nodeId));
+    }
+}
+
+void
+LoraHelper::DoPrintBanditTelemetry (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                    uint8_t event, uint8_t arm, double value0,
+                                    double value1, double value2)
+{
+  outputWriter->Add (Simulator::Now ().GetSeconds ());
+  outputWriter->Add (nodeId);
+  outputWriter->Add (event);
+  outputWriter->Add (arm);
+  outputWriter->Add (value0);
+  outputWriter->Add (value1);
+  outputWriter->Add (value2);
+  outputWriter->EndRow ();
+}
+
+void
+LoraHelper::BanditArmChosenCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                     uint8_t arm, uint16_t frameCounter)
+{
+  DoPrintBanditTelemetry (outputWriter, nodeId, ARM_CHOSEN, arm, frameCounter, 0, 0);
+}
+
+void
+LoraHelper::BanditFeedbackRequestedCallback (Ptr<LoraOutputWriter> outputWriter,
+                                             uint32_t nodeId, uint16_t frameCountMax,
+                                             uint8_t frameCountDeltaMin)
+{
+  // The request is added to the packet whose arm was just chosen
+  Ptr<EndDeviceLorawanMac> mac = NodeList::GetNode (nodeId)->GetDevice (0)
+    ->GetObject<LoraNetDevice> ()->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+  DoPrintBanditTelemetry (outputWriter, nodeId, FEEDBACK_REQUESTED, mac->GetDataRate (),
+                          frameCountMax, frameCountDeltaMin, 0);
+}
+
+void
+LoraHelper::BanditRewardsConsolidatedCallback (Ptr<LoraOutputWriter> outputWriter,
+                                               uint32_t nodeId, uint8_t arm, uint32_t sent,
+                                               uint32_t received, double reward)
+{
+  DoPrintBanditTelemetry (outputWriter, nodeId, REWARDS_CONSOLIDATED, arm, sent, received,
+                          reward);
+}
+
+void
+LoraHelper::BanditArmPosteriorCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                        uint8_t arm, uint32_t pulls, double mean,
+                                        double std)
+{
+  DoPrintBanditTelemetry (outputWriter, nodeId, ARM_POSTERIOR, arm, mean, std, pulls);
+}
+
 void
 LoraHelper::EnablePeriodicPhyPerformancePrinting (NodeContainer gateways,
                                                   std::string filename,
@@ -297,32 +664,34 @@ LoraHelper::DoPrintPhyPerformance (NodeContainer gateways,
 {
   NS_LOG_FUNCTION (this);
 
-  const char * c = filename.c_str ();
-  std::ofstream outputFile;
-  if (Simulator::Now () == Seconds (0))
-    {
-      // Delete contents of the file as it is opened
-      outputFile.open (c, std::ofstream::out | std::ofstream::trunc);
-    }
-  else
-    {
-      // Only append to the file
-      outputFile.open (c, std::ofstream::out | std::ofstream::app);
-    }
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("gwId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("sent", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("received", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("interfered", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("noMoreReceivers", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("underSensitivity", LoraOutputColumn::INT32));
+  columns.push_back (LoraOutputColumn ("lostBecauseTx", LoraOutputColumn::INT32));
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename, columns);
 
   for (auto it = gateways.Begin (); it != gateways.End (); ++it)
     {
       int systemId = (*it)->GetId ();
-      outputFile << Simulator::Now ().GetSeconds () << " " <<
-        std::to_string(systemId) << " " <<
-        m_packetTracker->PrintPhyPacketsPerGw(m_lastPhyPerformanceUpdate,
-                                              Simulator::Now (),
-                                              systemId) << std::endl;
+      std::vector<int> packetCounts =
+        m_packetTracker->CountPhyPacketsPerGw (m_lastPhyPerformanceUpdate,
+                                               Simulator::Now (),
+                                               systemId);
+      outputWriter->Add (Simulator::Now ().GetSeconds ());
+      outputWriter->Add (systemId);
+      for (int count : packetCounts)
+        {
+          outputWriter->Add (count);
+        }
+      outputWriter->EndRow ();
     }
 
   m_lastPhyPerformanceUpdate = Simulator::Now ();
-
-  outputFile.close();
 }
 
 void
@@ -344,27 +713,22 @@ LoraHelper::DoPrintGlobalPerformance (std::string filename)
 {
   NS_LOG_FUNCTION (this);
 
-  const char * c = filename.c_str ();
-  std::ofstream outputFile;
-  if (Simulator::Now () == Seconds (0))
-    {
-      // Delete contents of the file as it is opened
-      outputFile.open (c, std::ofstream::out | std::ofstream::trunc);
-    }
-  else
-    {
-      // Only append to the file
-      outputFile.open (c, std::ofstream::out | std::ofstream::app);
-    }
-
-  outputFile << Simulator::Now ().GetSeconds () << " " <<
-    m_packetTracker->CountMacPacketsGlobally (m_lastGlobalPerformanceUpdate,
-                                              Simulator::Now ()) <<
-    std::endl;
+  // The counts are printed as %f, as CountMacPacketsGlobally does
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("sent", LoraOutputColumn::UINT32, "%f"));
+  columns.push_back (LoraOutputColumn ("received", LoraOutputColumn::UINT32, "%f"));
+  Ptr<LoraOutputWriter> outputWriter = GetOutputWriter (filename, columns);
+
+  std::vector<int> packetCounts =
+    m_packetTracker->CountMacPacketsGloballyValues (m_lastGlobalPerformanceUpdate,
+                                                    Simulator::Now ());
+  outputWriter->Add (Simulator::Now ().GetSeconds ());
+  outputWriter->Add (packetCounts.at (0));
+  outputWriter->Add (packetCounts.at (1));
+  outputWriter->EndRow ();
 
   m_lastGlobalPerformanceUpdate = Simulator::Now ();
-
-  outputFile.close();
 }
 
 void
@@ -396,14 +760,13 @@ LoraHelper::DoPrintSimulationTime (Time interval)
  *   TODO: create this new Tag made to contain the metadata needed for "LoratapPcapHeader", and populate in the trace sources of the devices.
  * */
 /**
- * @brief Write a packet in a PCAP file
- * @param file the output file
+ * @brief Add the loratap header to a copy of a packet sent by a PHY
  * @param packet the packet
  * @param (TODO: metadata from the packet)
+ * @return the packet to write in a PCAP file
  */
-static void
-PcapSniffLoRaTx(
-		Ptr<PcapFileWrapper> file,
+static Ptr<Packet>
+MakeLoRaTxPcapPacket(
 		Ptr<const Packet> packet,
 		double m_frequency, /* LoRa frequency (Hz) */
 		uint8_t m_sf, /* LoRa SF (sf_t) [7, 8, 9, 10, 11, 12] */
@@ -427,12 +790,17 @@ PcapSniffLoRaTx(
     loratapHeader.SetMSnr(m_snr);
 
     packetCopy -> AddHeader (loratapHeader);
-	file->Write (Simulator::Now (), packetCopy);
+    return packetCopy;
 }
 
 
-static void
-PcapSniffLoRaRx(Ptr<PcapFileWrapper> file,	Ptr<const Packet> packet)
+/**
+ * @brief Add the loratap header to a copy of a received packet
+ * @param packet the packet
+ * @return the packet to write in a PCAP file
+ */
+static Ptr<Packet>
+MakeLoRaRxPcapPacket(Ptr<const Packet> packet)
 {
     Ptr<Packet> packetCopy = packet -> Copy ();
 
@@ -444,7 +812,124 @@ PcapSniffLoRaRx(Ptr<PcapFileWrapper> file,	Ptr<const Packet> packet)
 
     // This "FillHeader" is not enough because LoraTag does not have all the information, for not I manually set what is missing:
     packetCopy -> AddHeader (loratapHeader);
-	file->Write (Simulator::Now (), packetCopy);
+    return packetCopy;
+}
+
+
+/**
+ * @brief Write a packet in a PCAP file
+ * @param file the output file
+ * @param packet the packet
+ * @param (TODO: metadata from the packet)
+ */
+static void
+PcapSniffLoRaTx(
+		Ptr<PcapFileWrapper> file,
+		Ptr<const Packet> packet,
+		double m_frequency, /* LoRa frequency (Hz) */
+		uint8_t m_sf, /* LoRa SF (sf_t) [7, 8, 9, 10, 11, 12] */
+		double m_packet_rssi, /* LoRa packet RSSI,*/
+		int m_snr /* LoRa SNR*/
+		)
+{
+	file->Write (Simulator::Now (), MakeLoRaTxPcapPacket (packet, m_frequency, m_sf, m_packet_rssi, m_snr));
+}
+
+
+static void
+PcapSniffLoRaRx(Ptr<PcapFileWrapper> file,	Ptr<const Packet> packet)
+{
+	file->Write (Simulator::Now (), MakeLoRaRxPcapPacket (packet));
+}
+
+
+/**
+ * @brief Write a packet sent by a PHY in a shared capture
+ */
+static void
+PcapCaptureLoRaTx (Ptr<LoraPcapCapture> capture, Ptr<const Packet> packet,
+                   double frequency, uint8_t sf, double packetRssi, int snr)
+{
+  capture->Write (MakeLoRaTxPcapPacket (packet, frequency, sf, packetRssi, snr));
+}
+
+/**
+ * @brief Write a received packet in a shared capture
+ */
+static void
+PcapCaptureLoRaRx (Ptr<LoraPcapCapture> capture, Ptr<const Packet> packet)
+{
+  capture->Write (MakeLoRaRxPcapPacket (packet));
+}
+
+/**
+ * @brief Count a reception lost by a transmitting gateway towards a trigger
+ * of a capture
+ */
+static void
+PcapCaptureTrigger (Ptr<LoraPcapCapture> capture, Ptr<const Packet> packet,
+                    uint32_t nodeId)
+{
+  capture->NotifyTriggerEvent ();
+}
+
+Ptr<LoraPcapCapture>
+LoraHelper::EnablePcapCapture (std::string prefix, NodeContainer nodes, bool promiscuous)
+{
+  NS_LOG_FUNCTION (this << prefix << promiscuous);
+
+  Ptr<LoraPcapCapture> capture = CreateObject<LoraPcapCapture> ();
+  capture->SetPrefix (prefix);
+  Simulator::ScheduleDestroy (&LoraPcapCapture::Close, capture);
+
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); j++)
+        {
+          Ptr<LoraNetDevice> device = DynamicCast<LoraNetDevice> ((*i)->GetDevice (j));
+          if (device == 0)
+            {
+              continue;
+            }
+
+          // The same trace sources as EnablePcapInternal
+          Ptr<LoraPhy> phy = device->GetPhy ();
+          phy->TraceConnectWithoutContext ("SnifferTx",
+                                           MakeBoundCallback (&PcapCaptureLoRaTx, capture));
+          if (promiscuous)
+            {
+              phy->TraceConnectWithoutContext ("SnifferRx",
+                                               MakeBoundCallback (&PcapCaptureLoRaRx, capture));
+            }
+          else
+            {
+              device->GetMac ()->TraceConnectWithoutContext
+                ("SnifferRx", MakeBoundCallback (&PcapCaptureLoRaRx, capture));
+            }
+        }
+    }
+
+  return capture;
+}
+
+void
+LoraHelper::EnablePcapCaptureTrigger (Ptr<LoraPcapCapture> capture, NodeContainer gateways)
+{
+  NS_LOG_FUNCTION (this << capture);
+
+  for (NodeContainer::Iterator i = gateways.Begin (); i != gateways.End (); ++i)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); j++)
+        {
+          Ptr<LoraNetDevice> device = DynamicCast<LoraNetDevice> ((*i)->GetDevice (j));
+          if (device != 0 && DynamicCast<GatewayLoraPhy> (device->GetPhy ()) != 0)
+            {
+              device->GetPhy ()->TraceConnectWithoutContext
+                ("NoReceptionBecauseTransmitting",
+                MakeBoundCallback (&PcapCaptureTrigger, capture));
+            }
+        }
+    }
 }
 
 
@@ -26,11 +26,16 @@
 #include "ns3/node-container.h"
 #include "ns3/net-device-container.h"
 #include "ns3/net-device.h"
+#include "ns3/mobility-model.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-packet-tracker.h"
+#include "ns3/lora-topology-snapshot.h"
+#include "ns3/lora-output-writer.h"
+#include "ns3/lora-pcap-capture.h"
 #include "ns3/trace-helper.h"
 
 #include <ctime>
+#include <map>
 
 namespace ns3 {
 namespace lorawan {
@@ -95,6 +100,38 @@ public:
                                            std::string filename,
                                            Time interval);
 
+  /**
+   * Print the status of the end devices to a file only when it changes.
+   *
+   * A full snapshot (a keyframe) of all end devices is printed now and then
+   * every keyframeInterval (only now if it is zero). In between, a row is
+   * printed for an end device whenever its data rate or transmission power
+   * changes (the TransmissionParameters trace source of its MAC) or its
+   * mobility model changes course (the CourseChange trace source). Rows hold
+   * the time, the node id, the kind of row (0 for keyframes, 1 for
+   * transmission parameters, 2 for course changes), the position, the
+   * velocity, the data rate and the transmission power, so that the periodic
+   * status can be rebuilt by lorawan-device-status-reader.py.
+   */
+  void EnableDeviceStatusChangePrinting (NodeContainer endDevices,
+                                         std::string filename,
+                                         Time keyframeInterval);
+
+  /**
+   * Write the learning of the bandits of the end devices to a file, in the
+   * binary format of LoraOutputWriter whatever the output format.
+   *
+   * A row is written for each event of the trace sources of
+   * ClassAEndDeviceLorawanMacBandit, with the time, the node id, the event
+   * (0 for ArmChosen, 1 for FeedbackRequested, 2 for RewardsConsolidated, 3
+   * for ArmPosterior), the arm and three values: the frame counter for
+   * ArmChosen, the frames covered for FeedbackRequested, the packets sent
+   * and received and the reward of a reception for RewardsConsolidated, and
+   * the mean reward, its standard error and the pulls for ArmPosterior.
+   * Each row takes 26 bytes. End devices that are not bandits are skipped.
+   */
+  void EnableBanditTelemetry (NodeContainer endDevices, std::string filename);
+
   /**
    * Periodically prints PHY-level performance at every gateway in the container.
    */
@@ -114,6 +151,19 @@ public:
 
   LoraPacketTracker& GetPacketTracker (void);
 
+  /**
+   * Set the format of the files written by the Print functions (TEXT by
+   * default). It only applies to the files that are not open yet.
+   */
+  void SetOutputFormat (LoraOutputWriter::Format format);
+
+  /**
+   * Set whether the files written by the Print functions are written by a
+   * background thread (false by default). It only applies to the files that
+   * are not open yet.
+   */
+  void SetOutputBackgroundThread (bool enable);
+
   LoraPacketTracker* m_packetTracker = 0;
 
   time_t m_oldtime;
@@ -129,17 +179,146 @@ public:
    */
   void DoPrintDeviceStatus (NodeContainer gateways, std::string filename);
 
+  /**
+   * Capture the packets sent and received by the devices of some nodes,
+   * e.g., a few gateways of interest, in a loratap pcap capture shared by
+   * all of them. The same packets are captured as with EnablePcap, but the
+   * attributes of the returned capture can bound its disk usage with file
+   * rotation, truncate packets, or keep the packets in memory until a
+   * trigger. They can be set until the first packet is captured.
+   *
+   * \param prefix The prefix of the names of the files.
+   * \param nodes The nodes whose LoraNetDevices are captured.
+   * \param promiscuous Whether to capture all packets received by the PHYs,
+   * rather than the ones passed up by the MACs.
+   * \return The capture, which is closed when the simulator is destroyed.
+   */
+  Ptr<LoraPcapCapture> EnablePcapCapture (std::string prefix, NodeContainer nodes,
+                                          bool promiscuous = true);
+
+  /**
+   * Count the receptions lost because a gateway was transmitting towards the
+   * trigger of a capture, so that a burst of them dumps its ring buffer.
+   *
+   * \param capture The capture, with a RingDuration.
+   * \param gateways The gateways whose lost receptions are counted.
+   */
+  void EnablePcapCaptureTrigger (Ptr<LoraPcapCapture> capture, NodeContainer gateways);
+
+  /**
+   * Write a binary snapshot of the topology, which LoadTopologySnapshot can
+   * read back: the positions of the nodes, all buildings, the data rates of
+   * the end devices and, if channel is not 0, the path loss from each end
+   * device to each gateway.
+   *
+   * \return Whether the file could be written.
+   */
+  bool WriteTopologySnapshot (std::string filename, NodeContainer endDevices,
+                              NodeContainer gateways,
+                              Ptr<LoraChannel> channel = 0) const;
+
+  /**
+   * Load a topology snapshot written by WriteTopologySnapshot.
+   *
+   * The positions of the nodes are set (a ConstantPositionMobilityModel is
+   * aggregated to the nodes that have no mobility model), the buildings are
+   * created unless some already exist, and the data rates of the end devices
+   * that already have a MAC are set. The path losses can then be used with
+   * LorawanMacHelper::SetSpreadingFactorsUp.
+   *
+   * \return The snapshot, which stays mapped in memory as long as it is
+   * referenced, or 0 if the file cannot be loaded or does not match the
+   * number of nodes.
+   */
+  Ptr<LoraTopologySnapshot> LoadTopologySnapshot (std::string filename,
+                                                  NodeContainer endDevices,
+                                                  NodeContainer gateways) const;
+
 private:
+  /**
+   * Set the position of a node loaded from a snapshot.
+   */
+  void SetSnapshotPosition (Ptr<Node> node, Vector position) const;
+
   /**
    * Actually print the simulation time and re-schedule execution of this
    * function.
    */
   void DoPrintSimulationTime (Time interval);
+
+  /**
+   * Print a keyframe of the status of the end devices and re-schedule
+   * execution of this function, if the interval is not zero.
+   */
+  void DoPrintDeviceStatusKeyframe (NodeContainer endDevices, std::string filename,
+                                    Time keyframeInterval);
+
+  /**
+   * Print a row of the status of an end device, with the given data rate
+   * and transmission power.
+   */
+  static void DoPrintDeviceStatusChange (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                         uint32_t kind, uint8_t dataRate, double txPower);
+
+  /**
+   * Print a row when the transmission parameters of an end device change.
+   */
+  static void TransmissionParametersChangeCallback (Ptr<LoraOutputWriter> outputWriter,
+                                                    uint32_t nodeId, uint8_t dataRate,
+                                                    double txPower);
+
+  /**
+   * Print a row when the mobility model of an end device changes course.
+   */
+  static void CourseChangeCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                    Ptr<const MobilityModel> mobility);
   
+  /**
+   * Print a row of the learning of a bandit end device.
+   */
+  static void DoPrintBanditTelemetry (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                      uint8_t event, uint8_t arm, double value0,
+                                      double value1, double value2);
+
+  static void BanditArmChosenCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                       uint8_t arm, uint16_t frameCounter);
+
+  static void BanditFeedbackRequestedCallback (Ptr<LoraOutputWriter> outputWriter,
+                                               uint32_t nodeId, uint16_t frameCountMax,
+                                               uint8_t frameCountDeltaMin);
+
+  static void BanditRewardsConsolidatedCallback (Ptr<LoraOutputWriter> outputWriter,
+                                                 uint32_t nodeId, uint8_t arm, uint32_t sent,
+                                                 uint32_t received, double reward);
+
+  static void BanditArmPosteriorCallback (Ptr<LoraOutputWriter> outputWriter, uint32_t nodeId,
+                                          uint8_t arm, uint32_t pulls, double mean,
+                                          double std);
+
   virtual void EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename);
 
+  /**
+   * Get the writer of a file, opening it the first time. The file is
+   * replaced if it is opened at the beginning of the simulation, and
+   * appended to otherwise. It is closed when the simulator is destroyed.
+   */
+  Ptr<LoraOutputWriter> GetOutputWriter (std::string filename,
+                                         const std::vector<LoraOutputColumn> &columns);
+
+  /**
+   * Get the writer of a file in a given format, rather than in the output
+   * format of the helper.
+   */
+  Ptr<LoraOutputWriter> GetOutputWriter (std::string filename,
+                                         const std::vector<LoraOutputColumn> &columns,
+                                         LoraOutputWriter::Format format);
+
   Time m_lastPhyPerformanceUpdate;
   Time m_lastGlobalPerformanceUpdate;
+
+  std::map<std::string, Ptr<LoraOutputWriter> > m_outputWriters;
+  LoraOutputWriter::Format m_outputFormat;
+  bool m_outputBackgroundThread;
 };
 
 } //namespace ns3
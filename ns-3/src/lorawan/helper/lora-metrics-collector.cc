@@ -0,0 +1,316 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lora-metrics-collector.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/simulator.h"
+#include "ns3/lora-log.h"
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraMetricsCollector");
+
+namespace {
+
+// Time on air of a 32 bytes packet at each data rate, in ms
+const double timeOnAir32Bytes[] = {1810.43, 987.14, 452.61, 246.78, 133.63, 71.94};
+
+Ptr<LorawanMac>
+GetMac (Ptr<Node> node)
+{
+  Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+  NS_ASSERT (loraNetDevice != 0);
+  return loraNetDevice->GetMac ();
+}
+
+} // namespace
+
+LoraMetricsCollector::LoraMetricsCollector ()
+  : m_period (Seconds (1200)),
+    m_windowPeriods (10),
+    m_periods (0)
+{
+}
+
+LoraMetricsCollector::~LoraMetricsCollector ()
+{
+}
+
+void
+LoraMetricsCollector::SetPeriod (Time period)
+{
+  NS_LOG_FUNCTION (this << period);
+  NS_ASSERT (period.IsStrictlyPositive ());
+
+  m_period = period;
+}
+
+void
+LoraMetricsCollector::SetWindowPeriods (uint32_t periods)
+{
+  NS_LOG_FUNCTION (this << periods);
+  NS_ASSERT (periods > 0);
+  NS_ASSERT_MSG (m_deviceIds.empty (), "The window must be set before Install");
+
+  m_windowPeriods = periods;
+}
+
+void
+LoraMetricsCollector::Install (NodeContainer endDevices, NodeContainer gateways)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      uint32_t device = m_deviceIds.size ();
+      m_deviceIds.push_back ((*j)->GetId ());
+
+      Ptr<EndDeviceLorawanMac> mac = GetMac (*j)->GetObject<EndDeviceLorawanMac> ();
+      NS_ASSERT (mac != 0);
+      m_deviceEnergy.push_back (GetTransmissionEnergy (mac->GetDataRate (),
+                                                       mac->GetTransmissionPower ()));
+      mac->TraceConnectWithoutContext
+        ("SentNewPacket",
+        MakeBoundCallback (&LoraMetricsCollector::SentNewPacketCallback, this, device));
+      mac->TraceConnectWithoutContext
+        ("TransmissionParameters",
+        MakeBoundCallback (&LoraMetricsCollector::TransmissionParametersCallback, this,
+                           device));
+    }
+
+  for (NodeContainer::Iterator j = gateways.Begin (); j != gateways.End (); ++j)
+    {
+      GetMac (*j)->TraceConnectWithoutContext
+        ("ReceivedPacket",
+        MakeCallback (&LoraMetricsCollector::GatewayReceptionCallback, this));
+    }
+
+  uint32_t nDevices = m_deviceIds.size ();
+  m_sent.assign (nDevices, 0);
+  m_received.assign (nDevices, 0);
+  m_windowSent.assign (nDevices * m_windowPeriods, 0);
+  m_windowReceived.assign (nDevices * m_windowPeriods, 0);
+  m_windowEnergy.assign (nDevices * m_windowPeriods, 0);
+
+  Simulator::Schedule (m_period, &LoraMetricsCollector::EndPeriod, this);
+}
+
+const std::deque<LoraMetricsCollector::PeriodMetrics> &
+LoraMetricsCollector::GetWindow (void) const
+{
+  return m_window;
+}
+
+LoraMetricsCollector::Statistics
+LoraMetricsCollector::GetPdr (void) const
+{
+  std::vector<double> values;
+  for (const PeriodMetrics &metrics : m_window)
+    {
+      values.push_back (metrics.sent ? double (metrics.received) / metrics.sent
+                        : std::numeric_limits<double>::quiet_NaN ());
+    }
+  return ComputeStatistics (values);
+}
+
+LoraMetricsCollector::Statistics
+LoraMetricsCollector::GetJoules (void) const
+{
+  std::vector<double> values;
+  for (const PeriodMetrics &metrics : m_window)
+    {
+      values.push_back (metrics.joules);
+    }
+  return ComputeStatistics (values);
+}
+
+LoraMetricsCollector::Statistics
+LoraMetricsCollector::GetUnec (void) const
+{
+  std::vector<double> values;
+  for (const PeriodMetrics &metrics : m_window)
+    {
+      values.push_back (metrics.received ? metrics.joules * 1000 / metrics.received
+                        : std::numeric_limits<double>::quiet_NaN ());
+    }
+  return ComputeStatistics (values);
+}
+
+void
+LoraMetricsCollector::WriteSummary (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ofstream outputFile (filename.c_str (), std::ofstream::out | std::ofstream::trunc);
+  Statistics pdr = GetPdr ();
+  Statistics joules = GetJoules ();
+  Statistics unec = GetUnec ();
+  outputFile << "pdr " << pdr.mean << " " << pdr.std << std::endl
+             << "joules " << joules.mean << " " << joules.std << std::endl
+             << "unecMilliJoules " << unec.mean << " " << unec.std << std::endl;
+}
+
+void
+LoraMetricsCollector::WriteDeviceSummary (std::string filename,
+                                          LoraOutputWriter::Format format) const
+{
+  NS_LOG_FUNCTION (this << filename << format);
+
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("sent", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("received", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("pdr", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("joules", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("unecMilliJoules", LoraOutputColumn::DOUBLE));
+  LoraOutputWriter outputWriter (filename, LoraOutputWriter::CreateEncoder (format), columns,
+                                 false, false);
+
+  for (uint32_t device = 0; device < m_deviceIds.size (); device++)
+    {
+      uint32_t sent = 0;
+      uint32_t received = 0;
+      double joules = 0;
+      for (uint32_t slot = 0; slot < m_windowPeriods; slot++)
+        {
+          sent += m_windowSent[device * m_windowPeriods + slot];
+          received += m_windowReceived[device * m_windowPeriods + slot];
+          joules += m_windowEnergy[device * m_windowPeriods + slot];
+        }
+      outputWriter.Add (m_deviceIds[device]);
+      outputWriter.Add (sent);
+      outputWriter.Add (received);
+      outputWriter.Add (sent ? double (received) / sent
+                        : std::numeric_limits<double>::quiet_NaN ());
+      outputWriter.Add (joules);
+      outputWriter.Add (received ? joules * 1000 / received
+                        : std::numeric_limits<double>::quiet_NaN ());
+      outputWriter.EndRow ();
+    }
+  outputWriter.Close ();
+}
+
+double
+LoraMetricsCollector::GetTransmissionEnergy (uint8_t dataRate, double txPower)
+{
+  NS_ASSERT (dataRate < sizeof (timeOnAir32Bytes) / sizeof (timeOnAir32Bytes[0]));
+
+  // mW times ms, to Joules (the scripts use the integer dBm of nodeData)
+  return std::pow (10, unsigned (txPower) / 10.0) * timeOnAir32Bytes[dataRate] / 1e6;
+}
+
+void
+LoraMetricsCollector::EndPeriod (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  PeriodMetrics metrics;
+  metrics.time = Simulator::Now ();
+  metrics.sent = 0;
+  metrics.received = 0;
+  metrics.joules = 0;
+
+  uint32_t slot = m_periods % m_windowPeriods;
+  for (uint32_t device = 0; device < m_deviceIds.size (); device++)
+    {
+      metrics.sent += m_sent[device];
+      metrics.received += m_received[device];
+      metrics.joules += m_deviceEnergy[device];
+
+      m_windowSent[device * m_windowPeriods + slot] = m_sent[device];
+      m_windowReceived[device * m_windowPeriods + slot] = m_received[device];
+      m_windowEnergy[device * m_windowPeriods + slot] = m_deviceEnergy[device];
+      m_sent[device] = 0;
+      m_received[device] = 0;
+    }
+  m_periods++;
+
+  m_window.push_back (metrics);
+  if (m_window.size () > m_windowPeriods)
+    {
+      m_window.pop_front ();
+    }
+
+  // Later receptions are not counted, as in the periodic global performance
+  m_pendingPackets.clear ();
+
+  Simulator::Schedule (m_period, &LoraMetricsCollector::EndPeriod, this);
+}
+
+void
+LoraMetricsCollector::SentNewPacketCallback (LoraMetricsCollector *collector, uint32_t device,
+                                             Ptr<Packet const> packet)
+{
+  collector->m_sent[device]++;
+  collector->m_pendingPackets[packet] = device;
+}
+
+void
+LoraMetricsCollector::GatewayReceptionCallback (Ptr<Packet const> packet)
+{
+  // Only the first reception of a packet of the current period counts
+  std::map<Ptr<Packet const>, uint32_t>::iterator it = m_pendingPackets.find (packet);
+  if (it != m_pendingPackets.end ())
+    {
+      m_received[it->second]++;
+      m_pendingPackets.erase (it);
+    }
+}
+
+void
+LoraMetricsCollector::TransmissionParametersCallback (LoraMetricsCollector *collector,
+                                                      uint32_t device, uint8_t dataRate,
+                                                      double txPower)
+{
+  collector->m_deviceEnergy[device] = GetTransmissionEnergy (dataRate, txPower);
+}
+
+LoraMetricsCollector::Statistics
+LoraMetricsCollector::ComputeStatistics (const std::vector<double> &values)
+{
+  double sum = 0;
+  uint32_t n = 0;
+  for (double value : values)
+    {
+      if (!std::isnan (value))
+        {
+          sum += value;
+          n++;
+        }
+    }
+
+  Statistics statistics;
+  statistics.mean = n ? sum / n : std::numeric_limits<double>::quiet_NaN ();
+  double squares = 0;
+  for (double value : values)
+    {
+      if (!std::isnan (value))
+        {
+          squares += (value - statistics.mean) * (value - statistics.mean);
+        }
+    }
+  statistics.std = n ? std::sqrt (squares / n) : std::numeric_limits<double>::quiet_NaN ();
+  return statistics;
+}
+
+} // namespace lorawan
+} // namespace ns3
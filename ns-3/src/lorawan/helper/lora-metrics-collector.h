@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LORA_METRICS_COLLECTOR_H
+#define LORA_METRICS_COLLECTOR_H
+
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/lora-output-writer.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Compute the performance metrics of the network during the simulation.
+ *
+ * At the end of every period (1200 s by default), the collector records the
+ * number of new packets sent by the end devices during the period, the
+ * number of them that were received by at least one gateway by then (as
+ * LoraPacketTracker::CountMacPacketsGlobally does, with the same MAC trace
+ * sources), and the energy of a period: the energy of a transmission of a 32
+ * bytes packet by every end device with its current data rate and
+ * transmission power. The last periods (10 by default) are kept, globally and
+ * per end device, and give the packet delivery ratio (PDR), the energy in
+ * Joules and the useful network energy consumption (UNEC, the energy in mJ
+ * per delivered packet), without writing and parsing the periodic output
+ * files.
+ *
+ * The data rates and transmission powers are kept up to date by the
+ * TransmissionParameters trace source of the MAC of the end devices.
+ */
+class LoraMetricsCollector
+{
+public:
+  /**
+   * The metrics of the network during a period.
+   */
+  struct PeriodMetrics
+  {
+    Time time; //!< The end of the period
+    uint32_t sent; //!< The new packets sent during the period
+    uint32_t received; //!< The packets of the period received by a gateway
+    double joules; //!< The energy of a transmission by each end device
+  };
+
+  /**
+   * The mean and the (population) standard deviation of a metric over the
+   * periods of the window.
+   */
+  struct Statistics
+  {
+    double mean;
+    double std;
+  };
+
+  LoraMetricsCollector ();
+  ~LoraMetricsCollector ();
+
+  /**
+   * Set the duration of a period. Must be called before Install.
+   */
+  void SetPeriod (Time period);
+
+  /**
+   * Set the number of periods over which metrics are computed.
+   */
+  void SetWindowPeriods (uint32_t periods);
+
+  /**
+   * Connect to the trace sources of the end devices and of the gateways, and
+   * start recording periods, the first one ending a period from now.
+   */
+  void Install (NodeContainer endDevices, NodeContainer gateways);
+
+  /**
+   * Get the last periods, the oldest first.
+   */
+  const std::deque<PeriodMetrics> &GetWindow (void) const;
+
+  /**
+   * The PDR over the periods of the window in which packets were sent.
+   */
+  Statistics GetPdr (void) const;
+
+  /**
+   * The energy of the periods of the window, in Joules.
+   */
+  Statistics GetJoules (void) const;
+
+  /**
+   * The UNEC over the periods of the window in which packets were
+   * delivered, in mJ per delivered packet.
+   */
+  Statistics GetUnec (void) const;
+
+  /**
+   * Write the mean and standard deviation of the PDR, of the energy and of
+   * the UNEC over the window, one metric per line.
+   */
+  void WriteSummary (std::string filename) const;
+
+  /**
+   * Write, for each end device, its node id, and the packets it sent and
+   * that were received, its PDR, its energy in Joules and its UNEC in mJ over
+   * the window.
+   */
+  void WriteDeviceSummary (std::string filename,
+                           LoraOutputWriter::Format format = LoraOutputWriter::TEXT) const;
+
+  /**
+   * The energy of a transmission of a 32 bytes packet, in Joules, as used
+   * by the offline scripts of the experiments.
+   */
+  static double GetTransmissionEnergy (uint8_t dataRate, double txPower);
+
+private:
+  /**
+   * Record the current period and schedule the end of the next one.
+   */
+  void EndPeriod (void);
+
+  static void SentNewPacketCallback (LoraMetricsCollector *collector, uint32_t device,
+                                     Ptr<Packet const> packet);
+  void GatewayReceptionCallback (Ptr<Packet const> packet);
+  static void TransmissionParametersCallback (LoraMetricsCollector *collector,
+                                              uint32_t device, uint8_t dataRate,
+                                              double txPower);
+
+  /**
+   * The statistics of the values of the window that are not NaN.
+   */
+  static Statistics ComputeStatistics (const std::vector<double> &values);
+
+  Time m_period;
+  uint32_t m_windowPeriods;
+
+  std::deque<PeriodMetrics> m_window;
+
+  std::vector<uint32_t> m_deviceIds; //!< The node id of each end device
+  std::vector<double> m_deviceEnergy; //!< The energy of a transmission
+
+  // The current period
+  std::vector<uint32_t> m_sent;
+  std::vector<uint32_t> m_received;
+  std::map<Ptr<Packet const>, uint32_t> m_pendingPackets; //!< Sender of each packet
+
+  // The periods of the window per end device, m_windowPeriods slots each
+  std::vector<uint32_t> m_windowSent;
+  std::vector<uint32_t> m_windowReceived;
+  std::vector<double> m_windowEnergy;
+  uint32_t m_periods; //!< The number of periods recorded so far
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_METRICS_COLLECTOR_H */
@@ -0,0 +1,353 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-output-writer.h"
+#include "ns3/lora-log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraOutputWriter");
+
+namespace {
+
+template <typename T>
+void
+AppendRaw (std::string &buffer, T value)
+{
+  buffer.append (reinterpret_cast<const char *> (&value), sizeof (T));
+}
+
+void
+AppendFormatted (std::string &buffer, const char *format, double value)
+{
+  char text[64];
+  int length = std::snprintf (text, sizeof (text), format, value);
+  buffer.append (text, std::min<int> (length, sizeof (text) - 1));
+}
+
+} // namespace
+
+LoraOutputColumn::LoraOutputColumn (std::string name, Type type, std::string textFormat)
+  : name (name),
+    type (type),
+    textFormat (textFormat)
+{
+  if (textFormat.empty ())
+    {
+      this->textFormat = (type == DOUBLE || type == FLOAT) ? "%g" : "%.0f";
+    }
+}
+
+LoraOutputEncoder::~LoraOutputEncoder ()
+{
+}
+
+void
+LoraOutputEncoder::FinishBlock (const std::vector<LoraOutputColumn> &columns,
+                                std::string &buffer)
+{
+}
+
+void
+LoraTextOutputEncoder::WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                                    std::string &buffer)
+{
+}
+
+void
+LoraTextOutputEncoder::WriteRow (const std::vector<LoraOutputColumn> &columns,
+                                 const double *values, std::string &buffer)
+{
+  for (uint32_t i = 0; i < columns.size (); i++)
+    {
+      if (i > 0)
+        {
+          buffer += ' ';
+        }
+      AppendFormatted (buffer, columns[i].textFormat.c_str (), values[i]);
+    }
+  buffer += '\n';
+}
+
+void
+LoraCsvOutputEncoder::WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                                   std::string &buffer)
+{
+  for (uint32_t i = 0; i < columns.size (); i++)
+    {
+      if (i > 0)
+        {
+          buffer += ',';
+        }
+      buffer += columns[i].name;
+    }
+  buffer += '\n';
+}
+
+void
+LoraCsvOutputEncoder::WriteRow (const std::vector<LoraOutputColumn> &columns,
+                                const double *values, std::string &buffer)
+{
+  for (uint32_t i = 0; i < columns.size (); i++)
+    {
+      if (i > 0)
+        {
+          buffer += ',';
+        }
+      bool integer = columns[i].type != LoraOutputColumn::DOUBLE
+        && columns[i].type != LoraOutputColumn::FLOAT;
+      AppendFormatted (buffer, integer ? "%.0f" : "%.10g", values[i]);
+    }
+  buffer += '\n';
+}
+
+LoraBinaryOutputEncoder::LoraBinaryOutputEncoder ()
+  : m_nRows (0)
+{
+}
+
+void
+LoraBinaryOutputEncoder::WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                                      std::string &buffer)
+{
+  buffer.append ("LORACOL", 8);
+  AppendRaw<uint32_t> (buffer, 1);
+  AppendRaw<uint32_t> (buffer, columns.size ());
+  for (const LoraOutputColumn &column : columns)
+    {
+      AppendRaw<uint8_t> (buffer, column.type);
+      AppendRaw<uint16_t> (buffer, column.name.size ());
+      buffer += column.name;
+    }
+}
+
+void
+LoraBinaryOutputEncoder::WriteRow (const std::vector<LoraOutputColumn> &columns,
+                                   const double *values, std::string &buffer)
+{
+  m_rows.insert (m_rows.end (), values, values + columns.size ());
+  m_nRows++;
+}
+
+void
+LoraBinaryOutputEncoder::FinishBlock (const std::vector<LoraOutputColumn> &columns,
+                                      std::string &buffer)
+{
+  if (m_nRows == 0)
+    {
+      return;
+    }
+
+  AppendRaw<uint32_t> (buffer, m_nRows);
+  uint32_t nColumns = columns.size ();
+  for (uint32_t c = 0; c < nColumns; c++)
+    {
+      for (uint32_t r = 0; r < m_nRows; r++)
+        {
+          double value = m_rows[r * nColumns + c];
+          switch (columns[c].type)
+            {
+            case LoraOutputColumn::INT32:
+              AppendRaw<int32_t> (buffer, value);
+              break;
+            case LoraOutputColumn::UINT32:
+              AppendRaw<uint32_t> (buffer, value);
+              break;
+            case LoraOutputColumn::DOUBLE:
+              AppendRaw<double> (buffer, value);
+              break;
+            case LoraOutputColumn::UINT8:
+              AppendRaw<uint8_t> (buffer, value);
+              break;
+            case LoraOutputColumn::FLOAT:
+              AppendRaw<float> (buffer, value);
+              break;
+            }
+        }
+    }
+
+  m_rows.clear ();
+  m_nRows = 0;
+}
+
+Ptr<LoraOutputEncoder>
+LoraOutputWriter::CreateEncoder (Format format)
+{
+  switch (format)
+    {
+    case CSV:
+      return Create<LoraCsvOutputEncoder> ();
+    case BINARY:
+      return Create<LoraBinaryOutputEncoder> ();
+    default:
+      return Create<LoraTextOutputEncoder> ();
+    }
+}
+
+LoraOutputWriter::LoraOutputWriter (std::string filename, Ptr<LoraOutputEncoder> encoder,
+                                    std::vector<LoraOutputColumn> columns, bool append,
+                                    bool backgroundThread)
+  : m_encoder (encoder),
+    m_columns (columns),
+    m_pendingRows (0),
+    m_stop (false)
+{
+  NS_LOG_FUNCTION (this << filename << append << backgroundThread);
+
+  // The header is only needed at the beginning of the file
+  bool empty = true;
+  if (append)
+    {
+      std::ifstream existing (filename.c_str (), std::ifstream::binary | std::ifstream::ate);
+      empty = !existing.is_open () || existing.tellg () == 0;
+    }
+
+  m_file.open (filename.c_str (), std::ofstream::out | std::ofstream::binary |
+               (append ? std::ofstream::app : std::ofstream::trunc));
+  if (!m_file.is_open ())
+    {
+      NS_LOG_WARN ("Could not open " << filename);
+      return;
+    }
+
+  m_row.reserve (m_columns.size ());
+  m_buffer.reserve (BUFFER_SIZE);
+  if (empty)
+    {
+      m_encoder->WriteHeader (m_columns, m_buffer);
+    }
+
+  if (backgroundThread)
+    {
+      m_thread = std::thread (&LoraOutputWriter::WriterLoop, this);
+    }
+}
+
+LoraOutputWriter::~LoraOutputWriter ()
+{
+  Close ();
+}
+
+bool
+LoraOutputWriter::IsOpen (void) const
+{
+  return m_file.is_open ();
+}
+
+void
+LoraOutputWriter::Add (double value)
+{
+  NS_ASSERT (m_row.size () < m_columns.size ());
+  m_row.push_back (value);
+}
+
+void
+LoraOutputWriter::EndRow (void)
+{
+  NS_ASSERT_MSG (m_row.size () == m_columns.size (),
+                 "A row has " << m_row.size () << " values instead of " << m_columns.size ());
+
+  m_encoder->WriteRow (m_columns, m_row.data (), m_buffer);
+  m_row.clear ();
+
+  if (++m_pendingRows >= BLOCK_ROWS || m_buffer.size () >= BUFFER_SIZE)
+    {
+      Flush ();
+    }
+}
+
+void
+LoraOutputWriter::Flush (void)
+{
+  if (!IsOpen ())
+    {
+      return;
+    }
+
+  m_encoder->FinishBlock (m_columns, m_buffer);
+  m_pendingRows = 0;
+  if (m_buffer.empty ())
+    {
+      return;
+    }
+
+  if (m_thread.joinable ())
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_queue.push_back (std::string ());
+        m_queue.back ().swap (m_buffer);
+      }
+      m_condition.notify_one ();
+      m_buffer.reserve (BUFFER_SIZE);
+    }
+  else
+    {
+      m_file.write (m_buffer.data (), m_buffer.size ());
+      m_buffer.clear ();
+    }
+}
+
+void
+LoraOutputWriter::Close (void)
+{
+  if (!IsOpen ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+
+  Flush ();
+  if (m_thread.joinable ())
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_stop = true;
+      }
+      m_condition.notify_one ();
+      m_thread.join ();
+    }
+  m_file.close ();
+}
+
+void
+LoraOutputWriter::WriterLoop (void)
+{
+  std::string buffer;
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_condition.wait (lock, [this] { return m_stop || !m_queue.empty (); });
+        if (m_queue.empty ())
+          {
+            return;
+          }
+        buffer.swap (m_queue.front ());
+        m_queue.pop_front ();
+      }
+      m_file.write (buffer.data (), buffer.size ());
+      buffer.clear ();
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
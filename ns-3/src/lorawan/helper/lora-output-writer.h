@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_OUTPUT_WRITER_H
+#define LORA_OUTPUT_WRITER_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A typed column of the rows written by a LoraOutputWriter.
+ */
+struct LoraOutputColumn
+{
+  enum Type
+  {
+    INT32,
+    UINT32,
+    DOUBLE,
+    UINT8,
+    FLOAT
+  };
+
+  /**
+   * \param name The name of the column, in the CSV and binary headers.
+   * \param type The type of the values in the binary format.
+   * \param textFormat The printf format of the values in the text format,
+   * which takes a double (by default, "%g" for DOUBLE and FLOAT, and "%.0f"
+   * for integers).
+   */
+  LoraOutputColumn (std::string name, Type type, std::string textFormat = "");
+
+  std::string name;
+  Type type;
+  std::string textFormat;
+};
+
+/**
+ * Turns rows of values into the bytes of an output format.
+ *
+ * Rows are given one at a time to WriteRow, and FinishBlock is called before
+ * the buffer is written out, so that formats that store a block of rows
+ * column by column can output them.
+ */
+class LoraOutputEncoder : public SimpleRefCount<LoraOutputEncoder>
+{
+public:
+  virtual ~LoraOutputEncoder ();
+
+  /**
+   * Append the beginning of a new file to the buffer.
+   */
+  virtual void WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer) = 0;
+
+  /**
+   * Encode a row, with a value for each column.
+   */
+  virtual void WriteRow (const std::vector<LoraOutputColumn> &columns,
+                         const double *values, std::string &buffer) = 0;
+
+  /**
+   * Append the rows that were kept back, if any, to the buffer.
+   */
+  virtual void FinishBlock (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer);
+};
+
+/**
+ * Values separated by spaces, one row per line, without header: the format
+ * the LoraHelper printers always used.
+ */
+class LoraTextOutputEncoder : public LoraOutputEncoder
+{
+public:
+  virtual void WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer);
+  virtual void WriteRow (const std::vector<LoraOutputColumn> &columns,
+                         const double *values, std::string &buffer);
+};
+
+/**
+ * Comma-separated values, with a header line holding the column names.
+ */
+class LoraCsvOutputEncoder : public LoraOutputEncoder
+{
+public:
+  virtual void WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer);
+  virtual void WriteRow (const std::vector<LoraOutputColumn> &columns,
+                         const double *values, std::string &buffer);
+};
+
+/**
+ * A binary columnar format, in the native (little endian) byte order.
+ *
+ * The file starts with the magic "LORACOL" followed by a 0 byte, the version
+ * (uint32_t, 1) and the number of columns (uint32_t). Then, for each column,
+ * its type (uint8_t, a LoraOutputColumn::Type) and its name (uint16_t length
+ * followed by the characters). It is followed by blocks of rows: the number
+ * of rows (uint32_t), then all the values of the first column (1 byte for
+ * UINT8, 4 bytes for INT32, UINT32 and FLOAT, 8 bytes for DOUBLE), then of
+ * the second one, and so on.
+ */
+class LoraBinaryOutputEncoder : public LoraOutputEncoder
+{
+public:
+  LoraBinaryOutputEncoder ();
+
+  virtual void WriteHeader (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer);
+  virtual void WriteRow (const std::vector<LoraOutputColumn> &columns,
+                         const double *values, std::string &buffer);
+  virtual void FinishBlock (const std::vector<LoraOutputColumn> &columns,
+                            std::string &buffer);
+
+private:
+  std::vector<double> m_rows; //!< The rows of the current block, row by row
+  uint32_t m_nRows;
+};
+
+/**
+ * A file of rows of typed values, written through a large buffer.
+ *
+ * The file stays open until Close is called (or the writer is destroyed),
+ * and is written every BLOCK_ROWS rows, or when the buffer gets larger than
+ * BUFFER_SIZE. If a background thread is used, the buffers are written by
+ * that thread, while the simulation goes on.
+ */
+class LoraOutputWriter : public SimpleRefCount<LoraOutputWriter>
+{
+public:
+  enum Format
+  {
+    TEXT,
+    CSV,
+    BINARY
+  };
+
+  static const uint32_t BLOCK_ROWS = 4096;
+  static const uint32_t BUFFER_SIZE = 1 << 16;
+
+  /**
+   * Create the encoder of a format.
+   */
+  static Ptr<LoraOutputEncoder> CreateEncoder (Format format);
+
+  /**
+   * Open a file.
+   *
+   * \param filename The file to write.
+   * \param encoder The encoder of the output format.
+   * \param columns The columns of the rows.
+   * \param append Whether to add to the end of an existing file, rather than
+   * replacing it. The header is only written if the file is empty.
+   * \param backgroundThread Whether to write the file from another thread.
+   */
+  LoraOutputWriter (std::string filename, Ptr<LoraOutputEncoder> encoder,
+                    std::vector<LoraOutputColumn> columns, bool append,
+                    bool backgroundThread);
+  ~LoraOutputWriter ();
+
+  /**
+   * Whether the file is open.
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * Add the value of the next column of the current row.
+   */
+  void Add (double value);
+
+  /**
+   * End the current row, which must have a value for each column.
+   */
+  void EndRow (void);
+
+  /**
+   * Hand all complete rows to the file.
+   */
+  void Flush (void);
+
+  /**
+   * Flush, wait for the background thread to finish writing, and close the
+   * file.
+   */
+  void Close (void);
+
+private:
+  LoraOutputWriter (const LoraOutputWriter &);
+  LoraOutputWriter &operator = (const LoraOutputWriter &);
+
+  void WriterLoop (void);
+
+  std::ofstream m_file;
+  Ptr<LoraOutputEncoder> m_encoder;
+  std::vector<LoraOutputColumn> m_columns;
+  std::vector<double> m_row; //!< The values of the current row
+  std::string m_buffer; //!< The encoded rows that were not written yet
+  uint32_t m_pendingRows; //!< The rows since the last flush
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<std::string> m_queue; //!< Buffers for the background thread
+  bool m_stop;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_OUTPUT_WRITER_H */
@@ -19,7 +19,8 @@
  */
 
 #include "lora-packet-tracker.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/simulator.h"
 #include "ns3/lorawan-mac-header.h"
 #include <iostream>
@@ -27,7 +28,7 @@
 
 namespace ns3 {
 namespace lorawan {
-NS_LOG_COMPONENT_DEFINE ("LoraPacketTracker");
+LORA_LOG_COMPONENT_DEFINE ("LoraPacketTracker");
 
 LoraPacketTracker::LoraPacketTracker ()
 {
@@ -46,6 +47,7 @@ LoraPacketTracker::~LoraPacketTracker ()
 void
 LoraPacketTracker::MacTransmissionCallback (Ptr<Packet const> packet)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::MacTransmissionCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("A new packet was sent by the MAC layer");
@@ -66,6 +68,7 @@ LoraPacketTracker::RequiredTransmissionsCallback (uint8_t reqTx, bool success,
                                                   Time firstAttempt,
                                                   Ptr<Packet> packet)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::RequiredTransmissionsCallback");
   NS_LOG_INFO ("Finished retransmission attempts for a packet");
   NS_LOG_DEBUG ("Packet: " << packet << "ReqTx " << unsigned(reqTx) <<
                 ", succ: " << success << ", firstAttempt: " <<
@@ -84,6 +87,7 @@ LoraPacketTracker::RequiredTransmissionsCallback (uint8_t reqTx, bool success,
 void
 LoraPacketTracker::MacGwReceptionCallback (Ptr<Packet const> packet)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::MacGwReceptionCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("A packet was successfully received" <<
@@ -112,6 +116,7 @@ LoraPacketTracker::MacGwReceptionCallback (Ptr<Packet const> packet)
 void
 LoraPacketTracker::TransmissionCallback (Ptr<Packet const> packet, uint32_t edId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::TransmissionCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -130,6 +135,7 @@ LoraPacketTracker::TransmissionCallback (Ptr<Packet const> packet, uint32_t edId
 void
 LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::PacketReceptionCallback");
   if (IsUplink (packet))
     {
       // Remove the successfully received packet from the list of sent ones
@@ -146,6 +152,7 @@ LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t g
 void
 LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::InterferenceCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -161,6 +168,7 @@ LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t gwId
 void
 LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::NoMoreReceiversCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -175,6 +183,7 @@ LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t g
 void
 LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::UnderSensitivityCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -190,6 +199,7 @@ LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t
 void
 LoraPacketTracker::LostBecauseTxCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
+  LORA_PROFILE_SCOPE ("LoraPacketTracker::LostBecauseTxCallback");
   if (IsUplink (packet))
     {
       NS_LOG_INFO ("PHY packet " << packet
@@ -348,29 +358,38 @@ LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
   return output;
 }
 
-  std::string
-  LoraPacketTracker::CountMacPacketsGlobally (Time startTime, Time stopTime)
+  std::vector<int>
+  LoraPacketTracker::CountMacPacketsGloballyValues (Time startTime, Time stopTime)
   {
     NS_LOG_FUNCTION (this << startTime << stopTime);
 
-    double sent = 0;
-    double received = 0;
+    std::vector<int> packetCounts (2, 0);
     for (auto it = m_macPacketTracker.begin ();
          it != m_macPacketTracker.end ();
          ++it)
       {
         if ((*it).second.sendTime >= startTime && (*it).second.sendTime <= stopTime)
           {
-            sent++;
+            packetCounts.at (0)++;
             if ((*it).second.receptionTimes.size ())
               {
-                received++;
+                packetCounts.at (1)++;
               }
           }
       }
 
-    return std::to_string (sent) + " " +
-      std::to_string (received);
+    return packetCounts;
+  }
+
+  std::string
+  LoraPacketTracker::CountMacPacketsGlobally (Time startTime, Time stopTime)
+  {
+    NS_LOG_FUNCTION (this << startTime << stopTime);
+
+    std::vector<int> packetCounts = CountMacPacketsGloballyValues (startTime, stopTime);
+
+    return std::to_string (double (packetCounts.at (0))) + " " +
+      std::to_string (double (packetCounts.at (1)));
   }
 
   std::string
@@ -149,6 +149,13 @@ public:
    */
   std::string CountMacPacketsGlobally (Time startTime, Time stopTime);
 
+  /**
+   * The same as CountMacPacketsGlobally, returning the number of sent
+   * packets and the number of packets that were received by at least one
+   * gateway as a vector.
+   */
+  std::vector<int> CountMacPacketsGloballyValues (Time startTime, Time stopTime);
+
   /**
    * Count packets to evaluate the global performance at MAC level of the whole
    * network. In this case, a MAC layer packet is labeled as successful if it
@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-pcap-capture.h"
+#include "ns3/trace-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/abort.h"
+#include "ns3/lora-log.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <utility>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraPcapCapture");
+
+NS_OBJECT_ENSURE_REGISTERED (LoraPcapCapture);
+
+namespace {
+
+// The sizes of the pcap file header and of the header of each record
+const uint64_t FILE_HEADER_SIZE = 24;
+const uint64_t RECORD_HEADER_SIZE = 16;
+
+} // namespace
+
+TypeId
+LoraPcapCapture::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraPcapCapture")
+    .SetParent<Object> ()
+    .SetGroupName ("Lora")
+    .AddConstructor<LoraPcapCapture> ()
+    .AddAttribute ("SnapLength",
+                   "The maximum number of bytes kept of each packet",
+                   UintegerValue (PcapFile::SNAPLEN_DEFAULT),
+                   MakeUintegerAccessor (&LoraPcapCapture::m_snapLength),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxFileSize",
+                   "The size, in bytes, past which a file is rotated "
+                   "(0 to never rotate on size)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&LoraPcapCapture::m_maxFileSize),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RotationInterval",
+                   "The simulated time after which a file is rotated "
+                   "(0 to never rotate on time)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LoraPcapCapture::m_rotationInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxFiles",
+                   "The number of most recent files that are kept "
+                   "(0 to keep all of them)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&LoraPcapCapture::m_maxFiles),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RingDuration",
+                   "If not 0, keep the packets of this last duration in "
+                   "memory, and only write them when triggered",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LoraPcapCapture::m_ringDuration),
+                   MakeTimeChecker ())
+    .AddAttribute ("TriggerThreshold",
+                   "The number of events within TriggerWindow that trigger "
+                   "a dump of the ring buffer",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&LoraPcapCapture::m_triggerThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TriggerWindow",
+                   "The window in which TriggerThreshold events trigger a "
+                   "dump of the ring buffer",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&LoraPcapCapture::m_triggerWindow),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+LoraPcapCapture::LoraPcapCapture ()
+  : m_prefix ("lora-capture"),
+    m_fileOpen (false),
+    m_nFiles (0),
+    m_fileSize (0),
+    m_nTriggers (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LoraPcapCapture::~LoraPcapCapture ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LoraPcapCapture::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+  m_ring.clear ();
+  m_triggerEvents.clear ();
+  Object::DoDispose ();
+}
+
+void
+LoraPcapCapture::SetPrefix (std::string prefix)
+{
+  NS_LOG_FUNCTION (this << prefix);
+
+  m_prefix = prefix;
+}
+
+void
+LoraPcapCapture::Write (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  Record record;
+  record.time = Simulator::Now ();
+  record.originalLength = packet->GetSize ();
+  record.data.resize (std::min (record.originalLength, m_snapLength));
+  packet->CopyData (record.data.data (), record.data.size ());
+
+  if (!m_ringDuration.IsZero ())
+    {
+      Time oldest = record.time - m_ringDuration;
+      m_ring.push_back (std::move (record));
+      while (m_ring.front ().time < oldest)
+        {
+          m_ring.pop_front ();
+        }
+      return;
+    }
+
+  uint64_t recordSize = RECORD_HEADER_SIZE + record.data.size ();
+  if (!m_fileOpen)
+    {
+      Rotate ();
+    }
+  else if ((m_maxFileSize > 0 && m_fileSize > FILE_HEADER_SIZE
+            && m_fileSize + recordSize > m_maxFileSize)
+           || (!m_rotationInterval.IsZero ()
+               && record.time >= m_fileStart + m_rotationInterval))
+    {
+      Rotate ();
+    }
+
+  WriteRecord (m_file, record);
+  m_fileSize += recordSize;
+}
+
+void
+LoraPcapCapture::Trigger (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_ringDuration.IsZero ())
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  while (!m_ring.empty () && m_ring.front ().time < now - m_ringDuration)
+    {
+      m_ring.pop_front ();
+    }
+
+  std::string filename = GetTriggerFilename (m_nTriggers++);
+  NS_LOG_DEBUG ("Writing the " << m_ring.size () << " packets of the ring buffer to " <<
+                filename);
+
+  PcapFile file;
+  Open (file, filename);
+  for (const Record &record : m_ring)
+    {
+      WriteRecord (file, record);
+    }
+  file.Close ();
+}
+
+void
+LoraPcapCapture::NotifyTriggerEvent (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  m_triggerEvents.push_back (now);
+  while (m_triggerEvents.front () < now - m_triggerWindow)
+    {
+      m_triggerEvents.pop_front ();
+    }
+
+  // A burst only triggers a single dump
+  if (m_triggerEvents.size () >= m_triggerThreshold)
+    {
+      m_triggerEvents.clear ();
+      Trigger ();
+    }
+}
+
+void
+LoraPcapCapture::Close (void)
+{
+  if (m_fileOpen)
+    {
+      NS_LOG_FUNCTION (this);
+
+      m_file.Close ();
+      m_fileOpen = false;
+    }
+}
+
+uint32_t
+LoraPcapCapture::GetNFiles (void) const
+{
+  return m_nFiles;
+}
+
+uint32_t
+LoraPcapCapture::GetNTriggers (void) const
+{
+  return m_nTriggers;
+}
+
+std::string
+LoraPcapCapture::GetFilename (uint32_t index) const
+{
+  std::ostringstream filename;
+  filename << m_prefix << "-" << index << ".pcap";
+  return filename.str ();
+}
+
+std::string
+LoraPcapCapture::GetTriggerFilename (uint32_t index) const
+{
+  std::ostringstream filename;
+  filename << m_prefix << "-trigger-" << index << ".pcap";
+  return filename.str ();
+}
+
+void
+LoraPcapCapture::Open (PcapFile &file, std::string filename) const
+{
+  file.Open (filename, std::ios::out);
+  NS_ABORT_MSG_IF (file.Fail (), "Unable to open " << filename);
+  file.Init (PcapHelper::DLT_LORATAP, m_snapLength);
+}
+
+void
+LoraPcapCapture::WriteRecord (PcapFile &file, const Record &record) const
+{
+  // PcapFile truncates to the snap length of the file
+  NS_ASSERT_MSG (record.data.size () == std::min (record.originalLength, m_snapLength),
+                 "SnapLength was changed after packets were captured");
+
+  int64_t us = record.time.GetMicroSeconds ();
+  file.Write (us / 1000000, us % 1000000, record.data.data (), record.originalLength);
+}
+
+void
+LoraPcapCapture::Rotate (void)
+{
+  NS_LOG_FUNCTION (this << m_nFiles);
+
+  Close ();
+  Open (m_file, GetFilename (m_nFiles));
+  m_fileOpen = true;
+  m_fileSize = FILE_HEADER_SIZE;
+  m_fileStart = Simulator::Now ();
+  m_nFiles++;
+
+  if (m_maxFiles > 0 && m_nFiles > m_maxFiles)
+    {
+      std::string oldest = GetFilename (m_nFiles - m_maxFiles - 1);
+      NS_LOG_DEBUG ("Deleting " << oldest);
+      std::remove (oldest.c_str ());
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
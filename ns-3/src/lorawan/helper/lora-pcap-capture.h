@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_PCAP_CAPTURE_H
+#define LORA_PCAP_CAPTURE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/pcap-file.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A loratap pcap capture with bounded disk usage, shared by many devices.
+ *
+ * Packets, with their loratap header, are either streamed to a sequence of
+ * files (prefix-0.pcap, prefix-1.pcap, ...), or kept in memory and only
+ * written when something worth looking at happens:
+ *
+ * - Streamed files are rotated when they would grow past MaxFileSize, or
+ *   after RotationInterval of simulated time. If MaxFiles is not zero, only
+ *   the most recent files are kept, and older ones are deleted.
+ * - If RingDuration is not zero, the packets of the last RingDuration are
+ *   kept in memory instead, and Trigger writes them to a new file
+ *   (prefix-trigger-0.pcap, ...). NotifyTriggerEvent calls Trigger when
+ *   TriggerThreshold events happen within TriggerWindow, e.g., a burst of
+ *   receptions lost because a gateway was transmitting.
+ *
+ * In both cases, only the first SnapLength bytes of each packet are kept.
+ */
+class LoraPcapCapture : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LoraPcapCapture ();
+  virtual ~LoraPcapCapture ();
+
+  /**
+   * Set the prefix of the names of the files.
+   */
+  void SetPrefix (std::string prefix);
+
+  /**
+   * Capture a packet at the current simulation time.
+   */
+  void Write (Ptr<const Packet> packet);
+
+  /**
+   * Write the packets of the ring buffer to a new file. Nothing is done if
+   * the capture is streamed to files.
+   */
+  void Trigger (void);
+
+  /**
+   * Count an event that may trigger a dump of the ring buffer, which happens
+   * when TriggerThreshold of them are counted within TriggerWindow.
+   */
+  void NotifyTriggerEvent (void);
+
+  /**
+   * Close the current file.
+   */
+  void Close (void);
+
+  /**
+   * Get the number of files written so far, including those deleted by
+   * the rotation, and not counting the dumps of the ring buffer.
+   */
+  uint32_t GetNFiles (void) const;
+
+  /**
+   * Get the number of dumps of the ring buffer.
+   */
+  uint32_t GetNTriggers (void) const;
+
+  /**
+   * Get the name of a file of the sequence of streamed files.
+   */
+  std::string GetFilename (uint32_t index) const;
+
+  /**
+   * Get the name of a dump of the ring buffer.
+   */
+  std::string GetTriggerFilename (uint32_t index) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * A captured packet, truncated to the snap length.
+   */
+  struct Record
+  {
+    Time time;
+    uint32_t originalLength;
+    std::vector<uint8_t> data;
+  };
+
+  /**
+   * Open a file and write the pcap header.
+   */
+  void Open (PcapFile &file, std::string filename) const;
+
+  /**
+   * Write a record to a file.
+   */
+  void WriteRecord (PcapFile &file, const Record &record) const;
+
+  /**
+   * Close the current streamed file, open the next one, and delete the
+   * oldest one if there are more than MaxFiles.
+   */
+  void Rotate (void);
+
+  std::string m_prefix;
+  uint32_t m_snapLength;
+  uint64_t m_maxFileSize;
+  Time m_rotationInterval;
+  uint32_t m_maxFiles;
+  Time m_ringDuration;
+  uint32_t m_triggerThreshold;
+  Time m_triggerWindow;
+
+  PcapFile m_file;        //!< The current streamed file
+  bool m_fileOpen;
+  uint32_t m_nFiles;      //!< The files opened so far
+  uint64_t m_fileSize;    //!< The bytes in the current file
+  Time m_fileStart;       //!< When the current file was opened
+
+  std::deque<Record> m_ring;        //!< The packets of the last RingDuration
+  std::deque<Time> m_triggerEvents; //!< The events of the last TriggerWindow
+  uint32_t m_nTriggers;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_PCAP_CAPTURE_H */
@@ -19,13 +19,13 @@
  */
 
 #include "ns3/lora-phy-helper.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/sub-band.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraPhyHelper");
+LORA_LOG_COMPONENT_DEFINE ("LoraPhyHelper");
 
 LoraPhyHelper::LoraPhyHelper () : m_maxReceptionPaths (8), m_txPriority (true)
 {
@@ -0,0 +1,345 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lora-topology-snapshot.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/mobility-model.h"
+#include "ns3/building.h"
+#include "ns3/building-list.h"
+#include "ns3/lora-log.h"
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraTopologySnapshot");
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'L', 'O', 'R', 'A', 'T', 'O', 'P', 'O'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t FLAG_PATH_LOSS = 1;
+
+/**
+ * Offsets of the sections of a snapshot, and its total size
+ */
+struct Layout
+{
+  size_t positions;
+  size_t buildings;
+  size_t dataRates;
+  size_t pathLoss;
+  size_t size;
+};
+
+size_t
+AlignTo8 (size_t offset)
+{
+  return (offset + 7) & ~static_cast<size_t> (7);
+}
+
+Layout
+ComputeLayout (const LoraTopologySnapshot::Header &header)
+{
+  Layout layout;
+  layout.positions = sizeof (LoraTopologySnapshot::Header);
+  layout.buildings = layout.positions +
+    (size_t (header.nGateways) + header.nEndDevices) * 3 * sizeof (double);
+  layout.dataRates = layout.buildings +
+    size_t (header.nBuildings) * sizeof (LoraTopologySnapshot::BuildingRecord);
+  layout.pathLoss = AlignTo8 (layout.dataRates + header.nEndDevices);
+  layout.size = layout.pathLoss;
+  if (header.flags & FLAG_PATH_LOSS)
+    {
+      layout.size += size_t (header.nEndDevices) * header.nGateways * sizeof (float);
+    }
+  return layout;
+}
+
+void
+WritePosition (std::ofstream &output, Ptr<Node> node)
+{
+  Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+  NS_ASSERT_MSG (mobility != 0, "Node " << node->GetId () << " has no mobility");
+  Vector position = mobility->GetPosition ();
+  double coordinates[3] = {position.x, position.y, position.z};
+  output.write (reinterpret_cast<const char *> (coordinates), sizeof (coordinates));
+}
+
+} // anonymous namespace
+
+bool
+LoraTopologySnapshot::Write (std::string filename, NodeContainer endDevices,
+                             NodeContainer gateways, Ptr<LoraChannel> channel)
+{
+  NS_LOG_FUNCTION (filename << endDevices.GetN () << gateways.GetN () << channel);
+
+  std::ofstream output (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!output.is_open ())
+    {
+      NS_LOG_WARN ("Could not open " << filename);
+      return false;
+    }
+
+  Header header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.nGateways = gateways.GetN ();
+  header.nEndDevices = endDevices.GetN ();
+  header.nBuildings = BuildingList::GetNBuildings ();
+  header.flags = channel != 0 ? FLAG_PATH_LOSS : 0;
+  output.write (reinterpret_cast<const char *> (&header), sizeof (header));
+
+  Layout layout = ComputeLayout (header);
+
+  for (NodeContainer::Iterator it = gateways.Begin (); it != gateways.End (); ++it)
+    {
+      WritePosition (output, *it);
+    }
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      WritePosition (output, *it);
+    }
+
+  for (BuildingList::Iterator it = BuildingList::Begin (); it != BuildingList::End (); ++it)
+    {
+      Box box = (*it)->GetBoundaries ();
+      BuildingRecord record;
+      std::memset (&record, 0, sizeof (record));
+      record.xMin = box.xMin;
+      record.xMax = box.xMax;
+      record.yMin = box.yMin;
+      record.yMax = box.yMax;
+      record.zMin = box.zMin;
+      record.zMax = box.zMax;
+      record.nFloors = (*it)->GetNFloors ();
+      record.nRoomsX = (*it)->GetNRoomsX ();
+      record.nRoomsY = (*it)->GetNRoomsY ();
+      record.type = (*it)->GetBuildingType ();
+      record.extWallsType = (*it)->GetExtWallsType ();
+      output.write (reinterpret_cast<const char *> (&record), sizeof (record));
+    }
+
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      uint8_t dataRate = NO_DATA_RATE;
+      Ptr<LoraNetDevice> device = 0;
+      if ((*it)->GetNDevices () > 0)
+        {
+          device = (*it)->GetDevice (0)->GetObject<LoraNetDevice> ();
+        }
+      if (device != 0 && device->GetMac () != 0)
+        {
+          Ptr<EndDeviceLorawanMac> mac =
+            device->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+          if (mac != 0)
+            {
+              dataRate = mac->GetDataRate ();
+            }
+        }
+      output.put (dataRate);
+    }
+  for (size_t i = layout.dataRates + header.nEndDevices; i < layout.pathLoss; i++)
+    {
+      output.put (0);
+    }
+
+  if (channel != 0)
+    {
+      // This is the O(endDevices x gateways) sweep that loading the snapshot
+      // saves
+      std::vector<float> row (gateways.GetN ());
+      for (NodeContainer::Iterator ed = endDevices.Begin (); ed != endDevices.End (); ++ed)
+        {
+          Ptr<MobilityModel> edMobility = (*ed)->GetObject<MobilityModel> ();
+          uint32_t j = 0;
+          for (NodeContainer::Iterator gw = gateways.Begin (); gw != gateways.End (); ++gw, ++j)
+            {
+              Ptr<MobilityModel> gwMobility = (*gw)->GetObject<MobilityModel> ();
+              row[j] = -channel->GetRxPower (0, edMobility, gwMobility);
+            }
+          output.write (reinterpret_cast<const char *> (row.data ()),
+                        row.size () * sizeof (float));
+        }
+    }
+
+  output.close ();
+  return !output.fail ();
+}
+
+LoraTopologySnapshot::LoraTopologySnapshot (std::string filename) :
+  m_header (0),
+  m_positions (0),
+  m_buildings (0),
+  m_dataRates (0),
+  m_pathLoss (0),
+  m_data (MAP_FAILED),
+  m_size (0)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Could not open " << filename);
+      return;
+    }
+
+  struct stat st;
+  if (fstat (fd, &st) == 0 && size_t (st.st_size) >= sizeof (Header))
+    {
+      m_size = st.st_size;
+      m_data = mmap (0, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+  close (fd);
+
+  if (m_data == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Could not map " << filename);
+      return;
+    }
+
+  const Header *header = static_cast<const Header *> (m_data);
+  if (std::memcmp (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic)) != 0
+      || header->version != SNAPSHOT_VERSION)
+    {
+      NS_LOG_WARN (filename << " is not a topology snapshot");
+      return;
+    }
+
+  Layout layout = ComputeLayout (*header);
+  if (layout.size != m_size)
+    {
+      NS_LOG_WARN (filename << " has size " << m_size << " instead of " << layout.size);
+      return;
+    }
+
+  const char *data = static_cast<const char *> (m_data);
+  m_header = header;
+  m_positions = reinterpret_cast<const double *> (data + layout.positions);
+  m_buildings = reinterpret_cast<const BuildingRecord *> (data + layout.buildings);
+  m_dataRates = reinterpret_cast<const uint8_t *> (data + layout.dataRates);
+  if (header->flags & FLAG_PATH_LOSS)
+    {
+      m_pathLoss = reinterpret_cast<const float *> (data + layout.pathLoss);
+    }
+}
+
+LoraTopologySnapshot::~LoraTopologySnapshot ()
+{
+  if (m_data != MAP_FAILED)
+    {
+      munmap (m_data, m_size);
+    }
+}
+
+bool
+LoraTopologySnapshot::IsValid (void) const
+{
+  return m_header != 0;
+}
+
+uint32_t
+LoraTopologySnapshot::GetNGateways (void) const
+{
+  return m_header->nGateways;
+}
+
+uint32_t
+LoraTopologySnapshot::GetNEndDevices (void) const
+{
+  return m_header->nEndDevices;
+}
+
+uint32_t
+LoraTopologySnapshot::GetNBuildings (void) const
+{
+  return m_header->nBuildings;
+}
+
+bool
+LoraTopologySnapshot::HasPathLoss (void) const
+{
+  return m_pathLoss != 0;
+}
+
+Vector
+LoraTopologySnapshot::GetGatewayPosition (uint32_t i) const
+{
+  NS_ASSERT (i < m_header->nGateways);
+  const double *position = m_positions + 3 * size_t (i);
+  return Vector (position[0], position[1], position[2]);
+}
+
+Vector
+LoraTopologySnapshot::GetEndDevicePosition (uint32_t i) const
+{
+  NS_ASSERT (i < m_header->nEndDevices);
+  const double *position = m_positions + 3 * (size_t (m_header->nGateways) + i);
+  return Vector (position[0], position[1], position[2]);
+}
+
+uint8_t
+LoraTopologySnapshot::GetDataRate (uint32_t i) const
+{
+  NS_ASSERT (i < m_header->nEndDevices);
+  return m_dataRates[i];
+}
+
+double
+LoraTopologySnapshot::GetPathLoss (uint32_t i, uint32_t j) const
+{
+  NS_ASSERT (j < m_header->nGateways);
+  return GetPathLossRow (i)[j];
+}
+
+const float *
+LoraTopologySnapshot::GetPathLossRow (uint32_t i) const
+{
+  NS_ASSERT_MSG (m_pathLoss != 0, "The snapshot has no path loss");
+  NS_ASSERT (i < m_header->nEndDevices);
+  return m_pathLoss + size_t (i) * m_header->nGateways;
+}
+
+void
+LoraTopologySnapshot::CreateBuildings (void) const
+{
+  NS_LOG_FUNCTION (this << m_header->nBuildings);
+
+  for (uint32_t i = 0; i < m_header->nBuildings; i++)
+    {
+      const BuildingRecord &record = m_buildings[i];
+      Ptr<Building> building = CreateObject<Building> ();
+      building->SetBoundaries (Box (record.xMin, record.xMax, record.yMin,
+                                    record.yMax, record.zMin, record.zMax));
+      building->SetNFloors (record.nFloors);
+      building->SetNRoomsX (record.nRoomsX);
+      building->SetNRoomsY (record.nRoomsY);
+      building->SetBuildingType (static_cast<Building::BuildingType_t> (record.type));
+      building->SetExtWallsType (static_cast<Building::ExtWallsType_t> (record.extWallsType));
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_TOPOLOGY_SNAPSHOT_H
+#define LORA_TOPOLOGY_SNAPSHOT_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-container.h"
+#include "ns3/lora-channel.h"
+#include "ns3/vector.h"
+#include "ns3/box.h"
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A read-only view of a binary topology snapshot, mapped in memory.
+ *
+ * The file is made of fixed-size records in the native byte order, each
+ * section starting at a multiple of 8 bytes:
+ *
+ * - a 32 bytes Header;
+ * - the position of each gateway, then of each end device, as 3 doubles;
+ * - a BuildingRecord for each building;
+ * - the data rate of each end device, as a byte (NO_DATA_RATE if none);
+ * - if HasPathLoss, the path loss in dB from each end device to each gateway,
+ *   as floats, one row of nGateways values per end device.
+ *
+ * Since the file is mapped rather than read, several processes that load the
+ * same snapshot share its pages, and only the parts that are used are
+ * actually read from disk.
+ */
+class LoraTopologySnapshot : public SimpleRefCount<LoraTopologySnapshot>
+{
+public:
+  static const uint8_t NO_DATA_RATE = 0xff;
+
+  /**
+   * Write a snapshot of the current topology.
+   *
+   * The data rates are taken from the MAC of the end devices, if they have
+   * one, and the path losses are those of the channel, if it is not 0, for a
+   * transmission from each end device to each gateway. All buildings in the
+   * BuildingList are saved.
+   *
+   * \return Whether the file could be written.
+   */
+  static bool Write (std::string filename, NodeContainer endDevices,
+                     NodeContainer gateways, Ptr<LoraChannel> channel);
+
+  /**
+   * Map a snapshot file in memory.
+   *
+   * Use IsValid to check whether this succeeded.
+   */
+  LoraTopologySnapshot (std::string filename);
+  ~LoraTopologySnapshot ();
+
+  /**
+   * Whether the file was mapped and has the expected format.
+   */
+  bool IsValid (void) const;
+
+  uint32_t GetNGateways (void) const;
+  uint32_t GetNEndDevices (void) const;
+  uint32_t GetNBuildings (void) const;
+  bool HasPathLoss (void) const;
+
+  Vector GetGatewayPosition (uint32_t i) const;
+  Vector GetEndDevicePosition (uint32_t i) const;
+  uint8_t GetDataRate (uint32_t i) const;
+
+  /**
+   * Return the path loss, in dB, from the i-th end device to the j-th
+   * gateway.
+   */
+  double GetPathLoss (uint32_t i, uint32_t j) const;
+
+  /**
+   * Return the row of path losses, in dB, from the i-th end device to all
+   * gateways.
+   */
+  const float * GetPathLossRow (uint32_t i) const;
+
+  /**
+   * Create a Building for each building in the snapshot.
+   */
+  void CreateBuildings (void) const;
+
+  /**
+   * Layout of the beginning of the file
+   */
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t nGateways;
+    uint32_t nEndDevices;
+    uint32_t nBuildings;
+    uint32_t flags;
+    uint32_t reserved;
+  };
+
+  /**
+   * Layout of a building in the file
+   */
+  struct BuildingRecord
+  {
+    double xMin, xMax, yMin, yMax, zMin, zMax;
+    uint16_t nFloors;
+    uint16_t nRoomsX;
+    uint16_t nRoomsY;
+    uint8_t type;
+    uint8_t extWallsType;
+  };
+
+private:
+  LoraTopologySnapshot (const LoraTopologySnapshot &);
+  LoraTopologySnapshot &operator = (const LoraTopologySnapshot &);
+
+  const Header *m_header;
+  const double *m_positions;
+  const BuildingRecord *m_buildings;
+  const uint8_t *m_dataRates;
+  const float *m_pathLoss;
+
+  void *m_data;     //!< Start of the mapping
+  size_t m_size;    //!< Size of the mapping
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_TOPOLOGY_SNAPSHOT_H */
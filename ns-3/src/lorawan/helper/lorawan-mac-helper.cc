@@ -22,13 +22,15 @@
 #include "ns3/gateway-lora-phy.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/lora-net-device.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/random-variable-stream.h"
+#include <algorithm>
+#include <limits>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LorawanMacHelper");
+LORA_LOG_COMPONENT_DEFINE ("LorawanMacHelper");
 
 LorawanMacHelper::LorawanMacHelper () : m_region (LorawanMacHelper::EU)
 {
@@ -508,45 +510,7 @@ LorawanMacHelper::SetSpreadingFactorsUp (NodeContainer endDevices, NodeContainer
 
       // Get the ED sensitivity
       Ptr<EndDeviceLoraPhy> edPhy = loraNetDevice->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
-      const double *edSensitivity = edPhy->sensitivity;
-
-      if (rxPower > *edSensitivity)
-        {
-          mac->SetDataRate (5);
-          sfQuantity[0] = sfQuantity[0] + 1;
-        }
-      else if (rxPower > *(edSensitivity + 1))
-        {
-          mac->SetDataRate (4);
-          sfQuantity[1] = sfQuantity[1] + 1;
-        }
-      else if (rxPower > *(edSensitivity + 2))
-        {
-          mac->SetDataRate (3);
-          sfQuantity[2] = sfQuantity[2] + 1;
-        }
-      else if (rxPower > *(edSensitivity + 3))
-        {
-          mac->SetDataRate (2);
-          sfQuantity[3] = sfQuantity[3] + 1;
-        }
-      else if (rxPower > *(edSensitivity + 4))
-        {
-          mac->SetDataRate (1);
-          sfQuantity[4] = sfQuantity[4] + 1;
-        }
-      else if (rxPower > *(edSensitivity + 5))
-        {
-          mac->SetDataRate (0);
-          sfQuantity[5] = sfQuantity[5] + 1;
-        }
-      else // Device is out of range. Assign SF12.
-        {
-          // NS_LOG_DEBUG ("Device out of range");
-          mac->SetDataRate (0);
-          sfQuantity[6] = sfQuantity[6] + 1;
-          // NS_LOG_DEBUG ("sfQuantity[6] = " << sfQuantity[6]);
-        }
+      SetDataRateForRxPower (mac, edPhy->sensitivity, rxPower, sfQuantity);
 
       /*
 
@@ -604,6 +568,89 @@ LorawanMacHelper::SetSpreadingFactorsUp (NodeContainer endDevices, NodeContainer
 
 } //  end function
 
+std::vector<int>
+LorawanMacHelper::SetSpreadingFactorsUp (NodeContainer endDevices,
+                                         Ptr<LoraTopologySnapshot> snapshot)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  NS_ASSERT (snapshot->GetNEndDevices () == endDevices.GetN ());
+
+  std::vector<int> sfQuantity (7, 0);
+  uint32_t nGateways = snapshot->GetNGateways ();
+  uint32_t i = 0;
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j, ++i)
+    {
+      Ptr<LoraNetDevice> loraNetDevice = (*j)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<ClassAEndDeviceLorawanMac> mac =
+          loraNetDevice->GetMac ()->GetObject<ClassAEndDeviceLorawanMac> ();
+      NS_ASSERT (mac != 0);
+
+      // The best gateway is the one with the lowest path loss. Without
+      // gateways, all devices are out of range.
+      double rxPower = -std::numeric_limits<double>::infinity ();
+      if (nGateways > 0)
+        {
+          const float *pathLoss = snapshot->GetPathLossRow (i);
+          float lowestPathLoss = *std::min_element (pathLoss, pathLoss + nGateways);
+
+          // Assume devices transmit at 14 dBm
+          rxPower = 14 - lowestPathLoss;
+        }
+
+      Ptr<EndDeviceLoraPhy> edPhy = loraNetDevice->GetPhy ()->GetObject<EndDeviceLoraPhy> ();
+      SetDataRateForRxPower (mac, edPhy->sensitivity, rxPower, sfQuantity);
+    }
+
+  return sfQuantity;
+}
+
+void
+LorawanMacHelper::SetDataRateForRxPower (Ptr<ClassAEndDeviceLorawanMac> mac,
+                                         const double *edSensitivity,
+                                         double rxPower,
+                                         std::vector<int> &sfQuantity)
+{
+  if (rxPower > *edSensitivity)
+    {
+      mac->SetDataRate (5);
+      sfQuantity[0] = sfQuantity[0] + 1;
+    }
+  else if (rxPower > *(edSensitivity + 1))
+    {
+      mac->SetDataRate (4);
+      sfQuantity[1] = sfQuantity[1] + 1;
+    }
+  else if (rxPower > *(edSensitivity + 2))
+    {
+      mac->SetDataRate (3);
+      sfQuantity[2] = sfQuantity[2] + 1;
+    }
+  else if (rxPower > *(edSensitivity + 3))
+    {
+      mac->SetDataRate (2);
+      sfQuantity[3] = sfQuantity[3] + 1;
+    }
+  else if (rxPower > *(edSensitivity + 4))
+    {
+      mac->SetDataRate (1);
+      sfQuantity[4] = sfQuantity[4] + 1;
+    }
+  else if (rxPower > *(edSensitivity + 5))
+    {
+      mac->SetDataRate (0);
+      sfQuantity[5] = sfQuantity[5] + 1;
+    }
+  else // Device is out of range. Assign SF12.
+    {
+      // NS_LOG_DEBUG ("Device out of range");
+      mac->SetDataRate (0);
+      sfQuantity[6] = sfQuantity[6] + 1;
+      // NS_LOG_DEBUG ("sfQuantity[6] = " << sfQuantity[6]);
+    }
+}
+
 std::vector<int>
 LorawanMacHelper::SetSpreadingFactorsGivenDistribution (NodeContainer endDevices,
                                                         NodeContainer gateways,
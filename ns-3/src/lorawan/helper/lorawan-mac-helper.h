@@ -30,6 +30,7 @@
 #include "ns3/gateway-lorawan-mac.h"
 #include "ns3/node-container.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/lora-topology-snapshot.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -110,6 +111,13 @@ public:
    */
   static std::vector<int> SetSpreadingFactorsUp (NodeContainer endDevices, NodeContainer gateways,
                                                  Ptr<LoraChannel> channel);
+
+  /**
+   * Set up the end device's data rates like the method above, but using the
+   * path losses precomputed in a topology snapshot instead of the channel.
+   */
+  static std::vector<int> SetSpreadingFactorsUp (NodeContainer endDevices,
+                                                 Ptr<LoraTopologySnapshot> snapshot);
   /**
    * Set up the end device's data rates according to the given distribution.
    */
@@ -118,6 +126,15 @@ public:
                                                                 std::vector<double> distribution);
 
 private:
+  /**
+   * Set the data rate of an end device to the fastest one whose sensitivity
+   * is below rxPower, and count it in sfQuantity.
+   */
+  static void SetDataRateForRxPower (Ptr<ClassAEndDeviceLorawanMac> mac,
+                                     const double *edSensitivity,
+                                     double rxPower,
+                                     std::vector<int> &sfQuantity);
+
   /**
    * Perform region-specific configurations for the 868 MHz EU band.
    */
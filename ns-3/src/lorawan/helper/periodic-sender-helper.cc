@@ -25,12 +25,12 @@
 #include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/simulator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("PeriodicSenderHelper");
+LORA_LOG_COMPONENT_DEFINE ("PeriodicSenderHelper");
 
 PeriodicSenderHelper::PeriodicSenderHelper ()
 {
@@ -19,6 +19,7 @@
  */
 
 #include "ns3/adr-component.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -27,7 +28,7 @@ namespace lorawan {
 // LinkAdrRequest commands management //
 ////////////////////////////////////////
 
-NS_LOG_COMPONENT_DEFINE ("AdrComponent");
+LORA_LOG_COMPONENT_DEFINE ("AdrComponent");
 
 NS_OBJECT_ENSURE_REGISTERED (AdrComponent);
 
@@ -95,12 +96,7 @@ AdrComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraFrameHeaderView fHdr (status->GetLastPacketReceivedFromDevice ());
 
   //Execute the ADR algotithm only if the request bit is set
   if (fHdr.GetAdr ())
@@ -19,8 +19,10 @@
  */
 
 #include "ns3/adr-bandit-agent.h"
-#include "ns3/log.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-log.h"
 #include <boost/multi_array.hpp>
+#include <cmath>
 #include <Eigen/Core>
 //#include <eigen3/Eigen/Core>
 //#include <AIToolbox/Bandit/Types.hpp>
@@ -34,7 +36,7 @@ using namespace AIToolbox::Bandit;
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("ADRBanditAgent");
+LORA_LOG_COMPONENT_DEFINE ("ADRBanditAgent");
 NS_OBJECT_ENSURE_REGISTERED (AdrBanditAgent);
 
 
@@ -111,12 +113,11 @@ AdrBanditAgent::UpdateReward (size_t arm_number, double reward)
 size_t
 AdrBanditAgent::ChooseArm ()
 {
-  NS_LOG_FUNCTION ( "getRewardMatrix:" << "\n" << m_experience.getRewardMatrix());
-  //NS_LOG_FUNCTION ( "getM2Matrix (Variance):" << "\n" <<  m_experience.getM2Matrix());
-  NS_LOG_FUNCTION ( "getPolicy:" << "\n" <<  m_aiPolicy->getPolicy());
-
-
-
+  LORA_PROFILE_SCOPE ("AdrBanditAgent::ChooseArm");
+  NS_LOG_FUNCTION (this);
+  // The policy itself is not logged: Thompson sampling estimates it by
+  // sampling every arm many times (see the ArmPosterior trace source instead)
+  NS_LOG_LOGIC ("getRewardMatrix:" << "\n" << m_experience.getRewardMatrix());
 
   return m_aiPolicy->sampleAction();
 }
@@ -127,5 +128,29 @@ AdrBanditAgent::GetNumberOfArms ()
   return NUMER_OF_ARMS;
 }
 
+uint32_t
+AdrBanditAgent::GetArmPulls (size_t armNumber) const
+{
+  return m_experience.getVisitsTable ()[armNumber];
+}
+
+double
+AdrBanditAgent::GetArmMeanReward (size_t armNumber) const
+{
+  return m_experience.getRewardMatrix ()[armNumber];
+}
+
+double
+AdrBanditAgent::GetArmMeanRewardStd (size_t armNumber) const
+{
+  double pulls = m_experience.getVisitsTable ()[armNumber];
+  if (pulls < 2)
+    {
+      return 0;
+    }
+  // M2 is the sum of the squared deviations from the mean
+  return std::sqrt (m_experience.getM2Matrix ()[armNumber] / (pulls * (pulls - 1)));
+}
+
 } /* namespace lorawan */
 } /* namespace ns3 */
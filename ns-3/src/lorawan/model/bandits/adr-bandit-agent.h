@@ -73,6 +73,30 @@ public:
    */
   size_t  GetNumberOfArms ();
 
+  /**
+   * @brief Get the number of rewards recorded for an arm (bootstrapping included)
+   *
+   * @param armNumber
+   * @return The number of pulls of the arm
+   */
+  uint32_t GetArmPulls (size_t armNumber) const;
+
+  /**
+   * @brief Get the mean of the rewards recorded for an arm
+   *
+   * @param armNumber
+   * @return The mean reward, the center of the posterior sampled by Thompson sampling
+   */
+  double GetArmMeanReward (size_t armNumber) const;
+
+  /**
+   * @brief Get the spread of the posterior of the mean reward of an arm
+   *
+   * @param armNumber
+   * @return The standard error of the mean reward, or 0 with less than two pulls
+   */
+  double GetArmMeanRewardStd (size_t armNumber) const;
+
   /* TODO we start with a 2-arm bandit: SF12 and SF9 */
 
 
@@ -21,6 +21,9 @@
 #ifndef SRC_LORAWAN_MODEL_BANDITS_BANDIT_CONSTANTS_H_
 #define SRC_LORAWAN_MODEL_BANDITS_BANDIT_CONSTANTS_H_
 
+#include "ns3/lora-airtime.h"
+#include <array>
+
 namespace ns3 {
 namespace lorawan {
 
@@ -36,8 +39,12 @@ namespace banditConstants
   inline constexpr int framesForBoostraping  = 15   ; // The number of frames before the bandit starts asking for feedback
   inline constexpr double pAskingForFeedback = 0.05 ; // p of asking for feedback (Bernoulli)
 
-  /*                                      Rewards = {SF12, SF11, SF10, SF9 , SF8  , SF7 }   */
-  inline constexpr double rewardsTOARatioFor32B[] = { 1  , 1.8 , 4.0 , 7.3 , 13.6 , 25.2} ; // Time on air ratio for 32Bytes (https://loratiiks.nk/#/airtime)
+  /* Time on air ratio (SF12 over each SF) for any PHY payload size, computed at compile time by LoraAirtime
+   *                                                       Rewards = {SF12, SF11, SF10, SF9 , SF8  , SF7 }   */
+  template <uint32_t payloadSize>
+  inline constexpr std::array<double, 6> rewardsTOARatioFor = LoraAirtime::GetOnAirTimeRatios (payloadSize);
+
+  inline constexpr std::array<double, 6> rewardsTOARatioFor32B = rewardsTOARatioFor<32>; // ~{ 1, 1.8, 4.0, 7.3, 13.5, 25.2 }
   inline constexpr double rewardsEnergySimple[]   = { 1  , 2   , 4   , 8   , 16   , 32  } ; // Naif energy pondered reward
   inline constexpr double rewardsPurePDR[]        = { 1  , 1   , 1   , 1   , 1    , 1   } ; // Naif pure PDR
 
@@ -45,6 +52,7 @@ namespace banditConstants
 
 
 
+  // (A time on air ratio is selected with e.g. rewardsTOARatioFor<51>.data ())
   inline constexpr const double * rewardsDefinition     =  rewardsEnergySimple ; 
   /* we need constexpr and const https://stackoverflow.com/questions/14116003/difference-between-constexpr-and-const */
 
@@ -19,18 +19,43 @@
  */
 
 #include "bandit-delayed-reward-intelligence.h"
+#include "ns3/lora-log.h"
+#include "ns3/integer.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("BanditDelayedRewardIntelligence");
+LORA_LOG_COMPONENT_DEFINE ("BanditDelayedRewardIntelligence");
 NS_OBJECT_ENSURE_REGISTERED (BanditDelayedRewardIntelligence);
 
 TypeId BanditDelayedRewardIntelligence::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::BanditDelayedRewardIntelligence")
+    .SetParent<Object> ()
     .SetGroupName ("lorawan")
     .AddConstructor<BanditDelayedRewardIntelligence> ()
+    .AddAttribute ("FramesForBootstrapping",
+                   "Number of frames sent before the bandit starts asking "
+                   "for feedback",
+                   IntegerValue (banditConstants::framesForBoostraping),
+                   MakeIntegerAccessor (&BanditDelayedRewardIntelligence::m_framesForBootstrapping),
+                   MakeIntegerChecker<int> (0))
+    .AddAttribute ("FeedbackProbability",
+                   "Probability of asking for feedback after the "
+                   "bootstrapping frames",
+                   DoubleValue (banditConstants::pAskingForFeedback),
+                   MakeDoubleAccessor (&BanditDelayedRewardIntelligence::m_feedbackProbability),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("RewardMode",
+                   "How the reward of a successful pull of an arm is "
+                   "computed: the static per-arm weights, or the "
+                   "deliveries per Joule measured on that arm",
+                   EnumValue (BanditDelayedRewardIntelligence::STATIC_REWARDS),
+                   MakeEnumAccessor (&BanditDelayedRewardIntelligence::m_rewardMode),
+                   MakeEnumChecker (BanditDelayedRewardIntelligence::STATIC_REWARDS, "Static",
+                                    BanditDelayedRewardIntelligence::DELIVERIES_PER_JOULE, "DeliveriesPerJoule"))
     ;
   return tid;
 }
@@ -42,8 +67,13 @@ TypeId BanditDelayedRewardIntelligence::GetTypeId (void)
 static inline const double* rewards = banditConstants::rewardsDefinition;
 
 
-BanditDelayedRewardIntelligence::BanditDelayedRewardIntelligence ()
+BanditDelayedRewardIntelligence::BanditDelayedRewardIntelligence () :
+  m_armsEnergy (HARDCODED_NUMBER_ARMS, 0.0),
+  m_rewardMode (STATIC_REWARDS),
+  m_framesForBootstrapping (banditConstants::framesForBoostraping),
+  m_feedbackProbability (banditConstants::pAskingForFeedback)
 {
+  m_uniformRV = CreateObject<UniformRandomVariable> ();
 
   // We set-up the arms rewards values:
   for (int i = 0; i < HARDCODED_NUMBER_ARMS; i++)
@@ -83,20 +113,17 @@ BanditDelayedRewardIntelligence::InitBanditAgentAndArms (
   //this->CleanArmsStats();
   //TODO: initialize arms use reward vector
 
-  NS_LOG_INFO("\033[1;31m");
   NS_LOG_INFO("m_armsAndRewardsVector.size()" << m_armsAndRewardsVector.size());
-
-  NS_LOG_INFO("\033[0m");
 }
 
 void
 BanditDelayedRewardIntelligence::setBanditNeedStats (int frameCnt)
 {
-  if (frameCnt < banditConstants::framesForBoostraping) //If Frame is lower than "framesForBoostraping" (e.g., 15) we do not ask for feedback
+  if (frameCnt < m_framesForBootstrapping) //If Frame is lower than "FramesForBootstrapping" (e.g., 15) we do not ask for feedback
     {
       setBanditNeedsStats (false);
     }
-  else if (bernoulliDistribution (generator)) // We ask for feedback with p=p1 (banditConstants::pAskingForFeedback)
+  else if (m_uniformRV->GetValue () < m_feedbackProbability) // We ask for feedback with p=p1 (FeedbackProbability)
     {
       setBanditNeedsStats (true);
     }
@@ -142,6 +169,12 @@ BanditDelayedRewardIntelligence::UpdateUsedArm (size_t armNumber,  int frameCnt)
 
 }
 
+void
+BanditDelayedRewardIntelligence::UpdateArmEnergy (size_t armNumber, double energy)
+{
+  m_armsEnergy[armNumber] += energy;
+}
+
 Ptr<BanditRewardReq>
 BanditDelayedRewardIntelligence::GetRewardsMacCommandReq (uint16_t currentFrame)
 {
@@ -149,17 +182,12 @@ BanditDelayedRewardIntelligence::GetRewardsMacCommandReq (uint16_t currentFrame)
   m_requestedMaxFrmCntReward = currentFrame; // Important to keep track, because in case of re-sent message m_requestedMaxFrmCntReward will be < m_frmCntMaxWithoutStats
 
   uint8_t frameDelta =  currentFrame - m_frmCntMinWithoutStats;
-  // Colored Terminal: https://stackoverflow.com/questions/2616906/how-do-i-output-coloured-text-to-a-linux-terminal
-  NS_LOG_INFO("\033[1;31m");
-
-  NS_LOG_INFO("m_armsAndRewardsVector.size(): " << m_armsAndRewardsVector.size());
-  NS_LOG_INFO("printArmsAndRewardsVector: "<< printArmsAndRewardsVector());
+  NS_LOG_LOGIC("printArmsAndRewardsVector: "<< printArmsAndRewardsVector());
   NS_LOG_INFO("GetRewardsMacCommandReq. frameDelta = " << unsigned(frameDelta) << "  currentFrame: " << currentFrame);
 
   Ptr<BanditRewardReq> req = CreateObject<BanditRewardReq> (currentFrame, frameDelta); //CreateObject<BanditRewardReq> vs Create<BanditRewardReq>?
   m_waitingForStats= true;
 
-  NS_LOG_INFO("\033[0m");
   return req;
 }
 
@@ -207,7 +235,7 @@ BanditDelayedRewardIntelligence::ConsolidateRewardsIntoBandit ()
       int timesArmWorkedNOT = timesArmUsed - timesArmWorked;
 
       // std::get<2>(m_armsAndRewardsVector[currentArm]) --> Currently not used, it  was meant to store a PDR-based reward
-      double armWorkedReward    = std::get<3>(m_armsAndRewardsVector[currentArm]);
+      double armWorkedReward    = GetArmWorkedReward (currentArm);
       double armWorkedNOTReward = 0;
 
       NS_LOG_INFO("timesArmWorked: "    << timesArmWorked    <<" , armWorkedReward: "<< armWorkedReward);
@@ -221,19 +249,40 @@ BanditDelayedRewardIntelligence::ConsolidateRewardsIntoBandit ()
 
     }
 
-  NS_LOG_FUNCTION("printArmsAndRewardsVector():\n"<< printArmsAndRewardsVector());
+  NS_LOG_LOGIC("printArmsAndRewardsVector():\n"<< printArmsAndRewardsVector());
 
   CleanArmsStats ();
 
 }
 
 
+double
+BanditDelayedRewardIntelligence::GetArmWorkedReward (size_t armNumber) const
+{
+  if (m_rewardMode == DELIVERIES_PER_JOULE)
+    {
+      // A success is worth the inverse of the mean energy of a pull, so that the
+      // mean reward of the arm is its measured number of deliveries per Joule
+      int timesArmUsed = std::get<0>(m_armsAndRewardsVector[armNumber]);
+      double armEnergy = m_armsEnergy[armNumber];
+      return (armEnergy > 0) ? timesArmUsed / armEnergy : 0;
+    }
+  return std::get<3>(m_armsAndRewardsVector[armNumber]);
+}
+
+int
+BanditDelayedRewardIntelligence::GetTimesArmUsed (size_t armNumber) const
+{
+  return std::get<0>(m_armsAndRewardsVector[armNumber]);
+}
+
 void
 BanditDelayedRewardIntelligence::CleanArmsStats ()
 {
   for (unsigned int i = 0; i < m_armsAndRewardsVector.size(); i++)
     {
       std::get<0>(m_armsAndRewardsVector[i]) = std::get<1>(m_armsAndRewardsVector[i]) =  std::get<2>(m_armsAndRewardsVector[i]) = 0;
+      m_armsEnergy[i] = 0;
     }
 }
 
@@ -260,12 +309,13 @@ BanditDelayedRewardIntelligence::printArmsAndRewardsVector ()
   std::stringstream ss;
 
   ss<<"\n";
-  ss<<"(Sent\t, Rcvd\t, PDR\t, Weight \t)\n";
+  ss<<"(Sent\t, Rcvd\t, PDR\t, Weight \t, Joules \t)\n";
 
   for (unsigned int i = 0; i < m_armsAndRewardsVector.size(); i++)
     {
       ss << "("    << std::get<0>(m_armsAndRewardsVector[i]) << "\t, " << std::get<1>(m_armsAndRewardsVector[i])
-	 <<  "\t, " << std::get<2>(m_armsAndRewardsVector[i]) << "\t, " << std::get<3>(m_armsAndRewardsVector[i])<< " )\n";
+	 <<  "\t, " << std::get<2>(m_armsAndRewardsVector[i]) << "\t, " << std::get<3>(m_armsAndRewardsVector[i])
+	 <<  "\t, " << m_armsEnergy[i] << " )\n";
     }
 
   return ss.str();
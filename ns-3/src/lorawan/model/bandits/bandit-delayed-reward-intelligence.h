@@ -28,8 +28,8 @@
 #include "ns3/adr-bandit-agent.h"
 #include "ns3/mac-command.h"
 #include "ns3/bandit-constants.h"
+#include "ns3/random-variable-stream.h"
 //#include "ns3/end-device-status.h" // for ReceivedPacketList
-#include <random> // For the bernoulli distribution
 
 
 namespace ns3 {
@@ -44,6 +44,15 @@ namespace lorawan {
 class BanditDelayedRewardIntelligence : public Object
 {
 public:
+  /**
+   * How the reward of a successful pull of an arm is computed.
+   */
+  enum RewardMode
+  {
+    STATIC_REWARDS,       //!< The constant per-arm weights of banditConstants::rewardsDefinition
+    DELIVERIES_PER_JOULE  //!< The deliveries per Joule measured on the arm since the last feedback
+  };
+
   static TypeId GetTypeId (void);
 
   //Constructor
@@ -91,6 +100,32 @@ public:
    */
   void UpdateUsedArm(size_t armNumber, int frameCnt);
 
+  /**
+   * @brief This function accumulates the energy spent transmitting with an arm,
+   * retransmissions included, until the next feedback is consolidated.
+   *
+   * @param armNumber The arm that was used for the transmission
+   * @param energy The energy consumed by the transmission, in Joules
+   */
+  void UpdateArmEnergy(size_t armNumber, double energy);
+
+  /**
+   * @brief The reward of each successful pull of an arm, as used by ConsolidateRewardsIntoBandit.
+   *
+   * @param armNumber The arm
+   * @return The static weight of the arm, or the inverse of the mean energy of its pulls
+   * since the last feedback (in 1/J) in DELIVERIES_PER_JOULE mode
+   */
+  double GetArmWorkedReward(size_t armNumber) const;
+
+  /**
+   * @brief The number of times an arm was used since the last feedback was consolidated.
+   *
+   * @param armNumber The arm
+   * @return The packets sent with the arm
+   */
+  int GetTimesArmUsed(size_t armNumber) const;
+
   void CleanArmsStats();
 
 
@@ -133,11 +168,14 @@ protected:
   typedef std::tuple <int, int, double, double> arm_stats; // <packets sent, packets rcv, Packet Delivery Ratio (raw reward), reward scaling factor>
   std::vector<arm_stats> m_armsAndRewardsVector;
 
-  // Static/shared members (Maybe not a good idea... maybe a global static object is better?)
-  // https://stackoverflow.com/questions/3409428/putting-class-static-members-definition-into-cpp-file-technical-limitation
-  // https://stackoverflow.com/questions/46874055/why-is-inline-required-on-static-inline-variables
-  static inline std::default_random_engine generator; /* This makes the simulation deterministic if all inputs are the same TODO: see if we want better randomness use other RNG */
-  static inline std::bernoulli_distribution bernoulliDistribution{ banditConstants::pAskingForFeedback }; // p of asking for STATS
+  std::vector<double> m_armsEnergy; // Joules spent transmitting with each arm since the last feedback
+
+  enum RewardMode m_rewardMode;
+
+  int m_framesForBootstrapping; // Number of frames before the bandit starts asking for feedback
+  double m_feedbackProbability; // p of asking for STATS (Bernoulli)
+
+  Ptr<UniformRandomVariable> m_uniformRV; // Drawn from the ns-3 RNG, so that it changes with RngRun
 
 
 };
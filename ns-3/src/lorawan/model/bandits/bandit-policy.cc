@@ -19,13 +19,13 @@
  */
 
 #include "bandit-policy.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("BanditPolicy");
+LORA_LOG_COMPONENT_DEFINE ("BanditPolicy");
 NS_OBJECT_ENSURE_REGISTERED (BanditPolicy);
 
 TypeId
@@ -22,7 +22,8 @@
 #include "ns3/class-a-end-device-lorawan-mac-bandit.h"
 #include "ns3/end-device-lorawan-mac.h"
 #include "ns3/end-device-lora-phy.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
+#include "ns3/energy-source-container.h"
 
 #include "ns3/lora-tag.h"
 
@@ -33,7 +34,7 @@
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("ClassAEndDeviceLorawanMacBandit");
+LORA_LOG_COMPONENT_DEFINE ("ClassAEndDeviceLorawanMacBandit");
 NS_OBJECT_ENSURE_REGISTERED (ClassAEndDeviceLorawanMacBandit);
 
 // BEGIN Auxiliary functions
@@ -75,12 +76,48 @@ ClassAEndDeviceLorawanMacBandit::GetTypeId (void)
 static TypeId tid = TypeId ("ns3::ClassAEndDeviceLorawanMacBandit")
   .SetParent<ClassAEndDeviceLorawanMac> ()
   .SetGroupName ("lorawan")
-  .AddConstructor<ClassAEndDeviceLorawanMacBandit> ();
+  .AddConstructor<ClassAEndDeviceLorawanMacBandit> ()
+  .AddTraceSource ("TxEnergyConsumption",
+                   "Total energy consumed by the transmissions of this "
+                   "device, in Joules",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_txEnergyConsumption),
+                   "ns3::TracedValueCallback::Double")
+  .AddTraceSource ("TxEnergy",
+                   "Data rate and energy, in Joules, of each transmission",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_txEnergy),
+                   "ns3::ClassAEndDeviceLorawanMacBandit::TxEnergyCallback")
+  .AddTraceSource ("ArmChosen",
+                   "Arm (data rate) chosen by the bandit for a new packet, "
+                   "and the frame counter of the packet",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_armChosen),
+                   "ns3::ClassAEndDeviceLorawanMacBandit::ArmChosenCallback")
+  .AddTraceSource ("FeedbackRequested",
+                   "Frames covered by a BanditRewardReq added to a packet",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_feedbackRequested),
+                   "ns3::ClassAEndDeviceLorawanMacBandit::FeedbackRequestedCallback")
+  .AddTraceSource ("RewardsConsolidated",
+                   "Packets sent and received with an arm since the last "
+                   "feedback, and the reward of a reception, when a "
+                   "BanditRewardAns is given to the bandit",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_rewardsConsolidated),
+                   "ns3::ClassAEndDeviceLorawanMacBandit::RewardsConsolidatedCallback")
+  .AddTraceSource ("ArmPosterior",
+                   "Pulls, mean reward and standard error of the mean "
+                   "reward of each arm after a BanditRewardAns",
+                   MakeTraceSourceAccessor
+                     (&ClassAEndDeviceLorawanMacBandit::m_armPosterior),
+                   "ns3::ClassAEndDeviceLorawanMacBandit::ArmPosteriorCallback");
 return tid;
 }
 
-ClassAEndDeviceLorawanMacBandit::ClassAEndDeviceLorawanMacBandit () //:
-		//ClassAEndDeviceLorawanMac() // It is already called
+ClassAEndDeviceLorawanMacBandit::ClassAEndDeviceLorawanMacBandit () :
+  m_txEnergyConsumption (0),
+  m_energyModelLookedUp (false)
 {
   NS_LOG_FUNCTION (this  <<  "I am a bandit" );
   this->m_adrBanditAgent = Create<AdrBanditAgent> ();
@@ -92,7 +129,7 @@ ClassAEndDeviceLorawanMacBandit::ClassAEndDeviceLorawanMacBandit () //:
 
 
   //[Renzo] I am doing a shorcut to have the pointer in the  m_adrBanditRewardHelper TODO: proper constructor/encapsulation
-  Ptr<BanditDelayedRewardIntelligence> tmp = Create<BanditDelayedRewardIntelligence> ();
+  Ptr<BanditDelayedRewardIntelligence> tmp = CreateObject<BanditDelayedRewardIntelligence> ();
 
   tmp->m_adrBanditAgent = this->m_adrBanditAgent;
   this->m_banditDelayedRewardIntelligence = tmp;
@@ -114,10 +151,7 @@ void
 ClassAEndDeviceLorawanMacBandit::DoSendBeforeApplyNecessaryOptions (Ptr<Packet> packet)
 {
   //This function only called one new packets, not on re-transmission
-  // Colored Terminal: https://stackoverflow.com/questions/2616906/how-do-i-output-coloured-text-to-a-linux-terminal
-  NS_LOG_INFO("\033[1;31m");
-
-  NS_LOG_INFO("DoSendBeforeApplyNecessaryOptions");
+  NS_LOG_FUNCTION (this << packet);
 
   // Classic ADR (Adaptation at the ED only) disabled:
   m_enableDRAdapt = false; // Renzo: we disable it for bandits! ---> I put it in DoSendBeforeApplyNecessaryOptions
@@ -135,6 +169,7 @@ ClassAEndDeviceLorawanMacBandit::DoSendBeforeApplyNecessaryOptions (Ptr<Packet>
     //m_dataRate = 4 ; // Debugging with SF7 to create lost frames
 
     m_banditDelayedRewardIntelligence->UpdateUsedArm(m_dataRate, this->m_currentFCnt);
+    m_armChosen (m_dataRate, m_currentFCnt);
 
 
     NS_LOG_INFO ("Bandit chosen DR!:" << unsigned(m_dataRate));
@@ -165,16 +200,13 @@ ClassAEndDeviceLorawanMacBandit::DoSendBeforeApplyNecessaryOptions (Ptr<Packet>
           {
   	  Ptr<BanditRewardReq> req = m_banditDelayedRewardIntelligence->GetRewardsMacCommandReq (currentFrame); // We add the appopiate MAC command
   	  this->AddMacCommand (req);
+  	  m_feedbackRequested (req->GetFrameCountMax (), req->GetFrameCountDeltaMin ());
           }
 
       }
 
 
     //***************************************************************
-
-
-
-  NS_LOG_INFO("\033[0m");
 }
 
 void
@@ -229,6 +261,12 @@ ClassAEndDeviceLorawanMacBandit::SendToPhy (Ptr<Packet> packetToSend)
   // Compute packet duration
   Time duration = m_phy->GetOnAirTime (packetToSend, params);
 
+  // Account for the energy of this transmission (retransmissions included)
+  double energy = GetTxEnergyConsumption (duration);
+  m_txEnergyConsumption += energy;
+  m_txEnergy (m_dataRate, energy);
+  m_banditDelayedRewardIntelligence->UpdateArmEnergy (m_dataRate, energy);
+
   // Register the sent packet into the DutyCycleHelper
   m_channelHelper.AddEvent (duration, txChannel);
 
@@ -252,6 +290,41 @@ ClassAEndDeviceLorawanMacBandit::SendToPhy (Ptr<Packet> packetToSend)
 
 }
 
+double
+ClassAEndDeviceLorawanMacBandit::GetTxEnergyConsumption (Time duration)
+{
+  if (!m_energyModelLookedUp)
+    {
+      m_energyModelLookedUp = true;
+      Ptr<EnergySourceContainer> sources = 0;
+      if (m_device && m_device->GetNode ())
+        {
+          sources = m_device->GetNode ()->GetObject<EnergySourceContainer> ();
+        }
+      for (uint32_t i = 0; sources && i < sources->GetN () && !m_energyModel; i++)
+        {
+          DeviceEnergyModelContainer models =
+            sources->Get (i)->FindDeviceEnergyModels ("ns3::LoraRadioEnergyModel");
+          if (models.GetN () > 0)
+            {
+              m_energyModel = models.Get (0)->GetObject<LoraRadioEnergyModel> ();
+            }
+        }
+      if (!m_energyModel)
+        {
+          NS_LOG_DEBUG ("No LoraRadioEnergyModel, using a LinearLoraTxCurrentModel");
+          m_txCurrentModel = CreateObject<LinearLoraTxCurrentModel> ();
+        }
+    }
+
+  if (m_energyModel)
+    {
+      return m_energyModel->GetTxEnergyConsumption (m_txPower, duration);
+    }
+  return duration.GetSeconds () * m_txCurrentModel->CalcTxCurrent (m_txPower)
+         * m_txCurrentModel->GetVoltage ();
+}
+
 /**
  * @brief Class to implement the bandit delayed feedback learning
  *
@@ -284,19 +357,36 @@ ClassAEndDeviceLorawanMacBandit::BanditDelayedFeedbackUpdate (
     Ptr<BanditRewardAns> delayedRewards)
 {
 
-  // Colored Terminal: https://stackoverflow.com/questions/2616906/how-do-i-output-coloured-text-to-a-linux-terminal
-  NS_LOG_FUNCTION("\033[1;32m");
-  NS_LOG_FUNCTION("delayedRewards->GetDataRateStatistics(): "<<delayedRewards->GetDataRateStatistics());
-
-  //std::vector<int> drStatistics = delayedRewards->GetDataRateStatistics();
-  m_banditDelayedRewardIntelligence->UpdateRewardsAns(delayedRewards); // (this->m_currentFCnt)
+  NS_LOG_FUNCTION (this << delayedRewards);
 
+  // The feedback is traced before UpdateRewardsAns cleans the statistics of the arms
+  if (!m_rewardsConsolidated.IsEmpty ())
+    {
+      std::vector<int> drStatistics = delayedRewards->GetDataRateStatistics ();
+      for (size_t arm = 0; arm < m_adrBanditAgent->GetNumberOfArms (); arm++)
+        {
+          int sent = m_banditDelayedRewardIntelligence->GetTimesArmUsed (arm);
+          if (sent > 0)
+            {
+              m_rewardsConsolidated (arm, sent, drStatistics[arm],
+                                     m_banditDelayedRewardIntelligence->GetArmWorkedReward (arm));
+            }
+        }
+    }
 
-  //NS_LOG_FUNCTION("m_banditDelayedRewardIntelligence->printArmsAndRewardsVector():\n"<< m_banditDelayedRewardIntelligence->printArmsAndRewardsVector());
+  m_banditDelayedRewardIntelligence->UpdateRewardsAns(delayedRewards); // (this->m_currentFCnt)
 
+  if (!m_armPosterior.IsEmpty ())
+    {
+      for (size_t arm = 0; arm < m_adrBanditAgent->GetNumberOfArms (); arm++)
+        {
+          m_armPosterior (arm, m_adrBanditAgent->GetArmPulls (arm),
+                          m_adrBanditAgent->GetArmMeanReward (arm),
+                          m_adrBanditAgent->GetArmMeanRewardStd (arm));
+        }
+    }
 
 
-  NS_LOG_FUNCTION("\033[0m");
 }
 
 
@@ -308,39 +398,27 @@ ClassAEndDeviceLorawanMacBandit::Receive (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
 
-  // Work on a copy of the packet
-  Ptr<Packet> packetCopy = packet->Copy ();
-
-  // Remove the Mac Header to get some information
-  LorawanMacHeader mHdr;
-  packetCopy->RemoveHeader (mHdr);
-
-
-  //NS_LOG_DEBUG ("Mac Header: " << mHdr);
+  // Read the headers in place, without copying the packet
+  LoraFrameHeaderView view (packet);
 
   // Only keep analyzing the packet if it's downlink
-  if (!mHdr.IsUplink ())
+  if (!view.IsUplink ())
     {
       NS_LOG_INFO ("Found a downlink packet.");
 
-      // Remove the Frame Header
-      LoraFrameHeader fHdr;
-      fHdr.SetAsDownlink ();
-      packetCopy->RemoveHeader (fHdr);
-
-      //Renzo Disable TODO
-      //NS_LOG_DEBUG ("Frame Header: " << fHdr);
-
       // Determine whether this packet is for us
-      bool messageForUs = (m_address == fHdr.GetAddress ());
+      bool messageForUs = (m_address == view.GetAddress ());
 
       if (messageForUs)
         {
           NS_LOG_INFO ("The message is for us!");
 
+          // Decode the Frame Header
+          LoraFrameHeader fHdr = view.GetFrameHeader ();
+
           // If it exists, cancel the second receive window event
           // THIS WILL BE GetReceiveWindow()
-          Simulator::Cancel (m_secondReceiveWindow);
+          m_secondReceiveWindow.Cancel ();
 
 
           // Parse the MAC commands (will include a call to OnBanditRewardAns if the MAC is present)
@@ -421,7 +499,7 @@ ClassAEndDeviceLorawanMacBandit::OnLinkAdrReq (uint8_t dataRate, uint8_t txPower
 {
   NS_LOG_FUNCTION (this << unsigned (dataRate) << unsigned (txPower) <<
                    repetitions);
-  NS_LOG_FUNCTION ("\t\t OnLinkAdrReq! But I am a bandit and I do *not* Care !!!!");
+  NS_LOG_DEBUG ("Bandits choose their own data rate: LinkAdrReq ignored");
 
   // Three bools for three requirements before setting things up
   bool channelMaskOk = true;
@@ -447,8 +525,6 @@ ClassAEndDeviceLorawanMacBandit::OnBanditRewardAns (Ptr<MacCommand> banditReward
 
   Ptr<BanditRewardAns> delayedRewards = DynamicCast<BanditRewardAns>(banditRewardAns); // I could have used GetObject<> (); See "downcasting" https://www.nsnam.org/docs/manual/html/object-model.html
 
-  NS_LOG_FUNCTION ("OnBanditRewardAns! I like this MAC command, It has my rewards :D !!!  " << delayedRewards->GetDataRateStatistics());
-
   //m_banditDelayedRewardIntelligence->UpdateRewardsAns (delayedRewards); // Put the logic on function BanditDelayedFeedbackUpdate(delayedRewards);:
   BanditDelayedFeedbackUpdate(delayedRewards);
 
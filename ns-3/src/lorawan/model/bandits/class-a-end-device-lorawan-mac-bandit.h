@@ -25,6 +25,9 @@
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/adr-bandit-agent.h"
 #include "ns3/bandit-delayed-reward-intelligence.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/lora-tx-current-model.h"
+#include "ns3/traced-value.h"
 
 
 namespace ns3 {
@@ -42,6 +45,53 @@ public:
   ClassAEndDeviceLorawanMacBandit (); // TODO inherit the constructors
   virtual ~ClassAEndDeviceLorawanMacBandit (); // TODO inherit the destructor
 
+  /**
+   * TracedCallback signature for the energy of a transmission.
+   *
+   * \param dataRate The data rate (arm) used for the transmission.
+   * \param energy The energy consumed by the transmission, in Joules.
+   */
+  typedef void (* TxEnergyCallback)(uint8_t dataRate, double energy);
+
+  /**
+   * TracedCallback signature for the arm chosen for a new packet.
+   *
+   * \param arm The data rate (arm) chosen by the bandit.
+   * \param frameCounter The frame counter of the packet.
+   */
+  typedef void (* ArmChosenCallback)(uint8_t arm, uint16_t frameCounter);
+
+  /**
+   * TracedCallback signature for a request of feedback (BanditRewardReq).
+   *
+   * \param frameCountMax The last frame the feedback is asked for.
+   * \param frameCountDeltaMin The number of frames before it that are covered.
+   */
+  typedef void (* FeedbackRequestedCallback)(uint16_t frameCountMax,
+                                             uint8_t frameCountDeltaMin);
+
+  /**
+   * TracedCallback signature for the feedback of an arm given to the bandit.
+   *
+   * \param arm The arm.
+   * \param sent The packets sent with the arm since the last feedback.
+   * \param received The packets among them that were received.
+   * \param reward The reward of each received packet.
+   */
+  typedef void (* RewardsConsolidatedCallback)(uint8_t arm, uint32_t sent,
+                                               uint32_t received, double reward);
+
+  /**
+   * TracedCallback signature for the posterior of an arm after a feedback.
+   *
+   * \param arm The arm.
+   * \param pulls The rewards recorded for the arm, bootstrapping included.
+   * \param mean The mean reward of the arm.
+   * \param std The standard error of the mean reward.
+   */
+  typedef void (* ArmPosteriorCallback)(uint8_t arm, uint32_t pulls, double mean,
+                                        double std);
+
 
 
   /////////////////////
@@ -114,9 +164,55 @@ protected:
    */
   virtual void DoSendBeforeApplyNecessaryOptions(Ptr<Packet> packet);
 
+  /**
+   * Compute the energy consumed by a transmission at the current power.
+   *
+   * The LoraRadioEnergyModel installed on the node is used if there is one,
+   * else a LinearLoraTxCurrentModel with its default parameters.
+   *
+   * \param duration The time on air of the transmission.
+   * \return The energy, in Joules.
+   */
+  double GetTxEnergyConsumption (Time duration);
+
+  /**
+   * The total energy consumed by the transmissions of this device, in Joules.
+   */
+  TracedValue<double> m_txEnergyConsumption;
+
+  /**
+   * The trace source fired for each transmission, with its energy.
+   */
+  TracedCallback<uint8_t, double> m_txEnergy;
+
+  /**
+   * The trace source fired when the bandit chooses the arm of a new packet.
+   */
+  TracedCallback<uint8_t, uint16_t> m_armChosen;
+
+  /**
+   * The trace source fired when a BanditRewardReq is added to a packet.
+   */
+  TracedCallback<uint16_t, uint8_t> m_feedbackRequested;
+
+  /**
+   * The trace source fired, for each arm used since the last feedback, when
+   * a BanditRewardAns is given to the bandit.
+   */
+  TracedCallback<uint8_t, uint32_t, uint32_t, double> m_rewardsConsolidated;
+
+  /**
+   * The trace source fired for each arm after a BanditRewardAns was given to
+   * the bandit.
+   */
+  TracedCallback<uint8_t, uint32_t, double, double> m_armPosterior;
 
 private:
 
+  Ptr<LoraRadioEnergyModel> m_energyModel; //!< The energy model of the node, if any
+  bool m_energyModelLookedUp; //!< Whether the node was searched for an energy model
+  Ptr<LinearLoraTxCurrentModel> m_txCurrentModel; //!< Used without energy model
+
 
 
 }; /* ClassAEndDeviceLorawanMacBandit */
@@ -19,6 +19,7 @@
  */
 
 #include "network-controller-component-bandit.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -27,7 +28,7 @@ namespace lorawan {
 // BanditRewardReq commands management //
 ////////////////////////////////////////
 
-NS_LOG_COMPONENT_DEFINE ("NetworkControllerComponentBandit");
+LORA_LOG_COMPONENT_DEFINE ("NetworkControllerComponentBandit");
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkControllerComponentBandit);
 
@@ -70,22 +71,12 @@ NetworkControllerComponentBandit::BeforeSendingReply (Ptr<EndDeviceStatus> statu
                                   Ptr<NetworkStatus> networkStatus)
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
-
-  // Colored Terminal: https://stackoverflow.com/questions/2616906/how-do-i-output-coloured-text-to-a-linux-terminal
-  NS_LOG_FUNCTION ("\033[1;33m");
-  NS_LOG_FUNCTION ("\033[1;33m"<<"Packets received by this device (" << status->GetReceivedPacketList ().size () << ") !!!! "<< "\033[0m");
-  NS_LOG_FUNCTION ("\033[1;33m"<<"Last Packet Frame Count:  (" << status->GetLastReceivedPacketInfo().fCnt << ") OMG !!!!!!!!!!!!!!!!!!!"<< "\033[0m");
-  NS_LOG_FUNCTION ("\033[0m");
+  NS_LOG_DEBUG ("Packets received by this device: " << status->GetReceivedPacketList ().size ()
+                << ", last frame count: " << status->GetLastReceivedPacketInfo ().fCnt);
 
   // See: void AdrComponent::BeforeSendingReply, I inspired from there the packet/reply threatment.
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink (); // [Renzo] why they do this?
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraFrameHeader fHdr = LoraFrameHeaderView (status->GetLastPacketReceivedFromDevice ()).GetFrameHeader ();
 
 
   // Look for the BanditRewardReq , and create a BanditRewardAns
@@ -151,9 +142,7 @@ NetworkControllerComponentBandit::GetBanditRewardAns (
 
   uint16_t frmCntMinAbs =  unsigned(frmCntMaxAbs) - unsigned(frmCntDeltaMin);
 
- // Colored Terminal: https://stackoverflow.com/questions/2616906/how-do-i-output-coloured-text-to-a-linux-terminal
-  NS_LOG_FUNCTION ("\033[1;33m");
-  NS_LOG_FUNCTION ("MAC BanditRewardReq , Frame frmCntMinAbs" << frmCntMinAbs << " .... to frmCntDeltaMin : " << unsigned(frmCntDeltaMin) << " .... to frmCntMaxAbs : " << unsigned(frmCntMaxAbs));
+  NS_LOG_FUNCTION (banditRewardReq << frmCntMinAbs << unsigned (frmCntDeltaMin) << frmCntMaxAbs);
 
   //  typedef std::list<std::pair<Ptr<Packet const>, ReceivedPacketInfo> >   ReceivedPacketList; //EndDeviceStatus::
   //Iteration inspired by "AdrComponent::GetMinSNR"
@@ -170,15 +159,14 @@ NetworkControllerComponentBandit::GetBanditRewardAns (
 
   while (frmCntMinAbs <= frmCurrentIt)
     {
-      NS_LOG_FUNCTION("frmCurrentIt: " << frmCurrentIt);
+      NS_LOG_LOGIC ("frmCurrentIt: " << frmCurrentIt);
 
       if ((frmCntMinAbs <= frmCurrentIt) &&  (frmCurrentIt <= frmCntMaxAbs)) // (frmCntMinAbs <= frmCurrentIt) redundant because its in the while condition
 	{
 	  int SfToDR = (12 - unsigned (it->second.sf)); // number 12 convers from SF to DR ... TODO use proper function
 	  dr_rcv_packets[SfToDR]++;
 
-	  NS_LOG_FUNCTION(
-	      "dr_rcv_packets["<< SfToDR << "]: " << unsigned(dr_rcv_packets[SfToDR]));
+	  NS_LOG_LOGIC ("dr_rcv_packets[" << SfToDR << "]: " << unsigned (dr_rcv_packets[SfToDR]));
 	}
 
       if (frmCntMinAbs == frmCurrentIt) break;
@@ -186,11 +174,11 @@ NetworkControllerComponentBandit::GetBanditRewardAns (
       ++it;
 
       frmCurrentIt = (it->second.fCnt);
-      NS_LOG_FUNCTION("frmNEXTCurrentIt: " << frmCurrentIt << "   frmCntMinAbs: " << frmCntMinAbs);
+      NS_LOG_LOGIC ("frmNEXTCurrentIt: " << frmCurrentIt << "   frmCntMinAbs: " << frmCntMinAbs);
 
       if (it == packetList.rend ()) // [RENZO] Very important to iterate properly.. this whole function could use a refactor.
 	{
-	  NS_LOG_FUNCTION("We prevented the crazy bug!!! \a ");
+	  NS_LOG_DEBUG ("Reached the start of the received packet list");
 	  break;
 	} // A bug could happen if lost frames happened at the beginning, and the frame count was high: We ended up in an infinite loop at
 
@@ -200,10 +188,6 @@ NetworkControllerComponentBandit::GetBanditRewardAns (
     } // The logic I use could be better... I had infinite loop issues with the number Zero, also because it is "unsigned" and we are not using a proper "counter", but real values of  fCnt.
       // All this logic could be done cleaner (also, in current implementation issues can happen in out of order messages -early exit loop ...-).
 
-  NS_LOG_FUNCTION ("\033[0m");
-
-
-
   return CreateObject<BanditRewardAns> (dr_rcv_packets[0],dr_rcv_packets[1],
 					dr_rcv_packets[2],dr_rcv_packets[3],
 					dr_rcv_packets[4],dr_rcv_packets[5]);
@@ -19,13 +19,13 @@
 #include "ns3/building-penetration-loss.h"
 #include "ns3/mobility-building-info.h"
 #include "ns3/double.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <cmath>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("BuildingPenetrationLoss");
+LORA_LOG_COMPONENT_DEFINE ("BuildingPenetrationLoss");
 
 NS_OBJECT_ENSURE_REGISTERED (BuildingPenetrationLoss);
 
@@ -60,8 +60,31 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 {
   NS_LOG_FUNCTION (this << txPowerDbm << a << b);
 
-  Ptr<MobilityBuildingInfo> a1 = a->GetObject<MobilityBuildingInfo> ();
-  Ptr<MobilityBuildingInfo> b1 = b->GetObject<MobilityBuildingInfo> ();
+  uint32_t aIndex = GetNodeIndex (a);
+  uint32_t bIndex = GetNodeIndex (b);
+  return txPowerDbm - CalcLoss (aIndex, bIndex);
+}
+
+void
+BuildingPenetrationLoss::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                             const Ptr<MobilityModel> *b,
+                                             std::size_t n,
+                                             double *powerDbm) const
+{
+  NS_LOG_FUNCTION (this << a << n);
+
+  uint32_t aIndex = GetNodeIndex (a);
+  for (std::size_t i = 0; i < n; i++)
+    {
+      powerDbm[i] -= CalcLoss (aIndex, GetNodeIndex (b[i]));
+    }
+}
+
+double
+BuildingPenetrationLoss::CalcLoss (uint32_t a, uint32_t b) const
+{
+  NodeInfo &a1 = m_nodes[a];
+  NodeInfo &b1 = m_nodes[b];
 
   // These are the components of the loss due to building penetration
   double externalWallLoss = 0;
@@ -70,47 +93,47 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
   double gfh = 0;
 
   // Go through various cases in which a and b are indoors or outdoors
-  if ((b1->IsIndoor () && !a1->IsIndoor ()))
+  if ((b1.indoor && !a1.indoor))
     {
       NS_LOG_INFO ("Tx is outdoors and Rx is indoors");
 
-      externalWallLoss = GetWallLoss (b);     // External wall loss due to b
-      tor1 = GetTor1 (b);     // Internal wall loss due to b
+      externalWallLoss = GetWallLoss (b1);     // External wall loss due to b
+      tor1 = GetTor1 (b1);     // Internal wall loss due to b
       tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
       gfh = 0;
 
     }
-  else if ((!b1->IsIndoor () && a1->IsIndoor ()))
+  else if ((!b1.indoor && a1.indoor))
     {
       NS_LOG_INFO ("Rx is outdoors and Tx is indoors");
 
       // These are the components of the loss due to building penetration
-      externalWallLoss = GetWallLoss (a);
-      tor1 = GetTor1 (a);
+      externalWallLoss = GetWallLoss (a1);
+      tor1 = GetTor1 (a1);
       tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
       gfh = 0;
 
     }
-  else if (!a1->IsIndoor ()&& !b1->IsIndoor ())
+  else if (!a1.indoor && !b1.indoor)
     {
       NS_LOG_DEBUG ("No penetration loss since both devices are outside");
     }
-  else if (a1->IsIndoor ()&& b1->IsIndoor ())
+  else if (a1.indoor && b1.indoor)
     {
       // They are in the same building
-      if (a1->GetBuilding () == b1->GetBuilding ())
+      if (a1.buildingId == b1.buildingId)
         {
           NS_LOG_INFO ("Devices are in the same building");
           // Only internal wall loss
-          tor1 = GetTor1 (b);
+          tor1 = GetTor1 (b1);
           tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
         }
       // They are in different buildings
       else
         {
           // These are the components of the loss due to building penetration
-          externalWallLoss = GetWallLoss (b) + GetWallLoss (a);
-          tor1 = GetTor1 (b) + GetTor1 (a);
+          externalWallLoss = GetWallLoss (b1) + GetWallLoss (a1);
+          tor1 = GetTor1 (b1) + GetTor1 (a1);
           tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
           gfh = 0;
         }
@@ -127,7 +150,67 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 
   NS_LOG_DEBUG ("Total loss due to building penetration: " << loss);
 
-  return txPowerDbm - loss;
+  return loss;
+}
+
+uint32_t
+BuildingPenetrationLoss::GetNodeIndex (const Ptr<MobilityModel> &mobility) const
+{
+  Vector position = mobility->GetPosition ();
+
+  std::unordered_map<const MobilityModel *, uint32_t>::const_iterator it =
+    m_nodeIndices.find (PeekPointer (mobility));
+  if (it != m_nodeIndices.end ())
+    {
+      NodeInfo &node = m_nodes[it->second];
+      if (position < node.position || node.position < position)
+        {
+          Locate (node, position);
+        }
+      return it->second;
+    }
+
+  NS_LOG_FUNCTION (this << mobility);
+
+  NodeInfo node;
+  node.mobility = mobility;
+  node.wallLoss = -1;
+  node.pValue = -1;
+
+  // The first time, trust the MobilityBuildingInfo, which may have been set
+  // by hand
+  Ptr<MobilityBuildingInfo> buildingInfo = mobility->GetObject<MobilityBuildingInfo> ();
+  if (buildingInfo != 0)
+    {
+      node.position = position;
+      node.indoor = buildingInfo->IsIndoor ();
+      node.buildingId = node.indoor ? buildingInfo->GetBuilding ()->GetId () : 0;
+    }
+  else
+    {
+      Locate (node, position);
+    }
+
+  uint32_t index = m_nodes.size ();
+  m_nodes.push_back (node);
+  m_nodeIndices[PeekPointer (mobility)] = index;
+  return index;
+}
+
+void
+BuildingPenetrationLoss::Locate (NodeInfo &node, const Vector &position) const
+{
+  NS_LOG_FUNCTION (this << node.mobility << position);
+
+  if (!m_buildingTree.IsUpToDate ())
+    {
+      m_buildingTree.Build ();
+    }
+
+  Ptr<Building> building = m_buildingTree.FindBuilding (position);
+  node.position = position;
+  node.indoor = (building != 0);
+  node.buildingId = node.indoor ? building->GetId () : 0;
 }
 
 int64_t
@@ -188,23 +271,19 @@ BuildingPenetrationLoss::GetWallLossValue (void) const
 }
 
 double
-BuildingPenetrationLoss::GetWallLoss (Ptr<MobilityModel> b) const
+BuildingPenetrationLoss::GetWallLoss (NodeInfo &node) const
 {
-  NS_LOG_FUNCTION (this << b);
+  NS_LOG_FUNCTION (this << node.mobility);
 
-  std::map<Ptr<MobilityModel>, int>::const_iterator it;
-
-  // Check whether the b device already has a wall loss value
-  it = m_wallLossMap.find (b);
-  if (it == m_wallLossMap.end ())
+  // Check whether the device already has a wall loss value
+  if (node.wallLoss < 0)
     {
-      // Create a random value and insert it on the map
-      m_wallLossMap[b] = GetWallLossValue ();
-      NS_LOG_DEBUG ("Inserted a new wall loss value: " <<
-                    m_wallLossMap.find (b)->second);
+      // Create a random value and store it in the table
+      node.wallLoss = GetWallLossValue ();
+      NS_LOG_DEBUG ("Inserted a new wall loss value: " << int (node.wallLoss));
     }
 
-  switch (m_wallLossMap.find (b)->second)
+  switch (node.wallLoss)
     {
     case 0:
       return m_uniformRV->GetValue (4, 11);
@@ -219,21 +298,18 @@ BuildingPenetrationLoss::GetWallLoss (Ptr<MobilityModel> b) const
 }
 
 double
-BuildingPenetrationLoss::GetTor1 (Ptr<MobilityModel> b) const
+BuildingPenetrationLoss::GetTor1 (NodeInfo &node) const
 {
-  NS_LOG_FUNCTION (this << b);
-
-  std::map<Ptr<MobilityModel>, int>::const_iterator it;
+  NS_LOG_FUNCTION (this << node.mobility);
 
-  // Check whether the b device already has a p value
-  it = m_pMap.find (b);
-  if (it == m_pMap.end ())
+  // Check whether the device already has a p value
+  if (node.pValue < 0)
     {
-      // Create a random p value and insert it on the map
-      m_pMap[b] = GetPValue ();
-      NS_LOG_DEBUG ("Inserted a new p value: " << m_pMap.find (b)->second);
+      // Create a random p value and store it in the table
+      node.pValue = GetPValue ();
+      NS_LOG_DEBUG ("Inserted a new p value: " << int (node.pValue));
     }
-  return m_uniformRV->GetValue (4, 10) * m_pMap.find (b)->second;
+  return m_uniformRV->GetValue (4, 10) * node.pValue;
 }
 }
 }
@@ -23,6 +23,9 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/building-rtree.h"
+#include <unordered_map>
+#include <vector>
 
 namespace ns3 {
 class MobilityModel;
@@ -31,6 +34,12 @@ namespace lorawan {
 
 /**
  * A class implementing the TR 45.820 model for building losses
+ *
+ * The building of each node, and its classes of external wall loss and of
+ * internal wall loss (the p value of Tor1) are kept in a table, so that the
+ * MobilityBuildingInfo of a node is only looked up the first time it is met.
+ * A node is only classified again when it moves, by finding the building it
+ * moved into in an R-tree of the buildings.
  */
 class BuildingPenetrationLoss : public PropagationLossModel
 {
@@ -42,6 +51,19 @@ public:
   ~BuildingPenetrationLoss ();
 
 private:
+  /**
+   * What the model knows about a node.
+   */
+  struct NodeInfo
+  {
+    Ptr<MobilityModel> mobility; //!< The mobility model of the node
+    Vector position;    //!< The position the classification refers to
+    bool indoor;        //!< Whether the node is inside a building
+    uint32_t buildingId; //!< The id of that building
+    int8_t wallLoss;    //!< The external wall loss class, or -1 if not drawn
+    int8_t pValue;      //!< The Tor1 p value, or -1 if not drawn
+  };
+
   /**
    * Perform the computation of the received power according to the current
    * model.
@@ -50,8 +72,36 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
 
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const Ptr<MobilityModel> *b,
+                                   std::size_t n,
+                                   double *powerDbm) const;
+
   virtual int64_t DoAssignStreams (int64_t stream);
 
+  /**
+   * Compute the loss due to building penetration between two nodes.
+   * \param a The index of the transmitter in the node table.
+   * \param b The index of the receiver in the node table.
+   * \returns The loss, in dB.
+   */
+  double CalcLoss (uint32_t a, uint32_t b) const;
+
+  /**
+   * Find a node in the table, adding it the first time it is met, and
+   * classify it again if it moved.
+   * \param mobility The mobility model of the node.
+   * \returns The index of the node in the table.
+   */
+  uint32_t GetNodeIndex (const Ptr<MobilityModel> &mobility) const;
+
+  /**
+   * Find the building a node is in from its position.
+   * \param node The node to classify.
+   * \param position The current position of the node.
+   */
+  void Locate (NodeInfo &node, const Vector &position) const;
+
   /**
    * Generate a random p value.
    * The distribution of the returned value is as specified in TR 45.820.
@@ -67,33 +117,25 @@ private:
   int GetWallLossValue (void) const;
 
   /**
-   * Compute the wall loss associated to this mobility model
-   * \param b The mobility model associated to the node whose wall loss we need
-   * to compute.
+   * Compute the wall loss associated to a node
+   * \param node The node whose wall loss we need to compute.
    * \returns The power loss due to external walls.
    */
-  double GetWallLoss (Ptr<MobilityModel> b) const;
+  double GetWallLoss (NodeInfo &node) const;
 
   /**
    * Get the Tor1 value used in the TR 45.820 standard to account for internal
    * wall loss.
-   * \param b The mobility model of the node we want to compute the value for.
+   * \param node The node we want to compute the value for.
    * \returns The tor1 value.
    */
-  double GetTor1 (Ptr<MobilityModel> b) const;
+  double GetTor1 (NodeInfo &node) const;
 
   Ptr<UniformRandomVariable> m_uniformRV;     //!< An uniform RV
 
-  /**
-   * A map linking each mobility model to a p value
-   */
-  mutable std::map<Ptr<MobilityModel>, int> m_pMap;
-
-  /**
-   * A map linking each mobility model to a value deciding its external wall
-   * loss.
-   */
-  mutable std::map<Ptr<MobilityModel>, int> m_wallLossMap;
+  mutable std::vector<NodeInfo> m_nodes; //!< The node table
+  mutable std::unordered_map<const MobilityModel *, uint32_t> m_nodeIndices;
+  mutable BuildingRTree m_buildingTree; //!< To classify nodes that moved
 };
 }
 }
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/building-rtree.h"
+#include "ns3/building-list.h"
+#include "ns3/lora-log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("BuildingRTree");
+
+const uint32_t BuildingRTree::MAX_CHILDREN;
+
+BuildingRTree::BuildingRTree ()
+{
+}
+
+void
+BuildingRTree::Build (void)
+{
+  NS_LOG_FUNCTION (this << BuildingList::GetNBuildings ());
+
+  m_buildings.clear ();
+  m_nodes.clear ();
+  m_lastBuilding = 0;
+
+  std::vector<Ptr<Building> > buildings (BuildingList::Begin (), BuildingList::End ());
+  if (buildings.empty ())
+    {
+      return;
+    }
+  m_lastBuilding = buildings.back ();
+
+  // The leaves, over the buildings
+  std::vector<Box> boxes;
+  for (const Ptr<Building> &building : buildings)
+    {
+      boxes.push_back (building->GetBoundaries ());
+    }
+  std::vector<uint32_t> order = SortTiles (boxes);
+  std::vector<Box> sorted;
+  for (uint32_t i : order)
+    {
+      m_buildings.push_back (buildings[i]);
+      sorted.push_back (boxes[i]);
+    }
+  std::vector<Node> level = Pack (sorted, 0, true);
+
+  // The upper levels, until a single root is left
+  while (level.size () > 1)
+    {
+      boxes.clear ();
+      for (const Node &node : level)
+        {
+          boxes.push_back (node.box);
+        }
+      order = SortTiles (boxes);
+      uint32_t first = m_nodes.size ();
+      sorted.clear ();
+      for (uint32_t i : order)
+        {
+          m_nodes.push_back (level[i]);
+          sorted.push_back (boxes[i]);
+        }
+      level = Pack (sorted, first, false);
+    }
+  m_nodes.push_back (level.front ());
+
+  NS_LOG_DEBUG ("Built an R-tree of " << m_nodes.size () << " nodes over " <<
+                m_buildings.size () << " buildings");
+}
+
+bool
+BuildingRTree::IsUpToDate (void) const
+{
+  uint32_t nBuildings = BuildingList::GetNBuildings ();
+  return nBuildings == m_buildings.size ()
+         && (nBuildings == 0
+             || BuildingList::GetBuilding (nBuildings - 1) == m_lastBuilding);
+}
+
+Ptr<Building>
+BuildingRTree::FindBuilding (const Vector &position) const
+{
+  if (m_nodes.empty ())
+    {
+      return 0;
+    }
+
+  // Depth first, with a stack that holds the siblings of the nodes on the
+  // path from the root: a few levels are enough for millions of buildings
+  const uint32_t maxStack = 64;
+  uint32_t stack[maxStack];
+  uint32_t size = 0;
+  stack[size++] = m_nodes.size () - 1;
+  while (size > 0)
+    {
+      const Node &node = m_nodes[stack[--size]];
+      if (!node.box.IsInside (position))
+        {
+          continue;
+        }
+      for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+          if (!node.leaf)
+            {
+              NS_ASSERT (size < maxStack);
+              stack[size++] = i;
+            }
+          else if (m_buildings[i]->IsInside (position))
+            {
+              return m_buildings[i];
+            }
+        }
+    }
+  return 0;
+}
+
+uint32_t
+BuildingRTree::GetNBuildings (void) const
+{
+  return m_buildings.size ();
+}
+
+std::vector<uint32_t>
+BuildingRTree::SortTiles (const std::vector<Box> &boxes)
+{
+  uint32_t n = boxes.size ();
+  std::vector<uint32_t> order (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      order[i] = i;
+    }
+
+  // Twice the coordinates of the centers, which sort the same
+  std::sort (order.begin (), order.end (), [&boxes] (uint32_t a, uint32_t b)
+    {
+      return boxes[a].xMin + boxes[a].xMax < boxes[b].xMin + boxes[b].xMax;
+    });
+
+  // About as many slices as parents per slice
+  uint32_t nParents = (n + MAX_CHILDREN - 1) / MAX_CHILDREN;
+  uint32_t nSlices = std::ceil (std::sqrt (nParents));
+  uint32_t sliceSize = (nParents + nSlices - 1) / nSlices * MAX_CHILDREN;
+  for (uint32_t start = 0; start < n; start += sliceSize)
+    {
+      std::sort (order.begin () + start, order.begin () + std::min (start + sliceSize, n),
+                 [&boxes] (uint32_t a, uint32_t b)
+        {
+          return boxes[a].yMin + boxes[a].yMax < boxes[b].yMin + boxes[b].yMax;
+        });
+    }
+
+  return order;
+}
+
+std::vector<BuildingRTree::Node>
+BuildingRTree::Pack (const std::vector<Box> &boxes, uint32_t first, bool leaf)
+{
+  std::vector<Node> parents;
+  for (uint32_t start = 0; start < boxes.size (); start += MAX_CHILDREN)
+    {
+      Node node;
+      node.first = first + start;
+      node.count = std::min<uint32_t> (MAX_CHILDREN, boxes.size () - start);
+      node.leaf = leaf;
+      node.box = boxes[start];
+      for (uint32_t i = start + 1; i < start + node.count; i++)
+        {
+          node.box.xMin = std::min (node.box.xMin, boxes[i].xMin);
+          node.box.xMax = std::max (node.box.xMax, boxes[i].xMax);
+          node.box.yMin = std::min (node.box.yMin, boxes[i].yMin);
+          node.box.yMax = std::max (node.box.yMax, boxes[i].yMax);
+          node.box.zMin = std::min (node.box.zMin, boxes[i].zMin);
+          node.box.zMax = std::max (node.box.zMax, boxes[i].zMax);
+        }
+      parents.push_back (node);
+    }
+  return parents;
+}
+
+} // namespace lorawan
+} // namespace ns3
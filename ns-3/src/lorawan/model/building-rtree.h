@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BUILDING_RTREE_H
+#define BUILDING_RTREE_H
+
+#include "ns3/building.h"
+#include "ns3/box.h"
+#include "ns3/vector.h"
+#include "ns3/ptr.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * An R-tree over the bounding boxes of the buildings of the BuildingList,
+ * to find the building a position falls in without checking all of them.
+ *
+ * The tree is bulk-loaded with the Sort-Tile-Recursive algorithm, and is
+ * stored in a flat array, where the children of a node are contiguous.
+ * Buildings are not expected to move: the tree only needs to be built again
+ * when buildings are added.
+ */
+class BuildingRTree
+{
+public:
+  BuildingRTree ();
+
+  /**
+   * Build the tree from the buildings currently in the BuildingList.
+   */
+  void Build (void);
+
+  /**
+   * Whether the tree was built from all the buildings in the BuildingList,
+   * i.e., no building was added since and the list was not replaced by the
+   * one of a new simulation.
+   */
+  bool IsUpToDate (void) const;
+
+  /**
+   * Find the building a position is inside of.
+   *
+   * \param position The position to look up.
+   * \return The building, or 0 if the position is outdoors.
+   */
+  Ptr<Building> FindBuilding (const Vector &position) const;
+
+  /**
+   * Get the number of buildings in the tree.
+   */
+  uint32_t GetNBuildings (void) const;
+
+private:
+  /**
+   * A node of the tree: either a leaf, whose children are buildings, or an
+   * internal node, whose children are other nodes.
+   */
+  struct Node
+  {
+    Box box;        //!< The union of the boxes of the children
+    uint32_t first; //!< The index of the first child
+    uint32_t count; //!< The number of children
+    bool leaf;      //!< Whether the children are buildings
+  };
+
+  /**
+   * Sort boxes in Sort-Tile-Recursive order: in vertical slices by the x of
+   * their center, then by the y of their center within each slice.
+   *
+   * \return The indices of the boxes, in that order.
+   */
+  static std::vector<uint32_t> SortTiles (const std::vector<Box> &boxes);
+
+  /**
+   * Group consecutive boxes by MAX_CHILDREN, and return their parents.
+   */
+  static std::vector<Node> Pack (const std::vector<Box> &boxes, uint32_t first,
+                                 bool leaf);
+
+  static const uint32_t MAX_CHILDREN = 8;
+
+  std::vector<Ptr<Building> > m_buildings; //!< In the order of the leaves
+  std::vector<Node> m_nodes;               //!< Level by level, root last
+  Ptr<Building> m_lastBuilding; //!< The last building of the list when built
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* BUILDING_RTREE_H */
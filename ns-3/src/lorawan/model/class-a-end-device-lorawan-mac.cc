@@ -25,13 +25,13 @@
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/end-device-lorawan-mac.h"
 #include "ns3/end-device-lora-phy.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("ClassAEndDeviceLorawanMac");
+LORA_LOG_COMPONENT_DEFINE ("ClassAEndDeviceLorawanMac");
 
 NS_OBJECT_ENSURE_REGISTERED (ClassAEndDeviceLorawanMac);
 
@@ -54,13 +54,11 @@ ClassAEndDeviceLorawanMac::ClassAEndDeviceLorawanMac () :
 {
   NS_LOG_FUNCTION (this);
 
-  // Void the two receiveWindow events
-  m_closeFirstWindow = EventId ();
-  m_closeFirstWindow.Cancel ();
-  m_closeSecondWindow = EventId ();
-  m_closeSecondWindow.Cancel ();
-  m_secondReceiveWindow = EventId ();
-  m_secondReceiveWindow.Cancel ();
+  // Set the functions of the receive window timers
+  m_firstReceiveWindow.SetFunction (&ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow, this);
+  m_closeFirstWindow.SetFunction (&ClassAEndDeviceLorawanMac::CloseFirstReceiveWindow, this);
+  m_closeSecondWindow.SetFunction (&ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow, this);
+  m_secondReceiveWindow.SetFunction (&ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow, this);
 }
 
 ClassAEndDeviceLorawanMac::~ClassAEndDeviceLorawanMac ()
@@ -144,37 +142,29 @@ ClassAEndDeviceLorawanMac::Receive (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
 
-  // Work on a copy of the packet
-  Ptr<Packet> packetCopy = packet->Copy ();
-
-  // Remove the Mac Header to get some information
-  LorawanMacHeader mHdr;
-  packetCopy->RemoveHeader (mHdr);
-
-  NS_LOG_DEBUG ("Mac Header: " << mHdr);
+  // Read the headers in place, without copying the packet
+  LoraFrameHeaderView view (packet);
 
   // Only keep analyzing the packet if it's downlink
-  if (!mHdr.IsUplink ())
+  if (!view.IsUplink ())
     {
       NS_LOG_INFO ("Found a downlink packet.");
 
-      // Remove the Frame Header
-      LoraFrameHeader fHdr;
-      fHdr.SetAsDownlink ();
-      packetCopy->RemoveHeader (fHdr);
-
-      NS_LOG_DEBUG ("Frame Header: " << fHdr);
-
       // Determine whether this packet is for us
-      bool messageForUs = (m_address == fHdr.GetAddress ());
+      bool messageForUs = (m_address == view.GetAddress ());
 
       if (messageForUs)
         {
           NS_LOG_INFO ("The message is for us!");
 
+          // Decode the Frame Header
+          LoraFrameHeader fHdr = view.GetFrameHeader ();
+
+          NS_LOG_DEBUG ("Frame Header: " << fHdr);
+
           // If it exists, cancel the second receive window event
           // THIS WILL BE GetReceiveWindow()
-          Simulator::Cancel (m_secondReceiveWindow);
+          m_secondReceiveWindow.Cancel ();
 
 
           // Parse the MAC commands
@@ -272,13 +262,10 @@ ClassAEndDeviceLorawanMac::TxFinished (Ptr<const Packet> packet)
   NS_LOG_FUNCTION_NOARGS ();
 
   // Schedule the opening of the first receive window
-  Simulator::Schedule (m_receiveDelay1,
-                       &ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow, this);
+  m_firstReceiveWindow.Schedule (m_receiveDelay1);
 
   // Schedule the opening of the second receive window
-  m_secondReceiveWindow = Simulator::Schedule (m_receiveDelay2,
-                                               &ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow,
-                                               this);
+  m_secondReceiveWindow.Schedule (m_receiveDelay2);
   // // Schedule the opening of the first receive window
   // Simulator::Schedule (m_receiveDelay1,
   //                      &ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow, this);
@@ -306,8 +293,7 @@ ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow (void)
   // Schedule return to sleep after "at least the time required by the end
   // device's radio transceiver to effectively detect a downlink preamble"
   // (LoraWAN specification)
-  m_closeFirstWindow = Simulator::Schedule (Seconds (m_receiveWindowDurationInSymbols*tSym),
-                                            &ClassAEndDeviceLorawanMac::CloseFirstReceiveWindow, this); //m_receiveWindowDuration
+  m_closeFirstWindow.Schedule (Seconds (m_receiveWindowDurationInSymbols*tSym)); //m_receiveWindowDuration
 
 }
 
@@ -374,8 +360,7 @@ ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow (void)
   // Schedule return to sleep after "at least the time required by the end
   // device's radio transceiver to effectively detect a downlink preamble"
   // (LoraWAN specification)
-  m_closeSecondWindow = Simulator::Schedule (Seconds (m_receiveWindowDurationInSymbols*tSym),
-                                             &ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow, this);
+  m_closeSecondWindow.Schedule (Seconds (m_receiveWindowDurationInSymbols*tSym));
 
 }
 
@@ -187,19 +187,24 @@ protected:
    */
   Time m_receiveDelay2;
 
+  /**
+   * The event of the first receive window opening.
+   */
+  LoraMacTimer m_firstReceiveWindow;
+
   /**
    * The event of the closing the first receive window.
    *
    * This Event will be canceled if there's a successful reception of a packet.
    */
-  EventId m_closeFirstWindow;
+  LoraMacTimer m_closeFirstWindow;
 
   /**
    * The event of the closing the second receive window.
    *
    * This Event will be canceled if there's a successful reception of a packet.
    */
-  EventId m_closeSecondWindow;
+  LoraMacTimer m_closeSecondWindow;
 
   /**
    * The event of the second receive window opening.
@@ -207,7 +212,7 @@ protected:
    * This Event is used to cancel the second window in case the first one is
    * successful.
    */
-  EventId m_secondReceiveWindow;
+  LoraMacTimer m_secondReceiveWindow;
 
   /**
    * The frequency to listen on for the second receive window.
@@ -18,13 +18,13 @@
 
 #include "ns3/correlated-shadowing-propagation-loss-model.h"
 #include "ns3/double.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <cmath>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("CorrelatedShadowingPropagationLossModel");
+LORA_LOG_COMPONENT_DEFINE ("CorrelatedShadowingPropagationLossModel");
 
 NS_OBJECT_ENSURE_REGISTERED (CorrelatedShadowingPropagationLossModel);
 
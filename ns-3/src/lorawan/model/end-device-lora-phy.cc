@@ -22,12 +22,12 @@
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/simulator.h"
 #include "ns3/lora-tag.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("EndDeviceLoraPhy");
+LORA_LOG_COMPONENT_DEFINE ("EndDeviceLoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (EndDeviceLoraPhy);
 
@@ -25,13 +25,13 @@
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/simulator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("EndDeviceLorawanMac");
+LORA_LOG_COMPONENT_DEFINE ("EndDeviceLorawanMac");
 
 NS_OBJECT_ENSURE_REGISTERED (EndDeviceLorawanMac);
 
@@ -46,6 +46,18 @@ EndDeviceLorawanMac::GetTypeId (void)
                      MakeTraceSourceAccessor
                        (&EndDeviceLorawanMac::m_requiredTxCallback),
                      "ns3::TracedValueCallback::uint8_t")
+    .AddTraceSource ("PostponedTransmission",
+                     "A transmission was postponed by the MAC because of "
+                     "duty cycle limitations or open receive windows",
+                     MakeTraceSourceAccessor
+                       (&EndDeviceLorawanMac::m_postponedTransmission),
+                     "ns3::EndDeviceLorawanMac::PostponedTransmissionCallback")
+    .AddTraceSource ("TransmissionParameters",
+                     "The data rate or the transmission power of this end "
+                     "device changed",
+                     MakeTraceSourceAccessor
+                       (&EndDeviceLorawanMac::m_transmissionParametersChanged),
+                     "ns3::EndDeviceLorawanMac::TransmissionParametersCallback")
     .AddAttribute ("DataRate",
                    "Data Rate currently employed by this end device",
                    UintegerValue (0),
@@ -135,13 +147,18 @@ EndDeviceLorawanMac::EndDeviceLorawanMac ()
   // transmit on.
   m_uniformRV = CreateObject<UniformRandomVariable> ();
 
-  // Void the transmission event
-  m_nextTx = EventId ();
-  m_nextTx.Cancel ();
+  // Set the function of the transmission timer
+  m_nextTx.SetFunction (&EndDeviceLorawanMac::DoSendPostponed, this);
 
   // Initialize structure for retransmission parameters
   m_retxParams = EndDeviceLorawanMac::LoraRetxParameters ();
   m_retxParams.retxLeft = m_maxNumbTx;
+
+  // Report the changes of the transmission parameters, wherever they are made
+  m_dataRate.ConnectWithoutContext
+    (MakeCallback (&EndDeviceLorawanMac::NotifyDataRateChange, this));
+  m_txPower.ConnectWithoutContext
+    (MakeCallback (&EndDeviceLorawanMac::NotifyTxPowerChange, this));
 }
 
 EndDeviceLorawanMac::~EndDeviceLorawanMac ()
@@ -196,13 +213,35 @@ void
 EndDeviceLorawanMac::postponeTransmission (Time netxTxDelay, Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this);
-  // Delete previously scheduled transmissions if any.
-  Simulator::Cancel (m_nextTx);
-  m_nextTx = Simulator::Schedule (netxTxDelay, &EndDeviceLorawanMac::DoSend, this, packet);
+  // Replace previously scheduled transmissions if any.
+  m_nextTxPacket = packet;
+  m_nextTx.Schedule (netxTxDelay);
+  m_postponedTransmission (packet, netxTxDelay);
   NS_LOG_WARN ("Attempting to send, but the aggregate duty cycle won't allow it. Scheduling a tx at a delay "
                << netxTxDelay.GetSeconds () << ".");
 }
 
+void
+EndDeviceLorawanMac::DoSendPostponed (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> packet = m_nextTxPacket;
+  m_nextTxPacket = 0;
+  DoSend (packet);
+}
+
+Time
+EndDeviceLorawanMac::GetEarliestTransmissionTime (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time delay = GetNextTransmissionDelay ();
+  if (delay == Time::Max ())
+    {
+      return delay;
+    }
+  return Simulator::Now () + delay;
+}
 
 void
 EndDeviceLorawanMac::DoSendBeforeApplyNecessaryOptions (Ptr<Packet> packet)
@@ -553,27 +592,11 @@ EndDeviceLorawanMac::GetNextTransmissionDelay (void)
 
   //    Check duty cycle    //
 
-  // Pick a random channel to transmit on
-  std::vector<Ptr<LogicalLoraChannel> > logicalChannels;
-  logicalChannels = m_channelHelper.GetEnabledChannelList ();                 // Use a separate list to do the shuffle
-  //logicalChannels = Shuffle (logicalChannels);
-
-
-  Time waitingTime = Time::Max ();
-
-  // Try every channel
-  std::vector<Ptr<LogicalLoraChannel> >::iterator it;
-  for (it = logicalChannels.begin (); it != logicalChannels.end (); ++it)
-    {
-      // Pointer to the current channel
-      Ptr<LogicalLoraChannel> logicalChannel = *it;
-      double frequency = logicalChannel->GetFrequency ();
+  // Earliest time at which one of the enabled channels will be free
+  Time waitingTime = m_channelHelper.GetMinimumWaitingTime ();
 
-      waitingTime = std::min (waitingTime, m_channelHelper.GetWaitingTime (logicalChannel));
-
-      NS_LOG_DEBUG ("Waiting time before the next transmission in channel with frequecy " <<
-                    frequency << " is = " << waitingTime.GetSeconds () << ".");
-    }
+  NS_LOG_DEBUG ("Waiting time before the next transmission is = " <<
+                waitingTime.GetSeconds () << ".");
 
   waitingTime = GetNextClassTransmissionDelay (waitingTime);
 
@@ -585,60 +608,11 @@ EndDeviceLorawanMac::GetChannelForTx (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  // Pick a random channel to transmit on
-  std::vector<Ptr<LogicalLoraChannel> > logicalChannels;
-  logicalChannels = m_channelHelper.GetEnabledChannelList ();                 // Use a separate list to do the shuffle
-  logicalChannels = Shuffle (logicalChannels);
-
-  // Try every channel
-  std::vector<Ptr<LogicalLoraChannel> >::iterator it;
-  for (it = logicalChannels.begin (); it != logicalChannels.end (); ++it)
-    {
-      // Pointer to the current channel
-      Ptr<LogicalLoraChannel> logicalChannel = *it;
-      double frequency = logicalChannel->GetFrequency ();
-
-      NS_LOG_DEBUG ("Frequency of the current channel: " << frequency);
-
-      // Verify that we can send the packet
-      Time waitingTime = m_channelHelper.GetWaitingTime (logicalChannel);
-
-      NS_LOG_DEBUG ("Waiting time for current channel = " <<
-                    waitingTime.GetSeconds ());
-
-      // Send immediately if we can
-      if (waitingTime == Seconds (0))
-        {
-          return *it;
-        }
-      else
-        {
-          NS_LOG_DEBUG ("Packet cannot be immediately transmitted on " <<
-                        "the current channel because of duty cycle limitations.");
-        }
-    }
-  return 0;                 // In this case, no suitable channel was found
+  // Pick a random channel among the ones on which we can send right now
+  return m_channelHelper.GetRandomAvailableChannel (m_uniformRV->GetValue ());
 }
 
 
-std::vector<Ptr<LogicalLoraChannel> >
-EndDeviceLorawanMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  int size = vector.size ();
-
-  for (int i = 0; i < size; ++i)
-    {
-      uint16_t random = std::floor (m_uniformRV->GetValue (0, size));
-      Ptr<LogicalLoraChannel> temp = vector.at (random);
-      vector.at (random) = vector.at (i);
-      vector.at (i) = temp;
-    }
-
-  return vector;
-}
-
 /////////////////////////
 // Setters and Getters //
 /////////////////////////
@@ -651,7 +625,8 @@ void EndDeviceLorawanMac::resetRetransmissionParameters ()
   m_retxParams.firstAttempt = Seconds (0);
 
   // Cancel next retransmissions, if any
-  Simulator::Cancel (m_nextTx);
+  m_nextTx.Cancel ();
+  m_nextTxPacket = 0;
 }
 
 void
@@ -691,6 +666,18 @@ EndDeviceLorawanMac::SetDataRate (uint8_t dataRate)
   m_dataRate = dataRate;
 }
 
+void
+EndDeviceLorawanMac::NotifyDataRateChange (uint8_t oldValue, uint8_t newValue)
+{
+  m_transmissionParametersChanged (newValue, m_txPower);
+}
+
+void
+EndDeviceLorawanMac::NotifyTxPowerChange (double oldValue, double newValue)
+{
+  m_transmissionParametersChanged (m_dataRate, newValue);
+}
+
 uint8_t
 EndDeviceLorawanMac::GetDataRate (void)
 {
@@ -30,6 +30,7 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/traced-value.h"
+#include "ns3/lora-mac-timer.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -79,6 +80,42 @@ public:
    */
   virtual void postponeTransmission (Time nextTxDelay, Ptr<Packet>);
 
+  /**
+   * Send the packet of a postponed transmission, when m_nextTx expires.
+   */
+  void DoSendPostponed (void);
+
+  /**
+   * Get the earliest time at which a new packet handed to Send would be
+   * transmitted right away, i.e., without being postponed because of duty
+   * cycle limitations or open receive windows.
+   *
+   * Applications can use this to schedule their transmission directly at
+   * that time, instead of having the MAC postpone it.
+   *
+   * \return The earliest time at which transmission is allowed, or
+   * Time::Max () if no channel is enabled.
+   */
+  Time GetEarliestTransmissionTime (void);
+
+  /**
+   * TracedCallback signature for postponed transmissions.
+   *
+   * \param [in] packet The packet whose transmission was postponed.
+   * \param [in] delay The delay after which it will be transmitted.
+   */
+  typedef void (* PostponedTransmissionCallback)
+    (Ptr<const Packet> packet, Time delay);
+
+  /**
+   * TracedCallback signature for changes of the transmission parameters.
+   *
+   * \param [in] dataRate The data rate of the end device.
+   * \param [in] txPower The transmission power of the end device, in dBm.
+   */
+  typedef void (* TransmissionParametersCallback)
+    (uint8_t dataRate, double txPower);
+
 
   ///////////////////////
   // Receiving methods //
@@ -427,8 +464,8 @@ protected:
 
 
   /**
-   * An uniform random variable, used by the Shuffle method to randomly reorder
-   * the channel list.
+   * An uniform random variable, used by GetChannelForTx to pick a random
+   * channel among the available ones.
    */
   Ptr<UniformRandomVariable> m_uniformRV;
 
@@ -443,6 +480,18 @@ protected:
    */
   TracedCallback<uint8_t, bool, Time, Ptr<Packet> > m_requiredTxCallback;
 
+  /**
+   * The trace source fired when the MAC postpones a transmission because of
+   * duty cycle limitations or open receive windows.
+   */
+  TracedCallback<Ptr<const Packet>, Time> m_postponedTransmission;
+
+  /**
+   * The trace source fired when the data rate or the transmission power
+   * changes, with both of their new values.
+   */
+  TracedCallback<uint8_t, double> m_transmissionParametersChanged;
+
   //////////////////////////////////////////////////////////////////////
   //  The current UL Frame Counter (moved from private to protected)  //
   //////////////////////////////////////////////////////////////////////
@@ -481,16 +530,21 @@ protected:
 
 private:
   /**
-   * Randomly shuffle a Ptr<LogicalLoraChannel> vector.
-   *
-   * Used to pick a random channel on which to send the packet.
+   * Find the minimum waiting time before the next possible transmission.
+   */
+  Time GetNextTransmissionDelay (void);
+
+  /**
+   * Fire the TransmissionParameters trace source when m_dataRate changes
+   * (before the new value is stored).
    */
-  std::vector<Ptr<LogicalLoraChannel> > Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector);
+  void NotifyDataRateChange (uint8_t oldValue, uint8_t newValue);
 
   /**
-   * Find the minimum waiting time before the next possible transmission.
+   * Fire the TransmissionParameters trace source when m_txPower changes
+   * (before the new value is stored).
    */
-  Time GetNextTransmissionDelay (void);
+  void NotifyTxPowerChange (double oldValue, double newValue);
 
 
   /**
@@ -499,7 +553,12 @@ private:
    * This Event is used to cancel the retransmission if the ACK is found in ParseCommand function and
    * if a newer packet is delivered from the application to be sent.
    */
-  EventId m_nextTx;
+  LoraMacTimer m_nextTx;
+
+  /**
+   * The packet whose transmission m_nextTx was scheduled for.
+   */
+  Ptr<Packet> m_nextTxPacket;
 
   /**
    * The event of transmitting a packet in a consecutive moment, when the duty cycle let us transmit.
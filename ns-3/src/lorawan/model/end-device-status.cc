@@ -20,10 +20,11 @@
  */
 
 #include "ns3/end-device-status.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/simulator.h"
 #include "ns3/lorawan-mac-header.h"
 #include "ns3/lora-frame-header.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/pointer.h"
 #include "ns3/command-line.h"
 #include "ns3/simulator.h"
@@ -35,7 +36,7 @@
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("EndDeviceStatus");
+LORA_LOG_COMPONENT_DEFINE ("EndDeviceStatus");
 
 TypeId
 EndDeviceStatus::GetTypeId (void)
@@ -126,13 +127,7 @@ EndDeviceStatus::GetCompleteReplyPacket (void)
 
   // Add headers
   m_reply.frameHeader.SetAddress (m_endDeviceAddress);
-  Ptr<Packet> lastPacket = GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  lastPacket->RemoveHeader (mHdr);
-  lastPacket->RemoveHeader (fHdr);
-  m_reply.frameHeader.SetFCnt (fHdr.GetFCnt ());
+  m_reply.frameHeader.SetFCnt (LoraFrameHeaderView (GetLastPacketReceivedFromDevice ()).GetFCnt ());
   m_reply.macHeader.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
   replyPacket->AddHeader (m_reply.frameHeader);
   replyPacket->AddHeader (m_reply.macHeader);
@@ -241,22 +236,15 @@ EndDeviceStatus::SetReplyPayload (Ptr<Packet> replyPayload)
 void
 EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const Address &gwAddress)
 {
+  LORA_PROFILE_SCOPE ("EndDeviceStatus::InsertReceivedPacket");
   NS_LOG_FUNCTION_NOARGS ();
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = receivedPacket->Copy ();
-
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+  // Read the headers in place
+  LoraFrameHeaderView frameHdr (receivedPacket);
 
   // Update current parameters
   LoraTag tag;
-  myPacket->RemovePacketTag (tag);
+  receivedPacket->PeekPacketTag (tag);
   SetFirstReceiveWindowSpreadingFactor (tag.GetSpreadingFactor ());
   SetFirstReceiveWindowFrequency (tag.GetFrequency ());
 
@@ -278,12 +266,7 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const A
     {
       // Get the frame counter of the current packet to compare it with the
       // newly received one
-      Ptr<Packet> packetCopy = ((*it).first)->Copy ();
-      LorawanMacHeader currentMacHdr;
-      packetCopy->RemoveHeader (currentMacHdr);
-      LoraFrameHeader currentFrameHdr;
-      frameHdr.SetAsUplink ();
-      packetCopy->RemoveHeader (currentFrameHdr);
+      LoraFrameHeaderView currentFrameHdr ((*it).first);
 
       NS_LOG_DEBUG ("Received packet's frame counter: " << unsigned(frameHdr.GetFCnt ())
                                                         << "\nCurrent packet's frame counter: "
@@ -369,7 +352,7 @@ EndDeviceStatus::AddMACCommand (Ptr<MacCommand> macCommand)
 bool
 EndDeviceStatus::HasReceiveWindowOpportunityScheduled ()
 {
-  return m_receiveWindowEvent.IsRunning();
+  return m_receiveWindowEvent.IsRunning() || m_receiveWindowBatched;
 }
 
 void
@@ -382,6 +365,30 @@ void
 EndDeviceStatus::RemoveReceiveWindowOpportunity (void)
 {
   Simulator::Cancel(m_receiveWindowEvent);
+  if (m_receiveWindowBatched)
+    {
+      // The entry stays in the wheel, but will not match anymore
+      m_receiveWindowBatched = false;
+      m_receiveWindowGeneration++;
+    }
+}
+
+uint32_t
+EndDeviceStatus::SetBatchedReceiveWindowOpportunity (void)
+{
+  m_receiveWindowBatched = true;
+  return ++m_receiveWindowGeneration;
+}
+
+bool
+EndDeviceStatus::ExpireBatchedReceiveWindowOpportunity (uint32_t generation)
+{
+  if (!m_receiveWindowBatched || generation != m_receiveWindowGeneration)
+    {
+      return false;
+    }
+  m_receiveWindowBatched = false;
+  return true;
 }
 
 std::map<double, Address>
@@ -304,6 +304,26 @@ public:
 
   void RemoveReceiveWindowOpportunity (void);
 
+  /**
+   * Mark that a receive window opportunity for this device is queued in the
+   * batched timing wheel of the NetworkScheduler. Such opportunities have no
+   * EventId of their own, and cannot be removed from the wheel: they are
+   * told apart by a generation number instead.
+   *
+   * \return The generation of the opportunity, to be kept in the wheel.
+   */
+  uint32_t SetBatchedReceiveWindowOpportunity (void);
+
+  /**
+   * Called when a batched receive window opportunity is due. The
+   * opportunity is no longer pending afterwards.
+   *
+   * \param generation The generation it was queued with.
+   * \return Whether the opportunity must be opened, i.e., it was neither
+   * removed with RemoveReceiveWindowOpportunity nor replaced since.
+   */
+  bool ExpireBatchedReceiveWindowOpportunity (uint32_t generation);
+
   /**
    * Return an ordered list of the best gateways.
    */
@@ -322,6 +342,8 @@ private:
   uint8_t m_secondReceiveWindowOffset = 0;
   double m_secondReceiveWindowFrequency = 869.525;
   EventId m_receiveWindowEvent;
+  bool m_receiveWindowBatched = false;
+  uint32_t m_receiveWindowGeneration = 0; //!< Of the last batched opportunity
 
   ReceivedPacketList m_receivedPacketList;   //<! List of received packets
 
@@ -22,12 +22,12 @@
 #include "ns3/log-macros-enabled.h"
 #include "ns3/lora-tag.h"
 #include "ns3/simulator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("GatewayLoraPhy");
+LORA_LOG_COMPONENT_DEFINE ("GatewayLoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (GatewayLoraPhy);
 
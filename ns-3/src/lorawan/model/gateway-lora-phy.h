@@ -28,6 +28,7 @@
 #include "ns3/node.h"
 #include "ns3/lora-phy.h"
 #include "ns3/traced-value.h"
+#include "ns3/lora-object-pool.h"
 #include <list>
 
 namespace ns3 {
@@ -98,7 +99,8 @@ protected:
    * listen for a certain SF. ReceptionPaths be either locked on an event or
    * free.
    */
-  class ReceptionPath : public SimpleRefCount<GatewayLoraPhy::ReceptionPath>
+  class ReceptionPath : public SimpleRefCount<GatewayLoraPhy::ReceptionPath>,
+                        public LoraPooledAllocation<GatewayLoraPhy::ReceptionPath>
   {
 
   public:
@@ -22,12 +22,12 @@
 #include "ns3/lorawan-mac-header.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-frame-header.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("GatewayLorawanMac");
+LORA_LOG_COMPONENT_DEFINE ("GatewayLorawanMac");
 
 NS_OBJECT_ENSURE_REGISTERED (GatewayLorawanMac);
 
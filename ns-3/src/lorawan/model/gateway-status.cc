@@ -19,12 +19,12 @@
  */
 
 #include "ns3/gateway-status.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("GatewayStatus");
+LORA_LOG_COMPONENT_DEFINE ("GatewayStatus");
 
 TypeId
 GatewayStatus::GetTypeId (void)
@@ -16,13 +16,13 @@
  * Author: Davide Magrin <magrinda@dei.unipd.it>
  */
 
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/hex-grid-position-allocator.h"
 #include "ns3/double.h"
 
 namespace ns3 {
 
-  NS_LOG_COMPONENT_DEFINE ("HexGridPositionAllocator");
+  LORA_LOG_COMPONENT_DEFINE ("HexGridPositionAllocator");
 
   NS_OBJECT_ENSURE_REGISTERED (HexGridPositionAllocator);
 
@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lazy-basic-energy-source.h"
+#include "ns3/lora-log.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LazyBasicEnergySource");
+
+NS_OBJECT_ENSURE_REGISTERED (LazyBasicEnergySource);
+
+TypeId
+LazyBasicEnergySource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LazyBasicEnergySource")
+    .SetParent<EnergySource> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LazyBasicEnergySource> ()
+    .AddAttribute ("InitialEnergyJ",
+                   "Initial energy stored in the energy source.",
+                   DoubleValue (10),  // in Joules
+                   MakeDoubleAccessor (&LazyBasicEnergySource::SetInitialEnergy,
+                                       &LazyBasicEnergySource::GetInitialEnergy),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("SupplyVoltageV",
+                   "Supply voltage of the energy source.",
+                   DoubleValue (3.0), // in Volts
+                   MakeDoubleAccessor (&LazyBasicEnergySource::SetSupplyVoltage,
+                                       &LazyBasicEnergySource::GetSupplyVoltage),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LowBatteryThreshold",
+                   "Low battery threshold, as a fraction of the initial energy.",
+                   DoubleValue (0.10),
+                   MakeDoubleAccessor (&LazyBasicEnergySource::m_lowBatteryTh),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("HighBatteryThreshold",
+                   "High battery threshold, as a fraction of the initial energy.",
+                   DoubleValue (0.15),
+                   MakeDoubleAccessor (&LazyBasicEnergySource::m_highBatteryTh),
+                   MakeDoubleChecker<double> ())
+    .AddTraceSource ("RemainingEnergy",
+                     "Remaining energy at the energy source, updated on "
+                     "state changes and queries only.",
+                     MakeTraceSourceAccessor (&LazyBasicEnergySource::m_remainingEnergyJ),
+                     "ns3::TracedValueCallback::Double")
+  ;
+  return tid;
+}
+
+LazyBasicEnergySource::LazyBasicEnergySource ()
+  : m_depleted (false),
+    m_lastUpdateTime (Seconds (0)),
+    m_predictionStale (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LazyBasicEnergySource::~LazyBasicEnergySource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LazyBasicEnergySource::SetInitialEnergy (double initialEnergyJ)
+{
+  NS_LOG_FUNCTION (this << initialEnergyJ);
+  NS_ASSERT (initialEnergyJ >= 0);
+  m_initialEnergyJ = initialEnergyJ;
+  m_remainingEnergyJ = m_initialEnergyJ;
+}
+
+void
+LazyBasicEnergySource::SetSupplyVoltage (double supplyVoltageV)
+{
+  NS_LOG_FUNCTION (this << supplyVoltageV);
+  m_supplyVoltageV = supplyVoltageV;
+}
+
+double
+LazyBasicEnergySource::GetSupplyVoltage (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_supplyVoltageV;
+}
+
+double
+LazyBasicEnergySource::GetInitialEnergy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_initialEnergyJ;
+}
+
+double
+LazyBasicEnergySource::GetRemainingEnergy (void)
+{
+  NS_LOG_FUNCTION (this);
+  IntegrateEnergy ();
+  if (m_predictionStale)
+    {
+      UpdateThresholdPrediction ();
+    }
+  return m_remainingEnergyJ;
+}
+
+double
+LazyBasicEnergySource::GetEnergyFraction (void)
+{
+  NS_LOG_FUNCTION (this);
+  IntegrateEnergy ();
+  if (m_predictionStale)
+    {
+      UpdateThresholdPrediction ();
+    }
+  return m_remainingEnergyJ / m_initialEnergyJ;
+}
+
+void
+LazyBasicEnergySource::UpdateEnergySource (void)
+{
+  NS_LOG_FUNCTION (this);
+  IntegrateEnergy ();
+
+  // Device energy models call this method right before changing state, so
+  // the new current is only known once the caller returns. Until then, the
+  // current prediction no longer holds.
+  Simulator::Remove (m_thresholdEvent);
+  m_predictionStale = true;
+}
+
+void
+LazyBasicEnergySource::UpdateThresholdPrediction (void)
+{
+  NS_LOG_FUNCTION (this);
+  IntegrateEnergy ();
+  m_predictionStale = false;
+  PredictThresholdCrossing ();
+}
+
+Time
+LazyBasicEnergySource::GetPredictedThresholdCrossing (void)
+{
+  if (m_predictionStale)
+    {
+      UpdateThresholdPrediction ();
+    }
+  if (m_thresholdEvent.IsRunning ())
+    {
+      return Simulator::Now () + Simulator::GetDelayLeft (m_thresholdEvent);
+    }
+  return Time::Max ();
+}
+
+/*
+ * Private functions start here.
+ */
+
+void
+LazyBasicEnergySource::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  UpdateThresholdPrediction ();
+}
+
+void
+LazyBasicEnergySource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_thresholdEvent.Cancel ();
+  BreakDeviceEnergyModelRefCycle ();  // break reference cycle
+}
+
+void
+LazyBasicEnergySource::IntegrateEnergy (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time duration = Simulator::Now () - m_lastUpdateTime;
+  NS_ASSERT (duration.IsPositive ());
+  m_lastUpdateTime = Simulator::Now ();
+  if (duration.IsZero ())
+    {
+      return;
+    }
+
+  // The current didn't change since the last update: energy = current * voltage * time
+  double energyToDecreaseJ = CalculateTotalCurrent () * m_supplyVoltageV * duration.GetSeconds ();
+  double remainingEnergyJ = std::max (m_remainingEnergyJ.Get () - energyToDecreaseJ, 0.0);
+  m_remainingEnergyJ = remainingEnergyJ;
+  NS_LOG_DEBUG ("LazyBasicEnergySource:Remaining energy = " << remainingEnergyJ);
+
+  if (!m_depleted && remainingEnergyJ <= m_lowBatteryTh * m_initialEnergyJ)
+    {
+      NS_LOG_DEBUG ("LazyBasicEnergySource:Energy depleted!");
+      m_depleted = true;
+      NotifyEnergyDrained ();
+    }
+  else if (m_depleted && remainingEnergyJ > m_highBatteryTh * m_initialEnergyJ)
+    {
+      NS_LOG_DEBUG ("LazyBasicEnergySource:Energy recharged!");
+      m_depleted = false;
+      NotifyEnergyRecharged ();
+    }
+  else if (energyToDecreaseJ != 0)
+    {
+      NotifyEnergyChanged ();
+    }
+}
+
+void
+LazyBasicEnergySource::PredictThresholdCrossing (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Remove (m_thresholdEvent);
+
+  // The remaining energy decreases (or, with harvesters, increases) linearly
+  // until the next state change
+  double powerW = CalculateTotalCurrent () * m_supplyVoltageV;
+  double energyToThresholdJ;
+  if (!m_depleted && powerW > 0)
+    {
+      energyToThresholdJ = m_remainingEnergyJ - m_lowBatteryTh * m_initialEnergyJ;
+    }
+  else if (m_depleted && powerW < 0)
+    {
+      energyToThresholdJ = m_highBatteryTh * m_initialEnergyJ - m_remainingEnergyJ;
+    }
+  else
+    {
+      return;
+    }
+
+  double seconds = std::max (energyToThresholdJ, 0.0) / std::abs (powerW);
+  if (seconds >= (Simulator::GetMaximumSimulationTime () - Simulator::Now ()).GetSeconds ())
+    {
+      return;
+    }
+
+  // Never early: the handler would find the threshold not crossed yet
+  Time delay = Seconds (seconds);
+  if (delay.GetSeconds () < seconds)
+    {
+      delay += TimeStep (1);
+    }
+  NS_LOG_DEBUG ("LazyBasicEnergySource:Threshold crossed in " << delay.GetSeconds () << " s");
+  m_thresholdEvent = Simulator::Schedule (delay, &LazyBasicEnergySource::HandleThresholdCrossing,
+                                          this);
+}
+
+void
+LazyBasicEnergySource::HandleThresholdCrossing (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  bool depleted = m_depleted;
+  IntegrateEnergy ();
+
+  // Rounding errors may leave the remaining energy just short of the threshold
+  if (m_depleted == depleted)
+    {
+      m_depleted = !depleted;
+      if (m_depleted)
+        {
+          NS_LOG_DEBUG ("LazyBasicEnergySource:Energy depleted!");
+          NotifyEnergyDrained ();
+        }
+      else
+        {
+          NS_LOG_DEBUG ("LazyBasicEnergySource:Energy recharged!");
+          NotifyEnergyRecharged ();
+        }
+    }
+  m_predictionStale = false;
+  PredictThresholdCrossing ();
+}
+
+} // namespace lorawan
+} // namespace ns3
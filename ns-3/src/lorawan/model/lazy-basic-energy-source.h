@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LAZY_BASIC_ENERGY_SOURCE_H
+#define LAZY_BASIC_ENERGY_SOURCE_H
+
+#include "ns3/energy-source.h"
+#include "ns3/traced-value.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup energy
+ * \brief A BasicEnergySource that only updates its remaining energy when a
+ * device changes state or when it is queried.
+ *
+ * BasicEnergySource integrates the current drawn by its devices with a
+ * periodic update event, which is mostly useless for end devices that sleep
+ * most of the time. Since the current only changes when a device changes
+ * state, and devices call UpdateEnergySource right before doing so, this
+ * source integrates current x time over the interval since the last update
+ * on these calls and on queries only. After each state change, it computes
+ * the time at which the remaining energy will cross the low (or, when
+ * recharging, the high) battery threshold at the new current, and schedules
+ * a single event at that time.
+ *
+ * The remaining energy is thus the same as that of a BasicEnergySource, but
+ * the depletion is notified when it actually happens, instead of at the
+ * first periodic update after it. The RemainingEnergy trace source is only
+ * fired on updates.
+ */
+class LazyBasicEnergySource : public EnergySource
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LazyBasicEnergySource ();
+  virtual ~LazyBasicEnergySource ();
+
+  /**
+   * \return Initial energy stored in energy source, in Joules.
+   *
+   * Implements GetInitialEnergy.
+   */
+  virtual double GetInitialEnergy (void) const;
+
+  /**
+   * \returns Supply voltage at the energy source.
+   *
+   * Implements GetSupplyVoltage.
+   */
+  virtual double GetSupplyVoltage (void) const;
+
+  /**
+   * \return Remaining energy in energy source, in Joules
+   *
+   * Implements GetRemainingEnergy.
+   */
+  virtual double GetRemainingEnergy (void);
+
+  /**
+   * \returns Energy fraction.
+   *
+   * Implements GetEnergyFraction.
+   */
+  virtual double GetEnergyFraction (void);
+
+  /**
+   * Implements UpdateEnergySource.
+   *
+   * Integrates the current drawn since the last update. The device that
+   * called this method is about to change state, so the prediction of the
+   * next threshold crossing is left to UpdateThresholdPrediction, or to the
+   * next query.
+   */
+  virtual void UpdateEnergySource (void);
+
+  /**
+   * Predict the next threshold crossing at the current drawn now, and
+   * schedule it in place of the previous prediction.
+   *
+   * Device energy models call this method right after changing state, as
+   * LoraRadioEnergyModel does. With other models, the prediction is only
+   * made on the next query of the remaining energy, so that the crossing may
+   * be notified late.
+   */
+  void UpdateThresholdPrediction (void);
+
+  /**
+   * \param initialEnergyJ Initial energy, in Joules
+   */
+  void SetInitialEnergy (double initialEnergyJ);
+
+  /**
+   * \param supplyVoltageV Supply voltage at the energy source, in Volts.
+   */
+  void SetSupplyVoltage (double supplyVoltageV);
+
+  /**
+   * \returns The time at which the next threshold crossing is scheduled,
+   * or Time::Max () if none is.
+   */
+  Time GetPredictedThresholdCrossing (void);
+
+private:
+  /// Defined in ns3::Object
+  void DoInitialize (void);
+
+  /// Defined in ns3::Object
+  void DoDispose (void);
+
+  /**
+   * Subtract the energy drawn since the last update from the remaining
+   * energy, and notify the devices if a threshold was crossed.
+   */
+  void IntegrateEnergy (void);
+
+  /**
+   * Compute when the remaining energy will cross the next threshold at the
+   * current total current, and schedule the corresponding update. The
+   * previous prediction is removed from the scheduler, rather than just
+   * cancelled, so that replaced predictions, which are often far in the
+   * future, do not pile up there.
+   */
+  void PredictThresholdCrossing (void);
+
+  /**
+   * Handle the predicted threshold crossing.
+   */
+  void HandleThresholdCrossing (void);
+
+private:
+  double m_initialEnergyJ;                // initial energy, in Joules
+  double m_supplyVoltageV;                // supply voltage, in Volts
+  double m_lowBatteryTh;                  // low battery threshold, as a fraction of the initial energy
+  double m_highBatteryTh;                 // high battery threshold, as a fraction of the initial energy
+  bool m_depleted;                        // set to true when the remaining energy goes below the low threshold,
+                                          // set to false again when the remaining energy exceeds the high threshold
+  TracedValue<double> m_remainingEnergyJ; // remaining energy, in Joules
+  Time m_lastUpdateTime;                  // last update time
+  bool m_predictionStale;                 // whether a device changed state since the last prediction
+  EventId m_thresholdEvent;               // predicted threshold crossing
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LAZY_BASIC_ENERGY_SOURCE_H */
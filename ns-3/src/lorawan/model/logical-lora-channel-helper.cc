@@ -20,12 +20,13 @@
 
 #include "ns3/logical-lora-channel-helper.h"
 #include "ns3/simulator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LogicalLoraChannelHelper");
+LORA_LOG_COMPONENT_DEFINE ("LogicalLoraChannelHelper");
 
 NS_OBJECT_ENSURE_REGISTERED (LogicalLoraChannelHelper);
 
@@ -39,6 +40,8 @@ LogicalLoraChannelHelper::GetTypeId (void)
 }
 
 LogicalLoraChannelHelper::LogicalLoraChannelHelper () :
+  m_nSubBands (0),
+  m_nChannels (0),
   m_nextAggregatedTransmissionTime (Seconds (0)),
   m_aggregatedDutyCycle (1)
 {
@@ -100,13 +103,10 @@ Ptr<SubBand>
 LogicalLoraChannelHelper::GetSubBandFromFrequency (double frequency)
 {
   // Get the SubBand this frequency belongs to
-  std::list< Ptr< SubBand > >::iterator it;
-  for (it = m_subBandList.begin (); it != m_subBandList.end (); it++)
+  uint8_t index = GetSubBandIndex (frequency);
+  if (index != NO_SUB_BAND)
     {
-      if ((*it)->BelongsToSubBand (frequency))
-        {
-          return *it;
-        }
+      return m_subBands[index];
     }
 
   NS_LOG_ERROR ("Requested frequency: " << frequency);
@@ -115,6 +115,34 @@ LogicalLoraChannelHelper::GetSubBandFromFrequency (double frequency)
   return 0;     // If no SubBand is found, return 0
 }
 
+uint8_t
+LogicalLoraChannelHelper::GetSubBandIndex (double frequency) const
+{
+  for (uint8_t i = 0; i < m_nSubBands; i++)
+    {
+      if (m_subBands[i]->BelongsToSubBand (frequency))
+        {
+          return i;
+        }
+    }
+  return NO_SUB_BAND;
+}
+
+void
+LogicalLoraChannelHelper::UpdateChannelTable (void)
+{
+  NS_ABORT_MSG_IF (m_channelList.size () > MAX_CHANNELS,
+                   "Too many channels: at most " << unsigned (MAX_CHANNELS) <<
+                   " are supported");
+
+  m_nChannels = m_channelList.size ();
+  for (uint8_t i = 0; i < m_nChannels; i++)
+    {
+      m_channels[i] = PeekPointer (m_channelList[i]);
+      m_channelSubBand[i] = GetSubBandIndex (m_channels[i]->GetFrequency ());
+    }
+}
+
 void
 LogicalLoraChannelHelper::AddChannel (double frequency)
 {
@@ -125,6 +153,7 @@ LogicalLoraChannelHelper::AddChannel (double frequency)
 
   // Add it to the list
   m_channelList.push_back (channel);
+  UpdateChannelTable ();
 
   NS_LOG_DEBUG ("Added a channel. Current number of channels in list is " <<
                 m_channelList.size ());
@@ -137,6 +166,7 @@ LogicalLoraChannelHelper::AddChannel (Ptr<LogicalLoraChannel> logicalChannel)
 
   // Add it to the list
   m_channelList.push_back (logicalChannel);
+  UpdateChannelTable ();
 }
 
 void
@@ -147,6 +177,7 @@ LogicalLoraChannelHelper::SetChannel (uint8_t chIndex,
   NS_LOG_FUNCTION (this << chIndex << logicalChannel);
 
   m_channelList.at (chIndex) = logicalChannel;
+  UpdateChannelTable ();
 }
 
 void
@@ -159,7 +190,7 @@ LogicalLoraChannelHelper::AddSubBand (double firstFrequency,
   Ptr<SubBand> subBand = Create<SubBand> (firstFrequency, lastFrequency,
                                           dutyCycle, maxTxPowerDbm);
 
-  m_subBandList.push_back (subBand);
+  AddSubBand (subBand);
 }
 
 void
@@ -167,7 +198,17 @@ LogicalLoraChannelHelper::AddSubBand (Ptr<SubBand> subBand)
 {
   NS_LOG_FUNCTION (this << subBand);
 
+  NS_ABORT_MSG_IF (m_nSubBands == MAX_SUB_BANDS,
+                   "Too many SubBands: at most " << unsigned (MAX_SUB_BANDS) <<
+                   " are supported");
+
   m_subBandList.push_back (subBand);
+  m_subBands[m_nSubBands] = PeekPointer (subBand);
+  m_subBandNextTransmissionTime[m_nSubBands] = subBand->GetNextTransmissionTime ();
+  m_nSubBands++;
+
+  // Channels may have been added before their SubBand
+  UpdateChannelTable ();
 }
 
 void
@@ -181,6 +222,7 @@ LogicalLoraChannelHelper::RemoveChannel (Ptr<LogicalLoraChannel> logicalChannel)
       if (currentChannel == logicalChannel)
         {
           m_channelList.erase (it);
+          UpdateChannelTable ();
           return;
         }
     }
@@ -206,27 +248,96 @@ LogicalLoraChannelHelper::GetWaitingTime (Ptr<LogicalLoraChannel> channel)
 {
   NS_LOG_FUNCTION (this << channel);
 
+  uint8_t subBand = GetSubBandIndex (channel->GetFrequency ());
+  NS_ABORT_MSG_IF (subBand == NO_SUB_BAND,
+                   "Warning: frequency is outside any known SubBand.");
+
   // SubBand waiting time
-  Time subBandWaitingTime = GetSubBandFromChannel (channel)->
-    GetNextTransmissionTime () -
+  Time subBandWaitingTime = m_subBandNextTransmissionTime[subBand] -
     Simulator::Now ();
 
   // Handle case in which waiting time is negative
-  subBandWaitingTime = Seconds (std::max (subBandWaitingTime.GetSeconds (),
-                                          double(0)));
+  subBandWaitingTime = std::max (subBandWaitingTime, Time (0));
 
   NS_LOG_DEBUG ("Waiting time: " << subBandWaitingTime.GetSeconds ());
 
   return subBandWaitingTime;
 }
 
+Time
+LogicalLoraChannelHelper::GetMinimumWaitingTime (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time nextTransmissionTime = Time::Max ();
+  for (uint8_t i = 0; i < m_nChannels; i++)
+    {
+      if (m_channels[i]->IsEnabledForUplink ())
+        {
+          NS_ABORT_MSG_IF (m_channelSubBand[i] == NO_SUB_BAND,
+                           "Channel " << m_channels[i]->GetFrequency () <<
+                           " is outside any known SubBand.");
+          nextTransmissionTime = std::min (nextTransmissionTime,
+                                           m_subBandNextTransmissionTime[m_channelSubBand[i]]);
+        }
+    }
+
+  if (nextTransmissionTime == Time::Max ())
+    {
+      return nextTransmissionTime;
+    }
+  return std::max (nextTransmissionTime - Simulator::Now (), Time (0));
+}
+
+Ptr<LogicalLoraChannel>
+LogicalLoraChannelHelper::GetRandomAvailableChannel (double random)
+{
+  NS_LOG_FUNCTION (this << random);
+
+  // Indexes of the channels on which we could transmit right now
+  uint8_t eligible[MAX_CHANNELS];
+  uint8_t nEligible = 0;
+
+  Time now = Simulator::Now ();
+  for (uint8_t i = 0; i < m_nChannels; i++)
+    {
+      if (!m_channels[i]->IsEnabledForUplink ())
+        {
+          continue;
+        }
+      NS_ABORT_MSG_IF (m_channelSubBand[i] == NO_SUB_BAND,
+                       "Channel " << m_channels[i]->GetFrequency () <<
+                       " is outside any known SubBand.");
+      if (m_subBandNextTransmissionTime[m_channelSubBand[i]] <= now)
+        {
+          eligible[nEligible++] = i;
+        }
+    }
+
+  if (nEligible == 0)
+    {
+      NS_LOG_DEBUG ("No channel is available because of duty cycle limitations.");
+      return 0;
+    }
+
+  uint8_t chosen = std::min<uint8_t> (random * nEligible, nEligible - 1);
+
+  NS_LOG_DEBUG ("Chose channel " << m_channels[eligible[chosen]]->GetFrequency () <<
+                " among " << unsigned (nEligible) << " available ones");
+
+  return m_channels[eligible[chosen]];
+}
+
 void
 LogicalLoraChannelHelper::AddEvent (Time duration,
                                     Ptr<LogicalLoraChannel> channel)
 {
   NS_LOG_FUNCTION (this << duration << channel);
 
-  Ptr<SubBand> subBand = GetSubBandFromChannel (channel);
+  uint8_t index = GetSubBandIndex (channel->GetFrequency ());
+  NS_ABORT_MSG_IF (index == NO_SUB_BAND,
+                   "Warning: frequency is outside any known SubBand.");
+  SubBand *subBand = m_subBands[index];
 
   double dutyCycle = subBand->GetDutyCycle ();
   double timeOnAir = duration.GetSeconds ();
@@ -234,6 +345,7 @@ LogicalLoraChannelHelper::AddEvent (Time duration,
   // Computation of necessary waiting time on this sub-band
   subBand->SetNextTransmissionTime (Simulator::Now () + Seconds
                                       (timeOnAir / dutyCycle - timeOnAir));
+  m_subBandNextTransmissionTime[index] = subBand->GetNextTransmissionTime ();
 
   // Computation of necessary aggregate waiting time
   m_nextAggregatedTransmissionTime = Simulator::Now () + Seconds
@@ -255,14 +367,10 @@ LogicalLoraChannelHelper::GetTxPowerForChannel (Ptr<LogicalLoraChannel>
   NS_LOG_FUNCTION_NOARGS ();
 
   // Get the maxTxPowerDbm from the SubBand this channel is in
-  std::list< Ptr< SubBand > >::iterator it;
-  for (it = m_subBandList.begin (); it != m_subBandList.end (); it++)
+  uint8_t index = GetSubBandIndex (logicalChannel->GetFrequency ());
+  if (index != NO_SUB_BAND)
     {
-      // Check whether this channel is in this SubBand
-      if ((*it)->BelongsToSubBand (logicalChannel->GetFrequency ()))
-        {
-          return (*it)->GetMaxTxPowerDbm ();
-        }
+      return m_subBands[index]->GetMaxTxPowerDbm ();
     }
   NS_ABORT_MSG ("Logical channel doesn't belong to a known SubBand");
 
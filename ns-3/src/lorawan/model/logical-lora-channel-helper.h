@@ -47,6 +47,17 @@ class LogicalLoraChannelHelper : public Object
 public:
   static TypeId GetTypeId (void);
 
+  /**
+   * The maximum number of channels a device can manage (the size of the
+   * LoRaWAN channel mask).
+   */
+  static const uint8_t MAX_CHANNELS = 16;
+
+  /**
+   * The maximum number of SubBands that can be registered on this helper.
+   */
+  static const uint8_t MAX_SUB_BANDS = 8;
+
   LogicalLoraChannelHelper ();
   virtual ~LogicalLoraChannelHelper ();
 
@@ -72,6 +83,31 @@ public:
    */
   Time GetWaitingTime (Ptr<LogicalLoraChannel> channel);
 
+  /**
+   * Get the minimum time it is necessary to wait for before transmitting on
+   * any of the channels enabled for Uplink transmission.
+   *
+   * \remark Like GetWaitingTime, this function does not take into account
+   * aggregate waiting time.
+   *
+   * \return The minimum waiting time, or Time::Max () if no channel is
+   * enabled.
+   */
+  Time GetMinimumWaitingTime (void);
+
+  /**
+   * Pick a channel enabled for Uplink transmission on which it is possible to
+   * transmit right now, uniformly at random among the eligible ones.
+   *
+   * This function works on the internal channel and SubBand tables, and
+   * performs no allocation.
+   *
+   * \param random A number uniformly drawn in [0, 1).
+   * \return The chosen channel, or 0 if every enabled channel is blocked by
+   * duty cycle limitations.
+   */
+  Ptr<LogicalLoraChannel> GetRandomAvailableChannel (double random);
+
   /**
    * Register the transmission of a packet.
    *
@@ -176,11 +212,49 @@ public:
   void DisableChannel (int index);
 
 private:
+  /**
+   * Value of the m_channelSubBand table for a channel that is outside any
+   * known SubBand.
+   */
+  static const uint8_t NO_SUB_BAND = 0xff;
+
+  /**
+   * Get the index in m_subBands of the SubBand a frequency belongs to.
+   *
+   * \param frequency The frequency we want to check.
+   * \return The index of the SubBand, or NO_SUB_BAND.
+   */
+  uint8_t GetSubBandIndex (double frequency) const;
+
+  /**
+   * Rebuild the m_channels and m_channelSubBand tables from m_channelList.
+   */
+  void UpdateChannelTable (void);
+
   /**
    * A list of the SubBands that are currently registered within this helper.
    */
   std::list<Ptr <SubBand> > m_subBandList;
 
+  /**
+   * The SubBands of m_subBandList, in the same order, and the time from which
+   * transmission on each of them will be allowed again (a copy of their
+   * NextTransmissionTime, kept here to be checked without following the
+   * pointers).
+   */
+  SubBand *m_subBands[MAX_SUB_BANDS];
+  Time m_subBandNextTransmissionTime[MAX_SUB_BANDS];
+  uint8_t m_nSubBands; //!< The number of entries in m_subBands
+
+  /**
+   * The channels of m_channelList, in the same order, and the index in
+   * m_subBands of the SubBand each of them belongs to. These tables do not
+   * hold a reference: the channels are kept alive by m_channelList.
+   */
+  LogicalLoraChannel *m_channels[MAX_CHANNELS];
+  uint8_t m_channelSubBand[MAX_CHANNELS];
+  uint8_t m_nChannels; //!< The number of entries in m_channels
+
   /**
    * A vector of the LogicalLoraChannels that are currently registered within
    * this helper. This vector represents the node's channel mask. The first N
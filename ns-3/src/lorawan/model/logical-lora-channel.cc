@@ -19,12 +19,12 @@
  */
 
 #include "ns3/logical-lora-channel.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LogicalLoraChannel");
+LORA_LOG_COMPONENT_DEFINE ("LogicalLoraChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (LogicalLoraChannel);
 
@@ -0,0 +1,270 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LORA_AIRTIME_H
+#define LORA_AIRTIME_H
+
+#include <array>
+#include <cstdint>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * Closed-form, table-driven computation of the time on air of LoRa packets.
+ *
+ * The formula of the SX1272 LoRa modem designer's guide is split in the number
+ * of payload symbols, which only depends on the spreading factor, the coding
+ * rate, the header, CRC and low data rate optimization settings and the payload
+ * size, and in the symbol duration, which only depends on the spreading factor
+ * and the bandwidth. The former is looked up in a table generated at compile
+ * time for SF7 to SF12 and payloads up to MAX_TABLE_PAYLOAD bytes (and computed
+ * in closed form otherwise), the latter is a single division.
+ *
+ * All functions are constexpr, so that time on air values can be used to
+ * define constants.
+ */
+class LoraAirtime
+{
+public:
+  static constexpr uint8_t MIN_SF = 7; //!< The lowest SF in the table
+  static constexpr uint8_t MAX_SF = 12; //!< The highest SF in the table
+  static constexpr uint32_t MAX_TABLE_PAYLOAD = 255; //!< The largest payload in the table
+
+  /**
+   * Compute the number of symbols of the payload part of a packet (i.e.,
+   * everything but the preamble) with the closed-form formula.
+   *
+   * \param sf The spreading factor.
+   * \param payloadSize The PHY payload size, in bytes.
+   * \param codingRate The coding rate (obtained as 4/(codingRate+4)).
+   * \param headerDisabled Whether implicit header mode is used.
+   * \param crcEnabled Whether the CRC is enabled.
+   * \param lowDataRateOptimization Whether low data rate optimization is enabled.
+   * \return The number of payload symbols.
+   */
+  static constexpr uint32_t ComputePayloadSymbols (uint8_t sf, uint32_t payloadSize,
+                                                   uint8_t codingRate,
+                                                   bool headerDisabled, bool crcEnabled,
+                                                   bool lowDataRateOptimization);
+
+  /**
+   * Get the number of symbols of the payload part of a packet, from the table
+   * if the parameters are in its range.
+   *
+   * \copydetails ComputePayloadSymbols
+   */
+  static constexpr uint32_t GetPayloadSymbols (uint8_t sf, uint32_t payloadSize,
+                                               uint8_t codingRate,
+                                               bool headerDisabled, bool crcEnabled,
+                                               bool lowDataRateOptimization);
+
+  /**
+   * Get the duration of a symbol.
+   *
+   * \param sf The spreading factor.
+   * \param bandwidthHz The bandwidth, in Hz.
+   * \return The duration of a symbol, in seconds.
+   */
+  static constexpr double GetSymbolDuration (uint8_t sf, double bandwidthHz);
+
+  /**
+   * Whether LoRaWAN requires low data rate optimization, i.e., whether symbols
+   * last longer than 16 ms.
+   *
+   * \param sf The spreading factor.
+   * \param bandwidthHz The bandwidth, in Hz.
+   * \return True if low data rate optimization should be enabled.
+   */
+  static constexpr bool IsLowDataRateOptimizationRequired (uint8_t sf, double bandwidthHz);
+
+  /**
+   * Get the time on air of a packet.
+   *
+   * \param sf The spreading factor.
+   * \param bandwidthHz The bandwidth, in Hz.
+   * \param codingRate The coding rate (obtained as 4/(codingRate+4)).
+   * \param nPreamble The number of preamble symbols.
+   * \param headerDisabled Whether implicit header mode is used.
+   * \param crcEnabled Whether the CRC is enabled.
+   * \param lowDataRateOptimization Whether low data rate optimization is enabled.
+   * \param payloadSize The PHY payload size, in bytes.
+   * \return The time on air, in seconds.
+   */
+  static constexpr double GetOnAirSeconds (uint8_t sf, double bandwidthHz,
+                                           uint8_t codingRate, uint32_t nPreamble,
+                                           bool headerDisabled, bool crcEnabled,
+                                           bool lowDataRateOptimization,
+                                           uint32_t payloadSize);
+
+  /**
+   * Get the ratio between the time on air of a packet at SF12 and at each
+   * SF, from SF12 (index 0, i.e., DR0) to SF7 (index 5, i.e., DR5).
+   *
+   * The usual LoRaWAN uplink settings are assumed: 125 kHz, coding rate 4/5,
+   * 8 preamble symbols, explicit header, CRC, and low data rate optimization
+   * where it is required.
+   *
+   * \param payloadSize The PHY payload size, in bytes.
+   * \return The time on air ratios.
+   */
+  static constexpr std::array<double, 6> GetOnAirTimeRatios (uint32_t payloadSize);
+
+private:
+  /**
+   * The number of payload symbols, before applying the coding rate, for all
+   * the SF, header, CRC, low data rate optimization and payload size
+   * combinations.
+   */
+  struct Table
+  {
+    constexpr Table ();
+
+    /**
+     * The index of a combination of parameters in m_symbols.
+     */
+    static constexpr uint32_t GetIndex (uint8_t sf, bool headerDisabled, bool crcEnabled,
+                                        bool lowDataRateOptimization, uint32_t payloadSize);
+
+    uint8_t m_symbols[(MAX_SF - MIN_SF + 1) * 8 * (MAX_TABLE_PAYLOAD + 1)];
+  };
+
+  /**
+   * The ceiling of the number of payload symbols over (codingRate + 4), i.e.,
+   * the number of blocks of 4 bits, in closed form.
+   */
+  static constexpr uint32_t ComputePayloadBlocks (uint8_t sf, uint32_t payloadSize,
+                                                  bool headerDisabled, bool crcEnabled,
+                                                  bool lowDataRateOptimization);
+
+  static const Table s_table; //!< The table of payload blocks
+};
+
+constexpr uint32_t
+LoraAirtime::ComputePayloadBlocks (uint8_t sf, uint32_t payloadSize,
+                                   bool headerDisabled, bool crcEnabled,
+                                   bool lowDataRateOptimization)
+{
+  // num and den refer to numerator and denominator of the time on air formula
+  int32_t num = 8 * int32_t (payloadSize) - 4 * sf + 28 + 16 * crcEnabled - 20 * headerDisabled;
+  int32_t den = 4 * (sf - 2 * lowDataRateOptimization);
+
+  // Integer ceiling of num / den, which is never negative
+  return num <= 0 ? 0 : (num + den - 1) / den;
+}
+
+constexpr uint32_t
+LoraAirtime::ComputePayloadSymbols (uint8_t sf, uint32_t payloadSize, uint8_t codingRate,
+                                    bool headerDisabled, bool crcEnabled,
+                                    bool lowDataRateOptimization)
+{
+  return 8 + ComputePayloadBlocks (sf, payloadSize, headerDisabled, crcEnabled,
+                                   lowDataRateOptimization) * (codingRate + 4);
+}
+
+constexpr uint32_t
+LoraAirtime::Table::GetIndex (uint8_t sf, bool headerDisabled, bool crcEnabled,
+                              bool lowDataRateOptimization, uint32_t payloadSize)
+{
+  return ((((sf - MIN_SF) * 2 + headerDisabled) * 2 + crcEnabled) * 2 +
+          lowDataRateOptimization) * (MAX_TABLE_PAYLOAD + 1) + payloadSize;
+}
+
+constexpr
+LoraAirtime::Table::Table () : m_symbols ()
+{
+  for (uint8_t sf = MIN_SF; sf <= MAX_SF; sf++)
+    {
+      for (int options = 0; options < 8; options++)
+        {
+          bool headerDisabled = options & 4;
+          bool crcEnabled = options & 2;
+          bool lowDataRateOptimization = options & 1;
+          for (uint32_t payloadSize = 0; payloadSize <= MAX_TABLE_PAYLOAD; payloadSize++)
+            {
+              m_symbols[GetIndex (sf, headerDisabled, crcEnabled, lowDataRateOptimization,
+                                  payloadSize)] =
+                ComputePayloadBlocks (sf, payloadSize, headerDisabled, crcEnabled,
+                                      lowDataRateOptimization);
+            }
+        }
+    }
+}
+
+inline constexpr LoraAirtime::Table LoraAirtime::s_table {};
+
+constexpr uint32_t
+LoraAirtime::GetPayloadSymbols (uint8_t sf, uint32_t payloadSize, uint8_t codingRate,
+                                bool headerDisabled, bool crcEnabled,
+                                bool lowDataRateOptimization)
+{
+  if (sf < MIN_SF || sf > MAX_SF || payloadSize > MAX_TABLE_PAYLOAD)
+    {
+      return ComputePayloadSymbols (sf, payloadSize, codingRate, headerDisabled,
+                                    crcEnabled, lowDataRateOptimization);
+    }
+  return 8 + s_table.m_symbols[Table::GetIndex (sf, headerDisabled, crcEnabled,
+                                                lowDataRateOptimization, payloadSize)] *
+         (codingRate + 4);
+}
+
+constexpr double
+LoraAirtime::GetSymbolDuration (uint8_t sf, double bandwidthHz)
+{
+  return double (uint32_t (1) << sf) / bandwidthHz;
+}
+
+constexpr bool
+LoraAirtime::IsLowDataRateOptimizationRequired (uint8_t sf, double bandwidthHz)
+{
+  return GetSymbolDuration (sf, bandwidthHz) > 0.016;
+}
+
+constexpr double
+LoraAirtime::GetOnAirSeconds (uint8_t sf, double bandwidthHz, uint8_t codingRate,
+                              uint32_t nPreamble, bool headerDisabled, bool crcEnabled,
+                              bool lowDataRateOptimization, uint32_t payloadSize)
+{
+  double tSym = GetSymbolDuration (sf, bandwidthHz);
+  double tPreamble = (double (nPreamble) + 4.25) * tSym;
+  double tPayload = GetPayloadSymbols (sf, payloadSize, codingRate, headerDisabled,
+                                       crcEnabled, lowDataRateOptimization) * tSym;
+  return tPreamble + tPayload;
+}
+
+constexpr std::array<double, 6>
+LoraAirtime::GetOnAirTimeRatios (uint32_t payloadSize)
+{
+  std::array<double, 6> timeOnAir {};
+  std::array<double, 6> ratios {};
+  for (uint8_t dr = 0; dr < 6; dr++)
+    {
+      uint8_t sf = 12 - dr;
+      timeOnAir[dr] = GetOnAirSeconds (sf, 125000, 1, 8, false, true,
+                                       IsLowDataRateOptimizationRequired (sf, 125000),
+                                       payloadSize);
+      ratios[dr] = timeOnAir[0] / timeOnAir[dr];
+    }
+  return ratios;
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_AIRTIME_H */
@@ -19,19 +19,23 @@
  */
 
 #include "ns3/lora-channel.h"
-#include "ns3/log.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-log.h"
 #include "ns3/pointer.h"
 #include "ns3/object-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/gateway-lora-phy.h"
+#include "ns3/uinteger.h"
+#include "ns3/constant-position-mobility-model.h"
 #include <algorithm>
+#include <set>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraChannel");
+LORA_LOG_COMPONENT_DEFINE ("LoraChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraChannel);
 
@@ -52,6 +56,20 @@ LoraChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("WorkerThreads",
+                   "Number of worker threads, on top of the simulation one, "
+                   "used to compute the received power at all PHYs when a "
+                   "packet is sent. Results are the same as with 0, which "
+                   "disables this feature",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&LoraChannel::m_workerThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ParallelThreshold",
+                   "Minimum number of connected PHYs for the computations of "
+                   "a Send to be split among the worker threads",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&LoraChannel::m_parallelThreshold),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("PacketSent",
                      "Trace source fired whenever a packet goes out on the channel",
                      MakeTraceSourceAccessor (&LoraChannel::m_packetSent),
@@ -59,7 +77,11 @@ LoraChannel::GetTypeId (void)
   return tid;
 }
 
-LoraChannel::LoraChannel ()
+LoraChannel::LoraChannel () :
+  m_workerThreads (0),
+  m_parallelThreshold (1000),
+  m_mobilityCacheValid (false),
+  m_mobilityCacheSafe (false)
 {
 }
 
@@ -71,10 +93,29 @@ LoraChannel::~LoraChannel ()
 LoraChannel::LoraChannel (Ptr<PropagationLossModel> loss,
                           Ptr<PropagationDelayModel> delay) :
   m_loss (loss),
-  m_delay (delay)
+  m_delay (delay),
+  m_workerThreads (0),
+  m_parallelThreshold (1000),
+  m_mobilityCacheValid (false),
+  m_mobilityCacheSafe (false)
 {
 }
 
+void
+LoraChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Joins the worker threads
+  m_workerPool = 0;
+  m_senderProxies.clear ();
+  m_mobilityCache.clear ();
+  m_mobilityCacheValid = false;
+  m_receiverMobilities.clear ();
+
+  Channel::DoDispose ();
+}
+
 void
 LoraChannel::Add (Ptr<LoraPhy> phy)
 {
@@ -82,6 +123,7 @@ LoraChannel::Add (Ptr<LoraPhy> phy)
 
   // Add the new phy to the vector
   m_phyList.push_back (phy);
+  m_mobilityCacheValid = false;
 }
 
 void
@@ -91,6 +133,15 @@ LoraChannel::Remove (Ptr<LoraPhy> phy)
 
   // Remove the phy from the vector
   m_phyList.erase (find (m_phyList.begin (), m_phyList.end (), phy));
+  m_mobilityCacheValid = false;
+}
+
+void
+LoraChannel::InvalidateMobilityCache (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_mobilityCacheValid = false;
 }
 
 std::size_t
@@ -110,6 +161,7 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
                    double txPowerDbm, LoraTxParameters txParams,
                    Time duration, double frequencyMHz) const
 {
+  LORA_PROFILE_SCOPE ("LoraChannel::Send");
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << txParams <<
                    duration << frequencyMHz);
 
@@ -121,63 +173,277 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
   NS_LOG_INFO ("Starting cycle over all " << m_phyList.size () << " PHYs");
   NS_LOG_INFO ("Sender mobility: " << senderMobility->GetPosition ());
 
-  // Cycle over all registered PHYs
-  uint32_t j = 0;
-  std::vector<Ptr<LoraPhy> >::const_iterator i;
-  for (i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  if (m_workerThreads > 0 && m_phyList.size () >= m_parallelThreshold
+      && SendParallel (sender, senderMobility, packet, txPowerDbm, txParams,
+                       duration, frequencyMHz))
     {
-      // Do not deliver to the sender (*i is the current PHY)
-      if (sender != (*i))
+      return;
+    }
+
+  DeliverToPhys (sender, senderMobility, packet, txPowerDbm, txParams.sf,
+                 duration, frequencyMHz, Seconds (0));
+}
+
+void
+LoraChannel::DeliverToPhys (Ptr<LoraPhy> sender,
+                            Ptr<MobilityModel> senderMobility,
+                            Ptr<Packet> packet, double txPowerDbm, uint8_t sf,
+                            Time duration, double frequencyMHz,
+                            Time elapsed) const
+{
+  // Gather the receivers: all registered PHYs but the sender
+  m_receiverIndices.clear ();
+  m_receiverMobilities.clear ();
+  for (uint32_t j = 0; j < m_phyList.size (); j++)
+    {
+      if (sender != m_phyList[j])
         {
-          // Get the receiver's mobility model
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->
-            GetObject<MobilityModel> ();
+          m_receiverIndices.push_back (j);
+          m_receiverMobilities.push_back (m_phyList[j]->GetMobility ()->
+                                          GetObject<MobilityModel> ());
+        }
+    }
 
-          NS_LOG_INFO ("Receiver mobility: " <<
-                       receiverMobility->GetPosition ());
+  // Compute the received powers at once using the loss model
+  std::size_t nReceivers = m_receiverIndices.size ();
+  m_rxPowerBuffer.resize (nReceivers);
+  m_loss->CalcRxPowerBatch (txPowerDbm, senderMobility,
+                            m_receiverMobilities.data (), nReceivers,
+                            m_rxPowerBuffer.data ());
 
-          // Compute delay using the delay model
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  for (std::size_t k = 0; k < nReceivers; k++)
+    {
+      const Ptr<MobilityModel> &receiverMobility = m_receiverMobilities[k];
 
-          // Compute received power using the loss model
-          double rxPowerDbm = GetRxPower (txPowerDbm, senderMobility,
-                                          receiverMobility);
+      NS_LOG_INFO ("Receiver mobility: " <<
+                   receiverMobility->GetPosition ());
+
+      // Compute delay using the delay model
+      Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+      delay = Max (delay - elapsed, Seconds (0));
+
+      double rxPowerDbm = m_rxPowerBuffer[k];
+
+      NS_LOG_DEBUG ("Propagation: txPower=" << txPowerDbm <<
+                    "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                    "distance=" << senderMobility->GetDistanceFrom (receiverMobility) <<
+                    "m, delay=" << delay);
 
-          NS_LOG_DEBUG ("Propagation: txPower=" << txPowerDbm <<
-                        "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) <<
-                        "m, delay=" << delay);
+      ScheduleReception (m_receiverIndices[k], packet, rxPowerDbm, delay, sf,
+                         duration, frequencyMHz);
+    }
+}
+
+void
+LoraChannel::ScheduleReception (uint32_t j, Ptr<Packet> packet,
+                                double rxPowerDbm, Time delay, uint8_t sf,
+                                Time duration, double frequencyMHz) const
+{
+  // Get the id of the destination PHY to correctly format the context
+  Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice ();
+  uint32_t dstNode = 0;
+  if (dstNetDevice != 0)
+    {
+      NS_LOG_INFO ("Getting node index from NetDevice, since it exists");
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+      NS_LOG_DEBUG ("dstNode = " << dstNode);
+    }
+  else
+    {
+      NS_LOG_INFO ("No net device connected to the PHY, using context 0");
+    }
+
+  // Create the parameters object based on the calculations above
+  LoraChannelParameters parameters;
+  parameters.rxPowerDbm = rxPowerDbm;
+  parameters.sf = sf;
+  parameters.duration = duration;
+  parameters.frequencyMHz = frequencyMHz;
+
+  // Schedule the receive event
+  NS_LOG_INFO ("Scheduling reception of the packet");
+  Simulator::ScheduleWithContext (dstNode, delay, &LoraChannel::Receive,
+                                  this, j, packet, parameters);
+
+  // Fire the trace source for sent packet
+  m_packetSent (packet);
+}
 
-          // Get the id of the destination PHY to correctly format the context
-          Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode = 0;
-          if (dstNetDevice != 0)
+/**
+ * Whether a loss or delay model only depends on the positions of the two
+ * nodes, without keeping any state or drawing random numbers, and can thus be
+ * evaluated from several threads at once.
+ */
+static bool
+IsPositionOnlyModel (Ptr<Object> model)
+{
+  static const char *names[] = {
+    "ns3::LogDistancePropagationLossModel",
+    "ns3::ThreeLogDistancePropagationLossModel",
+    "ns3::FriisPropagationLossModel",
+    "ns3::TwoRayGroundPropagationLossModel",
+    "ns3::FixedRssLossModel",
+    "ns3::RangePropagationLossModel",
+    "ns3::ConstantSpeedPropagationDelayModel"
+  };
+
+  std::string name = model->GetInstanceTypeId ().GetName ();
+  for (std::size_t i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+    {
+      if (name == names[i])
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+LoraChannel::UpdateMobilityCache (void) const
+{
+  if (m_mobilityCacheValid)
+    {
+      return m_mobilityCacheSafe;
+    }
+
+  NS_LOG_FUNCTION (this);
+
+  // Worker threads must not call GetObject, which reorders the aggregates,
+  // nor GetPosition on models that update their state lazily. Each model must
+  // also belong to a single PHY, since reference counts are not atomic.
+  std::set<MobilityModel *> seen;
+  m_mobilityCache.resize (m_phyList.size ());
+  m_mobilityCacheSafe = true;
+  for (std::size_t j = 0; j < m_phyList.size (); j++)
+    {
+      m_mobilityCache[j] = m_phyList[j]->GetMobility ()->GetObject<MobilityModel> ();
+      if (DynamicCast<ConstantPositionMobilityModel> (m_mobilityCache[j]) == 0
+          || !seen.insert (PeekPointer (m_mobilityCache[j])).second)
+        {
+          m_mobilityCacheSafe = false;
+        }
+    }
+  m_mobilityCacheValid = true;
+
+  return m_mobilityCacheSafe;
+}
+
+bool
+LoraChannel::SendParallel (Ptr<LoraPhy> sender,
+                           Ptr<MobilityModel> senderMobility,
+                           Ptr<Packet> packet, double txPowerDbm,
+                           LoraTxParameters txParams, Time duration,
+                           double frequencyMHz) const
+{
+  NS_LOG_FUNCTION (this << sender << packet);
+
+  // Find the longest head of the loss model chain that can run in parallel
+  Ptr<PropagationLossModel> lastParallel;
+  Ptr<PropagationLossModel> rest = m_loss;
+  while (rest != 0 && IsPositionOnlyModel (rest))
+    {
+      lastParallel = rest;
+      rest = rest->GetNext ();
+    }
+  bool parallelLoss = (lastParallel != 0);
+  bool parallelDelay = IsPositionOnlyModel (m_delay);
+
+  if ((!parallelLoss && !parallelDelay) || !UpdateMobilityCache ())
+    {
+      return false;
+    }
+
+  if (m_workerPool == 0)
+    {
+      m_workerPool = Create<LoraWorkerPool> (m_workerThreads);
+      for (uint32_t p = 0; p < m_workerPool->GetNPartitions (); p++)
+        {
+          m_senderProxies.push_back (CreateObject<ConstantPositionMobilityModel> ());
+        }
+    }
+
+  // Each partition works on its own copy of the sender's position, so that
+  // threads do not share reference counts
+  for (uint32_t p = 0; p < m_senderProxies.size (); p++)
+    {
+      m_senderProxies[p]->SetPosition (senderMobility->GetPosition ());
+    }
+
+  std::size_t nPhys = m_phyList.size ();
+  m_rxPowerBuffer.resize (nPhys);
+  m_delayBuffer.resize (nPhys);
+
+  // Temporarily cut the chain after the last model that can run in parallel
+  if (parallelLoss)
+    {
+      lastParallel->SetNext (0);
+    }
+
+  m_workerPool->Run ([&] (uint32_t partition)
+    {
+      std::pair<std::size_t, std::size_t> range =
+        m_workerPool->GetRange (nPhys, partition);
+      const Ptr<MobilityModel> &proxy = m_senderProxies[partition];
+      if (parallelLoss)
+        {
+          // The power computed for the sender, if it is in the range, is
+          // not used
+          m_loss->CalcRxPowerBatch (txPowerDbm, proxy,
+                                    m_mobilityCache.data () + range.first,
+                                    range.second - range.first,
+                                    m_rxPowerBuffer.data () + range.first);
+        }
+      for (std::size_t j = range.first; j < range.second; j++)
+        {
+          if (m_phyList[j] == sender)
             {
-              NS_LOG_INFO ("Getting node index from NetDevice, since it exists");
-              dstNode = dstNetDevice->GetNode ()->GetId ();
-              NS_LOG_DEBUG ("dstNode = " << dstNode);
+              continue;
             }
-          else
+          if (parallelDelay)
             {
-              NS_LOG_INFO ("No net device connected to the PHY, using context 0");
+              m_delayBuffer[j] = m_delay->GetDelay (proxy, m_mobilityCache[j]);
             }
+        }
+    });
+
+  if (parallelLoss)
+    {
+      lastParallel->SetNext (rest);
+    }
 
-          // Create the parameters object based on the calculations above
-          LoraChannelParameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.sf = txParams.sf;
-          parameters.duration = duration;
-          parameters.frequencyMHz = frequencyMHz;
+  // Complete the computations and schedule the receptions in order
+  for (std::size_t j = 0; j < nPhys; j++)
+    {
+      if (m_phyList[j] == sender)
+        {
+          continue;
+        }
 
-          // Schedule the receive event
-          NS_LOG_INFO ("Scheduling reception of the packet");
-          Simulator::ScheduleWithContext (dstNode, delay, &LoraChannel::Receive,
-                                          this, j, packet, parameters);
+      const Ptr<MobilityModel> &receiverMobility = m_mobilityCache[j];
 
-          // Fire the trace source for sent packet
-          m_packetSent (packet);
+      Time delay = parallelDelay ? m_delayBuffer[j] :
+        m_delay->GetDelay (senderMobility, receiverMobility);
+
+      double rxPowerDbm;
+      if (!parallelLoss)
+        {
+          rxPowerDbm = GetRxPower (txPowerDbm, senderMobility, receiverMobility);
+        }
+      else if (rest != 0)
+        {
+          rxPowerDbm = rest->CalcRxPower (m_rxPowerBuffer[j], senderMobility,
+                                          receiverMobility);
+        }
+      else
+        {
+          rxPowerDbm = m_rxPowerBuffer[j];
         }
+
+      ScheduleReception (j, packet, rxPowerDbm, delay, txParams.sf, duration,
+                         frequencyMHz);
     }
+
+  return true;
 }
 
 void
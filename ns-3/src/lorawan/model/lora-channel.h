@@ -34,6 +34,7 @@
 #include "ns3/logical-lora-channel.h"
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
+#include "ns3/lora-worker-pool.h"
 
 namespace ns3 {
 class NetDevice;
@@ -114,6 +115,14 @@ public:
     */
   void Remove (Ptr<LoraPhy> phy);
 
+  /**
+   * Forget the mobility models of the PHYs that were cached by Send.
+   *
+   * LoraPhy::SetMobility calls this on the channel of the PHY, so that a
+   * PHY whose model is replaced is not sent to at its old position.
+   */
+  void InvalidateMobilityCache (void);
+
   /**
     * Send a packet in the channel.
     *
@@ -134,9 +143,9 @@ public:
     * When this method is called, the channel schedules an internal Receive call
     * that performs the actual call to the PHY's StartReceive function.
     */
-  void Send (Ptr<LoraPhy> sender, Ptr<Packet> packet, double txPowerDbm,
-             LoraTxParameters txParams, Time duration, double frequencyMHz)
-  const;
+  virtual void Send (Ptr<LoraPhy> sender, Ptr<Packet> packet,
+                     double txPowerDbm, LoraTxParameters txParams,
+                     Time duration, double frequencyMHz) const;
 
   /**
     * Compute the received power when transmitting from a point to another one.
@@ -153,6 +162,29 @@ public:
   double GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                      Ptr<MobilityModel> receiverMobility) const;
 
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * Compute the received power at all connected PHYs except the sender, and
+   * schedule the corresponding receptions.
+   *
+   * \param sender The sending PHY, or 0 if it is not connected to this
+   * channel.
+   * \param elapsed Time already elapsed since the start of the transmission,
+   * which is subtracted from the propagation delays.
+   */
+  void DeliverToPhys (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+                      Ptr<Packet> packet, double txPowerDbm, uint8_t sf,
+                      Time duration, double frequencyMHz, Time elapsed) const;
+
+  /**
+   * Schedule the reception of a packet at the j-th PHY.
+   */
+  void ScheduleReception (uint32_t j, Ptr<Packet> packet, double rxPowerDbm,
+                          Time delay, uint8_t sf, Time duration,
+                          double frequencyMHz) const;
+
 private:
   /**
     * Private method that is scheduled by LoraChannel's Send method to happen
@@ -168,6 +200,31 @@ private:
   void Receive (uint32_t i, Ptr<Packet> packet,
                 LoraChannelParameters parameters) const;
 
+  /**
+   * Send a packet splitting the per-receiver computations among the worker
+   * threads.
+   *
+   * Only the part of the loss model chain made of models that depend on the
+   * node positions alone is evaluated in parallel, on private copies of the
+   * sender's position. The remaining models and the scheduling of the
+   * receptions are performed afterwards by the calling thread, in the same
+   * order as a sequential Send, so that results do not change.
+   *
+   * \return false if nothing could be parallelized, in which case the packet
+   * was not sent.
+   */
+  bool SendParallel (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+                     Ptr<Packet> packet, double txPowerDbm,
+                     LoraTxParameters txParams, Time duration,
+                     double frequencyMHz) const;
+
+  /**
+   * Refresh the cache of receiver mobility models used by SendParallel.
+   *
+   * \return whether all receivers can be safely accessed by worker threads.
+   */
+  bool UpdateMobilityCache (void) const;
+
   /**
     * The vector containing the PHYs that are currently connected to the
     * channel.
@@ -192,6 +249,19 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_packetSent;
 
+  uint32_t m_workerThreads;     //!< Worker threads for the Send fan-out
+  uint32_t m_parallelThreshold; //!< Minimum PHYs to split the fan-out
+
+  mutable Ptr<LoraWorkerPool> m_workerPool;
+  mutable std::vector<Ptr<MobilityModel> > m_senderProxies; //!< One per partition
+  mutable std::vector<Ptr<MobilityModel> > m_mobilityCache; //!< One per PHY
+  mutable bool m_mobilityCacheValid;
+  mutable bool m_mobilityCacheSafe;
+  mutable std::vector<double> m_rxPowerBuffer;
+  mutable std::vector<uint32_t> m_receiverIndices; //!< PHYs but the sender
+  mutable std::vector<Ptr<MobilityModel> > m_receiverMobilities;
+  mutable std::vector<Time> m_delayBuffer;
+
 };
 
 } /* namespace ns3 */
@@ -19,12 +19,12 @@
  */
 
 #include "ns3/lora-device-address-generator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraDeviceAddressGenerator");
+LORA_LOG_COMPONENT_DEFINE ("LoraDeviceAddressGenerator");
 
 TypeId
 LoraDeviceAddressGenerator::GetTypeId (void)
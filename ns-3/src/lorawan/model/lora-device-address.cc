@@ -19,13 +19,13 @@
  */
 
 #include "ns3/lora-device-address.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <bitset>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraDeviceAddress");
+LORA_LOG_COMPONENT_DEFINE ("LoraDeviceAddress");
 
 // NwkID
 ////////
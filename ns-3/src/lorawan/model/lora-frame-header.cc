@@ -19,13 +19,177 @@
  */
 
 #include "ns3/lora-frame-header.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
+#include "ns3/simulator.h"
 #include <bitset>
+#include <cstring>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraFrameHeader");
+LORA_LOG_COMPONENT_DEFINE ("LoraFrameHeader");
+
+namespace {
+
+/**
+ * Create an empty MAC command of the type identified by a CID.
+ *
+ * \param cid The CID of the command.
+ * \param isUplink Whether the command is carried by an uplink message.
+ * \return The command, or 0 if the CID is not recognized.
+ */
+Ptr<MacCommand>
+CreateMacCommand (uint8_t cid, bool isUplink)
+{
+  Ptr<MacCommand> command = 0;
+
+  // Divide Uplink and Downlink messages
+  // This needs to be done because they have the same CID, and the context
+  // about where this message will be Serialized/Deserialized (i.e., at the
+  // ED or at the NS) is umportant.
+  if (isUplink)
+    {
+      switch (cid)
+        {
+        // In the case of Uplink messages, the NS will deserialize the
+        // request for a link check
+        case (0x02):
+          {
+            NS_LOG_DEBUG ("Creating a LinkCheckReq command");
+            command = Create<LinkCheckReq> ();
+            break;
+          }
+        case (0x03):
+          {
+            NS_LOG_DEBUG ("Creating a LinkAdrAns command");
+            command = Create<LinkAdrAns> ();
+            break;
+          }
+        case (0x04):
+          {
+            NS_LOG_DEBUG ("Creating a DutyCycleAns command");
+            command = Create<DutyCycleAns> ();
+            break;
+          }
+        case (0x05):
+          {
+            NS_LOG_DEBUG ("Creating a RxParamSetupAns command");
+            command = Create<RxParamSetupAns> ();
+            break;
+          }
+        case (0x06):
+          {
+            NS_LOG_DEBUG ("Creating a DevStatusAns command");
+            command = Create<DevStatusAns> ();
+            break;
+          }
+        case (0x07):
+          {
+            NS_LOG_DEBUG ("Creating a NewChannelAns command");
+            command = Create<NewChannelAns> ();
+            break;
+          }
+        case (0x08):
+          {
+            NS_LOG_DEBUG ("Creating a RxTimingSetupAns command");
+            command = Create<RxTimingSetupAns> ();
+            break;
+          }
+        case (0x09):
+          {
+            NS_LOG_DEBUG ("Creating a TxParamSetupAns command");
+            command = Create<TxParamSetupAns> ();
+            break;
+          }
+        case (0x0A):
+          {
+            NS_LOG_DEBUG ("Creating a DlChannelAns command");
+            command = Create<DlChannelAns> ();
+            break;
+          }
+        case (0xBB): /* [Renzo] Related to new custom MAC command for Bandits, uplink will be a BANDIT_REWARD_REQ */
+          {
+            NS_LOG_DEBUG ("Creating a BanditRewardReq command");
+            command = Create<BanditRewardReq> ();
+            break;
+          }
+        default:
+          {
+            NS_LOG_ERROR ("CID not recognized during deserialization");
+          }
+        }
+    }
+  else
+    {
+      switch (cid)
+        {
+        // In the case of Downlink messages, the ED will deserialize the
+        // answer to a link check
+        case (0x02):
+          {
+            NS_LOG_DEBUG ("Creating a LinkCheckAns command");
+            command = Create<LinkCheckAns> ();
+            break;
+          }
+        case (0x03):
+          {
+            NS_LOG_DEBUG ("Creating a LinkAdrReq command");
+            command = Create<LinkAdrReq> ();
+            break;
+          }
+        case (0x04):
+          {
+            NS_LOG_DEBUG ("Creating a DutyCycleReq command");
+            command = Create<DutyCycleReq> ();
+            break;
+          }
+        case (0x05):
+          {
+            NS_LOG_DEBUG ("Creating a RxParamSetupReq command");
+            command = Create<RxParamSetupReq> ();
+            break;
+          }
+        case (0x06):
+          {
+            NS_LOG_DEBUG ("Creating a DevStatusReq command");
+            command = Create<DevStatusReq> ();
+            break;
+          }
+        case (0x07):
+          {
+            NS_LOG_DEBUG ("Creating a NewChannelReq command");
+            command = Create<NewChannelReq> ();
+            break;
+          }
+        case (0x08):
+          {
+            NS_LOG_DEBUG ("Creating a RxTimingSetupReq command");
+            command = Create<RxTimingSetupReq> ();
+            break;
+          }
+        case (0x09):
+          {
+            NS_LOG_DEBUG ("Creating a TxParamSetupReq command");
+            command = Create<TxParamSetupReq> ();
+            break;
+          }
+        case (0xBB): /* [Renzo] Related to new custom MAC command for Bandits, uplink will be a BANDIT_REWARD_ANS */
+          {
+            NS_LOG_DEBUG ("Creating a BanditRewardAns command");
+            command = Create<BanditRewardAns> ();
+            break;
+          }
+        default:
+          {
+            NS_LOG_ERROR ("CID not recognized during deserialization");
+          }
+        }
+    }
+
+  return command;
+}
+
+} // namespace
 
 // Initialization list
 LoraFrameHeader::LoraFrameHeader () :
@@ -36,7 +200,8 @@ LoraFrameHeader::LoraFrameHeader () :
   m_ack       (0),
   m_fPending  (0),
   m_fOptsLen  (0),
-  m_fCnt      (0)
+  m_fCnt      (0),
+  m_fOptsDecoded (true)
 {
 }
 
@@ -98,6 +263,11 @@ LoraFrameHeader::Serialize (Buffer::Iterator start) const
   start.WriteU16 (m_fCnt);
 
   // FOpts field
+  if (!m_fOptsDecoded)
+    {
+      // The commands were never looked at: write back the received bytes
+      start.Write (m_fOpts, m_fOptsLen);
+    }
   for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
     {
       NS_LOG_DEBUG ("Serializing a MAC command");
@@ -146,198 +316,48 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
   NS_LOG_DEBUG ("fOptsLen: " << unsigned (m_fOptsLen));
   NS_LOG_DEBUG ("fCnt: " << unsigned (m_fCnt));
 
-  // Deserialize MAC commands
+  // Save the FOpts bytes, whose MAC commands are decoded when needed
+  start.Read (m_fOpts, m_fOptsLen);
+  m_macCommands.clear ();
+  m_fOptsDecoded = (m_fOptsLen == 0);
+
+  m_fPort = uint8_t (start.ReadU8 ());
+
+  return 8 + m_fOptsLen;       // the number of bytes consumed.
+}
+
+void
+LoraFrameHeader::DecodeFOpts (void) const
+{
+  if (m_fOptsDecoded)
+    {
+      return;
+    }
+  m_fOptsDecoded = true;
+
   NS_LOG_DEBUG ("Starting deserialization of MAC commands");
+
+  Buffer buffer;
+  buffer.AddAtStart (m_fOptsLen);
+  buffer.Begin ().Write (m_fOpts, m_fOptsLen);
+  Buffer::Iterator start = buffer.Begin ();
+
   for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen;)
     {
-      uint8_t cid = start.PeekU8 ();
+      uint8_t cid = m_fOpts[byteNumber];
       NS_LOG_DEBUG ("CID: " << unsigned(cid));
 
-      // Divide Uplink and Downlink messages
-      // This needs to be done because they have the same CID, and the context
-      // about where this message will be Serialized/Deserialized (i.e., at the
-      // ED or at the NS) is umportant.
-      if (m_isUplink)
-        {
-          switch (cid)
-            {
-            // In the case of Uplink messages, the NS will deserialize the
-            // request for a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create <LinkCheckReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create <LinkAdrAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create <DutyCycleAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create <RxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create <DevStatusAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create <NewChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create <RxTimingSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create <TxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x0A):
-              {
-                NS_LOG_DEBUG ("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create <DlChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0xBB): /* [Renzo] Related to new custom MAC command for Bandits, uplink will be a BANDIT_REWARD_REQ */
-              {
-                NS_LOG_DEBUG ("Creating a BanditRewardReq command");
-                Ptr<BanditRewardReq> command = Create <BanditRewardReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
-        }
-      else
+      // Commands are allocated from the MacCommand memory pool, so that a
+      // new instance per decoding is cheap
+      Ptr<MacCommand> command = CreateMacCommand (cid, m_isUplink);
+      if (command == 0)
         {
-          switch (cid)
-            {
-            // In the case of Downlink messages, the ED will deserialize the
-            // answer to a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create <LinkCheckAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create <LinkAdrReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create <DutyCycleReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create <RxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create <DevStatusReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create <NewChannelReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create <RxTimingSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create <TxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0xBB): /* [Renzo] Related to new custom MAC command for Bandits, uplink will be a BANDIT_REWARD_ANS */
-              {
-                NS_LOG_DEBUG ("Creating a BanditRewardAns command");
-                Ptr<BanditRewardAns> command = Create <BanditRewardAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
+          // The rest of the field cannot be interpreted
+          break;
         }
+      byteNumber += command->Deserialize (start);
+      m_macCommands.push_back (command);
     }
-
-  m_fPort = uint8_t (start.ReadU8 ());
-
-  return 8 + m_fOptsLen;       // the number of bytes consumed.
 }
 
 void
@@ -353,6 +373,7 @@ LoraFrameHeader::Print (std::ostream &os) const
   os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
   os << "FCnt=" << unsigned(m_fCnt) << std::endl;
 
+  DecodeFOpts ();
   for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
     {
       (*it)->Print (os);
@@ -450,6 +471,11 @@ LoraFrameHeader::GetFPending (void) const
 uint8_t
 LoraFrameHeader::GetFOptsLen (void) const
 {
+  if (!m_fOptsDecoded)
+    {
+      return m_fOptsLen;
+    }
+
   // Sum the serialized lenght of all commands in the list
   uint8_t fOptsLen = 0;
   std::list< Ptr< MacCommand> >::const_iterator it;
@@ -476,6 +502,7 @@ void
 LoraFrameHeader::AddLinkCheckReq (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  DecodeFOpts ();
 
   Ptr<LinkCheckReq> command = Create<LinkCheckReq> ();
   m_macCommands.push_back (command);
@@ -488,6 +515,7 @@ void
 LoraFrameHeader::AddLinkCheckAns (uint8_t margin, uint8_t gwCnt)
 {
   NS_LOG_FUNCTION (this << unsigned(margin) << unsigned(gwCnt));
+  DecodeFOpts ();
 
   Ptr<LinkCheckAns> command = Create<LinkCheckAns> (margin, gwCnt);
   m_macCommands.push_back (command);
@@ -499,6 +527,7 @@ void
 LoraFrameHeader::AddLinkAdrReq (uint8_t dataRate, uint8_t txPower, std::list<int> enabledChannels, int repetitions)
 {
   NS_LOG_FUNCTION (this << unsigned (dataRate) << txPower << repetitions);
+  DecodeFOpts ();
 
   uint16_t channelMask = 0;
   for (auto it = enabledChannels.begin (); it != enabledChannels.end (); it++)
@@ -522,6 +551,7 @@ void
 LoraFrameHeader::AddLinkAdrAns (bool powerAck, bool dataRateAck, bool channelMaskAck)
 {
   NS_LOG_FUNCTION (this << powerAck << dataRateAck << channelMaskAck);
+  DecodeFOpts ();
 
   Ptr<LinkAdrAns> command = Create<LinkAdrAns> (powerAck, dataRateAck, channelMaskAck);
   m_macCommands.push_back (command);
@@ -533,6 +563,7 @@ void
 LoraFrameHeader::AddDutyCycleReq (uint8_t dutyCycle)
 {
   NS_LOG_FUNCTION (this << unsigned (dutyCycle));
+  DecodeFOpts ();
 
   Ptr<DutyCycleReq> command = Create<DutyCycleReq> (dutyCycle);
 
@@ -545,6 +576,7 @@ void
 LoraFrameHeader::AddDutyCycleAns (void)
 {
   NS_LOG_FUNCTION (this);
+  DecodeFOpts ();
 
   Ptr<DutyCycleAns> command = Create<DutyCycleAns> ();
 
@@ -558,6 +590,7 @@ LoraFrameHeader::AddRxParamSetupReq (uint8_t rx1DrOffset, uint8_t rx2DataRate, d
 {
   NS_LOG_FUNCTION (this << unsigned (rx1DrOffset) << unsigned (rx2DataRate) <<
                    frequency);
+  DecodeFOpts ();
 
   // Evaluate whether to eliminate this assert in case new offsets can be defined.
   NS_ASSERT (0 <= rx1DrOffset && rx1DrOffset <= 5);
@@ -575,6 +608,7 @@ void
 LoraFrameHeader::AddRxParamSetupAns (void)
 {
   NS_LOG_FUNCTION (this);
+  DecodeFOpts ();
 
   Ptr<RxParamSetupAns> command = Create<RxParamSetupAns> ();
 
@@ -587,6 +621,7 @@ void
 LoraFrameHeader::AddDevStatusReq (void)
 {
   NS_LOG_FUNCTION (this);
+  DecodeFOpts ();
 
   Ptr<DevStatusReq> command = Create<DevStatusReq> ();
 
@@ -600,6 +635,7 @@ LoraFrameHeader::AddNewChannelReq (uint8_t chIndex, double frequency,
                                    uint8_t minDataRate, uint8_t maxDataRate)
 {
   NS_LOG_FUNCTION (this);
+  DecodeFOpts ();
 
   Ptr<NewChannelReq> command = Create<NewChannelReq> (chIndex, frequency,
                                                       minDataRate, maxDataRate);
@@ -614,6 +650,8 @@ LoraFrameHeader::GetCommands (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  DecodeFOpts ();
+
   return m_macCommands;
 }
 
@@ -621,10 +659,208 @@ void
 LoraFrameHeader::AddCommand (Ptr<MacCommand> macCommand)
 {
   NS_LOG_FUNCTION (this << macCommand);
+  DecodeFOpts ();
 
   m_macCommands.push_back (macCommand);
   m_fOptsLen += macCommand->GetSerializedSize ();
 }
 
+
+/////////////////////////
+// LoraFrameHeaderView //
+/////////////////////////
+
+namespace {
+
+/**
+ * A LoraFrameHeader deserialized by a LoraFrameHeaderView, together with the
+ * bytes and the UID of the packet it was deserialized from. Its MAC commands
+ * are left undecoded, so that every copy handed out decodes its own.
+ */
+struct CachedFrameHeader
+{
+  uint64_t uid;
+  uint32_t size;
+  uint8_t bytes[LoraFrameHeaderView::MAX_HEADERS_SIZE];
+  LoraFrameHeader header;
+
+  CachedFrameHeader () : uid (0), size (0)
+  {
+  }
+};
+
+/**
+ * The number of entries of the cache of decoded headers, which is indexed by
+ * packet UID. The packets whose headers are needed by more than one component
+ * are the ones received by the network server in the last few milliseconds,
+ * so a small cache is enough.
+ */
+const uint32_t FRAME_HEADER_CACHE_SIZE = 64;
+
+CachedFrameHeader *
+GetFrameHeaderCache (void)
+{
+  static CachedFrameHeader cache[FRAME_HEADER_CACHE_SIZE];
+  return cache;
+}
+
+/**
+ * Whether ClearFrameHeaderCache is scheduled to run when the simulator is
+ * destroyed.
+ */
+bool g_frameHeaderCacheCleanupScheduled = false;
+
+/**
+ * Empty the cache of deserialized headers, whose UIDs belong to the packets
+ * of a simulation that is over.
+ */
+void
+ClearFrameHeaderCache (void)
+{
+  CachedFrameHeader *cache = GetFrameHeaderCache ();
+  for (uint32_t i = 0; i < FRAME_HEADER_CACHE_SIZE; i++)
+    {
+      cache[i] = CachedFrameHeader ();
+    }
+  g_frameHeaderCacheCleanupScheduled = false;
+}
+
+} // namespace
+
+LoraFrameHeaderView::LoraFrameHeaderView (Ptr<const Packet> packet) :
+  m_uid (packet->GetUid ())
+{
+  m_size = packet->CopyData (m_bytes, MAX_HEADERS_SIZE);
+}
+
+bool
+LoraFrameHeaderView::IsValid (void) const
+{
+  // The FPort is the last of the fixed fields
+  return m_size >= 1 + 8 && m_size >= GetHeadersSize ();
+}
+
+uint32_t
+LoraFrameHeaderView::GetHeadersSize (void) const
+{
+  return 1 + 8 + GetFOptsLen ();
+}
+
+LorawanMacHeader::MType
+LoraFrameHeaderView::GetMType (void) const
+{
+  NS_ASSERT (m_size >= 1);
+  return LorawanMacHeader::MType (m_bytes[0] >> 5);
+}
+
+bool
+LoraFrameHeaderView::IsUplink (void) const
+{
+  LorawanMacHeader::MType mType = GetMType ();
+  return (mType == LorawanMacHeader::JOIN_REQUEST)
+         || (mType == LorawanMacHeader::UNCONFIRMED_DATA_UP)
+         || (mType == LorawanMacHeader::CONFIRMED_DATA_UP);
+}
+
+LoraDeviceAddress
+LoraFrameHeaderView::GetAddress (void) const
+{
+  NS_ASSERT (m_size >= 5);
+  // Fields are written in little endian order by Buffer::Iterator
+  return LoraDeviceAddress (uint32_t (m_bytes[1])
+                            | uint32_t (m_bytes[2]) << 8
+                            | uint32_t (m_bytes[3]) << 16
+                            | uint32_t (m_bytes[4]) << 24);
+}
+
+bool
+LoraFrameHeaderView::GetAdr (void) const
+{
+  NS_ASSERT (m_size >= 6);
+  return (m_bytes[5] >> 7) & 0b1;
+}
+
+bool
+LoraFrameHeaderView::GetAdrAckReq (void) const
+{
+  NS_ASSERT (m_size >= 6);
+  return (m_bytes[5] >> 6) & 0b1;
+}
+
+bool
+LoraFrameHeaderView::GetAck (void) const
+{
+  NS_ASSERT (m_size >= 6);
+  return (m_bytes[5] >> 5) & 0b1;
+}
+
+bool
+LoraFrameHeaderView::GetFPending (void) const
+{
+  NS_ASSERT (m_size >= 6);
+  return (m_bytes[5] >> 4) & 0b1;
+}
+
+uint8_t
+LoraFrameHeaderView::GetFOptsLen (void) const
+{
+  NS_ASSERT (m_size >= 6);
+  return m_bytes[5] & 0b1111;
+}
+
+uint16_t
+LoraFrameHeaderView::GetFCnt (void) const
+{
+  NS_ASSERT (m_size >= 8);
+  return uint16_t (m_bytes[6]) | uint16_t (m_bytes[7]) << 8;
+}
+
+LoraFrameHeader
+LoraFrameHeaderView::GetFrameHeader (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (IsValid ());
+
+  uint32_t size = GetHeadersSize ();
+  CachedFrameHeader &entry = GetFrameHeaderCache ()[m_uid % FRAME_HEADER_CACHE_SIZE];
+
+  // Packets keep their UID when they are copied, but their headers could have
+  // been changed in the meantime: compare the bytes too.
+  if (entry.size == size && entry.uid == m_uid
+      && std::memcmp (entry.bytes, m_bytes, size) == 0)
+    {
+      NS_LOG_DEBUG ("Frame header of packet " << m_uid << " found in the cache");
+      return entry.header;
+    }
+
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  buffer.Begin ().Write (m_bytes, size);
+  Buffer::Iterator start = buffer.Begin ();
+  start.Next ();           // Skip the LorawanMacHeader
+
+  LoraFrameHeader header;
+  if (IsUplink ())
+    {
+      header.SetAsUplink ();
+    }
+  else
+    {
+      header.SetAsDownlink ();
+    }
+  header.Deserialize (start);
+
+  if (!g_frameHeaderCacheCleanupScheduled)
+    {
+      Simulator::ScheduleDestroy (&ClearFrameHeaderCache);
+      g_frameHeaderCacheCleanupScheduled = true;
+    }
+  entry.uid = m_uid;
+  entry.size = size;
+  std::memcpy (entry.bytes, m_bytes, size);
+  entry.header = header;
+
+  return header;
+}
 }
 }
@@ -22,7 +22,9 @@
 #define LORA_FRAME_HEADER_H
 
 #include "ns3/header.h"
+#include "ns3/packet.h"
 #include "ns3/lora-device-address.h"
+#include "ns3/lorawan-mac-header.h"
 #include "ns3/mac-command.h"
 
 namespace ns3 {
@@ -70,6 +72,10 @@ public:
   /**
    * Deserialize the contents of the buffer into a LoraFrameHeader object.
    *
+   * Only the fixed fields are parsed here: the FOpts bytes are saved as they
+   * are, and the MAC commands they contain are only decoded the first time
+   * they are needed (see GetCommands and GetMacCommand).
+   *
    * \param start A pointer to the buffer we need to deserialize.
    * \return The number of consumed bytes.
    */
@@ -212,6 +218,11 @@ public:
   template<typename T>
   inline Ptr<T> GetMacCommand (void);
 
+  /**
+   * Maximum length of the FOpts field, in bytes.
+   */
+  static const uint8_t MAX_FOPTS_LEN = 15;
+
   /**
    * Add a LinkCheckReq command.
    */
@@ -308,15 +319,106 @@ private:
 
   uint16_t m_fCnt;
 
-  Buffer m_fOpts;
+  /**
+   * Decode the MAC commands of the FOpts bytes saved by Deserialize into
+   * m_macCommands, if this was not done yet.
+   */
+  void DecodeFOpts (void) const;
+
+  /**
+   * The FOpts bytes of a deserialized header, whose MAC commands were not
+   * decoded yet.
+   */
+  uint8_t m_fOpts[MAX_FOPTS_LEN];
+
+  /**
+   * Whether m_macCommands reflects the content of the FOpts field.
+   */
+  mutable bool m_fOptsDecoded;
 
   /**
    * List containing all the MacCommand instances that are contained in this
    * LoraFrameHeader.
    */
-  std::list< Ptr< MacCommand> > m_macCommands;
+  mutable std::list< Ptr< MacCommand> > m_macCommands;
 
   bool m_isUplink;
+
+  friend class LoraFrameHeaderView;
+};
+
+/**
+ * A read-only view of the headers at the start of a LoRaWAN packet, i.e., the
+ * LorawanMacHeader and the LoraFrameHeader.
+ *
+ * The fixed-size fields are parsed in place from the first bytes of the
+ * packet, which does not need to be copied and whose headers do not need to be
+ * removed. This is what the network server uses to look up the address or the
+ * frame counter of a packet.
+ *
+ * The full LoraFrameHeader, MAC commands included, is only built on request,
+ * and is cached against the UID of the packet until the simulator is
+ * destroyed: all the components that need the header of the same packet share
+ * a single deserialization. The MAC commands are decoded by each copy of the
+ * header on first use, so that they are never shared between copies.
+ */
+class LoraFrameHeaderView
+{
+public:
+  /**
+   * Parse the headers of a packet that starts with a LorawanMacHeader.
+   *
+   * \param packet The packet, which is not modified.
+   */
+  LoraFrameHeaderView (Ptr<const Packet> packet);
+
+  /**
+   * \return Whether the packet was long enough to contain the headers.
+   */
+  bool IsValid (void) const;
+
+  /**
+   * \return The MType of the LorawanMacHeader.
+   */
+  LorawanMacHeader::MType GetMType (void) const;
+
+  /**
+   * \return Whether the packet is an uplink one, according to its MType.
+   */
+  bool IsUplink (void) const;
+
+  LoraDeviceAddress GetAddress (void) const;
+  bool GetAdr (void) const;
+  bool GetAdrAckReq (void) const;
+  bool GetAck (void) const;
+  bool GetFPending (void) const;
+  uint8_t GetFOptsLen (void) const;
+  uint16_t GetFCnt (void) const;
+
+  /**
+   * Get the complete LoraFrameHeader, set as uplink or downlink according to
+   * the MType.
+   *
+   * \return The deserialized LoraFrameHeader, whose MAC commands belong to
+   * it alone.
+   */
+  LoraFrameHeader GetFrameHeader (void) const;
+
+  /**
+   * Size of the LorawanMacHeader and of the LoraFrameHeader of a packet, when
+   * the FOpts field has the maximum length.
+   */
+  static const uint32_t MAX_HEADERS_SIZE = 1 + 8 + LoraFrameHeader::MAX_FOPTS_LEN;
+
+private:
+  /**
+   * \return The number of bytes taken by the two headers.
+   */
+  uint32_t GetHeadersSize (void) const;
+
+  uint8_t m_bytes[MAX_HEADERS_SIZE]; //!< The first bytes of the packet
+  uint32_t m_size;                   //!< How many bytes of m_bytes are valid
+  uint64_t m_uid;                    //!< The UID of the packet
 };
 
 
@@ -324,6 +426,8 @@ template<typename T>
 Ptr<T>
 LoraFrameHeader::GetMacCommand ()
 {
+  DecodeFOpts ();
+
   // Iterate on MAC commands and try casting
   std::list< Ptr< MacCommand> >::const_iterator it;
   for (it = m_macCommands.begin (); it != m_macCommands.end (); ++it)
@@ -19,14 +19,15 @@
  */
 
 #include "ns3/lora-interference-helper.h"
-#include "ns3/log.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-log.h"
 #include "ns3/enum.h"
 #include <limits>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraInterferenceHelper");
+LORA_LOG_COMPONENT_DEFINE ("LoraInterferenceHelper");
 
 /***************************************
  *    LoraInterferenceHelper::Event    *
@@ -269,9 +270,11 @@ LoraInterferenceHelper::PrintEvents (std::ostream &stream)
 uint8_t
 LoraInterferenceHelper::IsDestroyedByInterference (Ptr<LoraInterferenceHelper::Event> event)
 {
+  LORA_PROFILE_SCOPE ("LoraInterferenceHelper::IsDestroyedByInterference");
   NS_LOG_FUNCTION (this << event);
 
   NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_events.size ());
+  LORA_PROFILE_COUNT ("LoraInterferenceHelper::ScannedEvents", m_events.size ());
 
   // We want to see the interference affecting this event: cycle through events
   // that overlap with this one and see whether it survives the interference or
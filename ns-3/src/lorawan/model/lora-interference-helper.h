@@ -28,6 +28,7 @@
 #include "ns3/callback.h"
 #include "ns3/packet.h"
 #include "ns3/logical-lora-channel.h"
+#include "ns3/lora-object-pool.h"
 #include <list>
 
 namespace ns3 {
@@ -49,7 +50,8 @@ public:
    * Used in LoraInterferenceHelper to keep track of which signals overlap and
    * cause destructive interference.
    */
-  class Event : public SimpleRefCount<LoraInterferenceHelper::Event>
+  class Event : public SimpleRefCount<LoraInterferenceHelper::Event>,
+                public LoraPooledAllocation<LoraInterferenceHelper::Event>
   {
 
   public:
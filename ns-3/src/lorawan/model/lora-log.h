@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_LOG_H
+#define LORA_LOG_H
+
+#include "ns3/log.h"
+#include <stdint.h>
+
+/**
+ * The log levels compiled into the components of the lorawan module, with
+ * the syntax of NS_LOG: entries separated by ':', each one either a level
+ * for all components or component=level, where level is one of none, error,
+ * warn, debug, info, function, logic and all (each one including the ones
+ * before it). For example, "warn:LoraChannel=all" keeps all the messages of
+ * LoraChannel, and only errors and warnings elsewhere. It is set by the
+ * --lorawan-log-levels option of waf, and keeps everything by default.
+ */
+#ifndef NS3_LORAWAN_LOG_LEVELS
+#define NS3_LORAWAN_LOG_LEVELS ""
+#endif
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Whether the characters from begin to end are the string text.
+ */
+constexpr bool
+LoraLogEquals (const char *begin, const char *end, const char *text)
+{
+  while (begin != end && *text != 0 && *begin == *text)
+    {
+      begin++;
+      text++;
+    }
+  return begin == end && *text == 0;
+}
+
+/**
+ * The LogLevel named by the characters from begin to end.
+ */
+constexpr uint32_t
+LoraLogParseLevel (const char *begin, const char *end)
+{
+  return LoraLogEquals (begin, end, "none") ? LOG_NONE
+         : LoraLogEquals (begin, end, "error") ? LOG_LEVEL_ERROR
+         : LoraLogEquals (begin, end, "warn") ? LOG_LEVEL_WARN
+         : LoraLogEquals (begin, end, "debug") ? LOG_LEVEL_DEBUG
+         : LoraLogEquals (begin, end, "info") ? LOG_LEVEL_INFO
+         : LoraLogEquals (begin, end, "function") ? LOG_LEVEL_FUNCTION
+         : LoraLogEquals (begin, end, "logic") ? LOG_LEVEL_LOGIC
+         : LOG_LEVEL_ALL;
+}
+
+/**
+ * The log levels of a component in a specification like
+ * NS3_LORAWAN_LOG_LEVELS, evaluated at compile time.
+ */
+constexpr uint32_t
+GetLoraLogLevels (const char *levels, const char *component)
+{
+  uint32_t defaultLevels = LOG_LEVEL_ALL;
+  uint32_t componentLevels = 0;
+  bool found = false;
+  const char *entry = levels;
+  while (*entry != 0)
+    {
+      const char *end = entry;
+      while (*end != 0 && *end != ':')
+        {
+          end++;
+        }
+      const char *equal = entry;
+      while (equal != end && *equal != '=')
+        {
+          equal++;
+        }
+      if (equal == end)
+        {
+          defaultLevels = LoraLogParseLevel (entry, end);
+        }
+      else if (LoraLogEquals (entry, equal, component))
+        {
+          componentLevels = LoraLogParseLevel (equal + 1, end);
+          found = true;
+        }
+      entry = (*end != 0) ? end + 1 : end;
+    }
+  return found ? componentLevels : defaultLevels;
+}
+
+/**
+ * A LogComponent whose levels outside of Levels can never be enabled.
+ *
+ * The NS_LOG macros call IsEnabled on the g_log of the file with a constant
+ * level, so that, with this component, the test of the levels that were not
+ * compiled in is folded to false, and their messages (and the arguments they
+ * format) are removed by the compiler. The prefixes are always kept.
+ */
+template <uint32_t Levels>
+class LoraLogComponent : public LogComponent
+{
+public:
+  LoraLogComponent (const std::string &name, const std::string &file)
+    : LogComponent (name, file, static_cast<enum LogLevel> (LOG_ALL & ~Levels))
+  {
+  }
+
+  bool IsEnabled (const enum LogLevel level) const
+  {
+    return ((Levels | LOG_PREFIX_ALL) & level) != 0 && LogComponent::IsEnabled (level);
+  }
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+/**
+ * Define the logging component of a file of the lorawan module, in place of
+ * NS_LOG_COMPONENT_DEFINE, with the levels of NS3_LORAWAN_LOG_LEVELS.
+ */
+#define LORA_LOG_COMPONENT_DEFINE(name)                                 \
+  static ns3::lorawan::LoraLogComponent<ns3::lorawan::GetLoraLogLevels  \
+                                          (NS3_LORAWAN_LOG_LEVELS, name)> \
+  g_log (name, __FILE__)
+
+#endif /* LORA_LOG_H */
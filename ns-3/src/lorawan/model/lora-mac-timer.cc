@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-mac-timer.h"
+#include "ns3/lora-log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraMacTimer");
+
+LoraMacTimer::Slot::Slot (LoraMacTimer *timer)
+  : m_timer (timer),
+    m_generation (0),
+    m_pending (false)
+{
+}
+
+void
+LoraMacTimer::Slot::Notify (void)
+{
+  if (m_timer)
+    {
+      m_timer->Expire (this);
+    }
+}
+
+LoraMacTimer::LoraMacTimer ()
+  : m_generation (0),
+    m_running (false),
+    m_ts (0)
+{
+}
+
+LoraMacTimer::~LoraMacTimer ()
+{
+  // Slots still in the scheduler outlive the timer
+  for (std::vector<Ptr<Slot> >::iterator it = m_slots.begin (); it != m_slots.end (); ++it)
+    {
+      (*it)->m_timer = 0;
+    }
+}
+
+void
+LoraMacTimer::Schedule (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+
+  Slot *slot = 0;
+  for (std::vector<Ptr<Slot> >::iterator it = m_slots.begin (); it != m_slots.end (); ++it)
+    {
+      if (!(*it)->m_pending)
+        {
+          slot = PeekPointer (*it);
+          break;
+        }
+    }
+  if (slot == 0)
+    {
+      m_slots.push_back (Create<Slot> (this));
+      slot = PeekPointer (m_slots.back ());
+      NS_LOG_LOGIC ("Allocated slot " << m_slots.size ());
+    }
+
+  m_generation++;
+  m_running = true;
+  slot->m_generation = m_generation;
+  slot->m_pending = true;
+  // The scheduler takes its own reference to the slot, and releases it once
+  // the slot is dispatched
+  m_ts = Simulator::Schedule (delay, Ptr<EventImpl> (slot)).GetTs ();
+}
+
+void
+LoraMacTimer::Cancel (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_running = false;
+}
+
+bool
+LoraMacTimer::IsRunning (void) const
+{
+  return m_running;
+}
+
+bool
+LoraMacTimer::IsExpired (void) const
+{
+  return !m_running;
+}
+
+uint64_t
+LoraMacTimer::GetTs (void) const
+{
+  return m_ts;
+}
+
+uint32_t
+LoraMacTimer::GetNSlots (void) const
+{
+  return m_slots.size ();
+}
+
+uint32_t
+LoraMacTimer::GetSlotReferenceCount (uint32_t slot) const
+{
+  NS_ASSERT (slot < m_slots.size ());
+  return m_slots[slot]->GetReferenceCount ();
+}
+
+void
+LoraMacTimer::Expire (Slot *slot)
+{
+  slot->m_pending = false;
+  if (!m_running || slot->m_generation != m_generation)
+    {
+      NS_LOG_LOGIC ("Dispatched a cancelled expiration");
+      return;
+    }
+
+  m_running = false;
+  m_function ();
+}
+
+} // namespace lorawan
+} // namespace ns3
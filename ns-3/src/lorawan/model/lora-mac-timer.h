@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_MAC_TIMER_H
+#define LORA_MAC_TIMER_H
+
+#include "ns3/callback.h"
+#include "ns3/event-impl.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A timer of a MAC layer, that is armed again and again during the
+ * simulation, such as the receive windows and the postponed transmissions
+ * of an end device.
+ *
+ * Each time it is scheduled, Simulator::Schedule would allocate a new event
+ * holding the function and its arguments. Instead, the timer calls a
+ * function without arguments, set once, and keeps a few preallocated event
+ * slots, that are scheduled again once they have been dispatched.
+ *
+ * Cancelling the timer does not touch the event in the scheduler: the timer
+ * only remembers the generation of its last scheduling, and a slot that is
+ * dispatched with an older generation (a tombstone) is ignored. Another slot
+ * is only needed when the timer is scheduled again before the tombstone is
+ * dispatched, so that a timer rarely holds more than two slots.
+ */
+class LoraMacTimer
+{
+public:
+  LoraMacTimer ();
+  ~LoraMacTimer ();
+
+  /**
+   * Set the method called when the timer expires.
+   *
+   * \param memPtr The method, without arguments.
+   * \param obj The object to call it on, which must outlive the timer's
+   * events, or destroy the timer first.
+   */
+  template <typename MEM, typename OBJ>
+  void SetFunction (MEM memPtr, OBJ obj);
+
+  /**
+   * Arm the timer to expire after a delay, replacing any earlier expiration.
+   *
+   * \param delay The delay, from the current time.
+   */
+  void Schedule (Time delay);
+
+  /**
+   * Disarm the timer, if it is running.
+   */
+  void Cancel (void);
+
+  /**
+   * \return Whether the timer is armed and has not expired yet.
+   */
+  bool IsRunning (void) const;
+
+  /**
+   * \return Whether the timer has expired or was cancelled, like
+   * EventId::IsExpired.
+   */
+  bool IsExpired (void) const;
+
+  /**
+   * \return The time of the last expiration that was scheduled (even if it
+   * was cancelled), in time steps, like EventId::GetTs.
+   */
+  uint64_t GetTs (void) const;
+
+  /**
+   * \return The number of event slots allocated by the timer.
+   */
+  uint32_t GetNSlots (void) const;
+
+  /**
+   * \param slot The index of an event slot.
+   * \return The number of references to the slot: one held by the timer,
+   * and one more while the slot is in the scheduler.
+   */
+  uint32_t GetSlotReferenceCount (uint32_t slot) const;
+
+private:
+  LoraMacTimer (const LoraMacTimer &);
+  LoraMacTimer &operator = (const LoraMacTimer &);
+
+  /**
+   * An event slot, scheduled once at a time.
+   */
+  class Slot : public EventImpl
+  {
+public:
+    Slot (LoraMacTimer *timer);
+
+    LoraMacTimer *m_timer; //!< The timer, or 0 once it is destroyed
+    uint32_t m_generation; //!< The generation of the timer it was scheduled with
+    bool m_pending; //!< Whether the slot is in the scheduler
+
+private:
+    virtual void Notify (void);
+  };
+
+  /**
+   * Called when a slot is dispatched.
+   *
+   * \param slot The slot.
+   */
+  void Expire (Slot *slot);
+
+  Callback<void> m_function;
+  std::vector<Ptr<Slot> > m_slots;
+  uint32_t m_generation; //!< Incremented each time the timer is scheduled
+  bool m_running;
+  uint64_t m_ts;
+};
+
+template <typename MEM, typename OBJ>
+void
+LoraMacTimer::SetFunction (MEM memPtr, OBJ obj)
+{
+  m_function = MakeCallback (memPtr, obj);
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_MAC_TIMER_H */
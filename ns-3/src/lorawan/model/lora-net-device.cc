@@ -21,13 +21,13 @@
 #include "ns3/lora-net-device.h"
 #include "ns3/pointer.h"
 #include "ns3/node.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/abort.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraNetDevice");
+LORA_LOG_COMPONENT_DEFINE ("LoraNetDevice");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraNetDevice);
 
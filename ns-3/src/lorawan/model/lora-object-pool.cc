@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lora-object-pool.h"
+#include "ns3/lora-log.h"
+#include <cxxabi.h>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <new>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraObjectPool");
+
+namespace {
+
+/**
+ * All the pools, by name. Neither the map nor the pools are ever destroyed.
+ */
+std::map<std::string, LoraObjectPool *> &
+GetPools (void)
+{
+  static std::map<std::string, LoraObjectPool *> *pools =
+    new std::map<std::string, LoraObjectPool *> ();
+  return *pools;
+}
+
+} // namespace
+
+LoraObjectPool *
+LoraObjectPool::Get (std::string name)
+{
+  std::map<std::string, LoraObjectPool *> &pools = GetPools ();
+  auto it = pools.find (name);
+  if (it == pools.end ())
+    {
+      it = pools.insert (std::make_pair (name, new LoraObjectPool (name))).first;
+    }
+  return it->second;
+}
+
+LoraObjectPool::LoraObjectPool (std::string name) :
+  m_freeLists (MAX_BLOCK_SIZE / ALIGNMENT + 1, 0),
+  m_chunk (0),
+  m_chunkLeft (0)
+{
+  m_statistics.name = name;
+  m_statistics.allocations = 0;
+  m_statistics.reused = 0;
+  m_statistics.inUse = 0;
+  m_statistics.peakInUse = 0;
+  m_statistics.chunks = 0;
+}
+
+bool
+LoraObjectPool::IsEnabled (void)
+{
+#ifdef NS3_LORAWAN_POOLS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void *
+LoraObjectPool::Allocate (std::size_t size)
+{
+  m_statistics.allocations++;
+  m_statistics.inUse++;
+  if (m_statistics.inUse > m_statistics.peakInUse)
+    {
+      m_statistics.peakInUse = m_statistics.inUse;
+    }
+
+#ifdef NS3_LORAWAN_POOLS
+  if (size <= MAX_BLOCK_SIZE)
+    {
+      std::size_t sizeClass = (size + ALIGNMENT - 1) / ALIGNMENT;
+      FreeBlock *block = m_freeLists[sizeClass];
+      if (block != 0)
+        {
+          m_freeLists[sizeClass] = block->next;
+          m_statistics.reused++;
+          return block;
+        }
+
+      // Carve a new block out of the current chunk, or out of a new one
+      std::size_t blockSize = std::max<std::size_t> (sizeClass, 1) * ALIGNMENT;
+      if (m_chunkLeft < blockSize)
+        {
+          m_chunk = static_cast<char *> (::operator new (CHUNK_SIZE));
+          m_chunkLeft = CHUNK_SIZE;
+          m_statistics.chunks++;
+          NS_LOG_DEBUG ("Pool " << m_statistics.name << " allocated chunk "
+                                << m_statistics.chunks);
+        }
+      void *newBlock = m_chunk;
+      m_chunk += blockSize;
+      m_chunkLeft -= blockSize;
+      return newBlock;
+    }
+#endif
+
+  return ::operator new (size);
+}
+
+void
+LoraObjectPool::Deallocate (void *block, std::size_t size)
+{
+  if (block == 0)
+    {
+      return;
+    }
+  m_statistics.inUse--;
+
+#ifdef NS3_LORAWAN_POOLS
+  if (size <= MAX_BLOCK_SIZE)
+    {
+      std::size_t sizeClass = (size + ALIGNMENT - 1) / ALIGNMENT;
+      FreeBlock *freeBlock = static_cast<FreeBlock *> (block);
+      freeBlock->next = m_freeLists[sizeClass];
+      m_freeLists[sizeClass] = freeBlock;
+      return;
+    }
+#endif
+
+  ::operator delete (block);
+}
+
+LoraObjectPool::Statistics
+LoraObjectPool::GetStatistics (void) const
+{
+  return m_statistics;
+}
+
+std::vector<LoraObjectPool::Statistics>
+LoraObjectPool::GetAllStatistics (void)
+{
+  std::vector<Statistics> statistics;
+  std::map<std::string, LoraObjectPool *> &pools = GetPools ();
+  for (auto it = pools.begin (); it != pools.end (); it++)
+    {
+      statistics.push_back (it->second->GetStatistics ());
+    }
+  return statistics;
+}
+
+void
+LoraObjectPool::PrintStatistics (std::ostream &os)
+{
+  os << "# Object pools " << (IsEnabled () ? "enabled" : "disabled") << std::endl;
+  os << "# name allocations reused inUse peakInUse chunks" << std::endl;
+  std::vector<Statistics> statistics = GetAllStatistics ();
+  for (auto it = statistics.begin (); it != statistics.end (); it++)
+    {
+      os << it->name << " " << it->allocations << " " << it->reused << " "
+         << it->inUse << " " << it->peakInUse << " " << it->chunks << std::endl;
+    }
+}
+
+std::string
+LoraObjectPool::Demangle (const char *typeName)
+{
+  int status = 0;
+  char *demangled = abi::__cxa_demangle (typeName, 0, 0, &status);
+  if (status != 0 || demangled == 0)
+    {
+      return typeName;
+    }
+  std::string name = demangled;
+  std::free (demangled);
+  return name;
+}
+
+}
+}
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LORA_OBJECT_POOL_H
+#define LORA_OBJECT_POOL_H
+
+#include <cstddef>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A pool of memory blocks for the objects of a class (and of the classes
+ * derived from it) that are created and destroyed at a high rate.
+ *
+ * Blocks are grouped in size classes, multiples of 16 bytes, each with its
+ * own free list, and are carved out of large chunks that are never given back
+ * to the system. Larger objects are allocated with the global operator new.
+ *
+ * Pools are only used if the module is configured with
+ * --enable-lorawan-pools. Otherwise, all blocks come from the global operator
+ * new, and pools only count allocations, so that the statistics of the two
+ * builds can be compared.
+ *
+ * Pools are not thread safe: they must only be used by the simulator's thread.
+ */
+class LoraObjectPool
+{
+public:
+  /**
+   * Allocation statistics of a pool.
+   */
+  struct Statistics
+  {
+    std::string name;       //!< The name of the pool
+    uint64_t allocations;   //!< Number of blocks allocated
+    uint64_t reused;        //!< Allocations served by a free list
+    uint64_t inUse;         //!< Blocks currently allocated
+    uint64_t peakInUse;     //!< Largest number of blocks allocated at once
+    uint64_t chunks;        //!< Chunks obtained from the system
+  };
+
+  /**
+   * Get a pool, created the first time it is requested.
+   *
+   * Pools are never destroyed, so that objects can be safely deleted at any
+   * time, even during the destruction of static variables.
+   *
+   * \param name The name of the pool.
+   * \return The pool with that name.
+   */
+  static LoraObjectPool * Get (std::string name);
+
+  /**
+   * \param size The size of the object, in bytes.
+   * \return A block of memory of at least that size.
+   */
+  void * Allocate (std::size_t size);
+
+  /**
+   * \param block A block returned by Allocate.
+   * \param size The size that was passed to Allocate.
+   */
+  void Deallocate (void *block, std::size_t size);
+
+  /**
+   * \return The statistics of this pool.
+   */
+  Statistics GetStatistics (void) const;
+
+  /**
+   * \return Whether the module was built with the pools enabled.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \return The statistics of all the pools.
+   */
+  static std::vector<Statistics> GetAllStatistics (void);
+
+  /**
+   * Print the statistics of all the pools, one per line.
+   *
+   * \param os The stream to print to.
+   */
+  static void PrintStatistics (std::ostream &os);
+
+  /**
+   * \param typeName The name of a type, as returned by std::type_info::name.
+   * \return The human-readable name of the type.
+   */
+  static std::string Demangle (const char *typeName);
+
+private:
+  LoraObjectPool (std::string name);
+
+  /**
+   * A block that is in a free list.
+   */
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  static const std::size_t ALIGNMENT = 16;      //!< Size granularity
+  static const std::size_t MAX_BLOCK_SIZE = 512; //!< Largest pooled block
+  static const std::size_t CHUNK_SIZE = 65536;   //!< Size of a chunk
+
+  Statistics m_statistics;
+  std::vector<FreeBlock *> m_freeLists; //!< One per size class
+  char *m_chunk;                        //!< The current chunk
+  std::size_t m_chunkLeft;              //!< Bytes left in m_chunk
+};
+
+/**
+ * A base class that makes Create<> and CreateObject<> take the memory of the
+ * objects of class T, and of the classes derived from it, from a
+ * LoraObjectPool.
+ *
+ * Objects are deleted through the reference counting of ns-3 as usual, which
+ * gives their memory back to the pool.
+ *
+ * \tparam T The class whose objects are pooled.
+ */
+template <typename T>
+class LoraPooledAllocation
+{
+public:
+  static void *
+  operator new (std::size_t size)
+  {
+    return GetPool ()->Allocate (size);
+  }
+
+  static void
+  operator delete (void *block, std::size_t size)
+  {
+    GetPool ()->Deallocate (block, size);
+  }
+
+  /**
+   * \return The pool of the objects of class T.
+   */
+  static LoraObjectPool *
+  GetPool (void)
+  {
+    static LoraObjectPool *pool =
+      LoraObjectPool::Get (LoraObjectPool::Demangle (typeid (T).name ()));
+    return pool;
+  }
+};
+
+}
+}
+#endif /* LORA_OBJECT_POOL_H */
@@ -19,14 +19,15 @@
  */
 
 #include "ns3/lora-phy.h"
-#include "ns3/log.h"
+#include "ns3/lora-airtime.h"
+#include "ns3/lora-log.h"
 #include "ns3/simulator.h"
 #include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraPhy");
+LORA_LOG_COMPONENT_DEFINE ("LoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraPhy);
 
@@ -136,6 +137,12 @@ LoraPhy::SetMobility (Ptr<MobilityModel> mobility)
   NS_LOG_FUNCTION_NOARGS ();
 
   m_mobility = mobility;
+
+  // The channel caches the mobility models of its PHYs
+  if (m_channel != 0)
+    {
+      m_channel->InvalidateMobilityCache ();
+    }
 }
 
 void
@@ -173,42 +180,23 @@ LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
 
   // The contents of this function are based on [1].
   // [1] SX1272 LoRa modem designer's guide.
-
-  // Compute the symbol duration
-  // Bandwidth is in Hz
-  double tSym = pow (2, int(txParams.sf)) / (txParams.bandwidthHz);
-
-  // Compute the preamble duration
-  double tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
+  // The number of payload symbols is looked up in a precomputed table.
 
   // Payload size
   uint32_t pl = packet->GetSize ();      // Size in bytes
   NS_LOG_DEBUG ("Packet of size " << pl << " bytes");
 
-  // This step is needed since the formula deals with double values.
-  // de = 1 when the low data rate optimization is enabled, 0 otherwise
-  // h = 1 when header is implicit, 0 otherwise
-  double de = txParams.lowDataRateOptimizationEnabled ? 1 : 0;
-  double h = txParams.headerDisabled ? 1 : 0;
-  double crc = txParams.crcEnabled ? 1 : 0;
-
-  // num and den refer to numerator and denominator of the time on air formula
-  double num = 8 * pl - 4 * txParams.sf + 28 + 16 * crc - 20 * h;
-  double den = 4 * (txParams.sf - 2 * de);
-  double payloadSymbNb = 8 + std::max (std::ceil (num / den) *
-                                       (txParams.codingRate + 4), double(0));
-
-  // Time to transmit the payload
-  double tPayload = payloadSymbNb * tSym;
+  double timeOnAir = LoraAirtime::GetOnAirSeconds (txParams.sf, txParams.bandwidthHz,
+                                                   txParams.codingRate, txParams.nPreamble,
+                                                   txParams.headerDisabled,
+                                                   txParams.crcEnabled,
+                                                   txParams.lowDataRateOptimizationEnabled,
+                                                   pl);
 
-  NS_LOG_DEBUG ("Time computation: num = " << num << ", den = " << den <<
-                ", payloadSymbNb = " << payloadSymbNb << ", tSym = " << tSym);
-  NS_LOG_DEBUG ("tPreamble = " << tPreamble);
-  NS_LOG_DEBUG ("tPayload = " << tPayload);
-  NS_LOG_DEBUG ("Total time = " << tPreamble + tPayload);
+  NS_LOG_DEBUG ("Total time = " << timeOnAir);
 
   // Compute and return the total packet on-air time
-  return Seconds (tPreamble + tPayload);
+  return Seconds (timeOnAir);
 }
 
 std::ostream &operator << (std::ostream &os, const LoraTxParameters &params)
@@ -198,6 +198,9 @@ public:
   /**
    * Set the mobility model associated to this PHY.
    *
+   * The model can be replaced at any time, including after the PHY was
+   * added to its channel.
+   *
    * \param mobility The mobility model to associate to this PHY.
    */
   void SetMobility (Ptr<MobilityModel> mobility);
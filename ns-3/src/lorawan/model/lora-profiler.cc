@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-object-pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace ns3 {
+namespace lorawan {
+
+namespace {
+
+/// Heap allocations made by each thread
+thread_local uint64_t g_allocations = 0;
+
+/**
+ * All the profile points, in creation order. They are never destroyed.
+ */
+std::vector<LoraProfilePoint *> &
+GetPointList (void)
+{
+  static std::vector<LoraProfilePoint *> *points = new std::vector<LoraProfilePoint *> ();
+  return *points;
+}
+
+} // namespace
+
+#ifdef NS3_LORAWAN_PROFILING
+} // namespace lorawan
+} // namespace ns3
+
+// Count the heap allocations of the process. The replaced operators have the
+// same behavior as the default ones.
+void *
+operator new (std::size_t size)
+{
+  ns3::lorawan::g_allocations++;
+  void *block = std::malloc (size == 0 ? 1 : size);
+  if (block == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return block;
+}
+
+void *
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *block) noexcept
+{
+  std::free (block);
+}
+
+void
+operator delete[] (void *block) noexcept
+{
+  std::free (block);
+}
+
+void
+operator delete (void *block, std::size_t) noexcept
+{
+  std::free (block);
+}
+
+void
+operator delete[] (void *block, std::size_t) noexcept
+{
+  std::free (block);
+}
+
+namespace ns3 {
+namespace lorawan {
+#endif
+
+//////////////////////
+// LoraProfilePoint //
+//////////////////////
+
+LoraProfilePoint::LoraProfilePoint (std::string name) :
+  m_name (name),
+  m_calls (0),
+  m_timedCalls (0),
+  m_totalNs (0),
+  m_allocations (0),
+  m_histogram (N_BUCKETS, 0)
+{
+}
+
+uint32_t
+LoraProfilePoint::GetBucket (uint64_t durationNs)
+{
+  if (durationNs < BUCKETS_PER_OCTAVE)
+    {
+      return durationNs;
+    }
+
+  // The octave is the position of the most significant bit, and the bucket
+  // in the octave is given by the two bits that follow it
+  uint32_t octave = 63 - __builtin_clzll (durationNs);
+  uint32_t sub = (durationNs >> (octave - 2)) & (BUCKETS_PER_OCTAVE - 1);
+  return octave * BUCKETS_PER_OCTAVE + sub;
+}
+
+void
+LoraProfilePoint::Record (uint64_t durationNs, uint64_t allocations)
+{
+  m_calls++;
+  m_timedCalls++;
+  m_totalNs += durationNs;
+  m_allocations += allocations;
+  m_histogram[GetBucket (durationNs)]++;
+}
+
+void
+LoraProfilePoint::Count (uint64_t count)
+{
+  m_calls += count;
+}
+
+std::string
+LoraProfilePoint::GetName (void) const
+{
+  return m_name;
+}
+
+uint64_t
+LoraProfilePoint::GetCalls (void) const
+{
+  return m_calls;
+}
+
+uint64_t
+LoraProfilePoint::GetTimedCalls (void) const
+{
+  return m_timedCalls;
+}
+
+uint64_t
+LoraProfilePoint::GetTotalNs (void) const
+{
+  return m_totalNs;
+}
+
+uint64_t
+LoraProfilePoint::GetAllocations (void) const
+{
+  return m_allocations;
+}
+
+uint64_t
+LoraProfilePoint::GetPercentileNs (double percentile) const
+{
+  if (m_timedCalls == 0)
+    {
+      return 0;
+    }
+
+  // The rank of the sample we look for, starting from 1
+  uint64_t rank = uint64_t (percentile / 100 * m_timedCalls + 0.5);
+  rank = std::max<uint64_t> (rank, 1);
+
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < N_BUCKETS; bucket++)
+    {
+      seen += m_histogram[bucket];
+      if (seen >= rank)
+        {
+          if (bucket < BUCKETS_PER_OCTAVE)
+            {
+              return bucket;
+            }
+          uint32_t octave = bucket / BUCKETS_PER_OCTAVE;
+          uint64_t sub = bucket % BUCKETS_PER_OCTAVE;
+          return ((BUCKETS_PER_OCTAVE + sub + 1) << (octave - 2)) - 1;
+        }
+    }
+  return 0;
+}
+
+void
+LoraProfilePoint::Reset (void)
+{
+  m_calls = 0;
+  m_timedCalls = 0;
+  m_totalNs = 0;
+  m_allocations = 0;
+  m_histogram.assign (N_BUCKETS, 0);
+}
+
+//////////////////
+// LoraProfiler //
+//////////////////
+
+LoraProfilePoint *
+LoraProfiler::GetPoint (std::string name)
+{
+  std::vector<LoraProfilePoint *> &points = GetPointList ();
+  for (auto it = points.begin (); it != points.end (); it++)
+    {
+      if ((*it)->GetName () == name)
+        {
+          return *it;
+        }
+    }
+  points.push_back (new LoraProfilePoint (name));
+  return points.back ();
+}
+
+std::vector<LoraProfilePoint *>
+LoraProfiler::GetPoints (void)
+{
+  return GetPointList ();
+}
+
+bool
+LoraProfiler::IsEnabled (void)
+{
+#ifdef NS3_LORAWAN_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t
+LoraProfiler::GetAllocations (void)
+{
+  return g_allocations;
+}
+
+void
+LoraProfiler::PrintReport (std::ostream &os)
+{
+  os << "# Profiling " << (IsEnabled () ? "enabled" : "disabled") << std::endl;
+  os << "# name calls totalNs meanNs p50Ns p99Ns allocations" << std::endl;
+  std::vector<LoraProfilePoint *> &points = GetPointList ();
+  for (auto it = points.begin (); it != points.end (); it++)
+    {
+      const LoraProfilePoint *point = *it;
+      os << point->GetName () << " " << point->GetCalls () << " "
+         << point->GetTotalNs () << " "
+         << (point->GetTimedCalls () > 0 ? point->GetTotalNs () / point->GetTimedCalls () : 0) << " "
+         << point->GetPercentileNs (50) << " " << point->GetPercentileNs (99) << " "
+         << point->GetAllocations () << std::endl;
+    }
+  LoraObjectPool::PrintStatistics (os);
+}
+
+void
+LoraProfiler::Reset (void)
+{
+  std::vector<LoraProfilePoint *> &points = GetPointList ();
+  for (auto it = points.begin (); it != points.end (); it++)
+    {
+      (*it)->Reset ();
+    }
+}
+
+}
+}
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef LORA_PROFILER_H
+#define LORA_PROFILER_H
+
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The statistics of a profiled code path: number of calls, time spent in it
+ * and heap allocations made while running it.
+ *
+ * Durations are kept in a histogram with four buckets per power of two, so
+ * that percentiles can be estimated, within 19%, without storing samples.
+ */
+class LoraProfilePoint
+{
+public:
+  /**
+   * \param name The name of the code path.
+   */
+  LoraProfilePoint (std::string name);
+
+  /**
+   * Record a call.
+   *
+   * \param durationNs The duration of the call, in nanoseconds.
+   * \param allocations The number of heap allocations made during the call.
+   */
+  void Record (uint64_t durationNs, uint64_t allocations);
+
+  /**
+   * Count events that are not timed.
+   *
+   * \param count The number of events.
+   */
+  void Count (uint64_t count);
+
+  std::string GetName (void) const;
+  uint64_t GetCalls (void) const;
+
+  /**
+   * \return The number of calls that were timed, that is, the calls
+   * counted by Count are left out.
+   */
+  uint64_t GetTimedCalls (void) const;
+
+  uint64_t GetTotalNs (void) const;
+  uint64_t GetAllocations (void) const;
+
+  /**
+   * Estimate a percentile of the durations of the calls.
+   *
+   * \param percentile The percentile, between 0 and 100.
+   * \return The upper bound of the histogram bucket that contains it, in
+   * nanoseconds, or 0 if no call was timed.
+   */
+  uint64_t GetPercentileNs (double percentile) const;
+
+  /**
+   * Forget all the recorded calls.
+   */
+  void Reset (void);
+
+  static const uint32_t BUCKETS_PER_OCTAVE = 4; //!< Histogram resolution
+  static const uint32_t N_BUCKETS = 64 * BUCKETS_PER_OCTAVE; //!< Histogram size
+
+private:
+  /**
+   * \param durationNs A duration, in nanoseconds.
+   * \return The index of the histogram bucket for that duration.
+   */
+  static uint32_t GetBucket (uint64_t durationNs);
+
+  std::string m_name;
+  uint64_t m_calls;
+  uint64_t m_timedCalls;
+  uint64_t m_totalNs;
+  uint64_t m_allocations;
+  std::vector<uint64_t> m_histogram;
+};
+
+/**
+ * The registry of all the LoraProfilePoints, and the report of their
+ * statistics.
+ *
+ * Profile points are placed in the hot paths of the module with the
+ * LORA_PROFILE_SCOPE and LORA_PROFILE_COUNT macros, which only do something
+ * if the module is configured with --enable-lorawan-profiling: otherwise, they
+ * expand to nothing. Profiling is not thread safe, and must only be used by
+ * the simulator's thread.
+ */
+class LoraProfiler
+{
+public:
+  /**
+   * Get a profile point, created the first time it is requested.
+   *
+   * \param name The name of the code path.
+   * \return The profile point with that name, which is never destroyed.
+   */
+  static LoraProfilePoint * GetPoint (std::string name);
+
+  /**
+   * \return All the profile points, in the order they were created.
+   */
+  static std::vector<LoraProfilePoint *> GetPoints (void);
+
+  /**
+   * \return Whether the module was built with profiling enabled.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \return The number of heap allocations made by the calling thread so far,
+   * which is only counted if profiling is enabled.
+   */
+  static uint64_t GetAllocations (void);
+
+  /**
+   * Print the statistics of all the profile points, followed by the
+   * statistics of the object pools.
+   *
+   * \param os The stream to print to.
+   */
+  static void PrintReport (std::ostream &os);
+
+  /**
+   * Forget the calls recorded by all the profile points.
+   */
+  static void Reset (void);
+};
+
+/**
+ * Times the scope it lives in, and records it in a LoraProfilePoint when it
+ * is destroyed.
+ */
+class LoraProfileScope
+{
+public:
+  LoraProfileScope (LoraProfilePoint *point)
+    : m_point (point),
+      m_allocations (LoraProfiler::GetAllocations ()),
+      m_start (std::chrono::steady_clock::now ())
+  {
+  }
+
+  ~LoraProfileScope ()
+  {
+    std::chrono::steady_clock::duration duration =
+      std::chrono::steady_clock::now () - m_start;
+    m_point->Record (std::chrono::duration_cast<std::chrono::nanoseconds> (duration).count (),
+                     LoraProfiler::GetAllocations () - m_allocations);
+  }
+
+private:
+  LoraProfilePoint *m_point;
+  uint64_t m_allocations;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+}
+}
+
+#define LORA_PROFILE_CONCAT_(a, b) a ## b
+#define LORA_PROFILE_CONCAT(a, b) LORA_PROFILE_CONCAT_ (a, b)
+
+#ifdef NS3_LORAWAN_PROFILING
+/**
+ * Time the rest of the enclosing scope, and record it under a name.
+ *
+ * \param name The name of the code path, a string literal.
+ */
+#define LORA_PROFILE_SCOPE(name)                                        \
+  static ::ns3::lorawan::LoraProfilePoint *                             \
+  LORA_PROFILE_CONCAT (loraProfilePoint, __LINE__) =                    \
+    ::ns3::lorawan::LoraProfiler::GetPoint (name);                      \
+  ::ns3::lorawan::LoraProfileScope                                      \
+  LORA_PROFILE_CONCAT (loraProfileScope, __LINE__) (LORA_PROFILE_CONCAT (loraProfilePoint, __LINE__))
+
+/**
+ * Count events under a name, without timing them.
+ *
+ * \param name The name of the counter, a string literal.
+ * \param count The number of events.
+ */
+#define LORA_PROFILE_COUNT(name, count)                                 \
+  do                                                                    \
+    {                                                                   \
+      static ::ns3::lorawan::LoraProfilePoint *loraProfilePoint =       \
+        ::ns3::lorawan::LoraProfiler::GetPoint (name);                  \
+      loraProfilePoint->Count (count);                                  \
+    }                                                                   \
+  while (false)
+#else
+#define LORA_PROFILE_SCOPE(name)
+#define LORA_PROFILE_COUNT(name, count)
+#endif
+
+#endif /* LORA_PROFILER_H */
@@ -14,7 +14,7 @@
  * Author: Romagnolo Stefano <romagnolostefano93@gmail.com>
  */
 
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/simulator.h"
 #include "ns3/pointer.h"
 #include "ns3/energy-source.h"
@@ -24,7 +24,7 @@
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraRadioEnergyModel");
+LORA_LOG_COMPONENT_DEFINE ("LoraRadioEnergyModel");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraRadioEnergyModel);
 
@@ -99,13 +99,22 @@ LoraRadioEnergyModel::SetEnergySource (Ptr<EnergySource> source)
   NS_LOG_FUNCTION (this << source);
   NS_ASSERT (source != NULL);
   m_source = source;
+  m_lazySource = DynamicCast<LazyBasicEnergySource> (source);
 }
 
 double
 LoraRadioEnergyModel::GetTotalEnergyConsumption (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_totalEnergyConsumption;
+  if (m_source == NULL)
+    {
+      return m_totalEnergyConsumption;
+    }
+  // The energy of the current state is only accounted for at the next state
+  // change: add what was consumed in it so far
+  Time duration = Simulator::Now () - m_lastUpdateTime;
+  return m_totalEnergyConsumption
+         + duration.GetSeconds () * DoGetCurrentA () * m_source->GetSupplyVoltage ();
 }
 
 double
@@ -210,6 +219,21 @@ LoraRadioEnergyModel::SetTxCurrentFromModel (double txPowerDbm)
     }
 }
 
+double
+LoraRadioEnergyModel::GetTxEnergyConsumption (double txPowerDbm,
+                                              Time duration) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << duration);
+  NS_ASSERT (m_source != NULL);
+
+  double txCurrentA = m_txCurrentA;
+  if (m_txCurrentModel)
+    {
+      txCurrentA = m_txCurrentModel->CalcTxCurrent (txPowerDbm);
+    }
+  return duration.GetSeconds () * txCurrentA * m_source->GetSupplyVoltage ();
+}
+
 void
 LoraRadioEnergyModel::ChangeState (int newState)
 {
@@ -270,6 +294,12 @@ LoraRadioEnergyModel::ChangeState (int newState)
   m_isSupersededChangeState = (m_nPendingChangeState > 1);
 
   m_nPendingChangeState--;
+
+  // the new current is known: a lazy source can predict its next threshold crossing
+  if (m_lazySource != 0)
+    {
+      m_lazySource->UpdateThresholdPrediction ();
+    }
 }
 
 void
@@ -319,6 +349,7 @@ LoraRadioEnergyModel::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_source = NULL;
+  m_lazySource = NULL;
   m_energyDepletionCallback.Nullify ();
 }
 
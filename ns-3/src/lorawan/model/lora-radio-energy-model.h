@@ -21,6 +21,7 @@
 #include "ns3/traced-value.h"
 #include "end-device-lora-phy.h"
 #include "lora-tx-current-model.h"
+#include "lazy-basic-energy-source.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -155,7 +156,7 @@ public:
   void SetEnergySource (Ptr<EnergySource> source);
 
   /**
-   * \returns Total energy consumption of the wifi device.
+   * \returns Total energy consumption of the lora device, up to now.
    *
    * Implements DeviceEnergyModel::GetTotalEnergyConsumption.
    */
@@ -245,6 +246,19 @@ public:
   // NOTICE VERY WELL: Current  Model linear or constant as possible choices
   void SetTxCurrentFromModel (double txPowerDbm);
 
+  /**
+   * \brief Computes the energy drawn from the energy source by a
+   *        transmission, without changing the state of the model.
+   *
+   * The tx current is the one of the tx current model at the given power,
+   * if a model is attached, or the TxCurrentA attribute otherwise.
+   *
+   * \param txPowerDbm the nominal tx power in dBm
+   * \param duration the time on air of the transmission
+   * \returns the energy consumed in the TX state, in Joules
+   */
+  double GetTxEnergyConsumption (double txPowerDbm, Time duration) const;
+
   /**
    * \brief Changes state of the LoraRadioEnergyMode.
    *
@@ -300,6 +314,7 @@ private:
   void SetLoraRadioState (const EndDeviceLoraPhy::State state);
 
   Ptr<EnergySource> m_source; ///< energy source
+  Ptr<LazyBasicEnergySource> m_lazySource; ///< m_source, if it predicts its threshold crossings
 
   // Member variables for current draw in different radio modes.
   double m_txCurrentA; ///< transmit current
@@ -0,0 +1,388 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/lora-remote-channel.h"
+#include "ns3/lora-log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/mobility-building-info.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraRemoteChannel");
+
+NS_OBJECT_ENSURE_REGISTERED (LoraRemoteTxHeader);
+NS_OBJECT_ENSURE_REGISTERED (LoraRemoteChannel);
+
+namespace {
+
+void
+WriteDouble (Buffer::Iterator &i, double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  i.WriteHtonU64 (bits);
+}
+
+double
+ReadDouble (Buffer::Iterator &i)
+{
+  uint64_t bits = i.ReadNtohU64 ();
+  double value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+} // anonymous namespace
+
+/////////////////////////
+// LoraRemoteTxHeader //
+/////////////////////////
+
+TypeId
+LoraRemoteTxHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraRemoteTxHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraRemoteTxHeader> ()
+  ;
+  return tid;
+}
+
+LoraRemoteTxHeader::LoraRemoteTxHeader () :
+  m_senderNode (0),
+  m_txPowerDbm (0),
+  m_sf (0),
+  m_frequencyMHz (0)
+{
+}
+
+LoraRemoteTxHeader::~LoraRemoteTxHeader ()
+{
+}
+
+TypeId
+LoraRemoteTxHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LoraRemoteTxHeader::GetSerializedSize (void) const
+{
+  // Node id, 3 coordinates, power, SF, duration and frequency
+  return 4 + 3 * 8 + 8 + 1 + 8 + 8;
+}
+
+void
+LoraRemoteTxHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (m_senderNode);
+  WriteDouble (start, m_senderPosition.x);
+  WriteDouble (start, m_senderPosition.y);
+  WriteDouble (start, m_senderPosition.z);
+  WriteDouble (start, m_txPowerDbm);
+  start.WriteU8 (m_sf);
+  start.WriteHtonU64 (static_cast<uint64_t> (m_duration.GetTimeStep ()));
+  WriteDouble (start, m_frequencyMHz);
+}
+
+uint32_t
+LoraRemoteTxHeader::Deserialize (Buffer::Iterator start)
+{
+  m_senderNode = start.ReadNtohU32 ();
+  m_senderPosition.x = ReadDouble (start);
+  m_senderPosition.y = ReadDouble (start);
+  m_senderPosition.z = ReadDouble (start);
+  m_txPowerDbm = ReadDouble (start);
+  m_sf = start.ReadU8 ();
+  m_duration = TimeStep (static_cast<int64_t> (start.ReadNtohU64 ()));
+  m_frequencyMHz = ReadDouble (start);
+  return GetSerializedSize ();
+}
+
+void
+LoraRemoteTxHeader::Print (std::ostream &os) const
+{
+  os << "SenderNode=" << m_senderNode << " Position=" << m_senderPosition
+     << " TxPower=" << m_txPowerDbm << " SF=" << unsigned (m_sf)
+     << " Duration=" << m_duration << " Frequency=" << m_frequencyMHz;
+}
+
+////////////////////////
+// LoraRemoteChannel //
+////////////////////////
+
+TypeId
+LoraRemoteChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraRemoteChannel")
+    .SetParent<LoraChannel> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraRemoteChannel> ()
+    .AddAttribute ("RegionOrigin",
+                   "X coordinate at which the region of the first rank starts",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&LoraRemoteChannel::m_regionOrigin),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("RegionWidth",
+                   "Width along the x axis of the region of each rank. The "
+                   "regions of the first and last rank extend to infinity",
+                   DoubleValue (10000),
+                   MakeDoubleAccessor (&LoraRemoteChannel::m_regionWidth),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxRange",
+                   "Distance beyond which a transmission is not forwarded "
+                   "to other ranks",
+                   DoubleValue (15000),
+                   MakeDoubleAccessor (&LoraRemoteChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LookAhead",
+                   "Minimum delay of receptions on a rank different from "
+                   "the sender's one",
+                   TimeValue (MicroSeconds (10)),
+                   MakeTimeAccessor (&LoraRemoteChannel::m_lookAhead),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+LoraRemoteChannel::LoraRemoteChannel () :
+  m_regionOrigin (0),
+  m_regionWidth (10000),
+  m_maxRange (15000),
+  m_lookAhead (MicroSeconds (10))
+{
+}
+
+LoraRemoteChannel::LoraRemoteChannel (Ptr<PropagationLossModel> loss,
+                                      Ptr<PropagationDelayModel> delay) :
+  LoraChannel (loss, delay),
+  m_regionOrigin (0),
+  m_regionWidth (10000),
+  m_maxRange (15000),
+  m_lookAhead (MicroSeconds (10))
+{
+}
+
+LoraRemoteChannel::~LoraRemoteChannel ()
+{
+}
+
+void
+LoraRemoteChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_remoteDevices.clear ();
+  m_remoteSenders.clear ();
+
+  LoraChannel::DoDispose ();
+}
+
+uint32_t
+LoraRemoteChannel::GetNRanks (void) const
+{
+  return MpiInterface::IsEnabled () ? MpiInterface::GetSize () : 1;
+}
+
+uint32_t
+LoraRemoteChannel::GetLocalRank (void) const
+{
+  return MpiInterface::IsEnabled () ? MpiInterface::GetSystemId () : 0;
+}
+
+uint32_t
+LoraRemoteChannel::GetRegion (Vector position) const
+{
+  uint32_t nRanks = GetNRanks ();
+
+  double region = std::floor ((position.x - m_regionOrigin) / m_regionWidth);
+  if (region <= 0)
+    {
+      return 0;
+    }
+  if (region >= nRanks - 1)
+    {
+      return nRanks - 1;
+    }
+  return static_cast<uint32_t> (region);
+}
+
+void
+LoraRemoteChannel::SetRankProxies (NodeContainer proxies)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nRanks = GetNRanks ();
+  NS_ASSERT_MSG (proxies.GetN () == nRanks,
+                 "There must be exactly one proxy node per rank");
+
+  uint32_t localRank = GetLocalRank ();
+  m_remoteDevices.assign (nRanks, 0);
+
+  // All ranks install the same links in the same order, so that the devices
+  // get the same indexes everywhere
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", TimeValue (m_lookAhead));
+  for (uint32_t a = 0; a < nRanks; a++)
+    {
+      for (uint32_t b = a + 1; b < nRanks; b++)
+        {
+          // Skip pairs of strips that are too far apart
+          if ((b - a - 1) * m_regionWidth > m_maxRange)
+            {
+              continue;
+            }
+
+          NetDeviceContainer devices = p2p.Install (proxies.Get (a),
+                                                    proxies.Get (b));
+          if (a == localRank || b == localRank)
+            {
+              uint32_t local = (a == localRank) ? 0 : 1;
+              uint32_t remoteRank = (a == localRank) ? b : a;
+              m_remoteDevices[remoteRank] = devices.Get (1 - local);
+              ListenToRank (remoteRank, devices.Get (local));
+            }
+        }
+    }
+}
+
+void
+LoraRemoteChannel::ListenToRank (uint32_t rank, Ptr<NetDevice> localDevice)
+{
+  NS_LOG_FUNCTION (this << rank << localDevice);
+
+  // Hijack the link: what comes from the remote rank is a transmission on
+  // this channel
+  Ptr<MpiReceiver> receiver = localDevice->GetObject<MpiReceiver> ();
+  NS_ASSERT_MSG (receiver != 0, "Proxies must be on their rank");
+  receiver->SetReceiveCallback
+    (MakeCallback (&LoraRemoteChannel::ReceiveRemote, this));
+}
+
+void
+LoraRemoteChannel::ForwardToRank (uint32_t rank, Ptr<Packet> packet) const
+{
+  NS_LOG_FUNCTION (this << rank << packet);
+
+  Ptr<NetDevice> device = m_remoteDevices[rank];
+  MpiInterface::SendPacket (packet, Simulator::Now () + m_lookAhead,
+                            device->GetNode ()->GetId (),
+                            device->GetIfIndex ());
+}
+
+void
+LoraRemoteChannel::Send (Ptr<LoraPhy> sender, Ptr<Packet> packet,
+                         double txPowerDbm, LoraTxParameters txParams,
+                         Time duration, double frequencyMHz) const
+{
+  NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << txParams <<
+                   duration << frequencyMHz);
+
+  LoraChannel::Send (sender, packet, txPowerDbm, txParams, duration,
+                     frequencyMHz);
+
+  if (m_remoteDevices.empty ())
+    {
+      return;
+    }
+
+  Vector position = sender->GetMobility ()->GetObject<MobilityModel> ()->
+    GetPosition ();
+
+  LoraRemoteTxHeader header;
+  Ptr<NetDevice> senderDevice = sender->GetDevice ();
+  header.m_senderNode = senderDevice ? senderDevice->GetNode ()->GetId () : 0;
+  header.m_senderPosition = position;
+  header.m_txPowerDbm = txPowerDbm;
+  header.m_sf = txParams.sf;
+  header.m_duration = duration;
+  header.m_frequencyMHz = frequencyMHz;
+
+  for (uint32_t rank = 0; rank < m_remoteDevices.size (); rank++)
+    {
+      if (m_remoteDevices[rank] == 0)
+        {
+          continue;
+        }
+
+      // Only forward to the ranks whose strip is within range
+      double low = (rank == 0) ? -std::numeric_limits<double>::infinity ()
+        : m_regionOrigin + rank * m_regionWidth;
+      double high = (rank == m_remoteDevices.size () - 1) ?
+        std::numeric_limits<double>::infinity ()
+        : m_regionOrigin + (rank + 1) * m_regionWidth;
+      double distance = std::max (0.0, std::max (low - position.x,
+                                                 position.x - high));
+      if (distance > m_maxRange)
+        {
+          continue;
+        }
+
+      NS_LOG_DEBUG ("Forwarding transmission of node " <<
+                    header.m_senderNode << " to rank " << rank);
+
+      Ptr<Packet> copy = packet->Copy ();
+      copy->AddHeader (header);
+      ForwardToRank (rank, copy);
+    }
+}
+
+void
+LoraRemoteChannel::ReceiveRemote (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  LoraRemoteTxHeader header;
+  packet->RemoveHeader (header);
+
+  NS_LOG_DEBUG ("Received remote transmission: " << header);
+
+  // Stand-in for the mobility model of the remote sender, kept across
+  // transmissions so that loss models can associate attributes to it
+  Ptr<MobilityModel> &senderMobility = m_remoteSenders[header.m_senderNode];
+  bool isNew = (senderMobility == 0);
+  if (isNew)
+    {
+      senderMobility = CreateObject<ConstantPositionMobilityModel> ();
+      senderMobility->AggregateObject (CreateObject<MobilityBuildingInfo> ());
+    }
+  if (isNew || senderMobility->GetPosition () != header.m_senderPosition)
+    {
+      senderMobility->SetPosition (header.m_senderPosition);
+      senderMobility->GetObject<MobilityBuildingInfo> ()->
+        MakeConsistent (senderMobility);
+    }
+
+  // The transmission started LookAhead ago
+  DeliverToPhys (0, senderMobility, packet, header.m_txPowerDbm,
+                 header.m_sf, header.m_duration, header.m_frequencyMHz,
+                 m_lookAhead);
+}
+
+} // namespace lorawan
+} // namespace ns3
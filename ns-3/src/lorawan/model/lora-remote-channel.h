@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_REMOTE_CHANNEL_H
+#define LORA_REMOTE_CHANNEL_H
+
+#include "ns3/lora-channel.h"
+#include "ns3/header.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device.h"
+#include "ns3/vector.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Header carrying the parameters of a LoRa transmission that is forwarded to
+ * another MPI rank by a LoraRemoteChannel.
+ */
+class LoraRemoteTxHeader : public Header
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LoraRemoteTxHeader ();
+  virtual ~LoraRemoteTxHeader ();
+
+  // Inherited from Header
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  uint32_t m_senderNode;    //!< Id of the node that is transmitting
+  Vector m_senderPosition;  //!< Position of the sender at transmission time
+  double m_txPowerDbm;      //!< Transmission power
+  uint8_t m_sf;             //!< Spreading factor
+  Time m_duration;          //!< Time on air of the packet
+  double m_frequencyMHz;    //!< Frequency of the transmission
+};
+
+/**
+ * A LoraChannel that spans several MPI ranks.
+ *
+ * The simulated area is split in vertical strips of equal width, one per
+ * rank, and each node should be created on the rank returned by GetRegion for
+ * its position. Every rank holds the whole node list, but only connects the
+ * PHYs of its local nodes to its channel.
+ *
+ * Transmissions are delivered to local PHYs as in a LoraChannel, and are
+ * also forwarded to the ranks whose strip is within MaxRange of the sender.
+ * There, they are delivered to the local PHYs as if the sender had been
+ * connected to the channel. Since neighboring strips touch, propagation
+ * delays across a boundary can be arbitrarily small: remote receptions are
+ * thus delayed by at least LookAhead. Neighboring ranks exchange the
+ * forwarded transmissions over point-to-point links between per-rank proxy
+ * nodes, whose delay is LookAhead, so that both the GrantedTimeWindow and
+ * the NullMessage synchronization algorithms derive their lookahead from
+ * it.
+ *
+ * Random attributes that loss models attach to a sender (e.g., the
+ * building penetration losses of BuildingPenetrationLoss) are drawn
+ * independently on each rank.
+ */
+class LoraRemoteChannel : public LoraChannel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LoraRemoteChannel ();
+  LoraRemoteChannel (Ptr<PropagationLossModel> loss,
+                     Ptr<PropagationDelayModel> delay);
+  virtual ~LoraRemoteChannel ();
+
+  /**
+   * Return the rank that is responsible for a position.
+   */
+  uint32_t GetRegion (Vector position) const;
+
+  /**
+   * Set the nodes that receive the transmissions forwarded to each rank.
+   *
+   * This method must be called with the same container on all ranks, after
+   * the channel attributes were set and before any other device is
+   * installed on the proxies. The i-th node must belong to rank i.
+   */
+  void SetRankProxies (NodeContainer proxies);
+
+  // Inherited from LoraChannel
+  virtual void Send (Ptr<LoraPhy> sender, Ptr<Packet> packet,
+                     double txPowerDbm, LoraTxParameters txParams,
+                     Time duration, double frequencyMHz) const;
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * \return The number of ranks, i.e., of strips (1 if MPI is not enabled).
+   */
+  virtual uint32_t GetNRanks (void) const;
+
+  /**
+   * \return The rank of this process (0 if MPI is not enabled).
+   */
+  virtual uint32_t GetLocalRank (void) const;
+
+  /**
+   * Receive on this channel what arrives on the local end of the link
+   * towards a rank.
+   *
+   * \param rank The rank at the other end of the link.
+   * \param localDevice The device of the link on the local proxy.
+   */
+  virtual void ListenToRank (uint32_t rank, Ptr<NetDevice> localDevice);
+
+  /**
+   * Send a transmission, with its LoraRemoteTxHeader, to a rank, where it is
+   * received LookAhead later.
+   *
+   * \param rank The rank, which must be linked to this one.
+   * \param packet The packet, starting with a LoraRemoteTxHeader.
+   */
+  virtual void ForwardToRank (uint32_t rank, Ptr<Packet> packet) const;
+
+  /**
+   * Receive a transmission forwarded by another rank, and deliver it to the
+   * local PHYs.
+   */
+  void ReceiveRemote (Ptr<Packet> packet);
+
+private:
+
+  double m_regionOrigin;  //!< X coordinate where the first strip starts
+  double m_regionWidth;   //!< Width of each strip
+  double m_maxRange;      //!< Range beyond which transmissions are ignored
+  Time m_lookAhead;       //!< Minimum delay of cross-rank receptions
+
+  /**
+   * Device at the remote end of the link towards each rank, or 0 if that
+   * rank is not a neighbor
+   */
+  std::vector<Ptr<NetDevice> > m_remoteDevices;
+
+  /**
+   * Mobility models standing for remote senders, indexed by node id
+   */
+  std::map<uint32_t, Ptr<MobilityModel> > m_remoteSenders;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_REMOTE_CHANNEL_H */
@@ -14,14 +14,14 @@
  */
 
 #include "lora-tx-current-model.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/double.h"
 #include "lora-utils.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LoraTxCurrentModel");
+LORA_LOG_COMPONENT_DEFINE ("LoraTxCurrentModel");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraTxCurrentModel);
 
@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-worker-pool.h"
+#include "ns3/lora-log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+LORA_LOG_COMPONENT_DEFINE ("LoraWorkerPool");
+
+LoraWorkerPool::LoraWorkerPool (uint32_t nWorkers) :
+  m_job (0),
+  m_generation (0),
+  m_pending (0),
+  m_stop (false)
+{
+  NS_LOG_FUNCTION (this << nWorkers);
+
+  for (uint32_t i = 0; i < nWorkers; i++)
+    {
+      m_threads.push_back (std::thread (&LoraWorkerPool::WorkerLoop, this,
+                                        i + 1));
+    }
+}
+
+LoraWorkerPool::~LoraWorkerPool ()
+{
+  NS_LOG_FUNCTION (this);
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_startCondition.notify_all ();
+
+  for (std::vector<std::thread>::iterator it = m_threads.begin ();
+       it != m_threads.end (); it++)
+    {
+      it->join ();
+    }
+}
+
+uint32_t
+LoraWorkerPool::GetNPartitions (void) const
+{
+  return m_threads.size () + 1;
+}
+
+std::pair<std::size_t, std::size_t>
+LoraWorkerPool::GetRange (std::size_t n, uint32_t partition) const
+{
+  std::size_t parts = GetNPartitions ();
+  return std::make_pair (n * partition / parts, n * (partition + 1) / parts);
+}
+
+void
+LoraWorkerPool::Run (const std::function<void (uint32_t)> &job)
+{
+  if (m_threads.empty ())
+    {
+      job (0);
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_job = &job;
+    m_pending = m_threads.size ();
+    m_generation++;
+  }
+  m_startCondition.notify_all ();
+
+  job (0);
+
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_doneCondition.wait (lock, [this] { return m_pending == 0; });
+  m_job = 0;
+}
+
+void
+LoraWorkerPool::WorkerLoop (uint32_t partition)
+{
+  uint64_t lastGeneration = 0;
+
+  while (true)
+    {
+      const std::function<void (uint32_t)> *job;
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_startCondition.wait (lock, [this, lastGeneration] {
+          return m_stop || m_generation != lastGeneration;
+        });
+        if (m_stop)
+          {
+            return;
+          }
+        lastGeneration = m_generation;
+        job = m_job;
+      }
+
+      (*job) (partition);
+
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_pending--;
+      }
+      m_doneCondition.notify_one ();
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
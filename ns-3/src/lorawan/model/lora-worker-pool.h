@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_WORKER_POOL_H
+#define LORA_WORKER_POOL_H
+
+#include "ns3/simple-ref-count.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A small pool of persistent worker threads that run the same job over a
+ * fixed number of partitions.
+ *
+ * The calling thread always takes partition 0, and each worker takes one of
+ * the others. Run returns only after all partitions are done, so the pool
+ * never overlaps with the simulator's event loop: jobs must only touch data
+ * that belongs to their partition, or that is read-only while they run.
+ */
+class LoraWorkerPool : public SimpleRefCount<LoraWorkerPool>
+{
+public:
+  /**
+   * Create a pool with the given number of worker threads, on top of the
+   * calling thread.
+   */
+  LoraWorkerPool (uint32_t nWorkers);
+
+  ~LoraWorkerPool ();
+
+  /**
+   * Return the number of partitions a job is split into.
+   */
+  uint32_t GetNPartitions (void) const;
+
+  /**
+   * Run the job once for each partition, and wait for all of them to end.
+   *
+   * \param job The function to run, taking the partition index.
+   */
+  void Run (const std::function<void (uint32_t)> &job);
+
+  /**
+   * Return the [begin, end) range of the partition-th slice of n items.
+   */
+  std::pair<std::size_t, std::size_t> GetRange (std::size_t n,
+                                                uint32_t partition) const;
+
+private:
+  void WorkerLoop (uint32_t partition);
+
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_startCondition;
+  std::condition_variable m_doneCondition;
+  const std::function<void (uint32_t)> *m_job; //!< The job being run
+  uint64_t m_generation;  //!< Incremented every time a job is posted
+  uint32_t m_pending;     //!< Workers that did not finish the current job
+  bool m_stop;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_WORKER_POOL_H */
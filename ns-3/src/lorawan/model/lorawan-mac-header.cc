@@ -19,13 +19,13 @@
  */
 
 #include "ns3/lorawan-mac-header.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <bitset>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LorawanMacHeader");
+LORA_LOG_COMPONENT_DEFINE ("LorawanMacHeader");
 
 LorawanMacHeader::LorawanMacHeader () : m_major (0)
 {
@@ -19,12 +19,12 @@
  */
 
 #include "ns3/lorawan-mac.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("LorawanMac");
+LORA_LOG_COMPONENT_DEFINE ("LorawanMac");
 
 NS_OBJECT_ENSURE_REGISTERED (LorawanMac);
 
@@ -19,14 +19,14 @@
  */
 
 #include "ns3/mac-command.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include <bitset>
 #include <cmath>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("MacCommand");
+LORA_LOG_COMPONENT_DEFINE ("MacCommand");
 
 NS_OBJECT_ENSURE_REGISTERED (MacCommand);
 
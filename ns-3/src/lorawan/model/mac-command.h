@@ -24,6 +24,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
+#include "ns3/lora-object-pool.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -63,7 +64,7 @@ enum MacCommandType
  * common features are supposed to be defined in detail by child classes, based
  * on that MAC command's attributes and structure.
  */
-class MacCommand : public Object
+class MacCommand : public Object, public LoraPooledAllocation<MacCommand>
 {
 public:
   static TypeId GetTypeId (void);
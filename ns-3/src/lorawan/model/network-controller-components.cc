@@ -19,11 +19,12 @@
  */
 
 #include "ns3/network-controller-components.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("NetworkControllerComponent");
+LORA_LOG_COMPONENT_DEFINE ("NetworkControllerComponent");
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkControllerComponent);
 
@@ -73,17 +74,12 @@ ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const Packet> packet,
   NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
 
   // Check whether the received packet requires an acknowledgment.
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraFrameHeaderView fHdr (packet);
 
-  NS_LOG_INFO ("Received packet Mac Header: " << mHdr);
-  NS_LOG_INFO ("Received packet Frame Header: " << fHdr);
+  NS_LOG_INFO ("Received packet with MType " << unsigned (fHdr.GetMType ())
+               << " from " << fHdr.GetAddress ());
 
-  if (mHdr.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
+  if (fHdr.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
     {
       NS_LOG_INFO ("Packet requires confirmation");
 
@@ -159,12 +155,7 @@ LinkCheckComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraFrameHeader fHdr = LoraFrameHeaderView (status->GetLastPacketReceivedFromDevice ()).GetFrameHeader ();
 
   Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq> ();
 
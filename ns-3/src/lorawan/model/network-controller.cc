@@ -19,11 +19,12 @@
  */
 
 #include "network-controller.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("NetworkController");
+LORA_LOG_COMPONENT_DEFINE ("NetworkController");
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkController);
 
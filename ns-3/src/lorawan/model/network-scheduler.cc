@@ -1,9 +1,119 @@
 #include "network-scheduler.h"
+#include "ns3/lora-log.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("NetworkScheduler");
+LORA_LOG_COMPONENT_DEFINE ("NetworkScheduler");
+
+ReceiveWindowWheel::ReceiveWindowWheel () :
+  m_current (0),
+  m_size (0)
+{
+}
+
+void
+ReceiveWindowWheel::Insert (const Entry &entry)
+{
+  NS_ASSERT (entry.tick > m_current);
+
+  Place (entry);
+  m_size++;
+}
+
+void
+ReceiveWindowWheel::Place (const Entry &entry)
+{
+  if ((entry.tick >> L0_BITS) == (m_current >> L0_BITS))
+    {
+      m_level0[entry.tick & (L0_SLOTS - 1)].push_back (entry);
+    }
+  else if ((entry.tick >> (L0_BITS + L1_BITS))
+           == (m_current >> (L0_BITS + L1_BITS)))
+    {
+      m_level1[(entry.tick >> L0_BITS) & (L1_SLOTS - 1)].push_back (entry);
+    }
+  else
+    {
+      m_overflow.push_back (entry);
+    }
+}
+
+bool
+ReceiveWindowWheel::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+uint64_t
+ReceiveWindowWheel::GetNextTick (void) const
+{
+  NS_ASSERT (m_size > 0);
+
+  // Remaining ticks of the current epoch
+  for (uint64_t tick = m_current + 1;
+       (tick >> L0_BITS) == (m_current >> L0_BITS); tick++)
+    {
+      if (!m_level0[tick & (L0_SLOTS - 1)].empty ())
+        {
+          return tick;
+        }
+    }
+
+  // Remaining epochs, the first non-empty one holds the earliest tick
+  const std::vector<Entry> *slot = &m_overflow;
+  for (uint64_t epoch = (m_current >> L0_BITS) + 1;
+       (epoch >> L1_BITS) == (m_current >> (L0_BITS + L1_BITS)); epoch++)
+    {
+      if (!m_level1[epoch & (L1_SLOTS - 1)].empty ())
+        {
+          slot = &m_level1[epoch & (L1_SLOTS - 1)];
+          break;
+        }
+    }
+
+  NS_ASSERT (!slot->empty ());
+  uint64_t next = slot->front ().tick;
+  for (std::vector<Entry>::const_iterator it = slot->begin ();
+       it != slot->end (); it++)
+    {
+      next = std::min (next, it->tick);
+    }
+  return next;
+}
+
+void
+ReceiveWindowWheel::Advance (uint64_t tick, std::vector<Entry> &batch)
+{
+  NS_ASSERT (tick > m_current);
+
+  uint64_t previous = m_current;
+  m_current = tick;
+
+  // Cascade the opportunities of the epoch we just entered into the first
+  // level. Since tick is the earliest one in the wheel, the slots we jumped
+  // over are all empty.
+  std::vector<Entry> cascade;
+  if ((tick >> (L0_BITS + L1_BITS)) != (previous >> (L0_BITS + L1_BITS)))
+    {
+      cascade.swap (m_overflow);
+    }
+  else if ((tick >> L0_BITS) != (previous >> L0_BITS))
+    {
+      cascade.swap (m_level1[(tick >> L0_BITS) & (L1_SLOTS - 1)]);
+    }
+  for (std::vector<Entry>::const_iterator it = cascade.begin ();
+       it != cascade.end (); it++)
+    {
+      Place (*it);
+    }
+
+  std::vector<Entry> &slot = m_level0[tick & (L0_SLOTS - 1)];
+  batch.insert (batch.end (), slot.begin (), slot.end ());
+  m_size -= slot.size ();
+  slot.clear ();
+}
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkScheduler);
 
@@ -13,6 +123,20 @@ NetworkScheduler::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::NetworkScheduler")
     .SetParent<Object> ()
     .AddConstructor<NetworkScheduler> ()
+    .AddAttribute ("BatchReceiveWindows",
+                   "Whether to coalesce receive window opportunities in a "
+                   "timing wheel, opening all the windows that fall in the "
+                   "same tick with a single event",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkScheduler::m_batchReceiveWindows),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ReceiveWindowTick",
+                   "Resolution of the receive window timing wheel. Windows "
+                   "are opened at the end of the tick they fall in, so this "
+                   "should stay well below the receive window duration",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&NetworkScheduler::m_tickResolution),
+                   MakeTimeChecker ())
     .AddTraceSource ("ReceiveWindowOpened",
                      "Trace source that is fired when a receive window opportunity happens.",
                      MakeTraceSourceAccessor (&NetworkScheduler::m_receiveWindowOpened),
@@ -21,12 +145,18 @@ NetworkScheduler::GetTypeId (void)
   return tid;
 }
 
-NetworkScheduler::NetworkScheduler ()
+NetworkScheduler::NetworkScheduler () :
+  m_batchReceiveWindows (false),
+  m_tickResolution (MilliSeconds (1)),
+  m_wheelEventTick (0)
 {
 }
 
 NetworkScheduler::NetworkScheduler (Ptr<NetworkStatus> status,
                                     Ptr<NetworkController> controller) :
+  m_batchReceiveWindows (false),
+  m_tickResolution (MilliSeconds (1)),
+  m_wheelEventTick (0),
   m_status (status),
   m_controller (controller)
 {
@@ -42,16 +172,7 @@ NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
   NS_LOG_FUNCTION (packet);
 
   // Get the current packet's frame counter
-  Ptr<Packet> packetCopy = packet->Copy ();
-  LorawanMacHeader receivedMacHdr;
-  packetCopy->RemoveHeader (receivedMacHdr);
-  LoraFrameHeader receivedFrameHdr;
-  receivedFrameHdr.SetAsUplink ();
-  NS_LOG_FUNCTION ("New MAC command hanged after calling packetCopy->RemoveHeader (receivedFrameHdr) [deserialization]");
-  packetCopy->RemoveHeader (receivedFrameHdr);
-  NS_LOG_FUNCTION ("MAC commands Deserialized  Ok :)");
-
-
+  LoraFrameHeaderView receivedFrameHdr (packet);
 
   // Need to decide whether to schedule a receive window
   if (!m_status->GetEndDeviceStatus (packet)->HasReceiveWindowOpportunityScheduled ())
@@ -62,15 +183,100 @@ NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
 
 
     // Schedule OnReceiveWindowOpportunity event
-    m_status->GetEndDeviceStatus (packet)->SetReceiveWindowOpportunity (
-      Simulator::Schedule (Seconds (1),
-                           &NetworkScheduler::OnReceiveWindowOpportunity,
-                           this,
-                           deviceAddress,
-                           1)); // This will be the first receive window
+    ScheduleReceiveWindowOpportunity (deviceAddress,
+                                      1,  // This will be the first receive window
+                                      Seconds (1));
   }
 }
 
+void
+NetworkScheduler::ScheduleReceiveWindowOpportunity (LoraDeviceAddress deviceAddress,
+                                                    int window, Time delay)
+{
+  NS_LOG_FUNCTION (this << deviceAddress << window << delay);
+
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+
+  if (!m_batchReceiveWindows)
+    {
+      edStatus->SetReceiveWindowOpportunity (
+        Simulator::Schedule (delay,
+                             &NetworkScheduler::OnReceiveWindowOpportunity,
+                             this,
+                             deviceAddress,
+                             window));
+      return;
+    }
+
+  // Round the opening time up to the end of the tick it falls in
+  int64_t resolution = m_tickResolution.GetTimeStep ();
+  NS_ASSERT_MSG (resolution > 0, "ReceiveWindowTick must be positive");
+  uint64_t tick = ((Simulator::Now () + delay).GetTimeStep () + resolution - 1)
+    / resolution;
+
+  ReceiveWindowWheel::Entry entry;
+  entry.tick = tick;
+  entry.deviceAddress = deviceAddress;
+  entry.window = window;
+  entry.generation = edStatus->SetBatchedReceiveWindowOpportunity ();
+  m_wheel.Insert (entry);
+
+  // Only touch the core scheduler if this tick precedes the pending one
+  if (!m_wheelEvent.IsRunning () || tick < m_wheelEventTick)
+    {
+      UpdateWheelEvent ();
+    }
+}
+
+void
+NetworkScheduler::UpdateWheelEvent (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_wheelEvent);
+
+  if (m_wheel.IsEmpty ())
+    {
+      return;
+    }
+
+  m_wheelEventTick = m_wheel.GetNextTick ();
+  Time tickTime = TimeStep (m_wheelEventTick * m_tickResolution.GetTimeStep ());
+  m_wheelEvent = Simulator::Schedule (tickTime - Simulator::Now (),
+                                      &NetworkScheduler::OnWheelTick, this);
+}
+
+void
+NetworkScheduler::OnWheelTick (void)
+{
+  NS_LOG_FUNCTION (this << m_wheelEventTick);
+
+  m_wheel.Advance (m_wheelEventTick, m_batch);
+
+  NS_LOG_DEBUG ("Opening " << m_batch.size () << " receive windows in batch");
+
+  for (std::size_t i = 0; i < m_batch.size (); i++)
+    {
+      // The opportunity expires now, just like a standalone event would. If
+      // the first window fails, a new one is placed in the wheel. Entries of
+      // removed opportunities are skipped, like cancelled events.
+      if (!m_status->GetEndDeviceStatus (m_batch[i].deviceAddress)->
+          ExpireBatchedReceiveWindowOpportunity (m_batch[i].generation))
+        {
+          NS_LOG_LOGIC ("Skipping a removed opportunity of "
+                        << m_batch[i].deviceAddress);
+          continue;
+        }
+      OnReceiveWindowOpportunity (m_batch[i].deviceAddress, m_batch[i].window);
+    }
+  m_batch.clear ();
+
+  if (!m_wheelEvent.IsRunning ())
+    {
+      UpdateWheelEvent ();
+    }
+}
+
 void
 NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window)
 {
@@ -90,12 +296,9 @@ NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, i
       // No suitable GW was found, but there's still hope to find one for the
       // second window.
       // Schedule another OnReceiveWindowOpportunity event
-      m_status->GetEndDeviceStatus (deviceAddress)->SetReceiveWindowOpportunity (
-        Simulator::Schedule (Seconds (1),
-                             &NetworkScheduler::OnReceiveWindowOpportunity,
-                             this,
-                             deviceAddress,
-                             2));     // This will be the second receive window
+      ScheduleReceiveWindowOpportunity (deviceAddress,
+                                        2,  // This will be the second receive window
+                                        Seconds (1));
     }
   else if (gwAddress == Address () && window == 2)
     {
@@ -29,6 +29,7 @@
 #include "ns3/lora-frame-header.h"
 #include "ns3/network-controller.h"
 #include "ns3/network-status.h"
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -36,6 +37,69 @@ namespace lorawan {
 class NetworkStatus;     // Forward declaration
 class NetworkController;     // Forward declaration
 
+/**
+ * Hierarchical timing wheel used by the NetworkScheduler to batch receive
+ * window opportunities.
+ *
+ * Time is quantized in ticks. The first level holds one slot per tick for
+ * the current 256-tick epoch, the second level holds one slot per epoch for
+ * the next 64 epochs, and anything further away is kept in an overflow list
+ * that is cascaded down when its turn comes.
+ */
+class ReceiveWindowWheel
+{
+public:
+  /**
+   * A pending receive window opportunity.
+   */
+  struct Entry
+  {
+    uint64_t tick;                   //!< Tick at which the window opens
+    LoraDeviceAddress deviceAddress; //!< The device the window belongs to
+    uint8_t window;                  //!< The receive window number (1 or 2)
+    uint32_t generation;             //!< See EndDeviceStatus::SetBatchedReceiveWindowOpportunity
+  };
+
+  ReceiveWindowWheel ();
+
+  /**
+   * Add an opportunity to the wheel. The tick must be strictly after the
+   * last tick that was extracted with Advance.
+   */
+  void Insert (const Entry &entry);
+
+  /**
+   * Return whether the wheel holds any opportunity.
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * Return the earliest tick for which there is at least one opportunity.
+   * The wheel must not be empty.
+   */
+  uint64_t GetNextTick (void) const;
+
+  /**
+   * Move the wheel forward to the given tick, which must be the one returned
+   * by GetNextTick, and move all opportunities due at that tick in batch.
+   */
+  void Advance (uint64_t tick, std::vector<Entry> &batch);
+
+private:
+  static const uint32_t L0_BITS = 8;
+  static const uint32_t L1_BITS = 6;
+  static const uint32_t L0_SLOTS = 1 << L0_BITS;
+  static const uint32_t L1_SLOTS = 1 << L1_BITS;
+
+  void Place (const Entry &entry);
+
+  uint64_t m_current;  //!< The last tick that was extracted
+  std::size_t m_size;  //!< The number of opportunities in the wheel
+  std::vector<Entry> m_level0[L0_SLOTS];
+  std::vector<Entry> m_level1[L1_SLOTS];
+  std::vector<Entry> m_overflow;
+};
+
 class NetworkScheduler : public Object
 {
 public:
@@ -60,6 +124,31 @@ public:
   void OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window);
 
 private:
+  /**
+   * Schedule a receive window opportunity for a device after the given
+   * delay, either as a standalone event or in the timing wheel.
+   */
+  void ScheduleReceiveWindowOpportunity (LoraDeviceAddress deviceAddress,
+                                         int window, Time delay);
+
+  /**
+   * Make sure the single wheel event is scheduled at the earliest tick
+   * holding an opportunity.
+   */
+  void UpdateWheelEvent (void);
+
+  /**
+   * Open all the receive windows that are due at the current tick.
+   */
+  void OnWheelTick (void);
+
+  bool m_batchReceiveWindows;  //!< Whether to use the timing wheel
+  Time m_tickResolution;       //!< Duration of a timing wheel tick
+  ReceiveWindowWheel m_wheel;
+  EventId m_wheelEvent;        //!< The event of the next non-empty tick
+  uint64_t m_wheelEventTick;   //!< The tick m_wheelEvent is scheduled for
+  std::vector<ReceiveWindowWheel::Entry> m_batch;
+
   TracedCallback<Ptr<const Packet> > m_receiveWindowOpened;
   Ptr<NetworkStatus> m_status;
   Ptr<NetworkController> m_controller;
@@ -20,6 +20,8 @@
  */
 
 #include "ns3/network-server.h"
+#include "ns3/lora-log.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/net-device.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/packet.h"
@@ -35,7 +37,7 @@
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("NetworkServer");
+LORA_LOG_COMPONENT_DEFINE ("NetworkServer");
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkServer);
 
@@ -56,7 +58,7 @@ NetworkServer::GetTypeId (void)
 NetworkServer::NetworkServer () :
   m_status (Create<NetworkStatus> ()),
   m_controller (Create<NetworkController> (m_status)),
-  m_scheduler (Create<NetworkScheduler> (m_status, m_controller))
+  m_scheduler (CreateObject<NetworkScheduler> (m_status, m_controller))
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -153,6 +155,7 @@ bool
 NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
                         uint16_t protocol, const Address& address)
 {
+  LORA_PROFILE_SCOPE ("NetworkServer::Receive");
   NS_LOG_FUNCTION (this << packet << protocol << address);
 
   // Create a copy of the packet
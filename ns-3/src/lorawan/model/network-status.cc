@@ -27,13 +27,13 @@
 #include "ns3/packet.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/node-container.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/pointer.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("NetworkStatus");
+LORA_LOG_COMPONENT_DEFINE ("NetworkStatus");
 
 NS_OBJECT_ENSURE_REGISTERED (NetworkStatus);
 
@@ -100,18 +100,8 @@ NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << gwAddress);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
-
   // Update the correct EndDeviceStatus object
-  LoraDeviceAddress edAddr = frameHdr.GetAddress ();
+  LoraDeviceAddress edAddr = LoraFrameHeaderView (packet).GetAddress ();
   NS_LOG_DEBUG ("Node address: " << edAddr);
   m_endDeviceStatuses.at (edAddr)->InsertReceivedPacket (packet, gwAddress);
 }
@@ -206,12 +196,7 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
   NS_LOG_FUNCTION (this << packet);
 
   // Get the address
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-  auto it = m_endDeviceStatuses.find (fHdr.GetAddress ());
+  auto it = m_endDeviceStatuses.find (LoraFrameHeaderView (packet).GetAddress ());
   if (it != m_endDeviceStatuses.end ())
     {
       return (*it).second;
@@ -21,7 +21,7 @@
 #include "ns3/one-shot-sender.h"
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/pointer.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/lora-net-device.h"
@@ -29,7 +29,7 @@
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("OneShotSender");
+LORA_LOG_COMPONENT_DEFINE ("OneShotSender");
 
 NS_OBJECT_ENSURE_REGISTERED (OneShotSender);
 
@@ -20,15 +20,16 @@
 
 #include "ns3/periodic-sender.h"
 #include "ns3/pointer.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/lora-net-device.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("PeriodicSender");
+LORA_LOG_COMPONENT_DEFINE ("PeriodicSender");
 
 NS_OBJECT_ENSURE_REGISTERED (PeriodicSender);
 
@@ -43,7 +44,19 @@ PeriodicSender::GetTypeId (void)
                    TimeValue (Seconds (0)),
                    MakeTimeAccessor (&PeriodicSender::GetInterval,
                                      &PeriodicSender::SetInterval),
-                   MakeTimeChecker ());
+                   MakeTimeChecker ())
+    .AddAttribute ("DutyCycleAware",
+                   "Whether to ask the MAC for the earliest time at which "
+                   "a packet can be transmitted, and send it only then, "
+                   "instead of letting the MAC postpone it",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PeriodicSender::m_dutyCycleAware),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("PostponedPacket",
+                     "The transmission of a packet was postponed because "
+                     "the MAC could not send it right away",
+                     MakeTraceSourceAccessor (&PeriodicSender::m_postponedPacket),
+                     "ns3::EndDeviceLorawanMac::PostponedTransmissionCallback");
   // .AddAttribute ("PacketSizeRandomVariable", "The random variable that determines the shape of the packet size, in bytes",
   //                StringValue ("ns3::UniformRandomVariable[Min=0,Max=10]"),
   //                MakePointerAccessor (&PeriodicSender::m_pktSizeRV),
@@ -55,7 +68,9 @@ PeriodicSender::PeriodicSender ()
   : m_interval (Seconds (10)),
   m_initialDelay (Seconds (1)),
   m_basePktSize (10),
-  m_pktSizeRV (0)
+  m_pktSizeRV (0),
+  m_dutyCycleAware (false),
+  m_nPostponedPackets (0)
 
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -118,7 +133,34 @@ PeriodicSender::SendPacket (void)
     {
       packet = Create<Packet> (m_basePktSize);
     }
-  m_mac->Send (packet);
+
+  // If the MAC can't transmit right now, hand it the packet only when it can
+  Time earliest = Simulator::Now ();
+  if (m_dutyCycleAware && m_endDeviceMac != 0)
+    {
+      earliest = m_endDeviceMac->GetEarliestTransmissionTime ();
+    }
+  if (earliest > Simulator::Now () && earliest != Time::Max ())
+    {
+      Time delay = earliest - Simulator::Now ();
+
+      // Like the MAC, replace a packet that is still waiting
+      if (m_postponedSendEvent.IsRunning ())
+        {
+          NS_LOG_DEBUG ("Dropping a packet that was still waiting to be sent");
+          m_postponedSendEvent.Cancel ();
+        }
+      m_postponedSendEvent = Simulator::Schedule (delay, &LorawanMac::Send,
+                                                  m_mac, packet);
+      m_nPostponedPackets++;
+      m_postponedPacket (packet, delay);
+
+      NS_LOG_DEBUG ("Postponed the packet by " << delay.GetSeconds () << " s");
+    }
+  else
+    {
+      m_mac->Send (packet);
+    }
 
   // Schedule the next SendPacket event
   m_sendEvent = Simulator::Schedule (m_interval, &PeriodicSender::SendPacket,
@@ -141,6 +183,7 @@ PeriodicSender::StartApplication (void)
       m_mac = loraNetDevice->GetMac ();
       NS_ASSERT (m_mac != 0);
     }
+  m_endDeviceMac = m_mac->GetObject<EndDeviceLorawanMac> ();
 
   // Schedule the next SendPacket event
   Simulator::Cancel (m_sendEvent);
@@ -156,6 +199,13 @@ PeriodicSender::StopApplication (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   Simulator::Cancel (m_sendEvent);
+  Simulator::Cancel (m_postponedSendEvent);
+}
+
+uint32_t
+PeriodicSender::GetNPostponedPackets (void) const
+{
+  return m_nPostponedPackets;
 }
 
 }
@@ -24,7 +24,9 @@
 #include "ns3/application.h"
 #include "ns3/nstime.h"
 #include "ns3/lorawan-mac.h"
+#include "ns3/end-device-lorawan-mac.h"
 #include "ns3/attribute.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -69,6 +71,14 @@ public:
    */
   void SendPacket (void);
 
+  /**
+   * Get the number of packets whose transmission was postponed because the
+   * MAC could not send them right away.
+   *
+   * \return The number of postponed packets.
+   */
+  uint32_t GetNPostponedPackets (void) const;
+
   /**
    * Start the application by scheduling the first SendPacket event
    */
@@ -111,6 +121,33 @@ private:
    */
   Ptr<RandomVariableStream> m_pktSizeRV;
 
+  /**
+   * The MAC layer of this node, if it's an end device one
+   */
+  Ptr<EndDeviceLorawanMac> m_endDeviceMac;
+
+  /**
+   * Whether to ask the MAC for the earliest time at which it can transmit,
+   * and hand the packet over only at that time
+   */
+  bool m_dutyCycleAware;
+
+  /**
+   * The event of handing over to the MAC a packet whose transmission was
+   * postponed
+   */
+  EventId m_postponedSendEvent;
+
+  /**
+   * The number of packets whose transmission was postponed
+   */
+  uint32_t m_nPostponedPackets;
+
+  /**
+   * The trace source fired when the transmission of a packet is postponed
+   */
+  TracedCallback<Ptr<const Packet>, Time> m_postponedPacket;
+
 
 };
 
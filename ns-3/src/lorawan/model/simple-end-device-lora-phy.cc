@@ -22,12 +22,12 @@
 #include "ns3/simple-end-device-lora-phy.h"
 #include "ns3/simulator.h"
 #include "ns3/lora-tag.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("SimpleEndDeviceLoraPhy");
+LORA_LOG_COMPONENT_DEFINE ("SimpleEndDeviceLoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (SimpleEndDeviceLoraPhy);
 
@@ -19,14 +19,15 @@
  */
 
 #include "ns3/simple-gateway-lora-phy.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/lora-tag.h"
 #include "ns3/simulator.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("SimpleGatewayLoraPhy");
+LORA_LOG_COMPONENT_DEFINE ("SimpleGatewayLoraPhy");
 
 NS_OBJECT_ENSURE_REGISTERED (SimpleGatewayLoraPhy);
 
@@ -121,6 +122,7 @@ void
 SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8_t sf,
                                     Time duration, double frequencyMHz)
 {
+  LORA_PROFILE_SCOPE ("SimpleGatewayLoraPhy::StartReceive");
   NS_LOG_FUNCTION (this << packet << rxPowerDbm << duration << frequencyMHz);
 
   // Fire the trace source
@@ -130,7 +132,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8
     {
       // If we get to this point, there are no demodulators we can use
       NS_LOG_INFO ("Dropping packet reception of packet with sf = "
-                   << unsigned (sf) << " because we are in TX mode\a\a"); // [Renzo We want to minimize this TX mode of GW will be real issue in 1000+ nodes net if all request a downling]
+                   << unsigned (sf) << " because we are in TX mode"); // [Renzo We want to minimize this TX mode of GW will be real issue in 1000+ nodes net if all request a downling]
 
       m_phyRxEndTrace (packet);
 
@@ -224,6 +226,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8
 void
 SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event)
 {
+  LORA_PROFILE_SCOPE ("SimpleGatewayLoraPhy::EndReceive");
   NS_LOG_FUNCTION (this << packet << *event);
 
   // Call the trace source
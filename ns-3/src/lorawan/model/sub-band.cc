@@ -19,12 +19,12 @@
  */
 
 #include "ns3/sub-band.h"
-#include "ns3/log.h"
+#include "ns3/lora-log.h"
 
 namespace ns3 {
 namespace lorawan {
 
-NS_LOG_COMPONENT_DEFINE ("SubBand");
+LORA_LOG_COMPONENT_DEFINE ("SubBand");
 
 NS_OBJECT_ENSURE_REGISTERED (SubBand);
 
@@ -0,0 +1,504 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This file includes testing for the following components:
+ * - LoraRemoteTxHeader
+ * - LoraRemoteChannel
+ *
+ * The tests run on a single rank, without MPI: the rank layout and the
+ * exchanges between ranks are replaced by a subclass of the channel.
+ */
+
+// Include headers of classes to test
+#include "ns3/log.h"
+#include "ns3/lora-remote-channel.h"
+#include "ns3/simple-end-device-lora-phy.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/mobility-building-info.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include <cstdlib>
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LoraRemoteChannelTestSuite");
+
+/**
+ * A LoraRemoteChannel that pretends to be one of several ranks, and records
+ * what it would exchange with the others.
+ */
+class FakeRankChannel : public LoraRemoteChannel
+{
+public:
+  FakeRankChannel (Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay,
+                   uint32_t nRanks, uint32_t localRank)
+    : LoraRemoteChannel (loss, delay),
+      m_nRanks (nRanks),
+      m_localRank (localRank)
+  {
+  }
+
+  using LoraRemoteChannel::ReceiveRemote;
+
+  std::vector<uint32_t> m_listenedRanks;
+  mutable std::vector<uint32_t> m_forwardedRanks;
+  mutable std::vector<Ptr<Packet> > m_forwardedPackets;
+
+protected:
+  virtual uint32_t
+  GetNRanks (void) const
+  {
+    return m_nRanks;
+  }
+
+  virtual uint32_t
+  GetLocalRank (void) const
+  {
+    return m_localRank;
+  }
+
+  virtual void
+  ListenToRank (uint32_t rank, Ptr<NetDevice> localDevice)
+  {
+    m_listenedRanks.push_back (rank);
+  }
+
+  virtual void
+  ForwardToRank (uint32_t rank, Ptr<Packet> packet) const
+  {
+    m_forwardedRanks.push_back (rank);
+    m_forwardedPackets.push_back (packet);
+  }
+
+private:
+  uint32_t m_nRanks;
+  uint32_t m_localRank;
+};
+
+/**
+ * A loss model that removes 30 dB, and records the mobility models of the
+ * senders it is called with.
+ */
+class SenderRecordingLossModel : public PropagationLossModel
+{
+public:
+  mutable std::vector<Ptr<MobilityModel> > m_senders;
+
+private:
+  virtual double
+  DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    m_senders.push_back (a);
+    return txPowerDbm - 30;
+  }
+
+  virtual int64_t
+  DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+};
+
+/**
+ * Create a PHY of an end device, listening at SF12 on 868.1 MHz.
+ */
+static Ptr<SimpleEndDeviceLoraPhy>
+CreatePhyAt (Vector position)
+{
+  Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+  mob->SetPosition (position);
+  phy->SetMobility (mob);
+  phy->SwitchToStandby ();
+  phy->SetSpreadingFactor (12);
+  phy->SetFrequency (868.1);
+  return phy;
+}
+
+/**************************
+ * LoraRemoteTxHeaderTest *
+ **************************/
+
+class LoraRemoteTxHeaderTest : public TestCase
+{
+public:
+  LoraRemoteTxHeaderTest ();
+  virtual ~LoraRemoteTxHeaderTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraRemoteTxHeaderTest::LoraRemoteTxHeaderTest ()
+  : TestCase ("Verify that the LoraRemoteTxHeader survives a round trip")
+{
+}
+
+LoraRemoteTxHeaderTest::~LoraRemoteTxHeaderTest ()
+{
+}
+
+void
+LoraRemoteTxHeaderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraRemoteTxHeaderTest");
+
+  LoraRemoteTxHeader header;
+  header.m_senderNode = 123456;
+  header.m_senderPosition = Vector (-1234.5, 6789.25, 15.125);
+  header.m_txPowerDbm = 13.7;
+  header.m_sf = 11;
+  header.m_duration = NanoSeconds (987654321);
+  header.m_frequencyMHz = 868.3;
+
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 10 + header.GetSerializedSize (),
+                         "Wrong packet size");
+
+  LoraRemoteTxHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 10, "The payload changed");
+  NS_TEST_EXPECT_MSG_EQ (received.m_senderNode, 123456, "Wrong sender node");
+  NS_TEST_EXPECT_MSG_EQ (received.m_senderPosition.x, -1234.5, "Wrong x");
+  NS_TEST_EXPECT_MSG_EQ (received.m_senderPosition.y, 6789.25, "Wrong y");
+  NS_TEST_EXPECT_MSG_EQ (received.m_senderPosition.z, 15.125, "Wrong z");
+  NS_TEST_EXPECT_MSG_EQ (received.m_txPowerDbm, 13.7, "Wrong tx power");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (received.m_sf), 11, "Wrong SF");
+  NS_TEST_EXPECT_MSG_EQ (received.m_duration, NanoSeconds (987654321), "Wrong duration");
+  NS_TEST_EXPECT_MSG_EQ (received.m_frequencyMHz, 868.3, "Wrong frequency");
+}
+
+/*************************
+ * LoraRemoteRegionTest *
+ *************************/
+
+class LoraRemoteRegionTest : public TestCase
+{
+public:
+  LoraRemoteRegionTest ();
+  virtual ~LoraRemoteRegionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraRemoteRegionTest::LoraRemoteRegionTest ()
+  : TestCase ("Verify the strips of the ranks of a LoraRemoteChannel")
+{
+}
+
+LoraRemoteRegionTest::~LoraRemoteRegionTest ()
+{
+}
+
+void
+LoraRemoteRegionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraRemoteRegionTest");
+
+  // Strips [1000, 3000), [3000, 5000), [5000, 7000) and [7000, 9000), the
+  // first and the last ones extending to infinity
+  Ptr<FakeRankChannel> channel =
+    CreateObject<FakeRankChannel> (CreateObject<SenderRecordingLossModel> (),
+                                   CreateObject<ConstantSpeedPropagationDelayModel> (), 4, 0);
+  channel->SetAttribute ("RegionOrigin", DoubleValue (1000));
+  channel->SetAttribute ("RegionWidth", DoubleValue (2000));
+
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (-1e9, 0, 0)), 0, "Far left");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (999, 0, 0)), 0, "Left of the origin");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (1000, 0, 0)), 0, "At the origin");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (2999, 0, 0)), 0, "End of strip 0");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (3000, 1e6, 0)), 1, "Start of strip 1");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (6999, 0, 0)), 2, "End of strip 2");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (7000, 0, 0)), 3, "Start of strip 3");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (9000, 0, 0)), 3, "Right of strip 3");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetRegion (Vector (1e9, 0, 0)), 3, "Far right");
+
+  // Without MPI, there is a single strip
+  Ptr<LoraRemoteChannel> single =
+    CreateObject<LoraRemoteChannel> (CreateObject<SenderRecordingLossModel> (),
+                                     CreateObject<ConstantSpeedPropagationDelayModel> ());
+  NS_TEST_EXPECT_MSG_EQ (single->GetRegion (Vector (-1e9, 0, 0)), 0, "Far left, one rank");
+  NS_TEST_EXPECT_MSG_EQ (single->GetRegion (Vector (1e9, 0, 0)), 0, "Far right, one rank");
+}
+
+/******************************
+ * LoraRemoteRankProxiesTest *
+ ******************************/
+
+class LoraRemoteRankProxiesTest : public TestCase
+{
+public:
+  LoraRemoteRankProxiesTest ();
+  virtual ~LoraRemoteRankProxiesTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraRemoteRankProxiesTest::LoraRemoteRankProxiesTest ()
+  : TestCase ("Verify that only the ranks within range of each other are linked")
+{
+}
+
+LoraRemoteRankProxiesTest::~LoraRemoteRankProxiesTest ()
+{
+}
+
+void
+LoraRemoteRankProxiesTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraRemoteRankProxiesTest");
+
+  // With 10 km strips and a 15 km range, a rank reaches the strips that are
+  // next to it and the ones after those, but not further
+  for (uint32_t localRank = 0; localRank < 5; localRank++)
+    {
+      Ptr<FakeRankChannel> channel =
+        CreateObject<FakeRankChannel> (CreateObject<SenderRecordingLossModel> (),
+                                       CreateObject<ConstantSpeedPropagationDelayModel> (),
+                                       5, localRank);
+      channel->SetAttribute ("RegionWidth", DoubleValue (10000));
+      channel->SetAttribute ("MaxRange", DoubleValue (15000));
+
+      NodeContainer proxies;
+      proxies.Create (5);
+      channel->SetRankProxies (proxies);
+
+      std::vector<uint32_t> expected;
+      for (uint32_t rank = 0; rank < 5; rank++)
+        {
+          if (rank != localRank && (rank + 2 >= localRank && rank <= localRank + 2))
+            {
+              expected.push_back (rank);
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ ((channel->m_listenedRanks == expected), true,
+                             "Wrong links of rank " << localRank);
+
+      // All ranks install the same links
+      for (uint32_t rank = 0; rank < 5; rank++)
+        {
+          uint32_t nLinks = (rank == 0 || rank == 4) ? 2 : (rank == 2 ? 4 : 3);
+          NS_TEST_EXPECT_MSG_EQ (proxies.Get (rank)->GetNDevices (), nLinks,
+                                 "Wrong number of links of proxy " << rank);
+        }
+    }
+
+  Simulator::Destroy ();
+}
+
+/*****************************
+ * LoraRemoteForwardingTest *
+ *****************************/
+
+class LoraRemoteForwardingTest : public TestCase
+{
+public:
+  LoraRemoteForwardingTest ();
+  virtual ~LoraRemoteForwardingTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send a packet from a position of the strip of rank 3 of 5.
+   *
+   * \return The ranks the packet was forwarded to.
+   */
+  std::vector<uint32_t> Forward (double x);
+};
+
+LoraRemoteForwardingTest::LoraRemoteForwardingTest ()
+  : TestCase ("Verify that transmissions are only forwarded to the strips in range")
+{
+}
+
+LoraRemoteForwardingTest::~LoraRemoteForwardingTest ()
+{
+}
+
+std::vector<uint32_t>
+LoraRemoteForwardingTest::Forward (double x)
+{
+  Ptr<FakeRankChannel> channel =
+    CreateObject<FakeRankChannel> (CreateObject<SenderRecordingLossModel> (),
+                                   CreateObject<ConstantSpeedPropagationDelayModel> (), 5, 3);
+  channel->SetAttribute ("RegionWidth", DoubleValue (10000));
+  channel->SetAttribute ("MaxRange", DoubleValue (15000));
+  NodeContainer proxies;
+  proxies.Create (5);
+  channel->SetRankProxies (proxies);
+
+  Ptr<SimpleEndDeviceLoraPhy> sender = CreatePhyAt (Vector (x, 50, 1.5));
+  channel->Add (sender);
+  sender->SetChannel (channel);
+
+  LoraTxParameters txParams;
+  txParams.sf = 9;
+  channel->Send (sender, Create<Packet> (10), 14, txParams, MilliSeconds (200), 868.5);
+
+  // Every forwarded packet carries the transmission
+  for (uint32_t i = 0; i < channel->m_forwardedPackets.size (); i++)
+    {
+      Ptr<Packet> packet = channel->m_forwardedPackets[i]->Copy ();
+      LoraRemoteTxHeader header;
+      packet->RemoveHeader (header);
+      NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 10, "Wrong payload size");
+      NS_TEST_EXPECT_MSG_EQ (header.m_senderPosition.x, x, "Wrong sender position");
+      NS_TEST_EXPECT_MSG_EQ (header.m_txPowerDbm, 14, "Wrong tx power");
+      NS_TEST_EXPECT_MSG_EQ (unsigned (header.m_sf), 9, "Wrong SF");
+      NS_TEST_EXPECT_MSG_EQ (header.m_duration, MilliSeconds (200), "Wrong duration");
+      NS_TEST_EXPECT_MSG_EQ (header.m_frequencyMHz, 868.5, "Wrong frequency");
+    }
+
+  Simulator::Destroy ();
+  return channel->m_forwardedRanks;
+}
+
+void
+LoraRemoteForwardingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraRemoteForwardingTest");
+
+  // Rank 3 holds [30000, 40000), and is linked to ranks 1, 2 and 4: rank 1,
+  // [10000, 20000), is only in range of the left part of the strip, and the
+  // strip of rank 4 extends to infinity
+  std::vector<uint32_t> expected;
+  expected.push_back (1);
+  expected.push_back (2);
+  expected.push_back (4);
+  NS_TEST_EXPECT_MSG_EQ ((Forward (35000) == expected), true,
+                         "Wrong ranks from the range limit of rank 1");
+
+  expected.erase (expected.begin ());
+  NS_TEST_EXPECT_MSG_EQ ((Forward (35001) == expected), true,
+                         "Wrong ranks from beyond the range of rank 1");
+  NS_TEST_EXPECT_MSG_EQ ((Forward (39999) == expected), true,
+                         "Wrong ranks from the right end of the strip");
+}
+
+/*******************************
+ * LoraRemoteReceptionTest *
+ *******************************/
+
+class LoraRemoteReceptionTest : public TestCase
+{
+public:
+  LoraRemoteReceptionTest ();
+  virtual ~LoraRemoteReceptionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+static void
+RecordReception (std::vector<Time> *times, Ptr<const Packet> packet, uint32_t node)
+{
+  times->push_back (Simulator::Now ());
+}
+
+static void
+ReceiveRemoteTx (Ptr<FakeRankChannel> channel, uint32_t senderNode, Vector position)
+{
+  LoraRemoteTxHeader header;
+  header.m_senderNode = senderNode;
+  header.m_senderPosition = position;
+  header.m_txPowerDbm = 14;
+  header.m_sf = 12;
+  header.m_duration = MilliSeconds (100);
+  header.m_frequencyMHz = 868.1;
+
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (header);
+  channel->ReceiveRemote (packet);
+}
+
+LoraRemoteReceptionTest::LoraRemoteReceptionTest ()
+  : TestCase ("Verify that forwarded transmissions reach the local PHYs")
+{
+}
+
+LoraRemoteReceptionTest::~LoraRemoteReceptionTest ()
+{
+}
+
+void
+LoraRemoteReceptionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraRemoteReceptionTest");
+
+  Ptr<SenderRecordingLossModel> loss = CreateObject<SenderRecordingLossModel> ();
+  Ptr<FakeRankChannel> channel =
+    CreateObject<FakeRankChannel> (loss, CreateObject<ConstantSpeedPropagationDelayModel> (),
+                                   2, 1);
+  channel->SetAttribute ("LookAhead", TimeValue (MicroSeconds (10)));
+
+  // The receiver is 1 ms of propagation away from the senders
+  std::vector<Time> times;
+  Ptr<SimpleEndDeviceLoraPhy> receiver = CreatePhyAt (Vector (299792.458, 0, 0));
+  channel->Add (receiver);
+  receiver->SetChannel (channel);
+  receiver->TraceConnectWithoutContext ("ReceivedPacket",
+                                        MakeBoundCallback (&RecordReception, &times));
+
+  Simulator::Schedule (Seconds (1), &ReceiveRemoteTx, channel, 7, Vector (0, 0, 0));
+  Simulator::Schedule (Seconds (2), &ReceiveRemoteTx, channel, 7, Vector (0, 10, 0));
+  Simulator::Schedule (Seconds (3), &ReceiveRemoteTx, channel, 8, Vector (0, 0, 0));
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  // The transmissions started LookAhead before they were received
+  NS_TEST_ASSERT_MSG_EQ (times.size (), 3, "Wrong number of receptions");
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      Time expected = Seconds (i + 1) + MilliSeconds (1) - MicroSeconds (10)
+        + MilliSeconds (100);
+      int64_t error = (times[i] - expected).GetNanoSeconds ();
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (std::abs (error), 1, "Wrong reception time " << i);
+    }
+
+  // Remote senders are stood in for by a mobility model per node, with
+  // building information for the loss models
+  NS_TEST_ASSERT_MSG_EQ (loss->m_senders.size (), 3, "Wrong number of loss computations");
+  NS_TEST_EXPECT_MSG_NE (loss->m_senders[0]->GetObject<MobilityBuildingInfo> (), 0,
+                         "The stand-in has no building information");
+  NS_TEST_EXPECT_MSG_EQ (loss->m_senders[0], loss->m_senders[1],
+                         "The stand-in of a sender was not reused");
+  NS_TEST_EXPECT_MSG_EQ (loss->m_senders[1]->GetPosition ().y, 10,
+                         "The stand-in did not move with the sender");
+  NS_TEST_EXPECT_MSG_NE (loss->m_senders[2], loss->m_senders[0],
+                         "Two senders shared a stand-in");
+
+  Simulator::Destroy ();
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+class LoraRemoteChannelTestSuite : public TestSuite
+{
+public:
+  LoraRemoteChannelTestSuite ();
+};
+
+LoraRemoteChannelTestSuite::LoraRemoteChannelTestSuite ()
+  : TestSuite ("lora-remote-channel", UNIT)
+{
+  LogComponentEnable ("LoraRemoteChannelTestSuite", LOG_LEVEL_DEBUG);
+  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+  AddTestCase (new LoraRemoteTxHeaderTest, TestCase::QUICK);
+  AddTestCase (new LoraRemoteRegionTest, TestCase::QUICK);
+  AddTestCase (new LoraRemoteRankProxiesTest, TestCase::QUICK);
+  AddTestCase (new LoraRemoteForwardingTest, TestCase::QUICK);
+  AddTestCase (new LoraRemoteReceptionTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+static LoraRemoteChannelTestSuite loraRemoteChannelTestSuite;
@@ -8,6 +8,32 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/integer.h"
+#include "ns3/config.h"
+#include "ns3/building.h"
+#include "ns3/building-list.h"
+#include "ns3/periodic-sender.h"
+#include "ns3/lora-airtime.h"
+#include "ns3/enum.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/lazy-basic-energy-source.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/lora-object-pool.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-output-writer.h"
+#include "ns3/lora-metrics-collector.h"
+#include "ns3/lora-log.h"
+#include "ns3/lora-mac-timer.h"
+#include "ns3/building-rtree.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/lora-pcap-capture.h"
+#include "ns3/class-a-end-device-lorawan-mac-bandit.h"
+#include "utilities.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -848,6 +874,32 @@ LogicalLoraChannelTest::DoRun (void)
                          "Waiting time affects other subbands");
   NS_TEST_EXPECT_MSG_EQ (channelHelper->GetWaitingTime (channel5), Time (0),
                          "Waiting time affects other subbands");
+
+  // Channel selection
+  ////////////////////
+
+  // Only the channels of the free SubBand can be picked
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetRandomAvailableChannel (0), channel4,
+                         "Picked a channel that is blocked by duty cycle");
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetRandomAvailableChannel (0.99), channel5,
+                         "Picked a channel that is blocked by duty cycle");
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetMinimumWaitingTime (), Time (0),
+                         "Minimum waiting time doesn't behave as expected");
+
+  // Disabled channels are never picked
+  channel4->DisableForUplink ();
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetRandomAvailableChannel (0), channel5,
+                         "Picked a channel that is disabled");
+  channel5->DisableForUplink ();
+  NS_TEST_EXPECT_MSG_EQ ((PeekPointer (channelHelper->GetRandomAvailableChannel (0)) == 0), true,
+                         "Picked a channel while none is available");
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetMinimumWaitingTime (), expectedTimeOff,
+                         "Minimum waiting time doesn't behave as expected");
+
+  // Replaced channels are taken into account
+  channelHelper->SetChannel (4, CreateObject<LogicalLoraChannel> (869.2));
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetRandomAvailableChannel (0.5)->GetFrequency (),
+                         869.2, "A replaced channel is not picked");
 }
 
 /*****************
@@ -958,6 +1010,35 @@ TimeOnAirTest::DoRun (void)
   txParams.codingRate = 1;
   duration = LoraPhy::GetOnAirTime (packet, txParams);
   NS_TEST_EXPECT_MSG_EQ_TOL (duration.GetSeconds (), 2.301952, 0.0001, "Unexpected duration");
+
+  // The precomputed table matches the closed-form formula
+  for (uint8_t sf = 6; sf <= 12; sf++)
+    {
+      for (int options = 0; options < 8; options++)
+        {
+          for (uint32_t pl = 0; pl <= LoraAirtime::MAX_TABLE_PAYLOAD + 1; pl++)
+            {
+              for (uint8_t cr = 1; cr <= 4; cr++)
+                {
+                  bool h = options & 4;
+                  bool crc = options & 2;
+                  bool de = options & 1;
+                  NS_TEST_ASSERT_MSG_EQ (LoraAirtime::GetPayloadSymbols (sf, pl, cr, h, crc, de),
+                                         LoraAirtime::ComputePayloadSymbols (sf, pl, cr, h, crc,
+                                                                             de),
+                                         "Table and formula differ");
+                }
+            }
+        }
+    }
+
+  // The time on air ratios match the ones that used to be hand-copied
+  const double expectedRatios[] = {1, 1.8, 4.0, 7.3, 13.6, 25.2};
+  constexpr std::array<double, 6> ratios = LoraAirtime::GetOnAirTimeRatios (32);
+  for (int dr = 0; dr < 6; dr++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (ratios[dr], expectedRatios[dr], 0.1, "Unexpected ratio");
+    }
 }
 
 /**************************
@@ -1361,6 +1442,1839 @@ PhyConnectivityTest::DoRun (void)
                          "State didn't switch to STANDBY as expected");
 }
 
+/**********************
+ * ParallelChannelTest *
+ **********************/
+
+class ParallelChannelTest : public TestCase
+{
+public:
+  ParallelChannelTest ();
+  virtual ~ParallelChannelTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send a packet from the first of a line of PHYs, and return what happened
+   * at each of them (0: nothing, 1: received, 2: under sensitivity).
+   */
+  std::vector<int> RunScenario (uint32_t workerThreads);
+};
+
+static void
+RecordOutcome (std::vector<int> *outcomes, int outcome, uint32_t index,
+               Ptr<const Packet> packet, uint32_t node)
+{
+  (*outcomes)[index] = outcome;
+}
+
+ParallelChannelTest::ParallelChannelTest ()
+    : TestCase ("Verify that the parallel LoraChannel fan-out gives the same "
+                "results as the sequential one")
+{
+}
+
+ParallelChannelTest::~ParallelChannelTest ()
+{
+}
+
+std::vector<int>
+ParallelChannelTest::RunScenario (uint32_t workerThreads)
+{
+  int nPhys = 40;
+  std::vector<int> outcomes (nPhys, 0);
+
+  // A position-only loss, that can run in parallel, followed by a random one
+  // that has to be evaluated sequentially
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Min", DoubleValue (0.0));
+  x->SetAttribute ("Max", DoubleValue (10.0));
+  Ptr<RandomPropagationLossModel> randomLoss = CreateObject<RandomPropagationLossModel> ();
+  randomLoss->SetAttribute ("Variable", PointerValue (x));
+  randomLoss->AssignStreams (0);
+  loss->SetNext (randomLoss);
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+  channel->SetAttribute ("WorkerThreads", UintegerValue (workerThreads));
+  channel->SetAttribute ("ParallelThreshold", UintegerValue (1));
+
+  std::vector<Ptr<SimpleEndDeviceLoraPhy> > phys;
+  for (int i = 0; i < nPhys; i++)
+    {
+      Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy> ();
+      Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+      mob->SetPosition (Vector (250.0 * i, 0.0, 0.0));
+      phy->SetMobility (mob);
+      phy->SwitchToStandby ();
+      phy->SetSpreadingFactor (12);
+      phy->SetFrequency (868.1);
+      channel->Add (phy);
+      phy->SetChannel (channel);
+
+      phy->TraceConnectWithoutContext ("ReceivedPacket",
+                                       MakeBoundCallback (&RecordOutcome, &outcomes, 1, i));
+      phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
+                                       MakeBoundCallback (&RecordOutcome, &outcomes, 2, i));
+      phys.push_back (phy);
+    }
+
+  LoraTxParameters txParams;
+  txParams.sf = 12;
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, phys[0],
+                       Create<Packet> (10), txParams, 868.1, 14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return outcomes;
+}
+
+void
+ParallelChannelTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ParallelChannelTest");
+
+  std::vector<int> sequential = RunScenario (0);
+  std::vector<int> parallel = RunScenario (3);
+
+  int received = 0;
+  int underSensitivity = 0;
+  for (std::size_t i = 1; i < sequential.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (parallel[i], sequential[i],
+                             "Outcome at PHY " << i << " differs");
+      received += (sequential[i] == 1);
+      underSensitivity += (sequential[i] == 2);
+    }
+
+  // Make sure both outcomes were exercised
+  NS_TEST_EXPECT_MSG_GT (received, 0, "No PHY received the packet");
+  NS_TEST_EXPECT_MSG_GT (underSensitivity, 0, "No PHY was under sensitivity");
+
+  // Replacing the mobility model of a PHY after the first Send must not leave
+  // the parallel fan-out with the old one
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<LoraChannel> channel =
+    CreateObject<LoraChannel> (loss, CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetAttribute ("WorkerThreads", UintegerValue (2));
+  channel->SetAttribute ("ParallelThreshold", UintegerValue (1));
+
+  int nPhys = 3;
+  std::vector<int> outcomes (nPhys, 0);
+  std::vector<Ptr<SimpleEndDeviceLoraPhy> > phys;
+  for (int i = 0; i < nPhys; i++)
+    {
+      Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy> ();
+      Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+      mob->SetPosition (Vector (i > 0 ? 250.0 : 0.0, 0.0, 0.0));
+      phy->SetMobility (mob);
+      phy->SwitchToStandby ();
+      phy->SetSpreadingFactor (12);
+      phy->SetFrequency (868.1);
+      channel->Add (phy);
+      phy->SetChannel (channel);
+
+      phy->TraceConnectWithoutContext ("ReceivedPacket",
+                                       MakeBoundCallback (&RecordOutcome, &outcomes, 1, i));
+      phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
+                                       MakeBoundCallback (&RecordOutcome, &outcomes, 2, i));
+      phys.push_back (phy);
+    }
+
+  LoraTxParameters txParams;
+  txParams.sf = 12;
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, phys[0],
+                       Create<Packet> (10), txParams, 868.1, 14);
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (outcomes[1], 1, "The first packet was not received");
+
+  Ptr<ConstantPositionMobilityModel> farAway = CreateObject<ConstantPositionMobilityModel> ();
+  farAway->SetPosition (Vector (100000.0, 0.0, 0.0));
+  phys[1]->SetMobility (farAway);
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, phys[0],
+                       Create<Packet> (10), txParams, 868.1, 14);
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (outcomes[1], 2, "The packet reached the old position of the PHY");
+  NS_TEST_EXPECT_MSG_EQ (outcomes[2], 1, "The PHY that did not move lost the packet");
+
+  Simulator::Destroy ();
+}
+
+/************************
+ * TopologySnapshotTest *
+ ************************/
+
+class TopologySnapshotTest : public TestCase
+{
+public:
+  TopologySnapshotTest ();
+  virtual ~TopologySnapshotTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TopologySnapshotTest::TopologySnapshotTest ()
+    : TestCase ("Verify that topology snapshots are written and loaded back correctly")
+{
+}
+
+TopologySnapshotTest::~TopologySnapshotTest ()
+{
+}
+
+void
+TopologySnapshotTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TopologySnapshotTest");
+
+  NetworkComponents components = InitializeNetwork (5, 2);
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+
+  for (uint32_t i = 0; i < gateways.GetN (); i++)
+    {
+      gateways.Get (i)->GetObject<MobilityModel> ()->SetPosition (Vector (3000.0 * i, 0, 15));
+    }
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      endDevices.Get (i)->GetObject<MobilityModel> ()->SetPosition (Vector (1000.0 * i, 50, 1.2));
+      GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (i))->SetDataRate (i);
+    }
+
+  uint32_t nBuildings = BuildingList::GetNBuildings ();
+  Ptr<Building> building = CreateObject<Building> ();
+  building->SetBoundaries (Box (-10, 10, 40, 60, 0, 6));
+  building->SetNFloors (2);
+  building->SetNRoomsX (3);
+
+  LoraHelper helper;
+  std::string filename = CreateTempDirFilename ("topology.bin");
+  NS_TEST_ASSERT_MSG_EQ (helper.WriteTopologySnapshot (filename, endDevices, gateways,
+                                                       components.channel),
+                         true, "Could not write the snapshot");
+
+  // Mess up the topology, and load it back
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      endDevices.Get (i)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+      GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (i))->SetDataRate (5);
+    }
+  Ptr<LoraTopologySnapshot> snapshot = helper.LoadTopologySnapshot (filename, endDevices,
+                                                                    gateways);
+  NS_TEST_ASSERT_MSG_NE (snapshot, 0, "Could not load the snapshot");
+
+  NS_TEST_EXPECT_MSG_EQ (snapshot->GetNBuildings (), nBuildings + 1, "Wrong number of buildings");
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Vector position = endDevices.Get (i)->GetObject<MobilityModel> ()->GetPosition ();
+      NS_TEST_EXPECT_MSG_EQ (position.x, 1000.0 * i, "Wrong position for end device " << i);
+      NS_TEST_EXPECT_MSG_EQ (position.z, 1.2, "Wrong position for end device " << i);
+      NS_TEST_EXPECT_MSG_EQ (unsigned (GetMacLayerFromNode<EndDeviceLorawanMac>
+                                       (endDevices.Get (i))->GetDataRate ()),
+                             i, "Wrong data rate for end device " << i);
+
+      for (uint32_t j = 0; j < gateways.GetN (); j++)
+        {
+          double rxPower = components.channel->GetRxPower
+            (14, endDevices.Get (i)->GetObject<MobilityModel> (),
+            gateways.Get (j)->GetObject<MobilityModel> ());
+          NS_TEST_EXPECT_MSG_EQ_TOL (14 - snapshot->GetPathLoss (i, j), rxPower, 0.001,
+                                     "Wrong path loss");
+        }
+    }
+
+  // The precomputed path losses give the same data rates as the channel
+  std::vector<int> fromChannel =
+    LorawanMacHelper::SetSpreadingFactorsUp (endDevices, gateways, components.channel);
+  std::vector<int> fromSnapshot = LorawanMacHelper::SetSpreadingFactorsUp (endDevices, snapshot);
+  for (std::size_t k = 0; k < fromChannel.size (); k++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (fromSnapshot[k], fromChannel[k], "Different data rates");
+    }
+
+  // A snapshot of another topology is rejected
+  NodeContainer fewerDevices (endDevices.Get (0));
+  NS_TEST_EXPECT_MSG_EQ (helper.LoadTopologySnapshot (filename, fewerDevices, gateways), 0,
+                         "Loaded a snapshot with the wrong number of nodes");
+
+  // Without gateways, all devices are out of range
+  NodeContainer noGateways;
+  std::string noGatewaysFilename = CreateTempDirFilename ("topology-no-gateways.bin");
+  NS_TEST_ASSERT_MSG_EQ (helper.WriteTopologySnapshot (noGatewaysFilename, endDevices, noGateways,
+                                                       components.channel),
+                         true, "Could not write the snapshot without gateways");
+  snapshot = helper.LoadTopologySnapshot (noGatewaysFilename, endDevices, noGateways);
+  NS_TEST_ASSERT_MSG_NE (snapshot, 0, "Could not load the snapshot without gateways");
+  fromSnapshot = LorawanMacHelper::SetSpreadingFactorsUp (endDevices, snapshot);
+  NS_TEST_EXPECT_MSG_EQ (fromSnapshot[6], int (endDevices.GetN ()),
+                         "Devices in range without gateways");
+
+  Simulator::Destroy ();
+}
+
+/**********************
+ * PeriodicSenderTest *
+ **********************/
+
+class PeriodicSenderTest : public TestCase
+{
+public:
+  PeriodicSenderTest ();
+  virtual ~PeriodicSenderTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Let a SF12 device with a short sending interval run into its duty cycle,
+   * and count the packets postponed by the application and by the MAC, and
+   * the actual transmissions. The application stops at 600 s, and the
+   * simulation at 700 s.
+   */
+  void RunScenario (bool dutyCycleAware, uint32_t *appPostponed,
+                    uint32_t *macPostponed, uint32_t *transmissions,
+                    Time *lastTransmission);
+};
+
+static void
+CountPostponed (uint32_t *counter, Ptr<const Packet> packet, Time delay)
+{
+  (*counter)++;
+}
+
+static void
+CountTransmissions (uint32_t *counter, Time *last, Ptr<const Packet> packet, uint32_t index)
+{
+  (*counter)++;
+  *last = Simulator::Now ();
+}
+
+PeriodicSenderTest::PeriodicSenderTest ()
+    : TestCase ("Verify that PeriodicSender hands packets to the MAC only when "
+                "the duty cycle allows it")
+{
+}
+
+PeriodicSenderTest::~PeriodicSenderTest ()
+{
+}
+
+void
+PeriodicSenderTest::RunScenario (bool dutyCycleAware, uint32_t *appPostponed,
+                                 uint32_t *macPostponed, uint32_t *transmissions,
+                                 Time *lastTransmission)
+{
+  NetworkComponents components = InitializeNetwork (1, 1);
+  Ptr<Node> node = components.endDevices.Get (0);
+  Ptr<EndDeviceLorawanMac> mac = GetMacLayerFromNode<EndDeviceLorawanMac> (node);
+  mac->SetDataRate (0);
+  mac->TraceConnectWithoutContext ("PostponedTransmission",
+                                   MakeBoundCallback (&CountPostponed, macPostponed));
+  node->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ()->TraceConnectWithoutContext
+    ("StartSending", MakeBoundCallback (&CountTransmissions, transmissions,
+                                                  lastTransmission));
+
+  Ptr<PeriodicSender> app = CreateObject<PeriodicSender> ();
+  app->SetInterval (Seconds (10));
+  app->SetAttribute ("DutyCycleAware", BooleanValue (dutyCycleAware));
+  app->TraceConnectWithoutContext ("PostponedPacket",
+                                   MakeBoundCallback (&CountPostponed, appPostponed));
+  node->AddApplication (app);
+  app->SetStartTime (Seconds (0));
+  app->SetStopTime (Seconds (600));
+
+  Simulator::Stop (Seconds (700));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (app->GetNPostponedPackets (), *appPostponed,
+                         "The counter and the trace disagree");
+
+  Simulator::Destroy ();
+}
+
+void
+PeriodicSenderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PeriodicSenderTest");
+
+  uint32_t appPostponed = 0;
+  uint32_t macPostponed = 0;
+  uint32_t transmissions = 0;
+  Time lastTransmission;
+  RunScenario (true, &appPostponed, &macPostponed, &transmissions, &lastTransmission);
+
+  // The application waits for the duty cycle, the MAC never has to
+  NS_TEST_EXPECT_MSG_GT (appPostponed, 0, "No packet was postponed");
+  NS_TEST_EXPECT_MSG_EQ (macPostponed, 0, "The MAC had to postpone a packet");
+  NS_TEST_EXPECT_MSG_GT (transmissions, 1, "Too few transmissions");
+  // A packet still waiting when the application stops is dropped
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (lastTransmission, Seconds (600),
+                               "The application sent a packet after it stopped");
+
+  // Without the handshake, the MAC postpones them instead, and still sends
+  // the one it holds after the application stopped
+  uint32_t legacyAppPostponed = 0;
+  uint32_t legacyMacPostponed = 0;
+  uint32_t legacyTransmissions = 0;
+  Time legacyLastTransmission;
+  RunScenario (false, &legacyAppPostponed, &legacyMacPostponed, &legacyTransmissions,
+               &legacyLastTransmission);
+
+  NS_TEST_EXPECT_MSG_EQ (legacyAppPostponed, 0, "The application postponed a packet");
+  NS_TEST_EXPECT_MSG_GT (legacyMacPostponed, 0, "The MAC didn't postpone any packet");
+  uint32_t legacyTransmissionsWhileRunning = legacyTransmissions;
+  if (legacyLastTransmission > Seconds (600))
+    {
+      legacyTransmissionsWhileRunning--;
+    }
+  NS_TEST_EXPECT_MSG_EQ (legacyTransmissionsWhileRunning, transmissions,
+                         "Different number of transmissions");
+}
+
+/****************
+ * TxEnergyTest *
+ ****************/
+
+class TxEnergyTest : public TestCase
+{
+public:
+  TxEnergyTest ();
+  virtual ~TxEnergyTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+static void
+RecordTxEnergy (uint8_t *dataRate, double *energy, uint8_t txDataRate, double txEnergy)
+{
+  *dataRate = txDataRate;
+  *energy = txEnergy;
+}
+
+static void
+RecordSentPacket (Ptr<const Packet> *sent, Ptr<const Packet> packet, uint32_t index)
+{
+  *sent = packet;
+}
+
+TxEnergyTest::TxEnergyTest ()
+    : TestCase ("Verify the energy of transmissions and the deliveries per "
+                "Joule bandit rewards")
+{
+}
+
+TxEnergyTest::~TxEnergyTest ()
+{
+}
+
+void
+TxEnergyTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TxEnergyTest");
+
+  // Energy of a transmission according to the energy model
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  source->SetSupplyVoltage (3.3);
+  Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+  model->SetEnergySource (source);
+  model->SetTxCurrentA (0.028);
+  NS_TEST_EXPECT_MSG_EQ_TOL (model->GetTxEnergyConsumption (14, Seconds (1)),
+                             0.028 * 3.3, 1e-12, "Wrong energy without tx current model");
+
+  Ptr<LinearLoraTxCurrentModel> linear = CreateObject<LinearLoraTxCurrentModel> ();
+  model->SetTxCurrentModel (linear);
+  NS_TEST_EXPECT_MSG_EQ_TOL (model->GetTxEnergyConsumption (14, Seconds (0.5)),
+                             0.5 * linear->CalcTxCurrent (14) * 3.3, 1e-12,
+                             "Wrong energy with a tx current model");
+  NS_TEST_EXPECT_MSG_GT (model->GetTxEnergyConsumption (14, Seconds (1)),
+                         model->GetTxEnergyConsumption (2, Seconds (1)),
+                         "The energy doesn't grow with the tx power");
+
+  // Energy reported by a bandit end device with an energy model
+  Ptr<LoraChannel> channel = CreateChannel ();
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A_ADR_BANDIT);
+  LoraHelper helper = LoraHelper ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  mobility.Install (endDevices);
+  NetDeviceContainer devices = helper.Install (phyHelper, macHelper, endDevices);
+
+  Ptr<BasicEnergySource> deviceSource = CreateObject<BasicEnergySource> ();
+  deviceSource->SetSupplyVoltage (3.3);
+  deviceSource->SetNode (endDevices.Get (0));
+  EnergySourceContainer sources;
+  sources.Add (deviceSource);
+  endDevices.Get (0)->AggregateObject (CreateObject<EnergySourceContainer> (sources));
+  LoraRadioEnergyModelHelper radioEnergyHelper;
+  radioEnergyHelper.Set ("TxCurrentA", DoubleValue (0.028));
+  radioEnergyHelper.Install (devices, sources);
+
+  Ptr<ClassAEndDeviceLorawanMacBandit> mac =
+    GetMacLayerFromNode<ClassAEndDeviceLorawanMacBandit> (endDevices.Get (0));
+  uint8_t dataRate = 0xff;
+  double energy = 0;
+  Ptr<const Packet> sent = 0;
+  mac->TraceConnectWithoutContext ("TxEnergy",
+                                   MakeBoundCallback (&RecordTxEnergy, &dataRate, &energy));
+  Ptr<LoraPhy> phy = devices.Get (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+  phy->TraceConnectWithoutContext ("StartSending", MakeBoundCallback (&RecordSentPacket, &sent));
+
+  Simulator::Schedule (Seconds (1), &LorawanMac::Send, mac, Create<Packet> (10));
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ ((sent != 0), true, "No packet was sent");
+  LoraTxParameters params;
+  params.sf = mac->GetSfFromDataRate (dataRate);
+  params.bandwidthHz = mac->GetBandwidthFromDataRate (dataRate);
+  Time duration = phy->GetOnAirTime (sent->Copy (), params);
+  NS_TEST_EXPECT_MSG_EQ_TOL (energy, duration.GetSeconds () * 0.028 * 3.3, 1e-12,
+                             "Wrong energy of the transmission");
+
+  Simulator::Destroy ();
+
+  // Deliveries per Joule rewards
+  Ptr<BanditDelayedRewardIntelligence> intelligence =
+    CreateObject<BanditDelayedRewardIntelligence> ();
+  intelligence->UpdateUsedArm (5, 1);
+  intelligence->UpdateUsedArm (5, 2);
+  intelligence->UpdateArmEnergy (5, 0.01);
+  intelligence->UpdateArmEnergy (5, 0.03);
+  NS_TEST_EXPECT_MSG_EQ (intelligence->GetArmWorkedReward (5),
+                         banditConstants::rewardsDefinition[5],
+                         "The static reward changed");
+  intelligence->SetAttribute ("RewardMode",
+                              EnumValue (BanditDelayedRewardIntelligence::DELIVERIES_PER_JOULE));
+  NS_TEST_EXPECT_MSG_EQ_TOL (intelligence->GetArmWorkedReward (5), 2 / 0.04, 1e-9,
+                             "Wrong reward of a delivery");
+  NS_TEST_EXPECT_MSG_EQ (intelligence->GetArmWorkedReward (0), 0,
+                         "Unused arms must not be rewarded");
+  intelligence->CleanArmsStats ();
+  NS_TEST_EXPECT_MSG_EQ (intelligence->GetArmWorkedReward (5), 0,
+                         "The energy was not cleaned");
+}
+
+/*****************************
+ * LazyBasicEnergySourceTest *
+ *****************************/
+
+class LazyBasicEnergySourceTest : public TestCase
+{
+public:
+  LazyBasicEnergySourceTest ();
+  virtual ~LazyBasicEnergySourceTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Let a radio go through a TX-STANDBY-SLEEP cycle every 10 seconds for
+   * 100 seconds, powered by the given source, and record the remaining
+   * energy at the end, the time of the depletion and the number of events.
+   */
+  void RunScenario (Ptr<EnergySource> source, double *remaining,
+                    Time *depletion, uint64_t *events);
+};
+
+static void
+RecordDepletion (Time *depletion)
+{
+  *depletion = Simulator::Now ();
+}
+
+/**
+ * A MapScheduler that counts the events it holds, cancelled ones included,
+ * which Simulator::GetEventCount does not tell.
+ */
+class PendingEventCountingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+  static uint32_t s_nPending; //!< Events of the last scheduler created
+};
+
+uint32_t PendingEventCountingScheduler::s_nPending = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (PendingEventCountingScheduler);
+
+TypeId
+PendingEventCountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PendingEventCountingScheduler")
+    .SetParent<MapScheduler> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<PendingEventCountingScheduler> ();
+  return tid;
+}
+
+void
+PendingEventCountingScheduler::Insert (const Scheduler::Event &ev)
+{
+  MapScheduler::Insert (ev);
+  s_nPending++;
+}
+
+Scheduler::Event
+PendingEventCountingScheduler::RemoveNext (void)
+{
+  s_nPending--;
+  return MapScheduler::RemoveNext ();
+}
+
+void
+PendingEventCountingScheduler::Remove (const Scheduler::Event &ev)
+{
+  s_nPending--;
+  MapScheduler::Remove (ev);
+}
+
+LazyBasicEnergySourceTest::LazyBasicEnergySourceTest ()
+    : TestCase ("Verify that LazyBasicEnergySource gives the same energy as "
+                "BasicEnergySource without periodic updates")
+{
+}
+
+LazyBasicEnergySourceTest::~LazyBasicEnergySourceTest ()
+{
+}
+
+void
+LazyBasicEnergySourceTest::RunScenario (Ptr<EnergySource> source, double *remaining,
+                                        Time *depletion, uint64_t *events)
+{
+  source->SetNode (CreateObject<Node> ());
+  Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+  model->SetSleepCurrentA (0.025);
+  model->SetEnergySource (source);
+  model->SetEnergyDepletionCallback (MakeBoundCallback (&RecordDepletion, depletion));
+  source->AppendDeviceEnergyModel (model);
+  source->Initialize ();
+
+  for (int i = 0; i < 10; i++)
+    {
+      Time start = Seconds (10 * i + 0.5);
+      Simulator::Schedule (start, &LoraRadioEnergyModel::ChangeState, model,
+                           int (EndDeviceLoraPhy::TX));
+      Simulator::Schedule (start + Seconds (1.2), &LoraRadioEnergyModel::ChangeState, model,
+                           int (EndDeviceLoraPhy::STANDBY));
+      Simulator::Schedule (start + Seconds (3), &LoraRadioEnergyModel::ChangeState, model,
+                           int (EndDeviceLoraPhy::SLEEP));
+    }
+
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+  *remaining = source->GetRemainingEnergy ();
+  *events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+}
+
+void
+LazyBasicEnergySourceTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LazyBasicEnergySourceTest");
+
+  Ptr<BasicEnergySource> eager = CreateObject<BasicEnergySource> ();
+  eager->SetInitialEnergy (10);
+  eager->SetSupplyVoltage (3);
+  eager->SetAttribute ("BasicEnergyLowBatteryThreshold", DoubleValue (0.5));
+  eager->SetAttribute ("BasicEnergyHighBatteryThreshold", DoubleValue (0.6));
+  double eagerRemaining = 0;
+  Time eagerDepletion = Seconds (0);
+  uint64_t eagerEvents = 0;
+  RunScenario (eager, &eagerRemaining, &eagerDepletion, &eagerEvents);
+
+  Ptr<LazyBasicEnergySource> lazy = CreateObject<LazyBasicEnergySource> ();
+  lazy->SetInitialEnergy (10);
+  lazy->SetSupplyVoltage (3);
+  lazy->SetAttribute ("LowBatteryThreshold", DoubleValue (0.5));
+  lazy->SetAttribute ("HighBatteryThreshold", DoubleValue (0.6));
+  double lazyRemaining = 0;
+  Time lazyDepletion = Seconds (0);
+  uint64_t lazyEvents = 0;
+  RunScenario (lazy, &lazyRemaining, &lazyDepletion, &lazyEvents);
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (lazyRemaining, eagerRemaining, 1e-6,
+                             "The remaining energy differs");
+  NS_TEST_EXPECT_MSG_GT (eagerDepletion, Seconds (0), "The eager source wasn't depleted");
+  NS_TEST_EXPECT_MSG_GT (lazyDepletion, Seconds (0), "The lazy source wasn't depleted");
+
+  // The eager source notices the depletion at its next periodic update
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (lazyDepletion, eagerDepletion, "Late depletion");
+  NS_TEST_EXPECT_MSG_LT (eagerDepletion - lazyDepletion, Seconds (1), "Early depletion");
+
+  // Both run the 30 state changes, but only the eager one runs ~100 updates
+  NS_TEST_EXPECT_MSG_LT (lazyEvents + 50, eagerEvents, "Too many events");
+
+  // A source that lasts far longer than the simulation, and a radio that
+  // changes state many times: the predictions that were replaced must not
+  // stay in the scheduler
+  PendingEventCountingScheduler::s_nPending = 0;
+  ObjectFactory schedulerFactory;
+  schedulerFactory.SetTypeId (PendingEventCountingScheduler::GetTypeId ());
+  Simulator::SetScheduler (schedulerFactory);
+
+  Ptr<LazyBasicEnergySource> large = CreateObject<LazyBasicEnergySource> ();
+  large->SetInitialEnergy (1e6);
+  large->SetNode (CreateObject<Node> ());
+  Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+  model->SetEnergySource (large);
+  large->AppendDeviceEnergyModel (model);
+  large->Initialize ();
+
+  int states[] = {EndDeviceLoraPhy::TX, EndDeviceLoraPhy::STANDBY, EndDeviceLoraPhy::SLEEP};
+  for (int i = 0; i < 3000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (10 * i + 5), &LoraRadioEnergyModel::ChangeState, model,
+                           states[i % 3]);
+    }
+
+  Simulator::Stop (Seconds (40));
+  Simulator::Run ();
+
+  uint32_t pending = PendingEventCountingScheduler::s_nPending;
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (pending, 1, "Replaced predictions are still scheduled");
+  NS_TEST_EXPECT_MSG_GT (large->GetPredictedThresholdCrossing (), Seconds (40),
+                         "The depletion is not predicted");
+  // Only the state changes, the initialization of the node and the stop
+  // event ran
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount (), uint64_t (3000 + 2),
+                         "Events were scheduled on state changes");
+
+  Simulator::Destroy ();
+}
+
+/***********************
+ * FrameHeaderViewTest *
+ ***********************/
+
+class FrameHeaderViewTest : public TestCase
+{
+public:
+  FrameHeaderViewTest ();
+  virtual ~FrameHeaderViewTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Create an uplink packet carrying a LinkCheckReq and a BanditRewardReq.
+   */
+  Ptr<Packet> CreateUplink (uint16_t fCnt);
+};
+
+FrameHeaderViewTest::FrameHeaderViewTest ()
+  : TestCase ("Verify that headers parsed in place match the deserialized ones")
+{
+}
+
+FrameHeaderViewTest::~FrameHeaderViewTest ()
+{
+}
+
+Ptr<Packet>
+FrameHeaderViewTest::CreateUplink (uint16_t fCnt)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAdr (true);
+  frameHdr.SetFCnt (fCnt);
+  frameHdr.SetAddress (LoraDeviceAddress (12, 3456));
+  frameHdr.AddLinkCheckReq ();
+  frameHdr.AddCommand (Create<BanditRewardReq> (300, 5));
+  packet->AddHeader (frameHdr);
+
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+
+  return packet;
+}
+
+void
+FrameHeaderViewTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FrameHeaderViewTest");
+
+  Ptr<Packet> packet = CreateUplink (513);
+
+  // Fixed fields, parsed in place
+  LoraFrameHeaderView view (packet);
+  NS_TEST_ASSERT_MSG_EQ (view.IsValid (), true, "The view was not parsed");
+  NS_TEST_EXPECT_MSG_EQ ((view.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP), true,
+                         "Wrong MType");
+  NS_TEST_EXPECT_MSG_EQ (view.IsUplink (), true, "Wrong direction");
+  NS_TEST_EXPECT_MSG_EQ ((view.GetAddress () == LoraDeviceAddress (12, 3456)), true,
+                         "Wrong address");
+  NS_TEST_EXPECT_MSG_EQ (view.GetAdr (), true, "Wrong ADR bit");
+  NS_TEST_EXPECT_MSG_EQ (view.GetAck (), false, "Wrong ACK bit");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFCnt (), 513, "Wrong FCnt");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (view.GetFOptsLen ()), 5, "Wrong FOptsLen");
+
+  // Full header, commands included
+  LoraFrameHeader frameHdr = view.GetFrameHeader ();
+  std::list<Ptr<MacCommand> > commands = frameHdr.GetCommands ();
+  NS_TEST_ASSERT_MSG_EQ (commands.size (), 2, "Wrong number of commands");
+  NS_TEST_EXPECT_MSG_EQ (commands.front ()->GetCommandType (), LINK_CHECK_REQ,
+                         "Wrong first command");
+  Ptr<BanditRewardReq> request = DynamicCast<BanditRewardReq> (commands.back ());
+  NS_TEST_ASSERT_MSG_NE (request, 0, "Wrong second command");
+  NS_TEST_EXPECT_MSG_EQ (request->GetFrameCountMax (), 300, "Wrong FCntMax");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (request->GetFrameCountDeltaMin ()), 5,
+                         "Wrong FCntDeltaMin");
+
+  // Another header of the same packet, served from the cache, has its own
+  // commands
+  LoraFrameHeader cachedHdr = LoraFrameHeaderView (packet).GetFrameHeader ();
+  Ptr<BanditRewardReq> cachedRequest =
+    DynamicCast<BanditRewardReq> (cachedHdr.GetCommands ().back ());
+  NS_TEST_ASSERT_MSG_NE (cachedRequest, 0, "Wrong second command of the cached header");
+  NS_TEST_EXPECT_MSG_NE (cachedRequest, request, "The command was shared between copies");
+  NS_TEST_EXPECT_MSG_EQ (cachedRequest->GetFrameCountMax (), 300,
+                         "Wrong FCntMax in the cached header");
+
+  // A header whose commands are never decoded is serialized as it was received
+  Ptr<Packet> copy = packet->Copy ();
+  LorawanMacHeader macHdr;
+  LoraFrameHeader lazyHdr;
+  lazyHdr.SetAsUplink ();
+  copy->RemoveHeader (macHdr);
+  copy->RemoveHeader (lazyHdr);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (lazyHdr.GetFOptsLen ()), 5, "Wrong lazy FOptsLen");
+  copy->AddHeader (lazyHdr);
+  copy->AddHeader (macHdr);
+  uint8_t original[LoraFrameHeaderView::MAX_HEADERS_SIZE];
+  uint8_t reserialized[LoraFrameHeaderView::MAX_HEADERS_SIZE];
+  packet->CopyData (original, LoraFrameHeaderView::MAX_HEADERS_SIZE);
+  copy->CopyData (reserialized, LoraFrameHeaderView::MAX_HEADERS_SIZE);
+  NS_TEST_EXPECT_MSG_EQ (std::memcmp (original, reserialized, 1 + 8 + 5), 0,
+                         "The headers changed after a round trip");
+
+  // Commands with the same content decoded from another packet are distinct
+  LoraFrameHeader otherHdr = LoraFrameHeaderView (CreateUplink (514)).GetFrameHeader ();
+  Ptr<BanditRewardReq> otherRequest =
+    DynamicCast<BanditRewardReq> (otherHdr.GetCommands ().back ());
+  NS_TEST_ASSERT_MSG_NE (otherRequest, 0, "Wrong second command of the other packet");
+  NS_TEST_EXPECT_MSG_NE (otherRequest, request, "The command was shared between packets");
+  NS_TEST_EXPECT_MSG_EQ (otherRequest->GetFrameCountMax (), 300,
+                         "Wrong FCntMax in the other packet");
+
+  // A copy with the same UID and different headers is not served from the cache
+  copy->RemoveHeader (macHdr);
+  copy->RemoveHeader (lazyHdr);
+  lazyHdr.SetFCnt (600);
+  copy->AddHeader (lazyHdr);
+  copy->AddHeader (macHdr);
+  NS_TEST_ASSERT_MSG_EQ (copy->GetUid (), packet->GetUid (), "The UID changed");
+  NS_TEST_EXPECT_MSG_EQ (LoraFrameHeaderView (copy).GetFrameHeader ().GetFCnt (), 600,
+                         "A stale header was returned by the cache");
+  NS_TEST_EXPECT_MSG_EQ (LoraFrameHeaderView (packet).GetFrameHeader ().GetFCnt (), 513,
+                         "A stale header was returned by the cache");
+}
+
+/**********************
+ * LoraObjectPoolTest *
+ **********************/
+
+class LoraObjectPoolTest : public TestCase
+{
+public:
+  LoraObjectPoolTest ();
+  virtual ~LoraObjectPoolTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraObjectPoolTest::LoraObjectPoolTest ()
+  : TestCase ("Verify that pooled objects are allocated, counted and recycled")
+{
+}
+
+LoraObjectPoolTest::~LoraObjectPoolTest ()
+{
+}
+
+void
+LoraObjectPoolTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraObjectPoolTest");
+
+  // Blocks of a pool
+  LoraObjectPool *pool = LoraObjectPool::Get ("LoraObjectPoolTest");
+  NS_TEST_EXPECT_MSG_EQ (pool, LoraObjectPool::Get ("LoraObjectPoolTest"),
+                         "The same name gave a different pool");
+
+  void *small = pool->Allocate (40);
+  void *large = pool->Allocate (4000);
+  NS_TEST_EXPECT_MSG_EQ (pool->GetStatistics ().inUse, 2, "Wrong blocks in use");
+  pool->Deallocate (small, 40);
+  pool->Deallocate (large, 4000);
+  void *reallocated = pool->Allocate (33);
+  pool->Deallocate (reallocated, 33);
+
+  LoraObjectPool::Statistics statistics = pool->GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (statistics.allocations, 3, "Wrong number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (statistics.inUse, 0, "Wrong blocks in use");
+  NS_TEST_EXPECT_MSG_EQ (statistics.peakInUse, 2, "Wrong peak");
+  if (LoraObjectPool::IsEnabled ())
+    {
+      // 33 and 40 bytes are in the same size class
+      NS_TEST_EXPECT_MSG_EQ (reallocated, small, "The freed block was not reused");
+      NS_TEST_EXPECT_MSG_EQ (statistics.reused, 1, "Wrong number of reused blocks");
+      NS_TEST_EXPECT_MSG_EQ (statistics.chunks, 1, "Wrong number of chunks");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (statistics.reused, 0, "Blocks reused without pools");
+    }
+
+  // Create<> and CreateObject<> go through the pools of the pooled classes
+  LoraObjectPool *eventPool = LoraPooledAllocation<LoraInterferenceHelper::Event>::GetPool ();
+  LoraObjectPool *commandPool = LoraPooledAllocation<MacCommand>::GetPool ();
+  uint64_t events = eventPool->GetStatistics ().allocations;
+  uint64_t eventsInUse = eventPool->GetStatistics ().inUse;
+  uint64_t commands = commandPool->GetStatistics ().allocations;
+  uint64_t commandsInUse = commandPool->GetStatistics ().inUse;
+  {
+    Ptr<LoraInterferenceHelper::Event> event =
+      Create<LoraInterferenceHelper::Event> (Seconds (1), -100, 7, Create<Packet> (10), 868.1);
+    Ptr<BanditRewardAns> command = CreateObject<BanditRewardAns> (1, 2, 3, 4, 5, 6);
+    Ptr<LinkCheckReq> otherCommand = Create<LinkCheckReq> ();
+    NS_TEST_EXPECT_MSG_EQ (eventPool->GetStatistics ().inUse, eventsInUse + 1,
+                           "The event was not allocated from its pool");
+    NS_TEST_EXPECT_MSG_EQ (commandPool->GetStatistics ().inUse, commandsInUse + 2,
+                           "The commands were not allocated from their pool");
+    NS_TEST_EXPECT_MSG_EQ (command->GetDataRateStatistics ().at (5), 6,
+                           "The pooled command was not constructed");
+  }
+  NS_TEST_EXPECT_MSG_EQ (eventPool->GetStatistics ().allocations, events + 1,
+                         "Wrong number of event allocations");
+  NS_TEST_EXPECT_MSG_EQ (eventPool->GetStatistics ().inUse, eventsInUse,
+                         "The event was not given back to its pool");
+  NS_TEST_EXPECT_MSG_EQ (commandPool->GetStatistics ().allocations, commands + 2,
+                         "Wrong number of command allocations");
+  NS_TEST_EXPECT_MSG_EQ (commandPool->GetStatistics ().inUse, commandsInUse,
+                         "The commands were not given back to their pool");
+}
+
+/********************
+ * LoraProfilerTest *
+ ********************/
+
+class LoraProfilerTest : public TestCase
+{
+public:
+  LoraProfilerTest ();
+  virtual ~LoraProfilerTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraProfilerTest::LoraProfilerTest ()
+  : TestCase ("Verify the statistics of the hot path profiler")
+{
+}
+
+LoraProfilerTest::~LoraProfilerTest ()
+{
+}
+
+void
+LoraProfilerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraProfilerTest");
+
+  LoraProfilePoint *point = LoraProfiler::GetPoint ("LoraProfilerTest");
+  NS_TEST_EXPECT_MSG_EQ (point, LoraProfiler::GetPoint ("LoraProfilerTest"),
+                         "The same name gave a different point");
+  point->Reset ();
+
+  // Durations of 1 to 1000 ns
+  for (uint64_t duration = 1; duration <= 1000; duration++)
+    {
+      point->Record (duration, duration % 2);
+    }
+  point->Count (10);
+
+  NS_TEST_EXPECT_MSG_EQ (point->GetCalls (), 1010, "Wrong number of calls");
+  NS_TEST_EXPECT_MSG_EQ (point->GetTimedCalls (), 1000, "Wrong number of timed calls");
+  NS_TEST_EXPECT_MSG_EQ (point->GetTotalNs (), 500500, "Wrong total time");
+  NS_TEST_EXPECT_MSG_EQ (point->GetAllocations (), 500, "Wrong number of allocations");
+
+  // Percentiles are the upper bound of a bucket that is at most 25% wide
+  uint64_t p50 = point->GetPercentileNs (50);
+  uint64_t p99 = point->GetPercentileNs (99);
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (p50, 500, "p50 too low");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (p50, 625, "p50 too high");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (p99, 990, "p99 too low");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (p99, 1250, "p99 too high");
+  NS_TEST_EXPECT_MSG_EQ (point->GetPercentileNs (0), 1, "Wrong minimum");
+
+  // The mean only covers the timed calls
+  std::ostringstream meanReport;
+  LoraProfiler::PrintReport (meanReport);
+  NS_TEST_EXPECT_MSG_NE (meanReport.str ().find ("LoraProfilerTest 1010 500500 500 "),
+                         std::string::npos, "Wrong mean in the report");
+
+  // Scopes record one call, and the allocations made in them if profiling is
+  // compiled in
+  point->Reset ();
+  {
+    LoraProfileScope scope (point);
+    std::vector<int> *allocated = new std::vector<int> (100);
+    delete allocated;
+  }
+  NS_TEST_EXPECT_MSG_EQ (point->GetCalls (), 1, "The scope was not recorded");
+  NS_TEST_EXPECT_MSG_EQ (point->GetAllocations (), (LoraProfiler::IsEnabled () ? 2 : 0),
+                         "Wrong number of allocations in the scope");
+
+  std::ostringstream report;
+  LoraProfiler::PrintReport (report);
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("LoraProfilerTest 1 "), std::string::npos,
+                         "The point is not in the report");
+}
+
+/************************
+ * LoraOutputWriterTest *
+ ************************/
+
+class LoraOutputWriterTest : public TestCase
+{
+public:
+  LoraOutputWriterTest ();
+  virtual ~LoraOutputWriterTest ();
+
+private:
+  virtual void DoRun (void);
+
+  void WriteRows (std::string filename, LoraOutputWriter::Format format, bool append,
+                  bool backgroundThread, uint32_t nRows);
+  std::string ReadFile (std::string filename);
+};
+
+LoraOutputWriterTest::LoraOutputWriterTest ()
+  : TestCase ("Verify the encoding of the files of the LoraHelper printers")
+{
+}
+
+LoraOutputWriterTest::~LoraOutputWriterTest ()
+{
+}
+
+void
+LoraOutputWriterTest::WriteRows (std::string filename, LoraOutputWriter::Format format,
+                                 bool append, bool backgroundThread, uint32_t nRows)
+{
+  std::vector<LoraOutputColumn> columns;
+  columns.push_back (LoraOutputColumn ("time", LoraOutputColumn::DOUBLE));
+  columns.push_back (LoraOutputColumn ("nodeId", LoraOutputColumn::UINT32));
+  columns.push_back (LoraOutputColumn ("dr", LoraOutputColumn::INT32));
+
+  LoraOutputWriter writer (filename, LoraOutputWriter::CreateEncoder (format), columns,
+                           append, backgroundThread);
+  NS_TEST_ASSERT_MSG_EQ (writer.IsOpen (), true, "Could not open " << filename);
+  for (uint32_t i = 0; i < nRows; i++)
+    {
+      writer.Add (0.5 * i);
+      writer.Add (i);
+      writer.Add (int (i % 7) - 1);
+      writer.EndRow ();
+    }
+  writer.Close ();
+}
+
+std::string
+LoraOutputWriterTest::ReadFile (std::string filename)
+{
+  std::ifstream file (filename.c_str (), std::ifstream::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  return contents.str ();
+}
+
+void
+LoraOutputWriterTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraOutputWriterTest");
+
+  // Text, as the printers always wrote it, and appended to without header
+  std::string text = CreateTempDirFilename ("output.txt");
+  WriteRows (text, LoraOutputWriter::TEXT, false, false, 3);
+  NS_TEST_EXPECT_MSG_EQ (ReadFile (text), "0 0 -1\n0.5 1 0\n1 2 1\n", "Wrong text");
+  WriteRows (text, LoraOutputWriter::TEXT, true, false, 1);
+  NS_TEST_EXPECT_MSG_EQ (ReadFile (text), "0 0 -1\n0.5 1 0\n1 2 1\n0 0 -1\n",
+                         "Wrong appended text");
+
+  // CSV, whose header is only written once
+  std::string csv = CreateTempDirFilename ("output.csv");
+  WriteRows (csv, LoraOutputWriter::CSV, true, false, 2);
+  WriteRows (csv, LoraOutputWriter::CSV, true, false, 1);
+  NS_TEST_EXPECT_MSG_EQ (ReadFile (csv), "time,nodeId,dr\n0,0,-1\n0.5,1,0\n0,0,-1\n",
+                         "Wrong CSV");
+
+  // Binary, with more rows than fit in a block, is the same when it is
+  // written by a background thread
+  uint32_t nRows = LoraOutputWriter::BLOCK_ROWS + 10;
+  std::string binary = CreateTempDirFilename ("output.bin");
+  std::string threaded = CreateTempDirFilename ("threaded.bin");
+  WriteRows (binary, LoraOutputWriter::BINARY, false, false, nRows);
+  WriteRows (threaded, LoraOutputWriter::BINARY, false, true, nRows);
+  std::string contents = ReadFile (binary);
+  NS_TEST_EXPECT_MSG_EQ ((ReadFile (threaded) == contents), true,
+                         "The background thread wrote a different file");
+
+  // Header: magic, version, number of columns, and the columns
+  NS_TEST_ASSERT_MSG_EQ (std::string (contents.data (), 8), std::string ("LORACOL", 8),
+                         "Wrong magic");
+  const char *position = contents.data () + 8;
+  uint32_t version;
+  uint32_t nColumns;
+  std::memcpy (&version, position, 4);
+  std::memcpy (&nColumns, position + 4, 4);
+  position += 8;
+  NS_TEST_EXPECT_MSG_EQ (version, 1, "Wrong version");
+  NS_TEST_ASSERT_MSG_EQ (nColumns, 3, "Wrong number of columns");
+  const char *names[] = {"time", "nodeId", "dr"};
+  const uint8_t types[] = {LoraOutputColumn::DOUBLE, LoraOutputColumn::UINT32,
+                           LoraOutputColumn::INT32};
+  for (uint32_t c = 0; c < nColumns; c++)
+    {
+      uint16_t length;
+      std::memcpy (&length, position + 1, 2);
+      NS_TEST_EXPECT_MSG_EQ (unsigned (uint8_t (*position)), unsigned (types[c]),
+                             "Wrong type of column " << c);
+      NS_TEST_EXPECT_MSG_EQ (std::string (position + 3, length), names[c],
+                             "Wrong name of column " << c);
+      position += 3 + length;
+    }
+
+  // Blocks, column by column
+  uint32_t row = 0;
+  uint32_t nBlocks = 0;
+  while (position < contents.data () + contents.size ())
+    {
+      uint32_t blockRows;
+      std::memcpy (&blockRows, position, 4);
+      position += 4;
+      for (uint32_t r = 0; r < blockRows; r++)
+        {
+          double time;
+          uint32_t nodeId;
+          int32_t dr;
+          std::memcpy (&time, position + 8 * r, 8);
+          std::memcpy (&nodeId, position + 8 * blockRows + 4 * r, 4);
+          std::memcpy (&dr, position + 12 * blockRows + 4 * r, 4);
+          NS_TEST_EXPECT_MSG_EQ (time, 0.5 * (row + r), "Wrong time in row " << row + r);
+          NS_TEST_EXPECT_MSG_EQ (nodeId, row + r, "Wrong node in row " << row + r);
+          NS_TEST_EXPECT_MSG_EQ (dr, int32_t ((row + r) % 7) - 1, "Wrong dr in row " << row + r);
+        }
+      position += 16 * blockRows;
+      row += blockRows;
+      nBlocks++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (row, nRows, "Wrong number of rows");
+  NS_TEST_EXPECT_MSG_EQ (nBlocks, 2, "Wrong number of blocks");
+}
+
+/**************************
+ * DeviceStatusChangeTest *
+ **************************/
+
+class DeviceStatusChangeTest : public TestCase
+{
+public:
+  DeviceStatusChangeTest ();
+  virtual ~DeviceStatusChangeTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DeviceStatusChangeTest::DeviceStatusChangeTest ()
+  : TestCase ("Verify that the device status is printed at keyframes and when it changes")
+{
+}
+
+DeviceStatusChangeTest::~DeviceStatusChangeTest ()
+{
+}
+
+void
+DeviceStatusChangeTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("DeviceStatusChangeTest");
+
+  NetworkComponents components = InitializeNetwork (2, 1);
+  NodeContainer endDevices = components.endDevices;
+  Ptr<MobilityModel> mobility = endDevices.Get (1)->GetObject<MobilityModel> ();
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 0));
+  mobility->SetPosition (Vector (1000, 0, 0));
+  Ptr<EndDeviceLorawanMac> mac = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0));
+  mac->SetDataRate (0);
+  GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (1))->SetDataRate (0);
+
+  LoraHelper helper;
+  std::string filename = CreateTempDirFilename ("deviceStatusChanges.txt");
+  helper.EnableDeviceStatusChangePrinting (endDevices, filename, Seconds (100));
+
+  // A data rate change, a course change, and a data rate that does not change
+  Simulator::Schedule (Seconds (10), &EndDeviceLorawanMac::SetDataRate, mac, 3);
+  Simulator::Schedule (Seconds (20), &MobilityModel::SetPosition, mobility, Vector (500, 0, 0));
+  Simulator::Schedule (Seconds (30), &EndDeviceLorawanMac::SetDataRate, mac, 3);
+  Simulator::Stop (Seconds (150));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::ostringstream expected;
+  uint32_t first = endDevices.Get (0)->GetId ();
+  uint32_t second = endDevices.Get (1)->GetId ();
+  expected << "0 " << first << " 0 0 0 0 0 0 14\n"
+           << "0 " << second << " 0 1000 0 0 0 0 14\n"
+           << "10 " << first << " 1 0 0 0 0 3 14\n"
+           << "20 " << second << " 2 500 0 0 0 0 14\n"
+           << "100 " << first << " 0 0 0 0 0 3 14\n"
+           << "100 " << second << " 0 500 0 0 0 0 14\n";
+
+  std::ifstream file (filename.c_str ());
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  NS_TEST_EXPECT_MSG_EQ (contents.str (), expected.str (), "Wrong device status changes");
+}
+
+/****************************
+ * LoraMetricsCollectorTest *
+ ****************************/
+
+class LoraMetricsCollectorTest : public TestCase
+{
+public:
+  LoraMetricsCollectorTest ();
+  virtual ~LoraMetricsCollectorTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraMetricsCollectorTest::LoraMetricsCollectorTest ()
+  : TestCase ("Verify the PDR, energy and UNEC computed during the simulation")
+{
+}
+
+LoraMetricsCollectorTest::~LoraMetricsCollectorTest ()
+{
+}
+
+void
+LoraMetricsCollectorTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraMetricsCollectorTest");
+
+  // The first end device is next to the gateway, the second one is too far
+  NetworkComponents components = InitializeNetwork (2, 1);
+  NodeContainer endDevices = components.endDevices;
+  components.gateways.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (0, 0, 15));
+  endDevices.Get (0)->GetObject<MobilityModel> ()->SetPosition (Vector (10, 0, 0));
+  endDevices.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (100000, 0, 0));
+  Ptr<EndDeviceLorawanMac> near = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0));
+  Ptr<EndDeviceLorawanMac> far = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (1));
+  for (Ptr<EndDeviceLorawanMac> mac : {near, far})
+    {
+      mac->SetDataRate (5);
+      mac->SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+    }
+
+  LoraMetricsCollector collector;
+  collector.SetPeriod (Seconds (100));
+  collector.SetWindowPeriods (3);
+  collector.Install (endDevices, components.gateways);
+
+  // Periods ending at 100 s (PDR 0.5), 200 s (PDR 1), 300 s (nothing sent)
+  // and 400 s (PDR 0), and a data rate change during the fourth period
+  Simulator::Schedule (Seconds (10), &LorawanMac::Send, near, Create<Packet> (10));
+  Simulator::Schedule (Seconds (20), &LorawanMac::Send, far, Create<Packet> (10));
+  Simulator::Schedule (Seconds (150), &LorawanMac::Send, near, Create<Packet> (10));
+  Simulator::Schedule (Seconds (350), &EndDeviceLorawanMac::SetDataRate, far, 0);
+  Simulator::Schedule (Seconds (360), &LorawanMac::Send, far, Create<Packet> (10));
+  Simulator::Stop (Seconds (450));
+  Simulator::Run ();
+
+  const std::deque<LoraMetricsCollector::PeriodMetrics> &window = collector.GetWindow ();
+  NS_TEST_ASSERT_MSG_EQ (window.size (), 3, "Wrong number of periods in the window");
+  NS_TEST_EXPECT_MSG_EQ (window[0].time, Seconds (200), "Wrong first period");
+  NS_TEST_EXPECT_MSG_EQ (window[0].sent, 1, "Wrong sent packets");
+  NS_TEST_EXPECT_MSG_EQ (window[0].received, 1, "Wrong received packets");
+  NS_TEST_EXPECT_MSG_EQ (window[1].sent, 0, "Wrong sent packets");
+  NS_TEST_EXPECT_MSG_EQ (window[2].sent, 1, "Wrong sent packets");
+  NS_TEST_EXPECT_MSG_EQ (window[2].received, 0, "Wrong received packets");
+
+  double fast = LoraMetricsCollector::GetTransmissionEnergy (5, 14);
+  double slow = LoraMetricsCollector::GetTransmissionEnergy (0, 14);
+  NS_TEST_EXPECT_MSG_EQ_TOL (fast, std::pow (10, 1.4) * 71.94e-6, 1e-12,
+                             "Wrong energy of a transmission");
+  NS_TEST_EXPECT_MSG_EQ_TOL (window[0].joules, 2 * fast, 1e-12, "Wrong energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (window[2].joules, fast + slow, 1e-12,
+                             "The data rate change was not taken into account");
+
+  // Periods without sent (or delivered) packets have no PDR (or UNEC)
+  LoraMetricsCollector::Statistics pdr = collector.GetPdr ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (pdr.mean, 0.5, 1e-12, "Wrong mean PDR");
+  NS_TEST_EXPECT_MSG_EQ_TOL (pdr.std, 0.5, 1e-12, "Wrong standard deviation of the PDR");
+  LoraMetricsCollector::Statistics joules = collector.GetJoules ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (joules.mean, (5 * fast + slow) / 3, 1e-12, "Wrong mean energy");
+  LoraMetricsCollector::Statistics unec = collector.GetUnec ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (unec.mean, 2 * fast * 1000, 1e-9, "Wrong mean UNEC");
+  NS_TEST_EXPECT_MSG_EQ_TOL (unec.std, 0, 1e-9, "Wrong standard deviation of the UNEC");
+
+  std::string filename = CreateTempDirFilename ("deviceMetrics.csv");
+  collector.WriteDeviceSummary (filename, LoraOutputWriter::CSV);
+  std::ifstream file (filename.c_str ());
+  std::string header;
+  std::string nearLine;
+  std::getline (file, header);
+  std::getline (file, nearLine);
+  std::ostringstream expected;
+  expected << endDevices.Get (0)->GetId () << ",1,1,1,";
+  NS_TEST_EXPECT_MSG_EQ (nearLine.substr (0, expected.str ().size ()), expected.str (),
+                         "Wrong summary of the first end device");
+
+  Simulator::Destroy ();
+}
+
+/***********************
+ * BanditTelemetryTest *
+ ***********************/
+
+class BanditTelemetryTest : public TestCase
+{
+public:
+  BanditTelemetryTest ();
+  virtual ~BanditTelemetryTest ();
+
+  void ArmChosen (uint8_t arm, uint16_t frameCounter);
+  void FeedbackRequested (uint16_t frameCountMax, uint8_t frameCountDeltaMin);
+  void RewardsConsolidated (uint8_t arm, uint32_t sent, uint32_t received, double reward);
+  void ArmPosterior (uint8_t arm, uint32_t pulls, double mean, double std);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<uint8_t> m_arms;
+  uint32_t m_feedbackRequests;
+  std::vector<uint32_t> m_consolidated; //!< Arm, sent and received of each feedback
+  std::vector<double> m_means;
+  std::vector<uint32_t> m_pulls;
+};
+
+BanditTelemetryTest::BanditTelemetryTest ()
+  : TestCase ("Verify the trace sources of the learning of the bandits"),
+    m_feedbackRequests (0)
+{
+}
+
+BanditTelemetryTest::~BanditTelemetryTest ()
+{
+}
+
+void
+BanditTelemetryTest::ArmChosen (uint8_t arm, uint16_t frameCounter)
+{
+  m_arms.push_back (arm);
+}
+
+void
+BanditTelemetryTest::FeedbackRequested (uint16_t frameCountMax, uint8_t frameCountDeltaMin)
+{
+  m_feedbackRequests++;
+}
+
+void
+BanditTelemetryTest::RewardsConsolidated (uint8_t arm, uint32_t sent, uint32_t received,
+                                          double reward)
+{
+  m_consolidated.push_back (arm);
+  m_consolidated.push_back (sent);
+  m_consolidated.push_back (received);
+}
+
+void
+BanditTelemetryTest::ArmPosterior (uint8_t arm, uint32_t pulls, double mean, double std)
+{
+  m_pulls.push_back (pulls);
+  m_means.push_back (mean);
+}
+
+void
+BanditTelemetryTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BanditTelemetryTest");
+
+  // Ask for feedback with every packet
+  Config::SetDefault ("ns3::BanditDelayedRewardIntelligence::FramesForBootstrapping",
+                      IntegerValue (0));
+  Config::SetDefault ("ns3::BanditDelayedRewardIntelligence::FeedbackProbability",
+                      DoubleValue (1));
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A_ADR_BANDIT);
+  LoraHelper helper = LoraHelper ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  mobility.Install (endDevices);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  Ptr<ClassAEndDeviceLorawanMacBandit> mac =
+    GetMacLayerFromNode<ClassAEndDeviceLorawanMacBandit> (endDevices.Get (0));
+  mac->TraceConnectWithoutContext ("ArmChosen",
+                                   MakeCallback (&BanditTelemetryTest::ArmChosen, this));
+  mac->TraceConnectWithoutContext ("FeedbackRequested",
+                                   MakeCallback (&BanditTelemetryTest::FeedbackRequested,
+                                                 this));
+  mac->TraceConnectWithoutContext ("RewardsConsolidated",
+                                   MakeCallback (&BanditTelemetryTest::RewardsConsolidated,
+                                                 this));
+  mac->TraceConnectWithoutContext ("ArmPosterior",
+                                   MakeCallback (&BanditTelemetryTest::ArmPosterior, this));
+  std::string filename = CreateTempDirFilename ("banditTelemetry.bin");
+  helper.EnableBanditTelemetry (endDevices, filename);
+
+  // The packet is received on its arm
+  Simulator::Schedule (Seconds (1), &LorawanMac::Send, mac, Create<Packet> (10));
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_arms.size (), 1, "The chosen arm was not traced");
+  NS_TEST_EXPECT_MSG_EQ (m_feedbackRequests, 1, "The feedback request was not traced");
+  uint8_t arm = m_arms[0];
+  std::vector<uint8_t> received (6, 0);
+  received[arm] = 1;
+  mac->OnBanditRewardAns (Create<BanditRewardAns> (received[0], received[1], received[2],
+                                                   received[3], received[4], received[5]));
+
+  NS_TEST_ASSERT_MSG_EQ (m_consolidated.size (), 3, "Only the arm that was used has feedback");
+  NS_TEST_EXPECT_MSG_EQ (m_consolidated[0], arm, "Wrong arm of the feedback");
+  NS_TEST_EXPECT_MSG_EQ (m_consolidated[1], 1, "Wrong packets sent with the arm");
+  NS_TEST_EXPECT_MSG_EQ (m_consolidated[2], 1, "Wrong packets received with the arm");
+
+  // The arms are bootstrapped with the rewards 0 and 1
+  NS_TEST_ASSERT_MSG_EQ (m_pulls.size (), 6, "The posterior of every arm is traced");
+  for (uint8_t i = 0; i < 6; i++)
+    {
+      uint32_t pulls = (i == arm) ? 3 : 2;
+      NS_TEST_EXPECT_MSG_EQ (m_pulls[i], pulls, "Wrong pulls of an arm");
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_means[arm], (1 + banditConstants::rewardsDefinition[arm]) / 3,
+                             1e-12, "Wrong mean reward of the arm");
+
+  Simulator::Destroy ();
+  Config::Reset ();
+
+  // The sink holds the header, and one block of the four rows
+  std::ifstream file (filename.c_str (), std::ifstream::binary | std::ifstream::ate);
+  uint32_t header = 8 + 4 + 4 + (3 + 4) + (3 + 6) + (3 + 5) + (3 + 3) + 3 * (3 + 6);
+  uint32_t rows = 1 + 1 + 1 + 6;
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) file.tellg (), header + 4 + rows * 26, "Wrong size of the sink");
+}
+
+/**************
+ * LoraLogTest *
+ **************/
+
+class LoraLogTest : public TestCase
+{
+public:
+  LoraLogTest ();
+  virtual ~LoraLogTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LoraLogTest::LoraLogTest ()
+  : TestCase ("Verify the log levels compiled into the lorawan components")
+{
+}
+
+LoraLogTest::~LoraLogTest ()
+{
+}
+
+void
+LoraLogTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraLogTest");
+
+  // The levels are known at compile time
+  static_assert (GetLoraLogLevels ("", "LoraChannel") == LOG_LEVEL_ALL,
+                 "All levels are kept by default");
+  static_assert (GetLoraLogLevels ("warn:LoraChannel=all", "LoraChannel") == LOG_LEVEL_ALL,
+                 "Wrong levels of a component");
+  static_assert (GetLoraLogLevels ("warn:LoraChannel=all", "LoraChannelHelper")
+                 == LOG_LEVEL_WARN, "Wrong default levels");
+  static_assert (GetLoraLogLevels ("LoraPhy=info:none", "LoraPhy") == LOG_LEVEL_INFO,
+                 "Wrong levels of a component before the default");
+
+  // Levels that were not compiled in can not be enabled (components stay
+  // registered until the end of the program)
+  static LoraLogComponent<LOG_LEVEL_WARN> component ("LoraLogTestComponent", __FILE__);
+  component.Enable (LOG_LEVEL_ALL);
+  NS_TEST_EXPECT_MSG_EQ (component.IsEnabled (LOG_WARN), true, "Warnings were not enabled");
+  NS_TEST_EXPECT_MSG_EQ (component.IsEnabled (LOG_DEBUG), false, "Debug was enabled");
+  NS_TEST_EXPECT_MSG_EQ (component.IsEnabled (LOG_FUNCTION), false, "Functions were enabled");
+  component.Disable (LOG_LEVEL_ALL);
+  NS_TEST_EXPECT_MSG_EQ (component.IsEnabled (LOG_WARN), false, "Warnings were not disabled");
+}
+
+/*******************
+ * LoraMacTimerTest *
+ ******************/
+
+class LoraMacTimerTest : public TestCase
+{
+public:
+  LoraMacTimerTest ();
+  virtual ~LoraMacTimerTest ();
+
+  void Expire (void);
+  void Arm (double delay);
+  void Disarm (void);
+  void CheckReferences (uint32_t first, uint32_t second);
+
+private:
+  virtual void DoRun (void);
+
+  LoraMacTimer m_timer;
+  std::vector<double> m_expirations;
+};
+
+LoraMacTimerTest::LoraMacTimerTest ()
+  : TestCase ("Verify that MAC timers can be armed again and cancelled")
+{
+}
+
+LoraMacTimerTest::~LoraMacTimerTest ()
+{
+}
+
+void
+LoraMacTimerTest::Expire (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_timer.IsRunning (), false, "The timer runs while it expires");
+  m_expirations.push_back (Simulator::Now ().GetSeconds ());
+}
+
+void
+LoraMacTimerTest::Arm (double delay)
+{
+  m_timer.Schedule (Seconds (delay));
+}
+
+void
+LoraMacTimerTest::Disarm (void)
+{
+  m_timer.Cancel ();
+}
+
+void
+LoraMacTimerTest::CheckReferences (uint32_t first, uint32_t second)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_timer.GetSlotReferenceCount (0), first,
+                         "Wrong references to the first slot at " << Simulator::Now ().GetSeconds ());
+  if (m_timer.GetNSlots () > 1)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_timer.GetSlotReferenceCount (1), second,
+                             "Wrong references to the second slot at "
+                             << Simulator::Now ().GetSeconds ());
+    }
+}
+
+void
+LoraMacTimerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraMacTimerTest");
+
+  m_timer.SetFunction (&LoraMacTimerTest::Expire, this);
+  NS_TEST_EXPECT_MSG_EQ (m_timer.IsExpired (), true, "A new timer is not expired");
+
+  // Armed again before it expires: only the last expiration is kept, and the
+  // first slot is still in the scheduler
+  Simulator::Schedule (Seconds (0), &LoraMacTimerTest::Arm, this, 10);
+  Simulator::Schedule (Seconds (5), &LoraMacTimerTest::Arm, this, 10);
+  // Cancelled, then armed again once the tombstone was dispatched
+  Simulator::Schedule (Seconds (20), &LoraMacTimerTest::Arm, this, 1);
+  Simulator::Schedule (Seconds (20.5), &LoraMacTimerTest::Disarm, this);
+  Simulator::Schedule (Seconds (30), &LoraMacTimerTest::Arm, this, 1);
+  // Cancelled and armed again at the same time
+  Simulator::Schedule (Seconds (40), &LoraMacTimerTest::Arm, this, 2);
+  Simulator::Schedule (Seconds (41), &LoraMacTimerTest::Disarm, this);
+  Simulator::Schedule (Seconds (41), &LoraMacTimerTest::Arm, this, 1);
+  // The scheduler holds one reference to each pending slot, and releases it
+  // once the slot is dispatched, even if the timer was cancelled
+  Simulator::Schedule (Seconds (1), &LoraMacTimerTest::CheckReferences, this, 2, 0);
+  Simulator::Schedule (Seconds (6), &LoraMacTimerTest::CheckReferences, this, 2, 2);
+  Simulator::Schedule (Seconds (12), &LoraMacTimerTest::CheckReferences, this, 1, 2);
+  Simulator::Schedule (Seconds (20.75), &LoraMacTimerTest::CheckReferences, this, 2, 1);
+  Simulator::Schedule (Seconds (25), &LoraMacTimerTest::CheckReferences, this, 1, 1);
+  Simulator::Schedule (Seconds (41.5), &LoraMacTimerTest::CheckReferences, this, 2, 2);
+  Simulator::Run ();
+
+  CheckReferences (1, 1);
+
+  NS_TEST_ASSERT_MSG_EQ (m_expirations.size (), 3, "Wrong number of expirations");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_expirations[0], 15, 1e-9, "Wrong first expiration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_expirations[1], 31, 1e-9, "Wrong second expiration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_expirations[2], 42, 1e-9, "Wrong third expiration");
+  NS_TEST_EXPECT_MSG_EQ (m_timer.GetTs (), uint64_t (Seconds (42).GetTimeStep ()),
+                         "Wrong time of the last expiration");
+  NS_TEST_EXPECT_MSG_EQ (m_timer.GetNSlots (), 2, "Slots were not reused");
+
+  Simulator::Destroy ();
+}
+
+/********************
+ * BuildingRTreeTest *
+ *******************/
+
+class BuildingRTreeTest : public TestCase
+{
+public:
+  BuildingRTreeTest ();
+  virtual ~BuildingRTreeTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BuildingRTreeTest::BuildingRTreeTest ()
+  : TestCase ("Verify that buildings are found through the R-tree, also for nodes that move")
+{
+}
+
+BuildingRTreeTest::~BuildingRTreeTest ()
+{
+}
+
+void
+BuildingRTreeTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BuildingRTreeTest");
+
+  // A grid of buildings, away from those of other tests
+  for (uint32_t i = 0; i < 23; i++)
+    {
+      for (uint32_t j = 0; j < 17; j++)
+        {
+          Ptr<Building> building = CreateObject<Building> ();
+          double x = 1e5 + 50.0 * i;
+          double y = 50.0 * j;
+          building->SetBoundaries (Box (x, x + 40, y, y + 30 + i % 3, 0, 6 + j % 4));
+        }
+    }
+
+  BuildingRTree tree;
+  NS_TEST_EXPECT_MSG_EQ (tree.IsUpToDate (), false, "An empty tree is up to date");
+  tree.Build ();
+  NS_TEST_EXPECT_MSG_EQ (tree.IsUpToDate (), true, "The tree is not up to date");
+  NS_TEST_EXPECT_MSG_EQ (tree.GetNBuildings (), BuildingList::GetNBuildings (),
+                         "Wrong number of buildings");
+
+  // The same building as a scan of all of them
+  for (double x = 1e5 - 20; x < 1e5 + 1200; x += 13.7)
+    {
+      for (double y = -20; y < 880; y += 11.9)
+        {
+          Vector position (x, y, 5.5);
+          Ptr<Building> expected;
+          for (BuildingList::Iterator it = BuildingList::Begin (); it != BuildingList::End (); ++it)
+            {
+              if ((*it)->IsInside (position))
+                {
+                  expected = *it;
+                }
+            }
+          NS_TEST_EXPECT_MSG_EQ (tree.FindBuilding (position), expected,
+                                 "Wrong building at " << position);
+        }
+    }
+
+  // A node that walks into a building, without building information
+  Ptr<MobilityModel> outside = CreateObject<ConstantPositionMobilityModel> ();
+  outside->SetPosition (Vector (1e5 - 100, 0, 1));
+  Ptr<MobilityModel> walker = CreateObject<ConstantPositionMobilityModel> ();
+  walker->SetPosition (Vector (1e5 - 50, 0, 1));
+  Ptr<BuildingPenetrationLoss> loss = CreateObject<BuildingPenetrationLoss> ();
+  NS_TEST_EXPECT_MSG_EQ (loss->CalcRxPower (14, outside, walker), 14,
+                         "Loss between two outdoor nodes");
+  walker->SetPosition (Vector (1e5 + 10, 10, 1));
+  NS_TEST_EXPECT_MSG_LT (loss->CalcRxPower (14, outside, walker), 14,
+                         "No loss for an indoor node");
+  Ptr<Building> added = CreateObject<Building> ();
+  added->SetBoundaries (Box (1e5 - 110, 1e5 - 90, -10, 10, 0, 3));
+  outside->SetPosition (Vector (1e5 - 100, 1, 1));
+  double rxPowerDbm;
+  loss->CalcRxPowerBatch (14, walker, &outside, 1, &rxPowerDbm);
+  NS_TEST_EXPECT_MSG_LT (rxPowerDbm, 14, "No loss between two buildings");
+  walker->SetPosition (Vector (1e5 - 100, 5, 1));
+  NS_TEST_EXPECT_MSG_LT (loss->CalcRxPower (14, outside, walker), 14,
+                         "No loss in the same building");
+
+  Simulator::Destroy ();
+}
+
+/**********************
+ * LoraPcapCaptureTest *
+ *********************/
+
+class LoraPcapCaptureTest : public TestCase
+{
+public:
+  LoraPcapCaptureTest ();
+  virtual ~LoraPcapCaptureTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Create a capture, and make it capture a 100 bytes packet every second
+   * for 10 seconds.
+   */
+  Ptr<LoraPcapCapture> CreateCapture (std::string name);
+
+  /**
+   * Read a pcap file, and check the lengths of its records.
+   * \return The number of records.
+   */
+  uint32_t CheckFile (std::string filename, uint32_t inclLen);
+};
+
+LoraPcapCaptureTest::LoraPcapCaptureTest ()
+  : TestCase ("Verify that pcap captures are rotated, truncated and dumped on triggers")
+{
+}
+
+LoraPcapCaptureTest::~LoraPcapCaptureTest ()
+{
+}
+
+Ptr<LoraPcapCapture>
+LoraPcapCaptureTest::CreateCapture (std::string name)
+{
+  Ptr<LoraPcapCapture> capture = CreateObject<LoraPcapCapture> ();
+  capture->SetPrefix (CreateTempDirFilename (name));
+  capture->SetAttribute ("SnapLength", UintegerValue (20));
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (i), &LoraPcapCapture::Write, capture,
+                           Ptr<const Packet> (Create<Packet> (100)));
+    }
+  return capture;
+}
+
+uint32_t
+LoraPcapCaptureTest::CheckFile (std::string filename, uint32_t inclLen)
+{
+  PcapFile file;
+  file.Open (filename, std::ios::in);
+  NS_TEST_EXPECT_MSG_EQ (file.Fail (), false, "Could not open " << filename);
+  NS_TEST_EXPECT_MSG_EQ (file.GetDataLinkType (), uint32_t (PcapHelper::DLT_LORATAP),
+                         "Wrong link type in " << filename);
+
+  uint8_t data[128];
+  uint32_t nRecords = 0;
+  while (true)
+    {
+      uint32_t tsSec, tsUsec, recordInclLen, origLen, readLen;
+      file.Read (data, sizeof (data), tsSec, tsUsec, recordInclLen, origLen, readLen);
+      if (file.Eof () || file.Fail ())
+        {
+          break;
+        }
+      NS_TEST_EXPECT_MSG_EQ (recordInclLen, inclLen, "Wrong included length");
+      NS_TEST_EXPECT_MSG_EQ (origLen, 100, "Wrong original length");
+      nRecords++;
+    }
+  return nRecords;
+}
+
+void
+LoraPcapCaptureTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LoraPcapCaptureTest");
+
+  // Three packets per file, of which the last two are kept
+  Ptr<LoraPcapCapture> bySize = CreateCapture ("size");
+  bySize->SetAttribute ("MaxFileSize", UintegerValue (24 + 3 * (16 + 20)));
+  bySize->SetAttribute ("MaxFiles", UintegerValue (2));
+
+  // A file every 2.5 s, when a packet comes
+  Ptr<LoraPcapCapture> byTime = CreateCapture ("time");
+  byTime->SetAttribute ("RotationInterval", TimeValue (Seconds (2.5)));
+
+  // Two events within a second dump the packets of the last 2.5 s
+  Ptr<LoraPcapCapture> ring = CreateCapture ("ring");
+  ring->SetAttribute ("RingDuration", TimeValue (Seconds (2.5)));
+  ring->SetAttribute ("TriggerThreshold", UintegerValue (2));
+  ring->SetAttribute ("TriggerWindow", TimeValue (Seconds (1)));
+  Simulator::Schedule (Seconds (5.5), &LoraPcapCapture::NotifyTriggerEvent, ring);
+  Simulator::Schedule (Seconds (7), &LoraPcapCapture::NotifyTriggerEvent, ring);
+  Simulator::Schedule (Seconds (7.5), &LoraPcapCapture::NotifyTriggerEvent, ring);
+
+  Simulator::Run ();
+  bySize->Close ();
+  byTime->Close ();
+
+  NS_TEST_EXPECT_MSG_EQ (bySize->GetNFiles (), 4, "Wrong number of files rotated on size");
+  NS_TEST_EXPECT_MSG_EQ (std::ifstream (bySize->GetFilename (1).c_str ()).good (), false,
+                         "An old file was not deleted");
+  NS_TEST_EXPECT_MSG_EQ (CheckFile (bySize->GetFilename (2), 20), 3, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (CheckFile (bySize->GetFilename (3), 20), 1, "Wrong number of packets");
+
+  NS_TEST_EXPECT_MSG_EQ (byTime->GetNFiles (), 4, "Wrong number of files rotated on time");
+  NS_TEST_EXPECT_MSG_EQ (CheckFile (byTime->GetFilename (1), 20), 3, "Wrong number of packets");
+
+  NS_TEST_EXPECT_MSG_EQ (ring->GetNFiles (), 0, "The ring buffer was written to files");
+  NS_TEST_EXPECT_MSG_EQ (ring->GetNTriggers (), 1, "Wrong number of triggers");
+  NS_TEST_EXPECT_MSG_EQ (CheckFile (ring->GetTriggerFilename (0), 20), 3,
+                         "Wrong number of packets in the ring buffer");
+
+  Simulator::Destroy ();
+}
+
 /*****************
  * LorawanMacTest *
  *****************/
@@ -1419,6 +3333,22 @@ LorawanTestSuite::LorawanTestSuite () : TestSuite ("lorawan", UNIT)
   AddTestCase (new LogicalLoraChannelTest, TestCase::QUICK);
   AddTestCase (new TimeOnAirTest, TestCase::QUICK);
   AddTestCase (new PhyConnectivityTest, TestCase::QUICK);
+  AddTestCase (new ParallelChannelTest, TestCase::QUICK);
+  AddTestCase (new TopologySnapshotTest, TestCase::QUICK);
+  AddTestCase (new PeriodicSenderTest, TestCase::QUICK);
+  AddTestCase (new TxEnergyTest, TestCase::QUICK);
+  AddTestCase (new LazyBasicEnergySourceTest, TestCase::QUICK);
+  AddTestCase (new FrameHeaderViewTest, TestCase::QUICK);
+  AddTestCase (new LoraObjectPoolTest, TestCase::QUICK);
+  AddTestCase (new LoraProfilerTest, TestCase::QUICK);
+  AddTestCase (new LoraOutputWriterTest, TestCase::QUICK);
+  AddTestCase (new DeviceStatusChangeTest, TestCase::QUICK);
+  AddTestCase (new LoraMetricsCollectorTest, TestCase::QUICK);
+  AddTestCase (new BanditTelemetryTest, TestCase::QUICK);
+  AddTestCase (new LoraLogTest, TestCase::QUICK);
+  AddTestCase (new LoraMacTimerTest, TestCase::QUICK);
+  AddTestCase (new BuildingRTreeTest, TestCase::QUICK);
+  AddTestCase (new LoraPcapCaptureTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
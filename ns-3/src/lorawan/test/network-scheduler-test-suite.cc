@@ -6,6 +6,9 @@
 // Include headers of classes to test
 #include "ns3/log.h"
 #include "ns3/network-scheduler.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "utilities.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -52,6 +55,257 @@ NetworkSchedulerTest::DoRun (void)
   // scheduled to happen 1 second after the reception.
 }
 
+/////////////////////////////
+// ReceiveWindowWheel testing //
+/////////////////////////////
+
+class ReceiveWindowWheelTest : public TestCase
+{
+public:
+  ReceiveWindowWheelTest ();
+  virtual ~ReceiveWindowWheelTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ReceiveWindowWheelTest::ReceiveWindowWheelTest ()
+  : TestCase ("Verify that the ReceiveWindowWheel returns opportunities in "
+              "order across all of its levels")
+{
+}
+
+ReceiveWindowWheelTest::~ReceiveWindowWheelTest ()
+{
+}
+
+void
+ReceiveWindowWheelTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ReceiveWindowWheelTest");
+
+  ReceiveWindowWheel wheel;
+
+  // Ticks in the first level, in the second level and in the overflow list,
+  // inserted out of order and with a duplicate
+  uint64_t ticks[] = {20000, 3, 1000, 250, 1000, 17000, 256};
+  for (uint64_t tick : ticks)
+    {
+      ReceiveWindowWheel::Entry entry;
+      entry.tick = tick;
+      entry.window = 1;
+      wheel.Insert (entry);
+    }
+
+  // Drain the wheel, adding a new opportunity half way through
+  std::vector<uint64_t> openedTicks;
+  std::vector<std::size_t> batchSizes;
+  std::vector<ReceiveWindowWheel::Entry> batch;
+  while (!wheel.IsEmpty ())
+    {
+      uint64_t next = wheel.GetNextTick ();
+      batch.clear ();
+      wheel.Advance (next, batch);
+      openedTicks.push_back (next);
+      batchSizes.push_back (batch.size ());
+
+      if (next == 1000)
+        {
+          ReceiveWindowWheel::Entry entry;
+          entry.tick = 2000;
+          entry.window = 2;
+          wheel.Insert (entry);
+        }
+    }
+
+  uint64_t expectedTicks[] = {3, 250, 256, 1000, 2000, 17000, 20000};
+  std::size_t expectedSizes[] = {1, 1, 1, 2, 1, 1, 1};
+  NS_TEST_ASSERT_MSG_EQ (openedTicks.size (), 7u, "Unexpected number of ticks");
+  for (int i = 0; i < 7; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (openedTicks[i], expectedTicks[i],
+                             "Unexpected tick order");
+      NS_TEST_ASSERT_MSG_EQ (batchSizes[i], expectedSizes[i],
+                             "Unexpected batch size");
+    }
+}
+
+/////////////////////////////////////
+// BatchedReceiveWindowDownlinkTest //
+/////////////////////////////////////
+
+class BatchedReceiveWindowDownlinkTest : public TestCase
+{
+public:
+  BatchedReceiveWindowDownlinkTest ();
+  virtual ~BatchedReceiveWindowDownlinkTest ();
+
+  void ReceivedPacketAtEndDevice (uint8_t requiredTransmissions, bool success,
+                                  Time time, Ptr<Packet> packet);
+  void SendPacket (Ptr<Node> endDevice);
+
+private:
+  virtual void DoRun (void);
+  bool m_receivedPacketAtEd = false;
+};
+
+BatchedReceiveWindowDownlinkTest::BatchedReceiveWindowDownlinkTest ()
+  : TestCase ("Verify that devices requesting an acknowledgment receive a "
+              "reply when receive windows are batched in a timing wheel")
+{
+}
+
+BatchedReceiveWindowDownlinkTest::~BatchedReceiveWindowDownlinkTest ()
+{
+}
+
+void
+BatchedReceiveWindowDownlinkTest::ReceivedPacketAtEndDevice (uint8_t requiredTransmissions,
+                                                             bool success, Time time,
+                                                             Ptr<Packet> packet)
+{
+  NS_LOG_DEBUG ("Received a packet at the ED");
+  m_receivedPacketAtEd = success;
+}
+
+void
+BatchedReceiveWindowDownlinkTest::SendPacket (Ptr<Node> endDevice)
+{
+  GetMacLayerFromNode<EndDeviceLorawanMac> (endDevice)->SetMType
+    (LorawanMacHeader::CONFIRMED_DATA_UP);
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+void
+BatchedReceiveWindowDownlinkTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatchedReceiveWindowDownlinkTest");
+
+  Config::SetDefault ("ns3::NetworkScheduler::BatchReceiveWindows",
+                      BooleanValue (true));
+
+  NetworkComponents components = InitializeNetwork (1, 1);
+  NodeContainer endDevices = components.endDevices;
+
+  GetMacLayerFromNode<EndDeviceLorawanMac> (endDevices.Get (0))->
+    TraceConnectWithoutContext
+      ("RequiredTransmissions",
+      MakeCallback (&BatchedReceiveWindowDownlinkTest::ReceivedPacketAtEndDevice,
+                    this));
+
+  Simulator::Schedule (Seconds (1), &BatchedReceiveWindowDownlinkTest::SendPacket,
+                       this, endDevices.Get (0));
+
+  Simulator::Stop (Seconds (10)); // Allow for time to receive a downlink packet
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::Reset ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_receivedPacketAtEd, true,
+                         "The device did not receive the batched reply");
+}
+
+/////////////////////////////////////
+// BatchedReceiveWindowRemovalTest //
+/////////////////////////////////////
+
+class BatchedReceiveWindowRemovalTest : public TestCase
+{
+public:
+  BatchedReceiveWindowRemovalTest ();
+  virtual ~BatchedReceiveWindowRemovalTest ();
+
+  void ReceivedPacketAtEndDevice (uint8_t requiredTransmissions, bool success,
+                                  Time time, Ptr<Packet> packet);
+  void SendPacket (Ptr<Node> endDevice);
+  void RemoveOpportunity (Ptr<NetworkStatus> status, LoraDeviceAddress address);
+
+private:
+  virtual void DoRun (void);
+  bool m_receivedPacketAtEd = false;
+};
+
+BatchedReceiveWindowRemovalTest::BatchedReceiveWindowRemovalTest ()
+  : TestCase ("Verify that a batched receive window opportunity that was "
+              "removed is never opened")
+{
+}
+
+BatchedReceiveWindowRemovalTest::~BatchedReceiveWindowRemovalTest ()
+{
+}
+
+void
+BatchedReceiveWindowRemovalTest::ReceivedPacketAtEndDevice (uint8_t requiredTransmissions,
+                                                            bool success, Time time,
+                                                            Ptr<Packet> packet)
+{
+  NS_LOG_DEBUG ("Received a packet at the ED");
+  m_receivedPacketAtEd = success;
+}
+
+void
+BatchedReceiveWindowRemovalTest::SendPacket (Ptr<Node> endDevice)
+{
+  GetMacLayerFromNode<EndDeviceLorawanMac> (endDevice)->SetMType
+    (LorawanMacHeader::CONFIRMED_DATA_UP);
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+void
+BatchedReceiveWindowRemovalTest::RemoveOpportunity (Ptr<NetworkStatus> status,
+                                                    LoraDeviceAddress address)
+{
+  Ptr<EndDeviceStatus> edStatus = status->GetEndDeviceStatus (address);
+  NS_TEST_ASSERT_MSG_EQ (edStatus->HasReceiveWindowOpportunityScheduled (), true,
+                         "No opportunity was scheduled for the uplink");
+  edStatus->RemoveReceiveWindowOpportunity ();
+  NS_TEST_EXPECT_MSG_EQ (edStatus->HasReceiveWindowOpportunityScheduled (), false,
+                         "The opportunity was not removed");
+}
+
+void
+BatchedReceiveWindowRemovalTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatchedReceiveWindowRemovalTest");
+
+  Config::SetDefault ("ns3::NetworkScheduler::BatchReceiveWindows",
+                      BooleanValue (true));
+
+  NetworkComponents components = InitializeNetwork (1, 1);
+  Ptr<Node> endDevice = components.endDevices.Get (0);
+  Ptr<EndDeviceLorawanMac> mac = GetMacLayerFromNode<EndDeviceLorawanMac> (endDevice);
+  Ptr<NetworkStatus> status = DynamicCast<NetworkServer>
+    (components.nsNode->GetApplication (0))->GetNetworkStatus ();
+
+  mac->TraceConnectWithoutContext
+    ("RequiredTransmissions",
+    MakeCallback (&BatchedReceiveWindowRemovalTest::ReceivedPacketAtEndDevice,
+                  this));
+
+  // The uplink reaches the server well before 1.5 s, and its first window
+  // would be opened one second after that
+  Simulator::Schedule (Seconds (1), &BatchedReceiveWindowRemovalTest::SendPacket,
+                       this, endDevice);
+  Simulator::Schedule (Seconds (1.5), &BatchedReceiveWindowRemovalTest::RemoveOpportunity,
+                       this, status, mac->GetDeviceAddress ());
+
+  // Stop before the device sends the packet again
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (status->NeedsReply (mac->GetDeviceAddress ()), true,
+                         "The removed opportunity was opened");
+
+  Simulator::Destroy ();
+
+  Config::Reset ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_receivedPacketAtEd, false,
+                         "The device received a reply in a removed window");
+}
+
 /**************
  * Test Suite *
  **************/
@@ -72,6 +326,9 @@ NetworkSchedulerTestSuite::NetworkSchedulerTestSuite ()
   LogComponentEnable ("NetworkSchedulerTestSuite", LOG_LEVEL_DEBUG);
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new NetworkSchedulerTest, TestCase::QUICK);
+  AddTestCase (new ReceiveWindowWheelTest, TestCase::QUICK);
+  AddTestCase (new BatchedReceiveWindowDownlinkTest, TestCase::QUICK);
+  AddTestCase (new BatchedReceiveWindowRemovalTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -28,7 +28,11 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include <algorithm>
 #include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace ns3 {
 
@@ -82,6 +86,33 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowerBatch (double txPowerDbm,
+                                        Ptr<MobilityModel> a,
+                                        const Ptr<MobilityModel> *b,
+                                        std::size_t n,
+                                        double *rxPowerDbm) const
+{
+  std::fill (rxPowerDbm, rxPowerDbm + n, txPowerDbm);
+  for (const PropagationLossModel *model = this; model != 0;
+       model = PeekPointer (model->m_next))
+    {
+      model->DoCalcRxPowerBatch (a, b, n, rxPowerDbm);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                          const Ptr<MobilityModel> *b,
+                                          std::size_t n,
+                                          double *powerDbm) const
+{
+  for (std::size_t i = 0; i < n; i++)
+    {
+      powerDbm[i] = DoCalcRxPower (powerDbm[i], a, b[i]);
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -534,6 +565,78 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+/**
+ * Compute the lengths of n vectors given by their coordinates, two at a time
+ * when SSE2 is available. The result is the same as Vector3D::GetLength.
+ */
+static void
+CalcLengths (const double *x, const double *y, const double *z,
+             std::size_t n, double *length)
+{
+  std::size_t i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d vx = _mm_loadu_pd (x + i);
+      __m128d vy = _mm_loadu_pd (y + i);
+      __m128d vz = _mm_loadu_pd (z + i);
+      __m128d sum = _mm_add_pd (_mm_add_pd (_mm_mul_pd (vx, vx), _mm_mul_pd (vy, vy)),
+                                _mm_mul_pd (vz, vz));
+      _mm_storeu_pd (length + i, _mm_sqrt_pd (sum));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      length[i] = std::sqrt (x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+    }
+}
+
+void
+LogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                     const Ptr<MobilityModel> *b,
+                                                     std::size_t n,
+                                                     double *powerDbm) const
+{
+  NS_LOG_FUNCTION (this << a << n);
+
+  // Work on blocks that fit on the stack, so that batches can be computed
+  // from several threads at once
+  const std::size_t blockSize = 64;
+  double x[blockSize];
+  double y[blockSize];
+  double z[blockSize];
+  double distance[blockSize];
+
+  Vector position = a->GetPosition ();
+  for (std::size_t start = 0; start < n; start += blockSize)
+    {
+      std::size_t size = std::min (blockSize, n - start);
+      for (std::size_t i = 0; i < size; i++)
+        {
+          Vector other = b[start + i]->GetPosition ();
+          x[i] = other.x - position.x;
+          y[i] = other.y - position.y;
+          z[i] = other.z - position.z;
+        }
+      CalcLengths (x, y, z, size, distance);
+
+      // Same formula as DoCalcRxPower
+      double *power = powerDbm + start;
+      for (std::size_t i = 0; i < size; i++)
+        {
+          if (distance[i] <= m_referenceDistance)
+            {
+              power[i] -= m_referenceLoss;
+            }
+          else
+            {
+              double pathLossDb = 10 * m_exponent * std::log10 (distance[i] / m_referenceDistance);
+              power[i] += -m_referenceLoss - pathLossDb;
+            }
+        }
+    }
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -93,6 +93,27 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Compute the Rx Power at several destinations, taking into account all
+   * the PropagationLossModel(s) chained to the current one.
+   *
+   * The result is the same as calling CalcRxPower for each destination in
+   * turn, but each model of the chain processes the whole batch at once,
+   * which lets models that only depend on the positions use vector
+   * instructions.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param a the mobility model of the source
+   * \param b the mobility models of the n destinations
+   * \param n the number of destinations
+   * \param rxPowerDbm the n reception powers (in dBm), written by this method
+   */
+  void CalcRxPowerBatch (double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         const Ptr<MobilityModel> *b,
+                         std::size_t n,
+                         double *rxPowerDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -134,6 +155,22 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Apply only the particular PropagationLossModel to a batch of
+   * destinations. The default implementation calls DoCalcRxPower for each
+   * destination, in order.
+   *
+   * \param a the mobility model of the source
+   * \param b the mobility models of the n destinations
+   * \param n the number of destinations
+   * \param powerDbm the n powers (in dBm) before this model, replaced by the
+   * powers after it
+   */
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const Ptr<MobilityModel> *b,
+                                   std::size_t n,
+                                   double *powerDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
@@ -529,6 +566,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const Ptr<MobilityModel> *b,
+                                   std::size_t n,
+                                   double *powerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -436,6 +436,52 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class PropagationLossModelBatchTestCase : public TestCase
+{
+public:
+  PropagationLossModelBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PropagationLossModelBatchTestCase::PropagationLossModelBatchTestCase ()
+  : TestCase ("Check that the batch computation of a chain of loss models gives the same received powers as one at a time")
+{
+}
+
+void
+PropagationLossModelBatchTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (3, -7, 1.5));
+
+  // More destinations than fit in a block, and an odd number of them, some
+  // closer than the reference distance
+  const std::size_t n = 151;
+  std::vector<Ptr<MobilityModel> > b;
+  for (std::size_t i = 0; i < n; i++)
+    {
+      Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (3 + 0.1 * i * i, -7 + 0.05 * i, 1.5 + (i % 7)));
+      b.push_back (mobility);
+    }
+
+  // Log distance (batched) followed by Friis (one at a time)
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  logDistance->SetPathLossExponent (3.76);
+  logDistance->SetReference (1, 7.7);
+  logDistance->SetNext (CreateObject<FriisPropagationLossModel> ());
+
+  std::vector<double> rxPowerDbm (n);
+  logDistance->CalcRxPowerBatch (14, a, b.data (), n, rxPowerDbm.data ());
+  for (std::size_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (rxPowerDbm[i], logDistance->CalcRxPower (14, a, b[i]),
+                             "Got a different rcv power from the batch");
+    }
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +496,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new PropagationLossModelBatchTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;